@@ -13,14 +13,26 @@
 // limitations under the License.
 
 #pragma once
+#include "graph_segment/label_histogram.hpp"
+#include "graph_segment/mask_propagator.hpp"
+#include "graph_segment/road_roi.hpp"
 #include "graph_segment/similar_area_searcher.hpp"
 
 #include <opencv4/opencv2/ximgproc/segmentation.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <yabloc_common/camera_info_subscriber.hpp>
+#include <yabloc_common/fixed_image.hpp>
+#include <yabloc_common/frame_buffer_pool.hpp>
+#include <yabloc_common/static_tf_subscriber.hpp>
+#include <yabloc_common/status_reporter.hpp>
 
+#include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
+#include <geometry_msgs/msg/twist_with_covariance_stamped.hpp>
 #include <sensor_msgs/msg/image.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
 
+#include <optional>
+
 namespace yabloc::graph_segment
 {
 class GraphSegment : public rclcpp::Node
@@ -28,21 +40,71 @@ class GraphSegment : public rclcpp::Node
 public:
   using PointCloud2 = sensor_msgs::msg::PointCloud2;
   using Image = sensor_msgs::msg::Image;
+  using TwistCovStamped = geometry_msgs::msg::TwistWithCovarianceStamped;
+  using PoseCovStamped = geometry_msgs::msg::PoseWithCovarianceStamped;
   GraphSegment();
 
 private:
   const float target_height_ratio_;
   const int target_candidate_box_width_;
 
-  rclcpp::Subscription<Image>::SharedPtr sub_image_;
-  rclcpp::Publisher<Image>::SharedPtr pub_mask_image_;
+  std::unique_ptr<common::ImageSubscriber> sub_image_;
+  std::unique_ptr<common::ImagePublisher> pub_mask_image_;
   rclcpp::Publisher<Image>::SharedPtr pub_debug_image_;
   cv::Ptr<cv::ximgproc::segmentation::GraphSegmentation> segmentation_;
   std::unique_ptr<SimilarAreaSearcher> similar_area_searcher_{nullptr};
+  LabelHistogram label_histogram_;
+
+  // These are used only if mask_propagator_ or road_roi_ is enabled.
+  std::unique_ptr<common::CameraInfoSubscriber> info_{nullptr};
+  std::unique_ptr<common::StaticTfSubscriber> tf_subscriber_{nullptr};
+
+  // Temporal reuse of the road mask. These are used only if mask_propagator_ is enabled.
+  std::unique_ptr<MaskPropagator> mask_propagator_{nullptr};
+  rclcpp::Subscription<TwistCovStamped>::SharedPtr sub_twist_;
+  std::optional<TwistCovStamped> latest_twist_{std::nullopt};
+  std::optional<rclcpp::Time> last_image_stamp_{std::nullopt};
+  std::unique_ptr<common::StatusReporter> status_{nullptr};
+  size_t status_mask_index_;
+
+  // Map prior ROI. These are used only if road_roi_ is enabled.
+  std::unique_ptr<RoadRoi> road_roi_{nullptr};
+  rclcpp::Subscription<PointCloud2>::SharedPtr sub_road_area_;
+  rclcpp::Subscription<PoseCovStamped>::SharedPtr sub_pose_;
+  std::optional<PoseCovStamped> latest_pose_{std::nullopt};
+  cv::Rect2i last_roi_;
+
+  enum BufferSlot {
+    RESIZED = 0,
+    SEGMENTED,
+    HALF_MASK,
+    HALF_DEBUG,
+    MASK,
+    DEBUG,
+    SHOW,
+    BUFFER_SLOT_COUNT
+  };
+  common::FrameBufferPool buffer_pool_{BUFFER_SLOT_COUNT};
+
+  void on_image(const common::ImageFrame & frame);
+
+  // Return the rectangle around the point where the road should be
+  cv::Rect2i target_rect(const cv::Size & image_size) const;
+
+  // `segmented` is the label image of `roi` in the image of `image_size`
+  int search_most_road_like_class(
+    const cv::Mat & segmented, const cv::Size & image_size, const cv::Rect2i & roi) const;
+
+  // Return the region to be segmented. It is the whole image unless the map prior is available.
+  cv::Rect2i compute_roi(const cv::Size & image_size, const rclcpp::Time & stamp);
 
-  void on_image(const Image & msg);
+  // Execute graph-based segmentation and draw the road mask and its debug image
+  void segment_road(
+    const cv::Mat & resized, const cv::Rect2i & roi, cv::Mat & output_image,
+    cv::Mat & debug_image);
 
-  int search_most_road_like_class(const cv::Mat & segmented) const;
+  // Return the homography of the ground plane between the last image and the current one
+  std::optional<cv::Matx33f> compute_ego_motion_homography(const rclcpp::Time & stamp);
 
   void draw_and_publish_image(
     const cv::Mat & raw_image, const cv::Mat & debug_image, const rclcpp::Time & stamp);
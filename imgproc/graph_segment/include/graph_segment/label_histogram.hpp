@@ -0,0 +1,59 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <opencv4/opencv2/core.hpp>
+
+#include <array>
+#include <vector>
+
+namespace yabloc::graph_segment
+{
+/**
+ * Color histograms of all segments stored in one flat table
+ *
+ * Labels of graph-based segmentation are dense integers (0, 1, ..., N-1).
+ * So the histograms are stored as a contiguous (labels x STRIDE) table instead of a map.
+ * Each row holds BIN bins for each of 3 channels, zero-padded to STRIDE floats.
+ */
+class LabelHistogram
+{
+public:
+  static constexpr int BIN = 10;
+  static constexpr int LANE = 8;
+  static constexpr int STRIDE = ((3 * BIN + LANE - 1) / LANE) * LANE;
+
+  LabelHistogram();
+
+  /**
+   * Count the area and the color histogram of each label in one pass
+   *
+   * @param[in] segmented CV_32SC1 label image
+   * @param[in] bgr_image CV_8UC3 image. If it is empty, only the areas are counted.
+   */
+  void compute(const cv::Mat & segmented, const cv::Mat & bgr_image = cv::Mat());
+
+  int label_count() const { return static_cast<int>(areas_.size()); }
+
+  int area(int label) const { return areas_[label]; }
+
+  // Return the histogram intersection of two labels. Both histograms are normalized implicitly.
+  float intersection(int label1, int label2) const;
+
+private:
+  std::array<uchar, 256> bin_table_;
+  std::vector<int> areas_;
+  std::vector<float> table_;
+};
+}  // namespace yabloc::graph_segment
@@ -0,0 +1,60 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Geometry>
+#include <opencv4/opencv2/core.hpp>
+
+namespace yabloc::graph_segment
+{
+/**
+ * Compute the homography which maps pixels on the ground plane of the previous frame into the
+ * current frame
+ *
+ * @param[in] intrinsic camera intrinsic matrix of the image to be warped
+ * @param[in] extrinsic camera pose in base_link
+ * @param[in] motion planar motion (x, y, yaw) of base_link from the previous frame
+ * @return 3x3 homography
+ */
+cv::Matx33f ground_homography(
+  const Eigen::Matrix3f & intrinsic, const Eigen::Affine3f & extrinsic,
+  const Eigen::Vector3f & motion);
+
+class MaskPropagator
+{
+public:
+  MaskPropagator(int full_segmentation_interval, float change_threshold);
+
+  // Store the result of full segmentation as a reference of the following propagation
+  void reset(const cv::Mat & bgr_image, const cv::Mat & road_mask);
+
+  /**
+   * Warp the last road mask into the current frame
+   *
+   * @param[in] bgr_image current image whose size is the same as the road mask
+   * @param[in] homography from ground_homography()
+   * @param[out] road_mask propagated road mask
+   * @return false if full segmentation is required (interval is elapsed or the change is detected)
+   */
+  bool propagate(const cv::Mat & bgr_image, const cv::Matx33f & homography, cv::Mat & road_mask);
+
+private:
+  const int full_segmentation_interval_;
+  const float change_threshold_;
+
+  int propagated_count_{0};
+  cv::Mat last_road_mask_;
+  cv::Scalar reference_road_color_;
+};
+}  // namespace yabloc::graph_segment
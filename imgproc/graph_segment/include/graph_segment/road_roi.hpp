@@ -0,0 +1,66 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Geometry>
+#include <opencv4/opencv2/core.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <optional>
+#include <vector>
+
+namespace yabloc::graph_segment
+{
+/**
+ * Estimate the image region where the road should appear from the vector map
+ *
+ * The road area polygons are projected into the image with the current pose estimate and the
+ * bounding rectangle of them is returned.
+ */
+class RoadRoi
+{
+public:
+  /**
+   * @param[in] max_range polygons farther than this [m] from base_link are ignored
+   * @param[in] margin the rectangle is dilated by this [pixel] to absorb the pose error
+   * @param[in] max_position_std no ROI is estimated if the position std is larger than this [m]
+   */
+  RoadRoi(float max_range, int margin, float max_position_std);
+
+  // The points which share the same label form a polygon, in the same way as ll2_bounding_box
+  void set_road_area(const pcl::PointCloud<pcl::PointXYZL> & road_area);
+
+  bool has_road_area() const { return !polygons_.empty(); }
+
+  /**
+   * @param[in] image_size size of the image
+   * @param[in] intrinsic camera intrinsic matrix of the image
+   * @param[in] extrinsic camera pose in base_link
+   * @param[in] pose base_link pose in map
+   * @param[in] position_std standard deviation of the position of the pose [m]
+   * @return ROI in the image, or nullopt if the pose is not converged or no road area is visible
+   */
+  std::optional<cv::Rect2i> estimate(
+    const cv::Size & image_size, const Eigen::Matrix3f & intrinsic,
+    const Eigen::Affine3f & extrinsic, const Eigen::Affine3f & pose, float position_std) const;
+
+private:
+  const float max_range_;
+  const int margin_;
+  const float max_position_std_;
+  std::vector<std::vector<Eigen::Vector3f>> polygons_;
+};
+}  // namespace yabloc::graph_segment
@@ -13,8 +13,8 @@
 // limitations under the License.
 
 #pragma once
-#include <Eigen/Core>
-#include <opencv4/opencv2/core.hpp>
+#include "graph_segment/label_histogram.hpp"
+
 #include <rclcpp/logger.hpp>
 
 #include <set>
@@ -30,8 +30,7 @@ public:
   {
   }
 
-  std::set<int> search(
-    const cv::Mat & rgb_image, const cv::Mat & segmented, int best_roadlike_class);
+  std::set<int> search(const LabelHistogram & histogram, int best_roadlike_class);
 
 private:
   const float similarity_score_threshold_;
@@ -13,14 +13,15 @@
 // limitations under the License.
 
 #include "graph_segment/graph_segment.hpp"
-#include "graph_segment/histogram.hpp"
 
 #include <opencv4/opencv2/highgui.hpp>
 #include <opencv4/opencv2/imgproc.hpp>
-#include <yabloc_common/cv_decompress.hpp>
+#include <yabloc_common/pose_conversions.hpp>
 #include <yabloc_common/pub_sub.hpp>
 #include <yabloc_common/timer.hpp>
 
+#include <pcl_conversions/pcl_conversions.h>
+
 namespace yabloc::graph_segment
 {
 GraphSegment::GraphSegment()
@@ -30,11 +31,12 @@ GraphSegment::GraphSegment()
 {
   using std::placeholders::_1;
 
-  // Subscriber
-  sub_image_ =
-    create_subscription<Image>("src_image", 10, std::bind(&GraphSegment::on_image, this, _1));
+  // The input image and the mask are exchanged as FixedImage if the middleware can loan it
+  const bool use_fixed_image = declare_parameter<bool>("use_fixed_image", false);
+  sub_image_ = std::make_unique<common::ImageSubscriber>(
+    this, "src_image", use_fixed_image, std::bind(&GraphSegment::on_image, this, _1));
 
-  pub_mask_image_ = create_publisher<Image>("mask_image", 10);
+  pub_mask_image_ = std::make_unique<common::ImagePublisher>(this, "mask_image", use_fixed_image);
   pub_debug_image_ = create_publisher<Image>("segmented_image", 10);
 
   const double sigma = declare_parameter<double>("sigma", 0.5);
@@ -47,6 +49,44 @@ GraphSegment::GraphSegment()
     similar_area_searcher_ = std::make_unique<SimilarAreaSearcher>(
       declare_parameter<float>("similarity_score_threshold", 0.8));
   }
+
+  // temporal reuse module
+  // If full_segmentation_interval is 1, graph-based segmentation is executed every frame.
+  // Whether the last mask is fresh or propagated is recorded in the status
+  const int full_segmentation_interval = declare_parameter<int>("full_segmentation_interval", 1);
+  if (full_segmentation_interval > 1) {
+    mask_propagator_ = std::make_unique<MaskPropagator>(
+      full_segmentation_interval, declare_parameter<float>("propagation_change_threshold", 30.f));
+    auto on_twist = [this](const TwistCovStamped & msg) -> void { latest_twist_ = msg; };
+    sub_twist_ = create_subscription<TwistCovStamped>("twist_cov", 10, std::move(on_twist));
+
+    status_ = std::make_unique<common::StatusReporter>(this, "status", "Graph segment");
+    status_mask_index_ = status_->add_label("mask", {"propagated", "fresh"});
+  }
+
+  // map prior ROI module
+  // If it is enabled, segmentation runs only around the road area of the vector map.
+  if (declare_parameter<bool>("use_map_roi", false)) {
+    road_roi_ = std::make_unique<RoadRoi>(
+      declare_parameter<float>("roi_max_range", 50.f), declare_parameter<int>("roi_margin", 20),
+      declare_parameter<float>("roi_max_position_std", 1.0f));
+
+    auto on_road_area = [this](const PointCloud2 & msg) -> void {
+      pcl::PointCloud<pcl::PointXYZL> road_area;
+      pcl::fromROSMsg(msg, road_area);
+      road_roi_->set_road_area(road_area);
+    };
+    auto on_pose = [this](const PoseCovStamped & msg) -> void { latest_pose_ = msg; };
+    const rclcpp::QoS latch_qos = rclcpp::QoS(10).transient_local();
+    sub_road_area_ =
+      create_subscription<PointCloud2>("ll2_road_area", latch_qos, std::move(on_road_area));
+    sub_pose_ = create_subscription<PoseCovStamped>("pose_with_covariance", 10, std::move(on_pose));
+  }
+
+  if (mask_propagator_ || road_roi_) {
+    info_ = std::make_unique<common::CameraInfoSubscriber>(this);
+    tf_subscriber_ = std::make_unique<common::StaticTfSubscriber>(this->get_clock());
+  }
 }
 
 cv::Vec3b random_hsv(int index)
@@ -55,99 +95,201 @@ cv::Vec3b random_hsv(int index)
   return cv::Vec3b(fmod(base, 1.2) * 255, 0.7 * 255, 0.5 * 255);
 };
 
-int GraphSegment::search_most_road_like_class(const cv::Mat & segmented) const
+cv::Rect2i GraphSegment::target_rect(const cv::Size & image_size) const
 {
   const int W = target_candidate_box_width_;
   const float R = target_height_ratio_;
-  cv::Point2i target_px(segmented.cols * 0.5, segmented.rows * R);
-  cv::Rect2i rect(target_px + cv::Point2i(-W, -W), target_px + cv::Point2i(W, W));
+  cv::Point2i target_px(image_size.width * 0.5, image_size.height * R);
+  return cv::Rect2i(target_px + cv::Point2i(-W, -W), target_px + cv::Point2i(W, W));
+}
 
-  std::unordered_map<int, int> areas;
-  std::unordered_set<int> candidates;
-  for (int h = 0; h < segmented.rows; h++) {
-    const int * seg_ptr = segmented.ptr<int>(h);
-    for (int w = 0; w < segmented.cols; w++) {
-      int key = seg_ptr[w];
-      if (areas.count(key) == 0) areas[key] = 0;
-      areas[key]++;
-      if (rect.contains(cv::Point2i{w, h})) candidates.insert(key);
-    }
-  }
+int GraphSegment::search_most_road_like_class(
+  const cv::Mat & segmented, const cv::Size & image_size, const cv::Rect2i & roi) const
+{
+  cv::Rect2i rect = target_rect(image_size) & roi;
+  rect -= roi.tl();
 
-  // Search the largest area and its class
+  // Search the largest area and its class among the labels in the target rectangle
+  // NOTE: The area of each label is already counted by label_histogram_
   int max_area = 0;
   int max_area_class = -1;
-  for (int c : candidates) {
-    if (areas.at(c) < max_area) continue;
-    max_area = areas.at(c);
-    max_area_class = c;
+  for (int h = rect.y; h < rect.y + rect.height; h++) {
+    const int * seg_ptr = segmented.ptr<int>(h);
+    for (int w = rect.x; w < rect.x + rect.width; w++) {
+      const int c = seg_ptr[w];
+      if (label_histogram_.area(c) < max_area) continue;
+      max_area = label_histogram_.area(c);
+      max_area_class = c;
+    }
   }
   return max_area_class;
 }
 
-void GraphSegment::on_image(const Image & msg)
+cv::Rect2i GraphSegment::compute_roi(const cv::Size & image_size, const rclcpp::Time & stamp)
+{
+  const cv::Rect2i full_rect(cv::Point2i(0, 0), image_size);
+  if (!road_roi_ || !road_roi_->has_road_area()) return full_rect;
+  if (!latest_pose_.has_value()) return full_rect;
+  if (info_->is_camera_info_nullopt()) return full_rect;
+
+  // Fall back to the full frame unless the pose estimate is fresh
+  const double pose_age = (stamp - rclcpp::Time(latest_pose_->header.stamp)).seconds();
+  if (std::abs(pose_age) > 1.0) return full_rect;
+
+  std::optional<Eigen::Affine3f> extrinsic = (*tf_subscriber_)(info_->get_frame_id(), "base_link");
+  if (!extrinsic.has_value()) return full_rect;
+
+  // The road mask is computed at half resolution
+  Eigen::Matrix3f intrinsic = info_->intrinsic();
+  intrinsic.topRows(2) *= 0.5f;
+
+  const auto & covariance = latest_pose_->pose.covariance;
+  const double position_std = std::sqrt(std::max(covariance[6 * 0 + 0], covariance[6 * 1 + 1]));
+  const Eigen::Affine3f pose = common::pose_to_affine(latest_pose_->pose.pose);
+  std::optional<cv::Rect2i> roi =
+    road_roi_->estimate(image_size, intrinsic, extrinsic.value(), pose, position_std);
+  if (!roi.has_value()) return full_rect;
+
+  // The target rectangle must be segmented to pick up the road-like class
+  return (roi.value() | target_rect(image_size)) & full_rect;
+}
+
+std::optional<cv::Matx33f> GraphSegment::compute_ego_motion_homography(
+  const rclcpp::Time & stamp)
 {
-  cv::Mat image = common::decompress_to_cv_mat(msg);
-  cv::Mat resized;
-  cv::resize(image, resized, cv::Size(), 0.5, 0.5);
+  std::optional<rclcpp::Time> last_stamp = last_image_stamp_;
+  last_image_stamp_ = stamp;
 
-  // Execute graph-based segmentation
+  if (!last_stamp.has_value()) return std::nullopt;
+  if (!latest_twist_.has_value()) return std::nullopt;
+  if (info_->is_camera_info_nullopt()) return std::nullopt;
+
+  std::optional<Eigen::Affine3f> extrinsic = (*tf_subscriber_)(info_->get_frame_id(), "base_link");
+  if (!extrinsic.has_value()) return std::nullopt;
+
+  const double dt = (stamp - last_stamp.value()).seconds();
+  if (dt < 0 || dt > 0.5) return std::nullopt;
+
+  // Planar motion of base_link with constant velocity
+  const float distance = latest_twist_->twist.twist.linear.x * dt;
+  const float yaw = latest_twist_->twist.twist.angular.z * dt;
+  const Eigen::Vector3f motion(distance * std::cos(yaw / 2), distance * std::sin(yaw / 2), yaw);
+
+  // The road mask is computed at half resolution
+  Eigen::Matrix3f intrinsic = info_->intrinsic();
+  intrinsic.topRows(2) *= 0.5f;
+  return ground_homography(intrinsic, extrinsic.value(), motion);
+}
+
+void GraphSegment::segment_road(
+  const cv::Mat & resized, const cv::Rect2i & roi, cv::Mat & output_image, cv::Mat & debug_image)
+{
   common::Timer timer;
-  cv::Mat segmented;
-  segmentation_->processImage(resized, segmented);
-  RCLCPP_INFO_STREAM(get_logger(), "segmentation time: " << timer);
+  // NOTE: processImage() writes into the ROI of the pooled buffer, since its size and type match
+  cv::Mat segmented = buffer_pool_.buffer(SEGMENTED, CV_32SC1, 0.5)(roi);
+  const cv::Mat resized_roi = resized(roi);
+  segmentation_->processImage(resized_roi, segmented);
+  RCLCPP_DEBUG_STREAM(get_logger(), "segmentation time: " << timer << " roi: " << roi);
+
+  // Count areas (and color histograms if necessary) of all labels in one pass
+  label_histogram_.compute(segmented, similar_area_searcher_ ? resized_roi : cv::Mat());
 
   //
-  int target_class = search_most_road_like_class(segmented);
+  int target_class = search_most_road_like_class(segmented, resized.size(), roi);
   //
   std::set<int> road_keys = {target_class};
-  if (similar_area_searcher_) {
-    road_keys = similar_area_searcher_->search(resized, segmented, target_class);
+  if (similar_area_searcher_ && target_class >= 0) {
+    road_keys = similar_area_searcher_->search(label_histogram_, target_class);
   }
 
   // Draw output image and debug image
-  // TODO: use ptr instead of at()
-  cv::Mat output_image = cv::Mat::zeros(resized.size(), CV_8UC1);
-  cv::Mat debug_image = cv::Mat::zeros(resized.size(), CV_8UC3);
-  for (int h = 0; h < resized.rows; h++) {
-    for (int w = 0; w < resized.cols; w++) {
-      cv::Point2i px(w, h);
-      int key = segmented.at<int>(px);
+  output_image.setTo(0);
+  if (roi.size() != resized.size()) debug_image.setTo(cv::Scalar(0, 0, 64));
+  for (int h = 0; h < roi.height; h++) {
+    const int * seg_ptr = segmented.ptr<int>(h);
+    uchar * output_ptr = output_image.ptr<uchar>(h + roi.y) + roi.x;
+    cv::Vec3b * debug_ptr = debug_image.ptr<cv::Vec3b>(h + roi.y) + roi.x;
+    for (int w = 0; w < roi.width; w++) {
+      int key = seg_ptr[w];
       if (road_keys.count(key) > 0) {
-        output_image.at<uchar>(px) = 255;
+        output_ptr[w] = 255;
         if (key == target_class)
-          debug_image.at<cv::Vec3b>(px) = cv::Vec3b(30, 255, 255);
+          debug_ptr[w] = cv::Vec3b(30, 255, 255);
         else
-          debug_image.at<cv::Vec3b>(px) = cv::Vec3b(10, 255, 255);
+          debug_ptr[w] = cv::Vec3b(10, 255, 255);
       } else {
-        debug_image.at<cv::Vec3b>(px) = random_hsv(key);
+        debug_ptr[w] = random_hsv(key);
       }
     }
   }
+}
+
+void GraphSegment::on_image(const common::ImageFrame & frame)
+{
+  // The image is read directly from the received message
+  const cv::Mat & image = frame.image;
+  if (image.type() != CV_8UC3) {
+    RCLCPP_WARN_STREAM(get_logger(), "graph_segment accepts only bgr8 image");
+    return;
+  }
+  const rclcpp::Time stamp = frame.header.stamp;
+
+  buffer_pool_.reserve(image.size());
+  cv::Mat & resized = buffer_pool_.buffer(RESIZED, CV_8UC3, 0.5);
+  cv::resize(image, resized, resized.size());
+
+  common::Timer timer;
+  cv::Mat & output_image = buffer_pool_.buffer(HALF_MASK, CV_8UC1, 0.5);
+  cv::Mat & debug_image = buffer_pool_.buffer(HALF_DEBUG, CV_8UC3, 0.5);
+
+  // Try to reuse the last road mask instead of segmentation
+  bool is_fresh = true;
+  if (mask_propagator_) {
+    std::optional<cv::Matx33f> homography = compute_ego_motion_homography(stamp);
+    if (homography.has_value()) {
+      is_fresh = !mask_propagator_->propagate(resized, homography.value(), output_image);
+    }
+  }
+
+  last_roi_ = cv::Rect2i(cv::Point2i(0, 0), resized.size());
+  if (is_fresh) {
+    last_roi_ = compute_roi(resized.size(), stamp);
+    segment_road(resized, last_roi_, output_image, debug_image);
+    if (mask_propagator_) mask_propagator_->reset(resized, output_image);
+  } else {
+    // Propagated mask has no segmentation label
+    debug_image.setTo(cv::Scalar(0, 0, 64));
+    debug_image.setTo(cv::Scalar(10, 255, 255), output_image);
+  }
   cv::cvtColor(debug_image, debug_image, cv::COLOR_HSV2BGR);
-  cv::resize(output_image, output_image, image.size(), 0, 0, cv::INTER_NEAREST);
-  cv::resize(debug_image, debug_image, image.size(), 0, 0, cv::INTER_NEAREST);
 
-  common::publish_image(*pub_mask_image_, output_image, msg.header.stamp);
+  cv::Mat & full_output_image = buffer_pool_.buffer(MASK, CV_8UC1);
+  cv::Mat & full_debug_image = buffer_pool_.buffer(DEBUG, CV_8UC3);
+  cv::resize(output_image, full_output_image, image.size(), 0, 0, cv::INTER_NEAREST);
+  cv::resize(debug_image, full_debug_image, image.size(), 0, 0, cv::INTER_NEAREST);
+
+  pub_mask_image_->publish(full_output_image, stamp);
+  if (status_) status_->set(status_mask_index_, is_fresh);
 
-  draw_and_publish_image(image, debug_image, msg.header.stamp);
-  RCLCPP_INFO_STREAM(get_logger(), "total processing time: " << timer);
+  draw_and_publish_image(image, full_debug_image, stamp);
+  RCLCPP_DEBUG_STREAM(
+    get_logger(), "total processing time: " << timer << (is_fresh ? "(fresh)" : "(propagated)"));
 }
 
 void GraphSegment::draw_and_publish_image(
   const cv::Mat & raw_image, const cv::Mat & debug_image, const rclcpp::Time & stamp)
 {
-  cv::Mat show_image;
+  cv::Mat & show_image = buffer_pool_.buffer(SHOW, CV_8UC3);
   cv::addWeighted(raw_image, 0.5, debug_image, 0.8, 1.0, show_image);
   const cv::Size size = debug_image.size();
 
   // Draw target rectangle
-  {
-    const int W = target_candidate_box_width_;
-    const float R = target_height_ratio_;
-    cv::Point2i target(size.width / 2, size.height * R);
-    cv::Rect2i rect(target + cv::Point2i(-W, -W), target + cv::Point2i(W, W));
-    cv::rectangle(show_image, rect, cv::Scalar::all(0), 2);
+  cv::rectangle(show_image, target_rect(size), cv::Scalar::all(0), 2);
+
+  // Draw ROI, which is in the half resolution
+  if (last_roi_.size() != buffer_pool_.buffer(RESIZED, CV_8UC3, 0.5).size()) {
+    cv::Rect2i roi(last_roi_.tl() * 2, last_roi_.br() * 2);
+    cv::rectangle(show_image, roi, cv::Scalar(0, 255, 255), 2);
   }
 
   common::publish_image(*pub_debug_image_, show_image, stamp);
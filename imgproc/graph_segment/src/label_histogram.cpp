@@ -0,0 +1,82 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graph_segment/label_histogram.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace yabloc::graph_segment
+{
+LabelHistogram::LabelHistogram()
+{
+  // The same binning as the former Eigen-based histogram
+  for (int i = 0; i < 256; ++i) {
+    bin_table_[i] = std::clamp(static_cast<int>(i * BIN / 255.f), 0, BIN - 1);
+  }
+}
+
+void LabelHistogram::compute(const cv::Mat & segmented, const cv::Mat & bgr_image)
+{
+  if (segmented.type() != CV_32SC1) throw std::runtime_error("segmented must be CV_32SC1");
+
+  double max_label = -1;
+  cv::minMaxLoc(segmented, nullptr, &max_label);
+  const int label_count = static_cast<int>(max_label) + 1;
+
+  // NOTE: assign() does not re-allocate if the capacity is enough
+  areas_.assign(label_count, 0);
+  const bool with_color = !bgr_image.empty();
+  if (with_color) table_.assign(static_cast<size_t>(label_count) * STRIDE, 0.f);
+
+  for (int h = 0; h < segmented.rows; h++) {
+    const int * seg_ptr = segmented.ptr<int>(h);
+    if (!with_color) {
+      for (int w = 0; w < segmented.cols; w++) areas_[seg_ptr[w]]++;
+      continue;
+    }
+
+    const cv::Vec3b * bgr_ptr = bgr_image.ptr<cv::Vec3b>(h);
+    for (int w = 0; w < segmented.cols; w++) {
+      const int label = seg_ptr[w];
+      areas_[label]++;
+      float * row = table_.data() + static_cast<size_t>(label) * STRIDE;
+      row[bin_table_[bgr_ptr[w][0]]] += 1.f;
+      row[BIN + bin_table_[bgr_ptr[w][1]]] += 1.f;
+      row[2 * BIN + bin_table_[bgr_ptr[w][2]]] += 1.f;
+    }
+  }
+}
+
+float LabelHistogram::intersection(int label1, int label2) const
+{
+  if (areas_[label1] == 0 || areas_[label2] == 0) throw std::runtime_error("invalid division");
+
+  const float * row1 = table_.data() + static_cast<size_t>(label1) * STRIDE;
+  const float * row2 = table_.data() + static_cast<size_t>(label2) * STRIDE;
+  // Each pixel votes once per channel
+  const float gain1 = 1.f / (3 * areas_[label1]);
+  const float gain2 = 1.f / (3 * areas_[label2]);
+
+  // NOTE: Independent accumulators let the compiler vectorize this loop without -ffast-math
+  std::array<float, LANE> acc{};
+  for (int i = 0; i < STRIDE; i += LANE) {
+    for (int l = 0; l < LANE; ++l) {
+      acc[l] += std::min(row1[i + l] * gain1, row2[i + l] * gain2);
+    }
+  }
+  return std::accumulate(acc.begin(), acc.end(), 0.f);
+}
+
+}  // namespace yabloc::graph_segment
@@ -0,0 +1,83 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graph_segment/mask_propagator.hpp"
+
+#include <opencv4/opencv2/core/eigen.hpp>
+#include <opencv4/opencv2/imgproc.hpp>
+
+namespace yabloc::graph_segment
+{
+cv::Matx33f ground_homography(
+  const Eigen::Matrix3f & intrinsic, const Eigen::Affine3f & extrinsic,
+  const Eigen::Vector3f & motion)
+{
+  // G maps a point (x,y) on the ground of base_link into the image.
+  // A point on the ground in camera frame is R^T ([x,y,0] - t)
+  const Eigen::Matrix3f Rt = extrinsic.rotation().transpose();
+  const Eigen::Vector3f t = extrinsic.translation();
+  Eigen::Matrix3f G;
+  G.col(0) = Rt.col(0);
+  G.col(1) = Rt.col(1);
+  G.col(2) = -Rt * t;
+  G = intrinsic * G;
+
+  // M maps a ground point in the previous base_link into the current base_link
+  const float c = std::cos(motion.z());
+  const float s = std::sin(motion.z());
+  Eigen::Matrix3f prev_to_curr;
+  prev_to_curr << c, -s, motion.x(), s, c, motion.y(), 0, 0, 1;
+  const Eigen::Matrix3f M = prev_to_curr.inverse();
+
+  const Eigen::Matrix3f H = G * M * G.inverse();
+  cv::Matx33f cv_H;
+  cv::eigen2cv(H, cv_H);
+  return cv_H;
+}
+
+MaskPropagator::MaskPropagator(int full_segmentation_interval, float change_threshold)
+: full_segmentation_interval_(full_segmentation_interval), change_threshold_(change_threshold)
+{
+}
+
+void MaskPropagator::reset(const cv::Mat & bgr_image, const cv::Mat & road_mask)
+{
+  road_mask.copyTo(last_road_mask_);
+  reference_road_color_ = cv::mean(bgr_image, road_mask);
+  propagated_count_ = 0;
+}
+
+bool MaskPropagator::propagate(
+  const cv::Mat & bgr_image, const cv::Matx33f & homography, cv::Mat & road_mask)
+{
+  if (last_road_mask_.empty()) return false;
+  if (last_road_mask_.size() != bgr_image.size()) return false;
+  if (propagated_count_ + 1 >= full_segmentation_interval_) return false;
+
+  cv::warpPerspective(
+    last_road_mask_, road_mask, homography, bgr_image.size(), cv::INTER_NEAREST,
+    cv::BORDER_CONSTANT, cv::Scalar::all(0));
+
+  // Change detector: If the color under the propagated mask differs from the one at the last full
+  // segmentation, something (e.g. a vehicle) may have entered the road area.
+  if (cv::countNonZero(road_mask) == 0) return false;
+  const cv::Scalar current_road_color = cv::mean(bgr_image, road_mask);
+  if (cv::norm(current_road_color - reference_road_color_) > change_threshold_) return false;
+
+  road_mask.copyTo(last_road_mask_);
+  propagated_count_++;
+  return true;
+}
+
+}  // namespace yabloc::graph_segment
@@ -0,0 +1,123 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graph_segment/road_roi.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+
+namespace yabloc::graph_segment
+{
+RoadRoi::RoadRoi(float max_range, int margin, float max_position_std)
+: max_range_(max_range), margin_(margin), max_position_std_(max_position_std)
+{
+}
+
+void RoadRoi::set_road_area(const pcl::PointCloud<pcl::PointXYZL> & road_area)
+{
+  std::map<uint32_t, std::vector<Eigen::Vector3f>> polygon_map;
+  for (const pcl::PointXYZL & p : road_area) {
+    polygon_map[p.label].push_back(p.getVector3fMap());
+  }
+
+  polygons_.clear();
+  for (auto & [label, polygon] : polygon_map) {
+    if (polygon.size() < 3) continue;
+    polygons_.push_back(std::move(polygon));
+  }
+}
+
+namespace
+{
+// Clip the polygon by the plane z=near in camera frame (Sutherland-Hodgman)
+std::vector<Eigen::Vector3f> clip_by_near_plane(
+  const std::vector<Eigen::Vector3f> & polygon, float near)
+{
+  std::vector<Eigen::Vector3f> clipped;
+  for (size_t i = 0; i < polygon.size(); i++) {
+    const Eigen::Vector3f & prev = polygon[(i + polygon.size() - 1) % polygon.size()];
+    const Eigen::Vector3f & curr = polygon[i];
+    const bool prev_in = prev.z() >= near;
+    const bool curr_in = curr.z() >= near;
+    if (prev_in != curr_in) {
+      const float lambda = (near - prev.z()) / (curr.z() - prev.z());
+      clipped.push_back(prev + lambda * (curr - prev));
+    }
+    if (curr_in) clipped.push_back(curr);
+  }
+  return clipped;
+}
+}  // namespace
+
+std::optional<cv::Rect2i> RoadRoi::estimate(
+  const cv::Size & image_size, const Eigen::Matrix3f & intrinsic,
+  const Eigen::Affine3f & extrinsic, const Eigen::Affine3f & pose, float position_std) const
+{
+  // The projected road area is unreliable unless the pose estimate is converged
+  if (position_std > max_position_std_) return std::nullopt;
+
+  // Polygons closer than this to the camera are clipped, since they are projected unstably
+  constexpr float near = 0.5f;
+
+  const Eigen::Affine3f camera_from_map = (pose * extrinsic).inverse();
+  const Eigen::Vector2f position = pose.translation().topRows(2);
+  const cv::Rect2i image_rect(cv::Point2i(0, 0), image_size);
+
+  std::optional<cv::Rect2i> roi = std::nullopt;
+  std::vector<Eigen::Vector3f> polygon_in_camera;
+  for (const std::vector<Eigen::Vector3f> & polygon : polygons_) {
+    // Skip the polygon whose bounding box is far from base_link
+    Eigen::Vector2f min_xy = polygon.front().topRows(2);
+    Eigen::Vector2f max_xy = min_xy;
+    for (const Eigen::Vector3f & p : polygon) {
+      min_xy = min_xy.cwiseMin(p.topRows(2));
+      max_xy = max_xy.cwiseMax(p.topRows(2));
+    }
+    const Eigen::Vector2f gap = (min_xy - position).cwiseMax(position - max_xy).cwiseMax(0.f);
+    if (gap.norm() > max_range_) continue;
+
+    polygon_in_camera.clear();
+    for (const Eigen::Vector3f & p : polygon) polygon_in_camera.push_back(camera_from_map * p);
+    const std::vector<Eigen::Vector3f> clipped = clip_by_near_plane(polygon_in_camera, near);
+    if (clipped.size() < 3) continue;
+
+    float min_u = std::numeric_limits<float>::max(), min_v = min_u;
+    float max_u = std::numeric_limits<float>::lowest(), max_v = max_u;
+    for (const Eigen::Vector3f & p : clipped) {
+      const Eigen::Vector3f u = intrinsic * p / p.z();
+      min_u = std::min(min_u, u.x());
+      min_v = std::min(min_v, u.y());
+      max_u = std::max(max_u, u.x());
+      max_v = std::max(max_v, u.y());
+    }
+
+    const cv::Point2i top_left(cvFloor(min_u), cvFloor(min_v));
+    const cv::Point2i bottom_right(cvCeil(max_u) + 1, cvCeil(max_v) + 1);
+    const cv::Rect2i rect = cv::Rect2i(top_left, bottom_right) & image_rect;
+    if (rect.empty()) continue;
+
+    roi = roi.has_value() ? (roi.value() | rect) : rect;
+  }
+
+  if (!roi.has_value()) return std::nullopt;
+
+  roi->x -= margin_;
+  roi->y -= margin_;
+  roi->width += 2 * margin_;
+  roi->height += 2 * margin_;
+  return roi.value() & image_rect;
+}
+
+}  // namespace yabloc::graph_segment
@@ -0,0 +1,79 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "graph_segment/label_histogram.hpp"
+#include "legacy_label_histogram.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace graph_segment = yabloc::graph_segment;
+
+// Return the mean time of `func` in milliseconds
+template <typename Func>
+double measure(int iteration, Func && func)
+{
+  using Clock = std::chrono::steady_clock;
+  func();  // warm up
+  const auto begin = Clock::now();
+  for (int i = 0; i < iteration; i++) func();
+  const std::chrono::duration<double, std::milli> elapsed = Clock::now() - begin;
+  return elapsed.count() / iteration;
+}
+
+// Compare the flat table with the former unordered_map and Eigen::MatrixXf histograms.
+// Each frame counts the histograms of all labels and compares every label with one label.
+int main(int argc, char * argv[])
+{
+  const int iteration = argc > 1 ? std::stoi(argv[1]) : 50;
+
+  std::cout << "block labels  legacy[ms]    flat[ms]  speedup" << std::endl;
+  for (const int block_size : {80, 40, 20, 10}) {
+    cv::Mat segmented, bgr_image;
+    make_synthetic_frame(segmented, bgr_image, block_size);
+
+    float legacy_score = 0;
+    const double legacy_ms = measure(iteration, [&]() -> void {
+      const LegacyResult legacy = compute_legacy(segmented, bgr_image);
+      const Eigen::MatrixXf ref_histogram = legacy.histogram_map.at(0).eval();
+      for (const auto & [label, histogram] : legacy.histogram_map) {
+        legacy_score += LegacyHistogram::intersection(ref_histogram, histogram.eval());
+      }
+    });
+
+    graph_segment::LabelHistogram histogram;
+    float flat_score = 0;
+    const double flat_ms = measure(iteration, [&]() -> void {
+      histogram.compute(segmented, bgr_image);
+      for (int label = 0; label < histogram.label_count(); label++) {
+        flat_score += histogram.intersection(0, label);
+      }
+    });
+
+    // The scores also keep the compiler from dropping either loop
+    if (std::abs(legacy_score - flat_score) > 1e-3f * legacy_score) {
+      std::cerr << "scores differ: " << legacy_score << " " << flat_score << std::endl;
+      return 1;
+    }
+
+    std::cout << std::fixed << std::setprecision(2) << std::setw(5) << block_size << std::setw(7)
+              << histogram.label_count() << std::setw(12) << legacy_ms << std::setw(12)
+              << flat_ms << std::setw(8) << legacy_ms / flat_ms << "x" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,81 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Core>
+#include <opencv4/opencv2/core.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+
+// The former map-based implementation. It is kept here as the reference of the flat table.
+struct LegacyHistogram
+{
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  LegacyHistogram(int bin = 10) : bin(bin) { data = Eigen::MatrixXf::Zero(3, bin); }
+
+  Eigen::MatrixXf eval() const { return data / data.sum(); }
+
+  void add(const cv::Vec3b & rgb)
+  {
+    for (int ch = 0; ch < 3; ++ch) {
+      int index = std::clamp(static_cast<int>(rgb[ch] * bin / 255.f), 0, bin - 1);
+      data(ch, index) += 1.0f;
+    }
+  }
+
+  static float intersection(const Eigen::MatrixXf & a, const Eigen::MatrixXf & b)
+  {
+    return a.cwiseMin(b).sum();
+  }
+
+  const int bin;
+  Eigen::MatrixXf data;
+};
+
+struct LegacyResult
+{
+  std::unordered_map<int, LegacyHistogram> histogram_map;
+  std::unordered_map<int, int> count_map;
+};
+
+inline LegacyResult compute_legacy(const cv::Mat & segmented, const cv::Mat & bgr_image)
+{
+  LegacyResult result;
+  for (int h = 0; h < bgr_image.rows; h++) {
+    const int * seg_ptr = segmented.ptr<int>(h);
+    const cv::Vec3b * bgr_ptr = bgr_image.ptr<cv::Vec3b>(h);
+    for (int w = 0; w < bgr_image.cols; w++) {
+      result.count_map[seg_ptr[w]]++;
+      result.histogram_map[seg_ptr[w]].add(bgr_ptr[w]);
+    }
+  }
+  return result;
+}
+
+// Make a label image which consists of rectangular blocks like the output of graph segmentation
+inline void make_synthetic_frame(cv::Mat & segmented, cv::Mat & bgr_image, int block_size)
+{
+  const cv::Size size(800, 600);
+  segmented.create(size, CV_32SC1);
+  bgr_image.create(size, CV_8UC3);
+  cv::randu(bgr_image, cv::Scalar::all(0), cv::Scalar::all(256));
+
+  const int blocks_per_row = (size.width + block_size - 1) / block_size;
+  for (int h = 0; h < size.height; h++) {
+    for (int w = 0; w < size.width; w++) {
+      segmented.at<int>(h, w) = (h / block_size) * blocks_per_row + (w / block_size);
+    }
+  }
+}
@@ -0,0 +1,80 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graph_segment/label_histogram.hpp"
+#include "legacy_label_histogram.hpp"
+
+#include <gtest/gtest.h>
+
+namespace graph_segment = yabloc::graph_segment;
+
+TEST(LabelHistogramTestSuite, sameAsLegacy)
+{
+  cv::Mat segmented, bgr_image;
+  make_synthetic_frame(segmented, bgr_image, 37);
+
+  graph_segment::LabelHistogram histogram;
+  histogram.compute(segmented, bgr_image);
+  const LegacyResult legacy = compute_legacy(segmented, bgr_image);
+
+  ASSERT_EQ(histogram.label_count(), static_cast<int>(legacy.count_map.size()));
+  for (const auto & [label, count] : legacy.count_map) {
+    EXPECT_EQ(histogram.area(label), count);
+  }
+
+  const int reference = 0;
+  const Eigen::MatrixXf ref_histogram = legacy.histogram_map.at(reference).eval();
+  for (int label = 0; label < histogram.label_count(); label++) {
+    const Eigen::MatrixXf query = legacy.histogram_map.at(label).eval();
+    const float expected = LegacyHistogram::intersection(ref_histogram, query);
+    EXPECT_NEAR(histogram.intersection(reference, label), expected, 1e-5f);
+  }
+  EXPECT_NEAR(histogram.intersection(reference, reference), 1.f, 1e-5f);
+}
+
+TEST(LabelHistogramTestSuite, areaOnly)
+{
+  cv::Mat segmented, bgr_image;
+  make_synthetic_frame(segmented, bgr_image, 100);
+
+  graph_segment::LabelHistogram histogram;
+  histogram.compute(segmented);
+  EXPECT_EQ(histogram.label_count(), 48);
+  EXPECT_EQ(histogram.area(0), 100 * 100);
+}
+
+TEST(LabelHistogramTestSuite, typicalLabelCount)
+{
+  // About 300 labels, which is typical for a half-resolution camera image
+  cv::Mat segmented, bgr_image;
+  make_synthetic_frame(segmented, bgr_image, 40);
+
+  float legacy_score = 0;
+  const LegacyResult legacy = compute_legacy(segmented, bgr_image);
+  const Eigen::MatrixXf ref_histogram = legacy.histogram_map.at(0).eval();
+  for (const auto & [label, histogram] : legacy.histogram_map) {
+    legacy_score += LegacyHistogram::intersection(ref_histogram, histogram.eval());
+  }
+
+  // The table is reused across frames
+  graph_segment::LabelHistogram histogram;
+  for (int i = 0; i < 2; i++) {
+    histogram.compute(segmented, bgr_image);
+    float flat_score = 0;
+    for (int label = 0; label < histogram.label_count(); label++) {
+      flat_score += histogram.intersection(0, label);
+    }
+    EXPECT_NEAR(legacy_score, flat_score, 1e-2f);
+  }
+}
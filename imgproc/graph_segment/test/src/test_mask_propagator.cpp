@@ -0,0 +1,162 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graph_segment/mask_propagator.hpp"
+
+#include <opencv4/opencv2/core.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+namespace graph_segment = yabloc::graph_segment;
+
+namespace
+{
+const cv::Size image_size(320, 240);
+
+Eigen::Matrix3f make_intrinsic()
+{
+  Eigen::Matrix3f K;
+  K << 200, 0, 160, 0, 200, 120, 0, 0, 1;
+  return K;
+}
+
+// Camera looking forward at 1.5 m above the ground
+Eigen::Affine3f make_extrinsic()
+{
+  Eigen::Matrix3f R;
+  R.col(0) = -Eigen::Vector3f::UnitY();  // x of camera
+  R.col(1) = -Eigen::Vector3f::UnitZ();  // y of camera
+  R.col(2) = Eigen::Vector3f::UnitX();   // z of camera
+  Eigen::Affine3f extrinsic = Eigen::Affine3f::Identity();
+  extrinsic.linear() = R;
+  extrinsic.translation() = Eigen::Vector3f(0, 0, 1.5f);
+  return extrinsic;
+}
+
+Eigen::Vector2f project(const Eigen::Vector2f & ground)
+{
+  const Eigen::Affine3f extrinsic = make_extrinsic();
+  const Eigen::Vector3f from_camera =
+    extrinsic.inverse() * Eigen::Vector3f(ground.x(), ground.y(), 0);
+  const Eigen::Vector3f uv = make_intrinsic() * from_camera / from_camera.z();
+  return uv.topRows(2);
+}
+
+Eigen::Vector2f transform(const cv::Matx33f & H, const Eigen::Vector2f & uv)
+{
+  const cv::Vec3f v = H * cv::Vec3f(uv.x(), uv.y(), 1);
+  return {v[0] / v[2], v[1] / v[2]};
+}
+
+// Ground point of base_link in the current frame, which was at `ground` in the previous frame
+Eigen::Vector2f move(const Eigen::Vector3f & motion, const Eigen::Vector2f & ground)
+{
+  const Eigen::Rotation2Df rotation(motion.z());
+  return rotation.inverse() * (ground - motion.topRows(2));
+}
+
+// Road mask of the strip x_min < x < x_max and |y| < 2 on the ground
+cv::Mat render_road(float x_min, float x_max)
+{
+  const Eigen::Affine3f extrinsic = make_extrinsic();
+  const Eigen::Matrix3f inv_K = make_intrinsic().inverse();
+  cv::Mat mask = cv::Mat::zeros(image_size, CV_8UC1);
+  for (int v = 0; v < image_size.height; v++) {
+    for (int u = 0; u < image_size.width; u++) {
+      const Eigen::Vector3f ray = extrinsic.linear() * (inv_K * Eigen::Vector3f(u, v, 1));
+      if (ray.z() > -1e-3f) continue;
+      const Eigen::Vector3f ground =
+        extrinsic.translation() - ray * (extrinsic.translation().z() / ray.z());
+      if (x_min < ground.x() && ground.x() < x_max && std::abs(ground.y()) < 2) {
+        mask.at<uchar>(v, u) = 255;
+      }
+    }
+  }
+  return mask;
+}
+}  // namespace
+
+TEST(MaskPropagatorTestSuite, identityWithoutMotion)
+{
+  const cv::Matx33f H = graph_segment::ground_homography(
+    make_intrinsic(), make_extrinsic(), Eigen::Vector3f::Zero());
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      EXPECT_NEAR(H(i, j) / H(2, 2), i == j ? 1.f : 0.f, 1e-4f);
+    }
+  }
+}
+
+TEST(MaskPropagatorTestSuite, groundHomography)
+{
+  const Eigen::Vector3f motion(0.8f, 0.1f, 0.05f);
+  const cv::Matx33f H =
+    graph_segment::ground_homography(make_intrinsic(), make_extrinsic(), motion);
+
+  const std::vector<Eigen::Vector2f> grounds = {{6.f, 1.f}, {10.f, -2.f}, {15.f, 0.f}, {4.f, 3.f}};
+  for (const Eigen::Vector2f & ground : grounds) {
+    const Eigen::Vector2f expected = project(move(motion, ground));
+    const Eigen::Vector2f actual = transform(H, project(ground));
+    EXPECT_NEAR(actual.x(), expected.x(), 1e-2f);
+    EXPECT_NEAR(actual.y(), expected.y(), 1e-2f);
+  }
+}
+
+TEST(MaskPropagatorTestSuite, propagateKnownMotion)
+{
+  const cv::Mat image(image_size, CV_8UC3, cv::Scalar::all(100));
+  graph_segment::MaskPropagator propagator(5, 30.f);
+  propagator.reset(image, render_road(3, 30));
+
+  // Moving 1 m forward, the strip comes closer by 1 m
+  const Eigen::Vector3f motion(1, 0, 0);
+  const cv::Matx33f H =
+    graph_segment::ground_homography(make_intrinsic(), make_extrinsic(), motion);
+  cv::Mat road_mask;
+  ASSERT_TRUE(propagator.propagate(image, H, road_mask));
+
+  const cv::Mat expected = render_road(2, 29);
+  cv::Mat difference;
+  cv::bitwise_xor(road_mask, expected, difference);
+  EXPECT_LT(cv::countNonZero(difference), 0.03 * cv::countNonZero(expected));
+}
+
+TEST(MaskPropagatorTestSuite, fullSegmentationInterval)
+{
+  const cv::Mat image(image_size, CV_8UC3, cv::Scalar::all(100));
+  const cv::Matx33f identity = cv::Matx33f::eye();
+  graph_segment::MaskPropagator propagator(3, 30.f);
+  cv::Mat road_mask;
+
+  // Nothing can be propagated before the first full segmentation
+  EXPECT_FALSE(propagator.propagate(image, identity, road_mask));
+
+  propagator.reset(image, render_road(3, 30));
+  EXPECT_TRUE(propagator.propagate(image, identity, road_mask));
+  EXPECT_TRUE(propagator.propagate(image, identity, road_mask));
+  EXPECT_FALSE(propagator.propagate(image, identity, road_mask));
+}
+
+TEST(MaskPropagatorTestSuite, detectChange)
+{
+  graph_segment::MaskPropagator propagator(5, 30.f);
+  propagator.reset(cv::Mat(image_size, CV_8UC3, cv::Scalar::all(100)), render_road(3, 30));
+
+  cv::Mat road_mask;
+  const cv::Mat changed(image_size, CV_8UC3, cv::Scalar(100, 200, 100));
+  EXPECT_FALSE(propagator.propagate(changed, cv::Matx33f::eye(), road_mask));
+}
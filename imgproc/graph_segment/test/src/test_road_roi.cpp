@@ -0,0 +1,122 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graph_segment/road_roi.hpp"
+
+#include <gtest/gtest.h>
+
+namespace graph_segment = yabloc::graph_segment;
+
+namespace
+{
+const cv::Size image_size(320, 240);
+
+Eigen::Matrix3f make_intrinsic()
+{
+  Eigen::Matrix3f K;
+  K << 200, 0, 160, 0, 200, 120, 0, 0, 1;
+  return K;
+}
+
+// Camera looking forward at 1.5 m above the ground
+Eigen::Affine3f make_extrinsic()
+{
+  Eigen::Matrix3f R;
+  R.col(0) = -Eigen::Vector3f::UnitY();  // x of camera
+  R.col(1) = -Eigen::Vector3f::UnitZ();  // y of camera
+  R.col(2) = Eigen::Vector3f::UnitX();   // z of camera
+  Eigen::Affine3f extrinsic = Eigen::Affine3f::Identity();
+  extrinsic.linear() = R;
+  extrinsic.translation() = Eigen::Vector3f(0, 0, 1.5f);
+  return extrinsic;
+}
+
+Eigen::Affine3f make_pose(float x, float y)
+{
+  Eigen::Affine3f pose = Eigen::Affine3f::Identity();
+  pose.translation() = Eigen::Vector3f(x, y, 0);
+  return pose;
+}
+
+// Road of 5 m < x < 20 m and |y| < 2 m in map
+graph_segment::RoadRoi make_road_roi(int margin)
+{
+  pcl::PointCloud<pcl::PointXYZL> road_area;
+  auto add = [&road_area](float x, float y) {
+    pcl::PointXYZL p;
+    p.x = x;
+    p.y = y;
+    p.z = 0;
+    p.label = 1;
+    road_area.push_back(p);
+  };
+  add(5, -2);
+  add(20, -2);
+  add(20, 2);
+  add(5, 2);
+
+  graph_segment::RoadRoi road_roi(50.f, margin, 1.0f);
+  road_roi.set_road_area(road_area);
+  return road_roi;
+}
+}  // namespace
+
+TEST(RoadRoiTestSuite, projectRoad)
+{
+  const graph_segment::RoadRoi road_roi = make_road_roi(10);
+  ASSERT_TRUE(road_roi.has_road_area());
+
+  // The near corners are at u = 160 -+ 200 * 2 / 5 and v = 120 + 200 * 1.5 / 5, and the far
+  // corners are at v = 120 + 200 * 1.5 / 20.
+  const std::optional<cv::Rect2i> roi = road_roi.estimate(
+    image_size, make_intrinsic(), make_extrinsic(), make_pose(0, 0), 0.1f);
+  ASSERT_TRUE(roi.has_value());
+  EXPECT_NEAR(roi->x, 80 - 10, 1);
+  EXPECT_NEAR(roi->y, 135 - 10, 1);
+  EXPECT_NEAR(roi->br().x, 241 + 10, 1);
+  EXPECT_NEAR(roi->br().y, 181 + 10, 1);
+}
+
+TEST(RoadRoiTestSuite, clipNearPlane)
+{
+  // The road starts behind the camera, so it reaches the bottom and both sides of the image
+  const graph_segment::RoadRoi road_roi = make_road_roi(0);
+  const std::optional<cv::Rect2i> roi = road_roi.estimate(
+    image_size, make_intrinsic(), make_extrinsic(), make_pose(10, 0), 0.1f);
+  ASSERT_TRUE(roi.has_value());
+  EXPECT_EQ(roi->x, 0);
+  EXPECT_EQ(roi->br().x, image_size.width);
+  EXPECT_EQ(roi->br().y, image_size.height);
+  EXPECT_NEAR(roi->y, 120 + 200 * 1.5 / 10, 1);
+}
+
+TEST(RoadRoiTestSuite, fallbackToFullImage)
+{
+  const graph_segment::RoadRoi road_roi = make_road_roi(10);
+
+  // The pose estimate has not converged yet
+  EXPECT_FALSE(road_roi
+                 .estimate(image_size, make_intrinsic(), make_extrinsic(), make_pose(0, 0), 5.0f)
+                 .has_value());
+
+  // The road is out of the range
+  EXPECT_FALSE(road_roi
+                 .estimate(image_size, make_intrinsic(), make_extrinsic(), make_pose(-100, 0), 0.1f)
+                 .has_value());
+
+  // The road is behind the camera
+  EXPECT_FALSE(road_roi
+                 .estimate(image_size, make_intrinsic(), make_extrinsic(), make_pose(30, 0), 0.1f)
+                 .has_value());
+}
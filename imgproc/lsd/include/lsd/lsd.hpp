@@ -18,6 +18,8 @@
 #include <opencv4/opencv2/core/eigen.hpp>
 #include <opencv4/opencv2/imgproc.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <yabloc_common/fixed_image.hpp>
+#include <yabloc_common/frame_buffer_pool.hpp>
 
 #include <sensor_msgs/msg/camera_info.hpp>
 #include <sensor_msgs/msg/compressed_image.hpp>
@@ -42,15 +44,22 @@ public:
   LineSegmentDetector();
 
 private:
-  rclcpp::Subscription<Image>::SharedPtr sub_image_;
+  std::unique_ptr<common::ImageSubscriber> sub_image_;
   rclcpp::Publisher<Image>::SharedPtr pub_image_with_line_segments_;
   rclcpp::Publisher<PointCloud2>::SharedPtr pub_cloud_;
 
   cv::Ptr<cv::LineSegmentDetector> line_segment_detector_;
 
+  enum BufferSlot { GRAY = 0, DRAWN, BUFFER_SLOT_COUNT };
+  common::FrameBufferPool buffer_pool_{BUFFER_SLOT_COUNT};
+
+  // Kept across frames to reuse their capacity
+  cv::Mat lines_;
+  pcl::PointCloud<pcl::PointNormal> line_cloud_;
+
   std::vector<cv::Mat> remove_too_outer_elements(
     const cv::Mat & lines, const cv::Size & size) const;
-  void on_image(const sensor_msgs::msg::Image & msg);
+  void on_image(const common::ImageFrame & frame);
   void execute(const cv::Mat & image, const rclcpp::Time & stamp);
 };
 }  // namespace yabloc::lsd
\ No newline at end of file
@@ -15,7 +15,7 @@
 #include "lsd/lsd.hpp"
 
 #include <opencv4/opencv2/imgproc.hpp>
-#include <yabloc_common/cv_decompress.hpp>
+#include <yabloc_common/line_segments_msg.hpp>
 #include <yabloc_common/pub_sub.hpp>
 #include <yabloc_common/timer.hpp>
 
@@ -28,8 +28,10 @@ LineSegmentDetector::LineSegmentDetector() : Node("line_detector")
   using std::placeholders::_1;
 
   // Subscriber
+  // The image is received as FixedImage if the middleware can loan it
   auto cb_image = std::bind(&LineSegmentDetector::on_image, this, _1);
-  sub_image_ = create_subscription<Image>("src_image", 10, cb_image);
+  sub_image_ = std::make_unique<common::ImageSubscriber>(
+    this, "src_image", declare_parameter<bool>("use_fixed_image", false), cb_image);
 
   // Publisher
   pub_image_with_line_segments_ = create_publisher<Image>("image_with_line_segments", 10);
@@ -38,29 +40,37 @@ LineSegmentDetector::LineSegmentDetector() : Node("line_detector")
   line_segment_detector_ = cv::createLineSegmentDetector(cv::LSD_REFINE_STD, 0.8, 0.6, 2.0, 22.5, 0, 0.7, 1024);
 }
 
-void LineSegmentDetector::on_image(const sensor_msgs::msg::Image & msg)
+void LineSegmentDetector::on_image(const common::ImageFrame & frame)
 {
-  cv::Mat image = common::decompress_to_cv_mat(msg);
-  execute(image, msg.header.stamp);
+  // The image is read directly from the received message
+  if (frame.image.type() != CV_8UC3) {
+    RCLCPP_WARN_STREAM(get_logger(), "lsd accepts only bgr8 image");
+    return;
+  }
+  buffer_pool_.reserve(frame.image.size());
+  execute(frame.image, frame.header.stamp);
 }
 
 void LineSegmentDetector::execute(const cv::Mat & image, const rclcpp::Time & stamp)
 {
-  cv::Mat gray_image;
+  cv::Mat & gray_image = buffer_pool_.buffer(GRAY, CV_8UC1);
   cv::cvtColor(image, gray_image, cv::COLOR_BGR2GRAY);
 
-  cv::Mat lines;
   {
     common::Timer timer;
-    line_segment_detector_->detect(gray_image, lines);
-    line_segment_detector_->drawSegments(gray_image, lines);
+    line_segment_detector_->detect(gray_image, lines_);
     RCLCPP_INFO_STREAM(this->get_logger(), "lsd: " << timer);
   }
 
-  common::publish_image(*pub_image_with_line_segments_, gray_image, stamp);
+  // NOTE: drawSegments() converts 1-channel image into 3-channel one by itself.
+  // It is done in another buffer to avoid re-allocating the gray buffer every frame.
+  cv::Mat & drawn_image = buffer_pool_.buffer(DRAWN, CV_8UC3);
+  cv::cvtColor(gray_image, drawn_image, cv::COLOR_GRAY2BGR);
+  line_segment_detector_->drawSegments(drawn_image, lines_);
+  common::publish_image(*pub_image_with_line_segments_, drawn_image, stamp);
 
-  pcl::PointCloud<pcl::PointNormal> line_cloud;
-  std::vector<cv::Mat> filtered_lines = remove_too_outer_elements(lines, image.size());
+  line_cloud_.clear();
+  std::vector<cv::Mat> filtered_lines = remove_too_outer_elements(lines_, image.size());
 
   for (const cv::Mat & xy_xy : filtered_lines) {
     Eigen::Vector3f xy1, xy2;
@@ -69,9 +79,9 @@ void LineSegmentDetector::execute(const cv::Mat & image, const rclcpp::Time & st
     pcl::PointNormal pn;
     pn.getVector3fMap() = xy1;
     pn.getNormalVector3fMap() = xy2;
-    line_cloud.push_back(pn);
+    line_cloud_.push_back(pn);
   }
-  common::publish_cloud(*pub_cloud_, line_cloud, stamp);
+  common::publish_line_segments(*pub_cloud_, line_cloud_, stamp);
 }
 
 std::vector<cv::Mat> LineSegmentDetector::remove_too_outer_elements(
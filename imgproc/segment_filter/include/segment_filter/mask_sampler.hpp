@@ -0,0 +1,35 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <opencv4/opencv2/core.hpp>
+
+namespace yabloc::segment_filter
+{
+/**
+ * Check whether a line segment lies on the mask by walking its pixels directly
+ *
+ * The pixels are the same as cv::line(..., LINE_4) would draw, and a pixel is regarded as masked
+ * if its value is greater than 1. The walk terminates as soon as the result is determined, so the
+ * cost is at most proportional to the length of the segment.
+ *
+ * @param[in] mask CV_8UC1 image
+ * @param[in] p1 end point of the segment
+ * @param[in] p2 another end point of the segment
+ * @param[in] min_ratio required ratio of masked pixels. If it is 0, a single pixel is enough.
+ * @return true if the ratio of masked pixels reaches min_ratio
+ */
+bool is_segment_on_mask(
+  const cv::Mat & mask, const cv::Point2i & p1, const cv::Point2i & p2, float min_ratio = 0.f);
+}  // namespace yabloc::segment_filter
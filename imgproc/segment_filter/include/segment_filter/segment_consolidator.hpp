@@ -0,0 +1,55 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+namespace yabloc::segment_filter
+{
+/**
+ * Merge fragments of the same painted line on the ground plane
+ *
+ * Each segment is represented as a PointNormal whose xyz and normal_xyz are its end points.
+ * Longer segments are taken first as anchors, and the nearly collinear segments which overlap or
+ * nearly touch the anchor are absorbed into it. Duplicated segments are absorbed as well.
+ */
+class SegmentConsolidator
+{
+public:
+  /**
+   * @param[in] angle_threshold_deg maximum angle between an anchor and a fragment
+   * @param[in] lateral_threshold maximum distance [m] from the anchor line to fragment end points
+   * @param[in] gap_threshold maximum gap [m] between an anchor and a fragment along the line
+   */
+  SegmentConsolidator(float angle_threshold_deg, float lateral_threshold, float gap_threshold);
+
+  pcl::PointCloud<pcl::PointNormal> consolidate(
+    const pcl::PointCloud<pcl::PointNormal> & segments) const;
+
+private:
+  const float cos_threshold_;
+  const float lateral_threshold_;
+  const float gap_threshold_;
+};
+
+/**
+ * Keep segments until their total length reaches max_total_length
+ *
+ * Segments are prioritized by reliability (larger label first) and then by the distance from
+ * base_link (nearer first). If max_total_length is not positive, all segments are kept.
+ */
+pcl::PointCloud<pcl::PointXYZLNormal> cap_total_length(
+  const pcl::PointCloud<pcl::PointXYZLNormal> & segments, float max_total_length);
+}  // namespace yabloc::segment_filter
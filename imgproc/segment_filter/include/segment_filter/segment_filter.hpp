@@ -13,11 +13,17 @@
 // limitations under the License.
 
 #pragma once
+#include "segment_filter/segment_consolidator.hpp"
+
 #include <opencv4/opencv2/core.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <yabloc_common/camera_info_subscriber.hpp>
+#include <yabloc_common/exact_synchro_subscriber.hpp>
+#include <yabloc_common/fixed_image.hpp>
+#include <yabloc_common/ground_projection_lut.hpp>
+#include <yabloc_common/line_segments_msg.hpp>
 #include <yabloc_common/static_tf_subscriber.hpp>
-#include <yabloc_common/synchro_subscriber.hpp>
+#include <yabloc_common/status_reporter.hpp>
 
 #include <sensor_msgs/msg/camera_info.hpp>
 #include <sensor_msgs/msg/image.hpp>
@@ -34,38 +40,52 @@ class SegmentFilter : public rclcpp::Node
 public:
   using PointCloud2 = sensor_msgs::msg::PointCloud2;
   using Image = sensor_msgs::msg::Image;
+  using ImageFrame = common::ImageFrame;
+  using Synchronizer = common::ExactStampSynchronizer<PointCloud2, ImageFrame>;
 
   SegmentFilter();
 
 private:
-  using ProjectFunc = std::function<std::optional<Eigen::Vector3f>(const Eigen::Vector3f &)>;
   const int image_size_;
   const float max_range_;
   const float min_segment_length_;
   const float max_segment_distance_;
   const float max_lateral_distance_;
+  const float min_mask_ratio_;
+  const float max_total_length_;
 
   common::CameraInfoSubscriber info_;
-  common::SynchroSubscriber<PointCloud2, Image> synchro_subscriber_;
+  Synchronizer synchronizer_;
   common::StaticTfSubscriber tf_subscriber_;
 
+  rclcpp::Subscription<PointCloud2>::SharedPtr sub_line_segments_;
+  std::unique_ptr<common::ImageSubscriber> sub_mask_image_;
+
   rclcpp::Publisher<PointCloud2>::SharedPtr pub_projected_cloud_;
   rclcpp::Publisher<PointCloud2>::SharedPtr pub_debug_cloud_;
   rclcpp::Publisher<Image>::SharedPtr pub_image_;
 
-  ProjectFunc project_func_ = nullptr;
+  std::unique_ptr<SegmentConsolidator> consolidator_{nullptr};
+
+  // Recorded per frame and published at 1 Hz
+  std::unique_ptr<common::StatusReporter> status_;
+  size_t status_raw_count_index_;
+  size_t status_consolidated_count_index_;
+
+  common::GroundProjectionLut projection_lut_;
 
-  // Return true if success to define or already defined
-  bool define_project_func();
+  // Return true if the look-up table is ready. It is rebuilt only when camera_info or tf changes.
+  bool update_projection_lut();
 
   pcl::PointCloud<pcl::PointNormal> project_lines(
-    const pcl::PointCloud<pcl::PointNormal> & lines, const std::set<int> & indices,
+    const common::LineSegmentsView & lines, const std::set<int> & indices,
     bool negative = false) const;
 
-  std::set<int> filt_by_mask(const cv::Mat & mask, const pcl::PointCloud<pcl::PointNormal> & edges);
+  std::set<int> filt_by_mask(const cv::Mat & mask, const common::LineSegmentsView & edges) const;
 
   cv::Point2i to_cv_point(const Eigen::Vector3f & v) const;
-  void execute(const PointCloud2 & msg1, const Image & msg2);
+  void on_mask_image(const ImageFrame & frame);
+  void execute(const PointCloud2 & msg1, const ImageFrame & msg2);
 
   bool is_near_element(const pcl::PointNormal & pn, pcl::PointNormal & truncated_pn) const;
 };
@@ -0,0 +1,45 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "segment_filter/mask_sampler.hpp"
+
+#include <opencv4/opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace yabloc::segment_filter
+{
+bool is_segment_on_mask(
+  const cv::Mat & mask, const cv::Point2i & p1, const cv::Point2i & p2, float min_ratio)
+{
+  if (mask.type() != CV_8UC1) throw std::runtime_error("mask must be CV_8UC1");
+
+  // NOTE: cv::line(LINE_4) iterates exactly this way, including clipping by the image border
+  cv::LineIterator it(mask, p1, p2, 4, true);
+  const int count = it.count;
+  if (count == 0) return false;
+
+  const int required = std::max(1, static_cast<int>(std::ceil(min_ratio * count)));
+  int masked = 0;
+  for (int i = 0; i < count; i++, ++it) {
+    if (**it > 1) masked++;
+    if (masked >= required) return true;
+    // Even if all the remaining pixels are masked, the ratio does not reach
+    if (masked + (count - i - 1) < required) return false;
+  }
+  return false;
+}
+}  // namespace yabloc::segment_filter
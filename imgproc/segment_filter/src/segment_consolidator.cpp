@@ -0,0 +1,130 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "segment_filter/segment_consolidator.hpp"
+
+#include <Eigen/Core>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace yabloc::segment_filter
+{
+SegmentConsolidator::SegmentConsolidator(
+  float angle_threshold_deg, float lateral_threshold, float gap_threshold)
+: cos_threshold_(std::cos(angle_threshold_deg * M_PI / 180.f)),
+  lateral_threshold_(lateral_threshold),
+  gap_threshold_(gap_threshold)
+{
+}
+
+pcl::PointCloud<pcl::PointNormal> SegmentConsolidator::consolidate(
+  const pcl::PointCloud<pcl::PointNormal> & segments) const
+{
+  const size_t N = segments.size();
+  std::vector<float> lengths(N);
+  for (size_t i = 0; i < N; i++) {
+    const auto & pn = segments.at(i);
+    lengths[i] = (pn.getNormalVector3fMap() - pn.getVector3fMap()).norm();
+  }
+
+  // Longer segments are more reliable as anchors
+  std::vector<size_t> order(N);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&lengths](size_t a, size_t b) {
+    return lengths[a] > lengths[b];
+  });
+
+  pcl::PointCloud<pcl::PointNormal> consolidated;
+  std::vector<bool> absorbed(N, false);
+  for (size_t i : order) {
+    if (absorbed[i]) continue;
+    absorbed[i] = true;
+    if (lengths[i] < 1e-3f) continue;
+
+    const Eigen::Vector3f origin = segments.at(i).getVector3fMap();
+    const Eigen::Vector3f direction = (segments.at(i).getNormalVector3fMap() - origin) / lengths[i];
+    float t_min = 0;
+    float t_max = lengths[i];
+
+    // Repeat until nothing is absorbed, since an extended anchor may reach further fragments
+    bool extended = true;
+    while (extended) {
+      extended = false;
+      for (size_t j : order) {
+        if (absorbed[j] || lengths[j] < 1e-3f) continue;
+
+        const Eigen::Vector3f from = segments.at(j).getVector3fMap() - origin;
+        const Eigen::Vector3f to = segments.at(j).getNormalVector3fMap() - origin;
+        const float cos_angle = std::abs(direction.dot(to - from)) / lengths[j];
+        if (cos_angle < cos_threshold_) continue;
+
+        const float t_from = direction.dot(from);
+        const float t_to = direction.dot(to);
+        if ((from - t_from * direction).norm() > lateral_threshold_) continue;
+        if ((to - t_to * direction).norm() > lateral_threshold_) continue;
+
+        const float t_lower = std::min(t_from, t_to);
+        const float t_upper = std::max(t_from, t_to);
+        if (t_lower > t_max + gap_threshold_ || t_upper < t_min - gap_threshold_) continue;
+
+        absorbed[j] = true;
+        extended |= (t_lower < t_min || t_upper > t_max);
+        t_min = std::min(t_min, t_lower);
+        t_max = std::max(t_max, t_upper);
+      }
+    }
+
+    pcl::PointNormal pn;
+    pn.getVector3fMap() = origin + t_min * direction;
+    pn.getNormalVector3fMap() = origin + t_max * direction;
+    consolidated.push_back(pn);
+  }
+  return consolidated;
+}
+
+pcl::PointCloud<pcl::PointXYZLNormal> cap_total_length(
+  const pcl::PointCloud<pcl::PointXYZLNormal> & segments, float max_total_length)
+{
+  if (max_total_length <= 0) return segments;
+
+  std::vector<float> distances(segments.size());
+  for (size_t i = 0; i < segments.size(); i++) {
+    const auto & pn = segments.at(i);
+    distances[i] = std::min(pn.getVector3fMap().norm(), pn.getNormalVector3fMap().norm());
+  }
+
+  std::vector<size_t> order(segments.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&segments, &distances](size_t a, size_t b) {
+    if (segments.at(a).label != segments.at(b).label) {
+      return segments.at(a).label > segments.at(b).label;
+    }
+    return distances[a] < distances[b];
+  });
+
+  pcl::PointCloud<pcl::PointXYZLNormal> capped;
+  float total_length = 0;
+  for (size_t i : order) {
+    const auto & pn = segments.at(i);
+    total_length += (pn.getNormalVector3fMap() - pn.getVector3fMap()).norm();
+    if (total_length > max_total_length) break;
+    capped.push_back(pn);
+  }
+  return capped;
+}
+
+}  // namespace yabloc::segment_filter
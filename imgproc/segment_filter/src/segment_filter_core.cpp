@@ -14,13 +14,17 @@
 
 #include "segment_filter/segment_filter.hpp"
 
+#include "segment_filter/mask_sampler.hpp"
+
 #include <opencv4/opencv2/core.hpp>
 #include <opencv4/opencv2/imgproc.hpp>
-#include <yabloc_common/cv_decompress.hpp>
+#include <yabloc_common/line_segments_msg.hpp>
 #include <yabloc_common/pub_sub.hpp>
 
 #include <pcl_conversions/pcl_conversions.h>
 
+#include <optional>
+
 namespace yabloc::segment_filter
 {
 SegmentFilter::SegmentFilter()
@@ -30,18 +34,41 @@ SegmentFilter::SegmentFilter()
   min_segment_length_(declare_parameter<float>("min_segment_length", -1)),
   max_segment_distance_(declare_parameter<float>("max_segment_distance", -1)),
   max_lateral_distance_(declare_parameter<float>("max_lateral_distance", -1)),
+  min_mask_ratio_(declare_parameter<float>("min_mask_ratio", 0.f)),
+  max_total_length_(declare_parameter<float>("max_total_length", -1)),
   info_(this),
-  synchro_subscriber_(this, "line_segments_cloud", "mask_image"),
+  synchronizer_(declare_parameter<int>("synchro_capacity", Synchronizer::DEFAULT_CAPACITY)),
   tf_subscriber_(this->get_clock())
 {
   using std::placeholders::_1;
   using std::placeholders::_2;
   auto cb = std::bind(&SegmentFilter::execute, this, _1, _2);
-  synchro_subscriber_.set_callback(std::move(cb));
+  synchronizer_.set_callback(std::move(cb));
+
+  auto on_line_segments = [this](PointCloud2::ConstSharedPtr msg) { synchronizer_.add(msg); };
+  auto on_mask_image = std::bind(&SegmentFilter::on_mask_image, this, _1);
+  sub_line_segments_ =
+    create_subscription<PointCloud2>("line_segments_cloud", 10, std::move(on_line_segments));
+  sub_mask_image_ = std::make_unique<common::ImageSubscriber>(
+    this, "mask_image", declare_parameter<bool>("use_fixed_image", false),
+    std::move(on_mask_image));
 
   pub_projected_cloud_ = create_publisher<PointCloud2>("projected_line_segments_cloud", 10);
   pub_debug_cloud_ = create_publisher<PointCloud2>("debug/line_segments_cloud", 10);
   pub_image_ = create_publisher<Image>("projected_image", 10);
+
+  // Merge fragments of the same painted line on the ground
+  if (declare_parameter<bool>("consolidate_segments", false)) {
+    consolidator_ = std::make_unique<SegmentConsolidator>(
+      declare_parameter<float>("merge_angle_threshold_deg", 3.f),
+      declare_parameter<float>("merge_lateral_threshold", 0.1f),
+      declare_parameter<float>("merge_gap_threshold", 0.2f));
+  }
+
+  status_ =
+    std::make_unique<common::StatusReporter>(this, "consolidation_status", "Segment filter");
+  status_raw_count_index_ = status_->add("segments before", 0);
+  status_consolidated_count_index_ = status_->add("segments after", 0);
 }
 
 cv::Point2i SegmentFilter::to_cv_point(const Eigen::Vector3f & v) const
@@ -52,58 +79,83 @@ cv::Point2i SegmentFilter::to_cv_point(const Eigen::Vector3f & v) const
   return pt;
 }
 
-bool SegmentFilter::define_project_func()
+void SegmentFilter::on_mask_image(const ImageFrame & frame)
 {
-  if (project_func_) return true;
+  // The frame refers to the received message, which is valid only in this callback.
+  // It is stored without copy only if its line segments are waiting and it is paired at once.
+  auto stored = std::make_shared<ImageFrame>(frame);
+  if (!synchronizer_.is_waiting(frame.header.stamp)) stored->image = frame.image.clone();
+  synchronizer_.add(ImageFrame::ConstSharedPtr(std::move(stored)));
+}
 
+bool SegmentFilter::update_projection_lut()
+{
   if (info_.is_camera_info_nullopt()) return false;
-  Eigen::Matrix3f Kinv = info_.intrinsic().inverse();
 
   std::optional<Eigen::Affine3f> camera_extrinsic =
     tf_subscriber_(info_.get_frame_id(), "base_link");
   if (!camera_extrinsic.has_value()) return false;
 
-  const Eigen::Vector3f t = camera_extrinsic->translation();
-  const Eigen::Quaternionf q(camera_extrinsic->rotation());
-
-  // TODO: This will take into account ground tilt and camera vibration someday.
-  project_func_ = [Kinv, q, t](const Eigen::Vector3f & u) -> std::optional<Eigen::Vector3f> {
-    Eigen::Vector3f u3(u.x(), u.y(), 1);
-    Eigen::Vector3f u_bearing = (q * Kinv * u3).normalized();
-    if (u_bearing.z() > -0.01) return std::nullopt;
-    float u_distance = -t.z() / u_bearing.z();
-    Eigen::Vector3f v;
-    v.x() = t.x() + u_bearing.x() * u_distance;
-    v.y() = t.y() + u_bearing.y() * u_distance;
-    v.z() = 0;
-    return v;
-  };
+  const Eigen::Vector2i size = info_.size();
+  projection_lut_.update(cv::Size(size.x(), size.y()), info_.intrinsic(), *camera_extrinsic);
   return true;
 }
 
-void SegmentFilter::execute(const PointCloud2 & line_segments_msg, const Image & segment_msg)
+void SegmentFilter::execute(const PointCloud2 & line_segments_msg, const ImageFrame & mask_frame)
 {
-  if (!define_project_func()) {
+  if (!update_projection_lut()) {
     using namespace std::literals::chrono_literals;
     RCLCPP_INFO_STREAM_THROTTLE(
-      get_logger(), *get_clock(), (1000ms).count(), "project_func cannot be defined");
+      get_logger(), *get_clock(), (1000ms).count(), "projection LUT cannot be built");
     return;
   }
 
   const rclcpp::Time stamp = line_segments_msg.header.stamp;
 
-  pcl::PointCloud<pcl::PointNormal>::Ptr line_segments_cloud{new pcl::PointCloud<pcl::PointNormal>()};
-  cv::Mat mask_image = common::decompress_to_cv_mat(segment_msg);
-  pcl::fromROSMsg(line_segments_msg, *line_segments_cloud);
+  {
+    const auto & counter = synchronizer_.counter();
+    if (counter.unmatched + counter.dropped > 0) {
+      using namespace std::literals::chrono_literals;
+      RCLCPP_WARN_STREAM_THROTTLE(
+        get_logger(), *get_clock(), (10000ms).count(),
+        "synchronization matched: " << counter.matched << " unmatched: " << counter.unmatched
+                                    << " dropped: " << counter.dropped);
+    }
+  }
+
+  // The mask is mono8, and is read directly from the received buffer or its copy
+  const cv::Mat & mask_image = mask_frame.image;
+  if (mask_image.type() != CV_8UC1) {
+    RCLCPP_WARN_STREAM(get_logger(), "mask image must be mono8");
+    return;
+  }
+
+  // Line segments are read directly from the received buffer
+  std::optional<common::LineSegmentsView> opt_line_segments;
+  try {
+    opt_line_segments.emplace(line_segments_msg);
+  } catch (const std::runtime_error & e) {
+    using namespace std::literals::chrono_literals;
+    RCLCPP_WARN_STREAM_THROTTLE(
+      get_logger(), *get_clock(), (1000ms).count(), "drop line segments: " << e.what());
+    return;
+  }
+  const common::LineSegmentsView & line_segments = opt_line_segments.value();
+
+  const std::set<int> indices = filt_by_mask(mask_image, line_segments);
 
-  const std::set<int> indices = filt_by_mask(mask_image, *line_segments_cloud);
+  pcl::PointCloud<pcl::PointNormal> valid_edges = project_lines(line_segments, indices);
+  pcl::PointCloud<pcl::PointNormal> invalid_edges = project_lines(line_segments, indices, true);
 
-  pcl::PointCloud<pcl::PointNormal> valid_edges = project_lines(*line_segments_cloud, indices);
-  pcl::PointCloud<pcl::PointNormal> invalid_edges = project_lines(*line_segments_cloud, indices, true);
+  const size_t raw_count = valid_edges.size() + invalid_edges.size();
+  if (consolidator_) {
+    valid_edges = consolidator_->consolidate(valid_edges);
+    invalid_edges = consolidator_->consolidate(invalid_edges);
+  }
 
   // Projected line segments
+  pcl::PointCloud<pcl::PointXYZLNormal> combined_edges;
   {
-    pcl::PointCloud<pcl::PointXYZLNormal> combined_edges;
     for (const auto & pn : valid_edges) {
       pcl::PointXYZLNormal pln;
       pln.getVector3fMap() = pn.getVector3fMap();
@@ -118,21 +170,24 @@ void SegmentFilter::execute(const PointCloud2 & line_segments_msg, const Image &
       pln.label = 0;
       combined_edges.push_back(pln);
     }
-    common::publish_cloud(*pub_projected_cloud_, combined_edges, stamp);
+    combined_edges = cap_total_length(combined_edges, max_total_length_);
+    common::publish_line_segments(*pub_projected_cloud_, combined_edges, stamp);
   }
 
+  // Statistics of consolidation
+  status_->set(status_raw_count_index_, raw_count);
+  status_->set(status_consolidated_count_index_, combined_edges.size());
+
   // Image
   {
     cv::Mat projected_image = cv::Mat::zeros(cv::Size{image_size_, image_size_}, CV_8UC3);
-    for (auto & pn : valid_edges) {
-      cv::Point2i p1 = to_cv_point(pn.getVector3fMap());
-      cv::Point2i p2 = to_cv_point(pn.getNormalVector3fMap());
-      cv::line(projected_image, p1, p2, cv::Scalar(100, 100, 255), 4, cv::LineTypes::LINE_8);
-    }
-    for (auto & pn : invalid_edges) {
-      cv::Point2i p1 = to_cv_point(pn.getVector3fMap());
-      cv::Point2i p2 = to_cv_point(pn.getNormalVector3fMap());
-      cv::line(projected_image, p1, p2, cv::Scalar(200, 200, 200), 3, cv::LineTypes::LINE_8);
+    for (auto & pln : combined_edges) {
+      cv::Point2i p1 = to_cv_point(pln.getVector3fMap());
+      cv::Point2i p2 = to_cv_point(pln.getNormalVector3fMap());
+      if (pln.label == 255)
+        cv::line(projected_image, p1, p2, cv::Scalar(100, 100, 255), 4, cv::LineTypes::LINE_8);
+      else
+        cv::line(projected_image, p1, p2, cv::Scalar(200, 200, 200), 3, cv::LineTypes::LINE_8);
     }
     common::publish_image(*pub_image_, projected_image, stamp);
   }
@@ -140,16 +195,15 @@ void SegmentFilter::execute(const PointCloud2 & line_segments_msg, const Image &
   // Line segments for debug
   {
     pcl::PointCloud<pcl::PointXYZLNormal> combined_debug_edges;
-    for (size_t index = 0; index < line_segments_cloud->size(); ++index) {
-      const pcl::PointNormal& pn = line_segments_cloud->at(index);
+    for (size_t index = 0; index < line_segments.size(); ++index) {
       pcl::PointXYZLNormal pln;
-      pln.getVector3fMap() = pn.getVector3fMap();
-      pln.getNormalVector3fMap() = pn.getNormalVector3fMap();
+      pln.getVector3fMap() = line_segments.from(index);
+      pln.getNormalVector3fMap() = line_segments.to(index);
       if (indices.count(index) > 0) pln.label = 255;
       else pln.label = 0;
       combined_debug_edges.push_back(pln);
     }
-    common::publish_cloud(*pub_debug_cloud_, combined_debug_edges, stamp);
+    common::publish_line_segments(*pub_debug_cloud_, combined_debug_edges, stamp);
   }
 }
 
@@ -176,37 +230,19 @@ bool SegmentFilter::is_near_element(
   return true;
 }
 
-std::set<ushort> get_unique_pixel_value(cv::Mat & image)
-{
-  // `image` is a set of ushort.
-  // The purpose is to find the unduplicated set of values contained in `image`.
-  // For example, if `image` is {0,1,2,0,1,2,3}, this function returns {0,1,2,3}.
-
-  if (image.depth() != CV_16U) throw std::runtime_error("image's depth must be ushort");
-
-  auto begin = image.begin<ushort>();
-  auto last = std::unique(begin, image.end<ushort>());
-  std::sort(begin, last);
-  last = std::unique(begin, last);
-  return std::set<ushort>(begin, last);
-}
-
 pcl::PointCloud<pcl::PointNormal> SegmentFilter::project_lines(
-  const pcl::PointCloud<pcl::PointNormal> & points, const std::set<int> & indices,
-  bool negative) const
+  const common::LineSegmentsView & lines, const std::set<int> & indices, bool negative) const
 {
   pcl::PointCloud<pcl::PointNormal> projected_points;
-  for (int index = 0; index < points.size(); ++index) {
+  for (int index = 0; index < static_cast<int>(lines.size()); ++index) {
     if (negative) {
       if (indices.count(index) > 0) continue;
     } else {
       if (indices.count(index) == 0) continue;
     }
 
-    pcl::PointNormal truncated_pn = points.at(index);
-
-    std::optional<Eigen::Vector3f> opt1 = project_func_(truncated_pn.getVector3fMap());
-    std::optional<Eigen::Vector3f> opt2 = project_func_(truncated_pn.getNormalVector3fMap());
+    std::optional<Eigen::Vector3f> opt1 = projection_lut_(lines.from(index));
+    std::optional<Eigen::Vector3f> opt2 = projection_lut_(lines.to(index));
     if (!opt1.has_value()) continue;
     if (!opt2.has_value()) continue;
 
@@ -240,36 +276,16 @@ pcl::PointCloud<pcl::PointNormal> SegmentFilter::project_lines(
 }
 
 std::set<int> SegmentFilter::filt_by_mask(
-  const cv::Mat & mask, const pcl::PointCloud<pcl::PointNormal> & edges)
+  const cv::Mat & mask, const common::LineSegmentsView & edges) const
 {
-  // Create line image and assign different color to each segment.
-  cv::Mat line_image = cv::Mat::zeros(mask.size(), CV_16UC1);
-  for (size_t i = 0; i < edges.size(); i++) {
-    auto & pn = edges.at(i);
-    Eigen::Vector3f p1 = pn.getVector3fMap();
-    Eigen::Vector3f p2 = pn.getNormalVector3fMap();
-    cv::Scalar color = cv::Scalar::all(i + 1);
-    cv::line(
-      line_image, cv::Point2i(p1.x(), p1.y()), cv::Point2i(p2.x(), p2.y()), color, 1,
-      cv::LineTypes::LINE_4);
-  }
-
-  cv::Mat mask_image;
-  mask.convertTo(mask_image, CV_16UC1);
-  cv::threshold(mask_image, mask_image, 1, std::numeric_limits<ushort>::max(), cv::THRESH_BINARY);
-
-  // TODO: Using boost::geometry is more intuitive.
-  // https://boostjp.github.io/tips/geometry.html#disjoint
-
-  // And operator
-  cv::Mat masked_line;
-  cv::bitwise_and(mask_image, line_image, masked_line);
-  std::set<ushort> pixel_values = get_unique_pixel_value(masked_line);
-
   // Extract edges within masks
   std::set<int> reliable_indices;
   for (size_t i = 0; i < edges.size(); i++) {
-    if (pixel_values.count(i + 1) != 0) reliable_indices.insert(i);
+    const auto p1 = edges.from(i);
+    const auto p2 = edges.to(i);
+    cv::Point2i cv_p1(p1.x(), p1.y());
+    cv::Point2i cv_p2(p2.x(), p2.y());
+    if (is_segment_on_mask(mask, cv_p1, cv_p2, min_mask_ratio_)) reliable_indices.insert(i);
   }
 
   return reliable_indices;
@@ -0,0 +1,118 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "segment_filter/mask_sampler.hpp"
+
+#include <opencv4/opencv2/imgproc.hpp>
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace segment_filter = yabloc::segment_filter;
+
+using Segment = std::pair<cv::Point2i, cv::Point2i>;
+
+// The former image-based implementation. It draws all segments with unique values and then
+// collects the values which survive bitwise-and with the mask.
+std::set<int> filt_by_mask_legacy(const cv::Mat & mask, const std::vector<Segment> & segments)
+{
+  cv::Mat line_image = cv::Mat::zeros(mask.size(), CV_16UC1);
+  for (size_t i = 0; i < segments.size(); i++) {
+    cv::Scalar color = cv::Scalar::all(i + 1);
+    cv::line(line_image, segments[i].first, segments[i].second, color, 1, cv::LineTypes::LINE_4);
+  }
+
+  cv::Mat mask_image;
+  mask.convertTo(mask_image, CV_16UC1);
+  cv::threshold(mask_image, mask_image, 1, std::numeric_limits<ushort>::max(), cv::THRESH_BINARY);
+
+  cv::Mat masked_line;
+  cv::bitwise_and(mask_image, line_image, masked_line);
+  std::set<ushort> pixel_values(masked_line.begin<ushort>(), masked_line.end<ushort>());
+
+  std::set<int> reliable_indices;
+  for (size_t i = 0; i < segments.size(); i++) {
+    if (pixel_values.count(i + 1) != 0) reliable_indices.insert(i);
+  }
+  return reliable_indices;
+}
+
+std::set<int> filt_by_mask(const cv::Mat & mask, const std::vector<Segment> & segments)
+{
+  std::set<int> reliable_indices;
+  for (size_t i = 0; i < segments.size(); i++) {
+    if (segment_filter::is_segment_on_mask(mask, segments[i].first, segments[i].second)) {
+      reliable_indices.insert(i);
+    }
+  }
+  return reliable_indices;
+}
+
+TEST(MaskSamplerTestSuite, sameAsLegacy)
+{
+  const cv::Size size(800, 600);
+  cv::RNG rng(0);
+
+  // Road-like mask which consists of some blobs
+  cv::Mat mask = cv::Mat::zeros(size, CV_8UC1);
+  for (int i = 0; i < 20; i++) {
+    cv::Point2i center(rng.uniform(0, size.width), rng.uniform(0, size.height));
+    cv::circle(mask, center, rng.uniform(10, 120), cv::Scalar::all(255), -1);
+  }
+
+  // NOTE: The legacy implementation lets a later segment overwrite an earlier one where they
+  // cross. Each segment is confined to its own horizontal band to compare decisions exactly.
+  constexpr int band_height = 3;
+  std::vector<Segment> segments;
+  for (int top = 0; top + band_height <= size.height; top += band_height) {
+    // Some segments stick out of the image
+    cv::Point2i p1(rng.uniform(-50, size.width + 50), rng.uniform(top, top + band_height));
+    cv::Point2i p2(rng.uniform(-50, size.width + 50), rng.uniform(top, top + band_height));
+    segments.emplace_back(p1, p2);
+  }
+
+  const std::set<int> expected = filt_by_mask_legacy(mask, segments);
+  const std::set<int> actual = filt_by_mask(mask, segments);
+  EXPECT_EQ(expected, actual);
+
+  // Make sure that both decisions appear
+  EXPECT_GT(actual.size(), 0u);
+  EXPECT_LT(actual.size(), segments.size());
+}
+
+TEST(MaskSamplerTestSuite, minRatio)
+{
+  cv::Mat mask = cv::Mat::zeros(cv::Size(100, 100), CV_8UC1);
+  mask.colRange(0, 30).setTo(255);
+
+  // 30 of 100 pixels are masked
+  const cv::Point2i p1(0, 50), p2(99, 50);
+  EXPECT_TRUE(segment_filter::is_segment_on_mask(mask, p1, p2, 0.f));
+  EXPECT_TRUE(segment_filter::is_segment_on_mask(mask, p1, p2, 0.25f));
+  EXPECT_FALSE(segment_filter::is_segment_on_mask(mask, p1, p2, 0.35f));
+  // The direction does not matter
+  EXPECT_FALSE(segment_filter::is_segment_on_mask(mask, p2, p1, 0.35f));
+
+  // Out of the image
+  EXPECT_FALSE(
+    segment_filter::is_segment_on_mask(mask, cv::Point2i(-10, -10), cv::Point2i(-10, 200)));
+
+  // Pixel values equal to 1 are not regarded as masked, the same as the former threshold
+  mask.setTo(1);
+  EXPECT_FALSE(segment_filter::is_segment_on_mask(mask, p1, p2));
+}
@@ -0,0 +1,98 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "segment_filter/segment_consolidator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace segment_filter = yabloc::segment_filter;
+
+template <typename PointT = pcl::PointNormal>
+PointT make_segment(float x1, float y1, float x2, float y2)
+{
+  PointT pn;
+  pn.getVector3fMap() << x1, y1, 0;
+  pn.getNormalVector3fMap() << x2, y2, 0;
+  return pn;
+}
+
+float length(const pcl::PointNormal & pn)
+{
+  return (pn.getNormalVector3fMap() - pn.getVector3fMap()).norm();
+}
+
+TEST(SegmentConsolidatorTestSuite, mergeFragments)
+{
+  segment_filter::SegmentConsolidator consolidator(3.f, 0.1f, 0.2f);
+
+  pcl::PointCloud<pcl::PointNormal> segments;
+  // Fragments of a dashed line along x-axis, one of them is reversed
+  segments.push_back(make_segment(0.0f, 1.0f, 2.0f, 1.0f));
+  segments.push_back(make_segment(3.9f, 1.02f, 2.1f, 1.01f));
+  segments.push_back(make_segment(4.0f, 0.98f, 5.0f, 0.99f));
+  // A duplicate
+  segments.push_back(make_segment(0.5f, 1.0f, 1.5f, 1.0f));
+  // Parallel but another line
+  segments.push_back(make_segment(0.0f, 2.0f, 5.0f, 2.0f));
+  // Too far along the line
+  segments.push_back(make_segment(6.0f, 1.0f, 7.0f, 1.0f));
+  // Crossing
+  segments.push_back(make_segment(1.0f, 0.0f, 1.0f, 3.0f));
+
+  const pcl::PointCloud<pcl::PointNormal> consolidated = consolidator.consolidate(segments);
+  ASSERT_EQ(consolidated.size(), 4u);
+
+  std::vector<float> lengths;
+  for (const auto & pn : consolidated) lengths.push_back(length(pn));
+  std::sort(lengths.begin(), lengths.end());
+  EXPECT_NEAR(lengths.at(0), 1.0f, 1e-2f);
+  EXPECT_NEAR(lengths.at(1), 3.0f, 1e-2f);
+  EXPECT_NEAR(lengths.at(2), 5.0f, 1e-2f);
+  EXPECT_NEAR(lengths.at(3), 5.0f, 1e-2f);
+
+  // Merged one spans all fragments
+  float min_x = 1e3f, max_x = -1e3f;
+  for (const auto & pn : consolidated) {
+    if (std::abs(pn.y - 1.0f) > 0.1f || std::abs(pn.normal_y - 1.0f) > 0.1f) continue;
+    if (length(pn) < 4.f) continue;
+    min_x = std::min({min_x, pn.x, pn.normal_x});
+    max_x = std::max({max_x, pn.x, pn.normal_x});
+  }
+  EXPECT_NEAR(min_x, 0.0f, 1e-2f);
+  EXPECT_NEAR(max_x, 5.0f, 1e-2f);
+}
+
+TEST(SegmentConsolidatorTestSuite, capTotalLength)
+{
+  using PointT = pcl::PointXYZLNormal;
+  pcl::PointCloud<PointT> segments;
+  segments.push_back(make_segment<PointT>(10.f, 0.f, 12.f, 0.f));
+  segments.back().label = 0;
+  segments.push_back(make_segment<PointT>(20.f, 0.f, 22.f, 0.f));
+  segments.back().label = 255;
+  segments.push_back(make_segment<PointT>(5.f, 0.f, 7.f, 0.f));
+  segments.back().label = 255;
+
+  // Not capped
+  EXPECT_EQ(segment_filter::cap_total_length(segments, -1).size(), 3u);
+
+  // Reliable ones first, and then nearer ones
+  const pcl::PointCloud<PointT> capped = segment_filter::cap_total_length(segments, 5.f);
+  ASSERT_EQ(capped.size(), 2u);
+  EXPECT_FLOAT_EQ(capped.at(0).x, 5.f);
+  EXPECT_FLOAT_EQ(capped.at(1).x, 20.f);
+}
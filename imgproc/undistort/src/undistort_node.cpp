@@ -17,15 +17,14 @@
 #include <opencv4/opencv2/imgproc.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <yabloc_common/cv_decompress.hpp>
-#include <yabloc_common/pub_sub.hpp>
+#include <yabloc_common/fixed_image.hpp>
+#include <yabloc_common/frame_buffer_pool.hpp>
 #include <yabloc_common/timer.hpp>
 
 #include <sensor_msgs/msg/camera_info.hpp>
 #include <sensor_msgs/msg/compressed_image.hpp>
 #include <sensor_msgs/msg/image.hpp>
 
-#include <cv_bridge/cv_bridge.h>
-
 #include <optional>
 
 namespace yabloc::undistort
@@ -55,7 +54,9 @@ public:
     sub_info_ = create_subscription<CameraInfo>("src_info", qos, std::move(on_info));
 
     pub_info_ = create_publisher<CameraInfo>("resized_info", 10);
-    pub_image_ = create_publisher<Image>("resized_image", 10);
+    // The image is also published as loaned FixedImage if the middleware can loan it
+    pub_image_ = std::make_unique<common::ImagePublisher>(
+      this, "resized_image", declare_parameter<bool>("use_fixed_image", false));
   }
 
 private:
@@ -64,13 +65,16 @@ private:
 
   rclcpp::Subscription<CompressedImage>::SharedPtr sub_image_;
   rclcpp::Subscription<CameraInfo>::SharedPtr sub_info_;
-  rclcpp::Publisher<Image>::SharedPtr pub_image_;
+  std::unique_ptr<common::ImagePublisher> pub_image_;
   rclcpp::Publisher<CameraInfo>::SharedPtr pub_info_;
   std::optional<CameraInfo> info_{std::nullopt};
   std::optional<CameraInfo> scaled_info_{std::nullopt};
 
   cv::Mat undistort_map_x, undistort_map_y;
 
+  enum BufferSlot { DECOMPRESSED = 0, UNDISTORTED, BUFFER_SLOT_COUNT };
+  common::FrameBufferPool buffer_pool_{BUFFER_SLOT_COUNT};
+
   void make_remap_lut()
   {
     if (!info_.has_value()) return;
@@ -96,6 +100,8 @@ private:
     scaled_info_->d.resize(5);
     scaled_info_->width = new_size.width;
     scaled_info_->height = new_size.height;
+
+    buffer_pool_.reserve(scaled_info_.value());
   }
 
   void on_image(const CompressedImage & msg)
@@ -104,9 +110,12 @@ private:
     if (undistort_map_x.empty()) make_remap_lut();
 
     common::Timer timer;
-    cv::Mat image = common::decompress_to_cv_mat(msg);
+    // NOTE: The decompressed image has the size of the original camera_info, not the resized one
+    cv::Mat & image =
+      buffer_pool_.buffer(DECOMPRESSED, cv::Size(info_->width, info_->height), CV_8UC3);
+    common::decompress_to_cv_mat(msg, image);
 
-    cv::Mat undistorted_image;
+    cv::Mat & undistorted_image = buffer_pool_.buffer(UNDISTORTED, CV_8UC3);
     cv::remap(image, undistorted_image, undistort_map_x, undistort_map_y, cv::INTER_LINEAR);
 
     // Publish CameraInfo
@@ -118,18 +127,12 @@ private:
 
     // Publish Image
     {
-      cv_bridge::CvImage bridge;
-      bridge.header.stamp = msg.header.stamp;
-      if (OVERRIDE_FRAME_ID != "")
-        bridge.header.frame_id = OVERRIDE_FRAME_ID;
-      else
-        bridge.header.frame_id = msg.header.frame_id;
-      bridge.encoding = "bgr8";
-      bridge.image = undistorted_image;
-      pub_image_->publish(*bridge.toImageMsg());
+      std::string frame_id = msg.header.frame_id;
+      if (OVERRIDE_FRAME_ID != "") frame_id = OVERRIDE_FRAME_ID;
+      pub_image_->publish(undistorted_image, msg.header.stamp, frame_id);
     }
 
-    RCLCPP_INFO_STREAM(get_logger(), "image undistort: " << timer);
+    RCLCPP_DEBUG_STREAM(get_logger(), "image undistort: " << timer);
   }
 
   void on_info(const CameraInfo & msg) { info_ = msg; }
@@ -19,6 +19,7 @@
 
 #include <opencv2/core.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <yabloc_common/thread_pool.hpp>
 
 #include <autoware_auto_mapping_msgs/msg/had_map_bin.hpp>
 #include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
@@ -28,6 +29,10 @@
 #include <sensor_msgs/msg/point_cloud2.hpp>
 #include <tier4_localization_msgs/srv/pose_with_covariance_stamped.hpp>
 
+#include <memory>
+#include <string>
+#include <vector>
+
 namespace yabloc
 {
 class CameraPoseInitializer : public rclcpp::Node
@@ -46,6 +51,17 @@ public:
 
 private:
   const int angle_resolution_;
+  // Preprocessed bundle used instead of the vector map if it is made from the same map
+  const std::string map_bundle_path_;
+  // Distance in pixels over which the score of a projected point decreases to 0
+  const float score_max_distance_;
+  // Bisections to refine the best angle of the grid search
+  const int refine_iterations_;
+  // Positions sampled on the ellipse of candidate_sigma_ of the requested covariance, in addition
+  // to the requested position itself
+  const int candidate_count_;
+  const float candidate_sigma_;
+  std::unique_ptr<common::ThreadPool> thread_pool_{nullptr};
   std::unique_ptr<LaneImage> lane_image_{nullptr};
   std::unique_ptr<initializer::MarkerModule> marker_module_{nullptr};
   std::unique_ptr<initializer::ProjectorModule> projector_module_{nullptr};
@@ -60,7 +76,6 @@ private:
   rclcpp::CallbackGroup::SharedPtr service_callback_group_;
 
   std::optional<Image::ConstSharedPtr> latest_image_msg_{std::nullopt};
-  lanelet::ConstLanelets const_lanelets_;
 
   void on_map(const HADMapBin & msg);
   void on_service(
@@ -69,6 +84,10 @@ private:
   PoseCovStamped create_rectified_initial_pose(
     const Eigen::Vector3f & pos, double yaw_angle_rad, const PoseCovStamped & src_msg);
 
-  bool estimate_pose(const Eigen::Vector3f & position, double & yaw_angle_rad, double yaw_std_rad);
+  // Estimate the yaw at each position, and return the position of the best score weighted by
+  // the prior weight of the position
+  bool estimate_pose(
+    const std::vector<Eigen::Vector3f> & positions, const std::vector<float> & prior_weights,
+    double & yaw_angle_rad, double yaw_std_rad, Eigen::Vector3f * best_position);
 };
 }  // namespace yabloc
\ No newline at end of file
@@ -13,12 +13,16 @@
 // limitations under the License.
 
 #pragma once
+#include "camera_pose_initializer/lanelet_util.hpp"
+
 #include <Eigen/Geometry>
+#include <ll2_decomposer/decompose.hpp>
 #include <opencv2/core.hpp>
 
 #include <geometry_msgs/msg/pose.hpp>
 
-#include <lanelet2_core/LaneletMap.h>
+#include <memory>
+#include <vector>
 
 namespace yabloc
 {
@@ -27,13 +31,19 @@ class LaneImage
 public:
   using Pose = geometry_msgs::msg::Pose;
   using SharedPtr = std::shared_ptr<LaneImage>;
-  LaneImage(lanelet::LaneletMapPtr map);
+  using Lane = ll2_decomposer::Lane;
+  explicit LaneImage(std::vector<Lane> lanes);
+
+  // These only read the lanes, so they can be called from several threads at once
+  cv::Mat get_image(const Pose & pose) const;
 
-  cv::Mat get_image(const Pose & pose);
+  cv::Mat create_vectormap_image(const Eigen::Vector3f & position) const;
 
-  cv::Mat create_vectormap_image(const Eigen::Vector3f & position);
+  const std::vector<Lane> & lanes() const { return lanes_; }
+  const LaneIndex & index() const { return index_; }
 
 private:
-  lanelet::LaneletMapPtr map_;
+  std::vector<Lane> lanes_;
+  LaneIndex index_;
 };
 }  // namespace yabloc
\ No newline at end of file
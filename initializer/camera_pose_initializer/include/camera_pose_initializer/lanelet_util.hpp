@@ -13,21 +13,43 @@
 // limitations under the License.
 
 #pragma once
-#include <lanelet2_core/LaneletMap.h>
+#include <Eigen/Core>
+#include <ll2_decomposer/decompose.hpp>
+
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/index/rtree.hpp>
 
 #include <optional>
+#include <utility>
+#include <vector>
 
-// TODO: Reuse autoware_common/lanelet2_extension instead of this
-namespace lanelet
+namespace yabloc
 {
-std::optional<double> get_current_direction(
-  const ConstLanelets & lanelets, const Eigen::Vector3f & query_position);
+using Lane = ll2_decomposer::Lane;
+
+// Return true if the point is inside of the polygon made of the right and left bounds
+bool is_inside(const Lane & lane, const Eigen::Vector2f & point);
+
+// R-tree over the bounding boxes of the lanes, which is built once when the map arrives
+class LaneIndex
+{
+public:
+  explicit LaneIndex(const std::vector<Lane> & lanes);
+
+  // Return the indices of the lanes whose bounding box intersects the box, in ascending order
+  std::vector<size_t> query(const Eigen::Vector2f & min, const Eigen::Vector2f & max) const;
 
-bool get_current_lanelets(
-  const ConstLanelets & lanelets, const Eigen::Vector3f & query_position,
-  ConstLanelets * current_lanelets_ptr);
+private:
+  using BgPoint = boost::geometry::model::point<float, 2, boost::geometry::cs::cartesian>;
+  using BgBox = boost::geometry::model::box<BgPoint>;
+  using Value = std::pair<BgBox, size_t>;
 
-ConstLineString3d get_closest_segment(
-  const lanelet::BasicPoint2d & search_pt, const lanelet::ConstLineString3d & linestring);
+  boost::geometry::index::rtree<Value, boost::geometry::index::rstar<16>> rtree_;
+};
+
+// Return the direction of the centerline segment closest to the position in the lane containing it
+std::optional<double> get_current_direction(
+  const std::vector<Lane> & lanes, const LaneIndex & index, const Eigen::Vector3f & query_position);
 
-}  // namespace lanelet
\ No newline at end of file
+}  // namespace yabloc
@@ -13,10 +13,13 @@
 // limitations under the License.
 
 #pragma once
+#include "camera_pose_initializer/rotation_search.hpp"
+
 #include <Eigen/Core>
 #include <opencv2/core.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <yabloc_common/camera_info_subscriber.hpp>
+#include <yabloc_common/ground_projection_lut.hpp>
 #include <yabloc_common/static_tf_subscriber.hpp>
 
 #include <sensor_msgs/msg/image.hpp>
@@ -26,15 +29,17 @@ namespace yabloc::initializer
 class ProjectorModule
 {
 public:
-  using ProjectFunc = std::function<std::optional<Eigen::Vector3f>(const cv::Point2i &)>;
   ProjectorModule(rclcpp::Node * node);
 
-  bool define_project_func();
+  // Return true if the look-up table is ready. It is rebuilt only when camera_info or tf changes.
+  bool update_projection_lut();
 
-  cv::Mat project_image(const sensor_msgs::msg::Image & image_msg);
+  // Contours of the segmented semantics projected on the ground, in the pixels of the 800x800 image
+  // centered at base_link. Pixels shared by several contour points appear only once.
+  ChannelPoints project_contours(const sensor_msgs::msg::Image & image_msg);
 
 private:
-  ProjectFunc project_func_ = nullptr;
+  common::GroundProjectionLut projection_lut_;
   rclcpp::Logger logger_;
   common::CameraInfoSubscriber info_;
   common::StaticTfSubscriber tf_subscriber_;
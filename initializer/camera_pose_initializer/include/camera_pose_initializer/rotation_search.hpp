@@ -0,0 +1,71 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <opencv2/core.hpp>
+#include <yabloc_common/thread_pool.hpp>
+
+#include <array>
+#include <functional>
+#include <vector>
+
+namespace yabloc::initializer
+{
+// Pixels of the projected semantics for each channel (B, G, R) of the vector map image
+using ChannelPoints = std::array<std::vector<cv::Point2f>, 3>;
+
+/**
+ * Score of the projected points rotated around the image center against the vector map image
+ *
+ * Only the sparse points are rotated instead of the dense image. Each channel of the vector map is
+ * converted to a score map by the distance transform, so that the score is 1 on the drawn pixels
+ * and decreases linearly to 0 at max_distance. The score is the same as the count of the
+ * overlapping pixels when max_distance is 1, and is smooth enough to refine the angle otherwise.
+ */
+class RotationScorer
+{
+public:
+  RotationScorer(const cv::Mat & vectormap_image, float max_distance);
+
+  // The rotation is the same as cv::getRotationMatrix2D() with the angle in degrees
+  float operator()(const ChannelPoints & points, double angle_deg) const;
+
+private:
+  // Empty if nothing is drawn in the channel
+  std::array<cv::Mat, 3> score_maps_;
+  cv::Point2f center_;
+};
+
+struct RotationSearchResult
+{
+  double angle_rad;
+  float score;
+  // Scores of the coarse search, for visualization
+  std::vector<float> scores;
+  std::vector<float> angles_rad;
+};
+
+/**
+ * Search the best angle by the grid of 2 * resolution angles in [center - range, center + range),
+ * and then refine it by bisection around the best grid angle
+ *
+ * The angles are scored on the pool if it is given, so score_function must be thread safe. Ties
+ * are broken by the order of the angles, so the result does not depend on the scheduling.
+ *
+ * @param[in] score_function Score of the angle in radians
+ */
+RotationSearchResult search_rotation(
+  const std::function<float(double)> & score_function, double center_rad, double range_rad,
+  int resolution, int refine_iterations, common::ThreadPool * pool = nullptr);
+}  // namespace yabloc::initializer
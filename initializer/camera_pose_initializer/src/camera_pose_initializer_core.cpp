@@ -15,8 +15,9 @@
 #include "camera_pose_initializer/camera_pose_initializer.hpp"
 #include "camera_pose_initializer/lanelet_util.hpp"
 
+#include <Eigen/Cholesky>
 #include <ll2_decomposer/from_bin_msg.hpp>
-#include <opencv2/highgui.hpp>
+#include <ll2_decomposer/map_bundle.hpp>
 #include <opencv2/imgproc.hpp>
 
 #include <pcl/point_cloud.h>
@@ -26,7 +27,13 @@
 namespace yabloc
 {
 CameraPoseInitializer::CameraPoseInitializer()
-: Node("camera_pose_initializer"), angle_resolution_{declare_parameter("angle_resolution", 30)}
+: Node("camera_pose_initializer"),
+  angle_resolution_{declare_parameter("angle_resolution", 30)},
+  map_bundle_path_{declare_parameter("map_bundle_path", std::string{})},
+  score_max_distance_{static_cast<float>(declare_parameter("score_max_distance", 10.0))},
+  refine_iterations_{declare_parameter("refine_iterations", 4)},
+  candidate_count_{declare_parameter("candidate_count", 1)},
+  candidate_sigma_{static_cast<float>(declare_parameter("candidate_sigma", 1.0))}
 {
   using std::placeholders::_1;
   using std::placeholders::_2;
@@ -34,6 +41,7 @@ CameraPoseInitializer::CameraPoseInitializer()
   service_callback_group_ = create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
 
   marker_module_ = std::make_unique<initializer::MarkerModule>(this);
+  thread_pool_ = std::make_unique<common::ThreadPool>(declare_parameter("thread_count", 0));
   projector_module_ = std::make_unique<initializer::ProjectorModule>(this);
 
   // Subscriber
@@ -61,38 +69,36 @@ CameraPoseInitializer::CameraPoseInitializer()
   }
 }
 
-cv::Mat bitwise_and_3ch(const cv::Mat src1, const cv::Mat src2)
+std::vector<Eigen::Vector2f> sample_candidate_positions(
+  const Eigen::Vector2f & center, const Eigen::Matrix2f & covariance, int count, float sigma)
 {
-  std::vector<cv::Mat> src1_array;
-  std::vector<cv::Mat> src2_array;
-  cv::split(src1, src1_array);
-  cv::split(src2, src2_array);
-  std::vector<cv::Mat> dst_array;
-  for (int i = 0; i < 3; i++) {
-    cv::Mat dst;
-    cv::bitwise_and(src1_array.at(i), src2_array.at(i), dst);
-    dst_array.push_back(dst);
+  // The center and the points evenly spaced on the ellipse of the sigma
+  std::vector<Eigen::Vector2f> candidates = {center};
+  Eigen::LLT<Eigen::Matrix2f> llt(covariance);
+  if (count <= 1 || llt.info() != Eigen::Success) return candidates;
+
+  const Eigen::Matrix2f l = llt.matrixL();
+  for (int i = 0; i < count - 1; i++) {
+    const float theta = 2 * M_PI * i / (count - 1);
+    candidates.push_back(center + sigma * l * Eigen::Vector2f(std::cos(theta), std::sin(theta)));
   }
-  cv::Mat merged;
-  cv::merge(dst_array, merged);
-  return merged;
+  return candidates;
 }
 
-int count_nonzero(cv::Mat image_3ch)
+float candidate_prior_weight(const Eigen::Vector2f & offset, const Eigen::Matrix2f & covariance)
 {
-  std::vector<cv::Mat> images;
-  cv::split(image_3ch, images);
-  int count = 0;
-  for (int i = 0; i < 3; i++) {
-    count += cv::countNonZero(images.at(i));
-  }
-  return count;
+  // Gaussian likelihood relative to the center, i.e. 1 at the center
+  Eigen::LLT<Eigen::Matrix2f> llt(covariance);
+  if (llt.info() != Eigen::Success) return 1.f;
+  const Eigen::Vector2f whitened = llt.matrixL().solve(offset);
+  return std::exp(-0.5f * whitened.squaredNorm());
 }
 
 bool CameraPoseInitializer::estimate_pose(
-  const Eigen::Vector3f & position, double & yaw_angle_rad, double yaw_std_rad)
+  const std::vector<Eigen::Vector3f> & positions, const std::vector<float> & prior_weights,
+  double & yaw_angle_rad, double yaw_std_rad, Eigen::Vector3f * best_position)
 {
-  if (!projector_module_->define_project_func()) {
+  if (!projector_module_->update_projection_lut()) {
     return false;
   }
   if (!lane_image_) {
@@ -121,65 +127,74 @@ bool CameraPoseInitializer::estimate_pose(
     }
   }
 
-  const std::optional<double> lane_angle_rad =
-    lanelet::get_current_direction(const_lanelets_, position);
-
-  cv::Mat projected_image = projector_module_->project_image(semseg_image);
-  cv::Mat vectormap_image = lane_image_->create_vectormap_image(position);
-
-  std::vector<float> scores;
-  std::vector<float> angles_rad;
-
-  for (int i = -angle_resolution_; i < angle_resolution_; i++) {
-    const double angle_rad =
-      yaw_angle_rad + yaw_std_rad * static_cast<double>(i) / static_cast<double>(angle_resolution_);
-    const double angle_deg = angle_rad * 180. / M_PI;
-
-    cv::Mat rot = cv::getRotationMatrix2D(cv::Point2f(400, 400), angle_deg, 1);
-    cv::Mat rotated_image;
-    cv::warpAffine(projected_image, rotated_image, rot, vectormap_image.size());
-    cv::Mat dst = bitwise_and_3ch(rotated_image, vectormap_image);
-
-    // consider lanelet direction
-    float gain = 1;
-    if (lane_angle_rad) {
-      gain = 2 + std::cos((lane_angle_rad.value() - angle_rad) / 2.0);
-    }
-    const float score = gain * count_nonzero(dst);
-
-    // DEBUG:
-    constexpr bool imshow = false;
-    if (imshow) {
-      cv::Mat show_image;
-      cv::hconcat(std::vector<cv::Mat>{rotated_image, vectormap_image, dst}, show_image);
-      cv::imshow("and operator", show_image);
-      cv::waitKey(50);
-    }
-
-    scores.push_back(score);
-    angles_rad.push_back(angle_rad);
+  // The same observation is matched with the vector map around every candidate
+  const initializer::ChannelPoints projected_points =
+    projector_module_->project_contours(semseg_image);
+
+  // Drawing the vector map and its distance transform dominate the cost of a candidate, so the
+  // candidates run in parallel, each with its own scorer. A single candidate parallelizes its
+  // angles instead, since the pool can not be nested.
+  const bool parallel_candidates = positions.size() > 1;
+  std::vector<initializer::RotationSearchResult> results(positions.size());
+  auto search_candidate = [&](size_t i) -> void {
+    const Eigen::Vector3f & position = positions[i];
+    const std::optional<double> lane_angle_rad =
+      get_current_direction(lane_image_->lanes(), lane_image_->index(), position);
+    const initializer::RotationScorer scorer(
+      lane_image_->create_vectormap_image(position), score_max_distance_);
+
+    auto score_function = [&](double angle_rad) -> float {
+      // consider lanelet direction
+      float gain = 1;
+      if (lane_angle_rad) {
+        gain = 2 + std::cos((lane_angle_rad.value() - angle_rad) / 2.0);
+      }
+      return gain * scorer(projected_points, angle_rad * 180. / M_PI);
+    };
+
+    results[i] = initializer::search_rotation(
+      score_function, yaw_angle_rad, yaw_std_rad, angle_resolution_, refine_iterations_,
+      parallel_candidates ? nullptr : thread_pool_.get());
+  };
+  if (parallel_candidates) {
+    thread_pool_->parallel_for(positions.size(), search_candidate);
+  } else {
+    search_candidate(0);
   }
 
-  {
-    size_t max_index =
-      std::distance(scores.begin(), std::max_element(scores.begin(), scores.end()));
-    yaw_angle_rad = angles_rad.at(max_index);
+  // A candidate far from the requested position needs a better match to be selected.
+  // The first candidate wins ties, so the result does not depend on the scheduling.
+  auto weighted_score = [&](size_t i) -> float { return results[i].score * prior_weights[i]; };
+  size_t best_index = 0;
+  for (size_t i = 1; i < results.size(); i++) {
+    if (weighted_score(i) > weighted_score(best_index)) best_index = i;
   }
+  const initializer::RotationSearchResult & best_result = results[best_index];
+  *best_position = positions[best_index];
+  yaw_angle_rad = best_result.angle_rad;
 
-  marker_module_->publish_marker(scores, angles_rad, position);
+  marker_module_->publish_marker(best_result.scores, best_result.angles_rad, *best_position);
 
   return true;
 }
 
 void CameraPoseInitializer::on_map(const HADMapBin & msg)
 {
-  lanelet::LaneletMapPtr lanelet_map = ll2_decomposer::from_bin_msg(msg);
-  lane_image_ = std::make_unique<LaneImage>(lanelet_map);
-
-  const_lanelets_.clear();
-  for (auto l : lanelet_map->laneletLayer) {
-    const_lanelets_.push_back(l);
+  std::vector<ll2_decomposer::Lane> lanes;
+  if (!map_bundle_path_.empty()) {
+    std::string error;
+    const auto bundle = ll2_decomposer::open_map_bundle(map_bundle_path_, msg, &error);
+    if (bundle && ll2_decomposer::read_lanes(*bundle, &lanes)) {
+      RCLCPP_INFO_STREAM(get_logger(), "loaded lanes from " << map_bundle_path_);
+      lane_image_ = std::make_unique<LaneImage>(std::move(lanes));
+      return;
+    }
+    RCLCPP_WARN_STREAM(get_logger(), "lanes are extracted online. " << error);
   }
+
+  lanelet::LaneletMapPtr lanelet_map = ll2_decomposer::from_bin_msg(msg);
+  lanes = ll2_decomposer::extract_lanes(lanelet_map->laneletLayer);
+  lane_image_ = std::make_unique<LaneImage>(std::move(lanes));
 }
 
 void CameraPoseInitializer::on_service(
@@ -194,32 +209,49 @@ void CameraPoseInitializer::on_service(
   const auto orientation = request->pose_with_covariance.pose.pose.orientation;
   const double yaw_std_rad = std::sqrt(query_pos_with_cov.pose.covariance.at(35));
 
-  auto ground_request = std::make_shared<GroundSrv::Request>();
-  ground_request->point.x = query_pos.x;
-  ground_request->point.y = query_pos.y;
+  // Heights of all candidates are requested at once
+  const Eigen::Vector2f query_xy(query_pos.x, query_pos.y);
+  const auto & covariance = query_pos_with_cov.pose.covariance;
+  Eigen::Matrix2f xy_covariance;
+  xy_covariance << covariance.at(0), covariance.at(1), covariance.at(6), covariance.at(7);
+  const std::vector<Eigen::Vector2f> candidates =
+    sample_candidate_positions(query_xy, xy_covariance, candidate_count_, candidate_sigma_);
+  std::vector<std::shared_future<GroundSrv::Response::SharedPtr>> futures;
+  for (const Eigen::Vector2f & xy : candidates) {
+    auto ground_request = std::make_shared<GroundSrv::Request>();
+    ground_request->point.x = xy.x();
+    ground_request->point.y = xy.y();
+    futures.push_back(ground_client_->async_send_request(ground_request).future.share());
+  }
 
+  // All the requests share one deadline, so that the service waits at most 1s in total
   using namespace std::chrono_literals;
-  auto result_future = ground_client_->async_send_request(ground_request);
-  std::future_status status = result_future.wait_for(1000ms);
-  if (status == std::future_status::ready) {
-  } else {
+  const auto deadline = std::chrono::steady_clock::now() + 1000ms;
+  std::vector<Eigen::Vector3f> positions;
+  std::vector<float> prior_weights;
+  for (size_t i = 0; i < futures.size(); i++) {
+    if (futures[i].wait_until(deadline) != std::future_status::ready) continue;
+    // Retrieve 3d position
+    const auto position = futures[i].get()->pose.position;
+    positions.emplace_back(position.x, position.y, position.z);
+    prior_weights.push_back(candidate_prior_weight(candidates[i] - query_xy, xy_covariance));
+  }
+  if (positions.empty()) {
     RCLCPP_ERROR_STREAM(get_logger(), "get height from LL2 service exited unexpectedly");
     return;
   }
-
-  // Retrieve 3d position
-  const auto position = result_future.get()->pose.position;
-  Eigen::Vector3f pos_vec3f;
-  pos_vec3f << position.x, position.y, position.z;
-  RCLCPP_INFO_STREAM(get_logger(), "get initial position " << pos_vec3f.transpose());
+  // The request of the center may time out as well as the others
+  RCLCPP_INFO_STREAM(
+    get_logger(), "get heights of " << positions.size() << " of " << candidates.size()
+                                    << " candidates around " << query_xy.transpose());
 
   // Estimate orientation
-  const auto header = request->pose_with_covariance.header;
   double yaw_angle_rad = 2 * std::atan2(orientation.z, orientation.w);
-  if (estimate_pose(pos_vec3f, yaw_angle_rad, yaw_std_rad)) {
+  Eigen::Vector3f best_position;
+  if (estimate_pose(positions, prior_weights, yaw_angle_rad, yaw_std_rad, &best_position)) {
     response->success = true;
     response->pose_with_covariance =
-      create_rectified_initial_pose(pos_vec3f, yaw_angle_rad, query_pos_with_cov);
+      create_rectified_initial_pose(best_position, yaw_angle_rad, query_pos_with_cov);
   }
 }
 
@@ -23,6 +23,9 @@
 #include <boost/geometry/geometries/polygon.hpp>
 #include <boost/range/adaptors.hpp>
 
+#include <utility>
+#include <vector>
+
 namespace yabloc
 {
 namespace bg = boost::geometry;
@@ -31,7 +34,7 @@ typedef bg::model::d2::point_xy<double> point_t;
 typedef bg::model::box<point_t> box_t;
 typedef bg::model::polygon<point_t> polygon_t;
 
-LaneImage::LaneImage(lanelet::LaneletMapPtr map) : map_(map) {}
+LaneImage::LaneImage(std::vector<Lane> lanes) : lanes_(std::move(lanes)), index_(lanes_) {}
 
 cv::Point2i to_cv_point(const Eigen::Vector3f & v)
 {
@@ -44,7 +47,7 @@ cv::Point2i to_cv_point(const Eigen::Vector3f & v)
   return pt;
 }
 
-cv::Mat LaneImage::create_vectormap_image(const Eigen::Vector3f & position)
+cv::Mat LaneImage::create_vectormap_image(const Eigen::Vector3f & position) const
 {
   geometry_msgs::msg::Pose pose;
   pose.position.x = position.x();
@@ -66,41 +69,46 @@ void draw_lane(cv::Mat & image, const polygon_t & polygon)
   cv::drawContours(image, contours, -1, cv::Scalar(255, 0, 0), -1);
 }
 
-void draw_line(cv::Mat & image, const lanelet::LineString2d & line, geometry_msgs::msg::Point xyz)
+void draw_line(
+  cv::Mat & image, const std::vector<Eigen::Vector2f> & line, geometry_msgs::msg::Point xyz)
 {
   std::vector<cv::Point> contour;
-  for (auto p : line) {
+  for (const Eigen::Vector2f & p : line) {
     cv::Point2i pt = to_cv_point({p.x() - xyz.x, p.y() - xyz.y, 0});
     contour.push_back(pt);
   }
   cv::polylines(image, contour, false, cv::Scalar(0, 0, 255), 2);
 }
 
-cv::Mat LaneImage::get_image(const Pose & pose)
+cv::Mat LaneImage::get_image(const Pose & pose) const
 {
   const auto xyz = pose.position;
   box_t box(point_t(-20, -20), point_t(20, 20));
 
   cv::Mat image = cv::Mat::zeros(cv::Size(800, 800), CV_8UC3);
 
-  std::vector<lanelet::Lanelet> joint_lanes;
-  for (auto lanelet : map_->laneletLayer) {
+  // Lanes whose bounding box is out of the box can not intersect it
+  const Eigen::Vector2f center(xyz.x, xyz.y);
+  const Eigen::Vector2f half_size(20, 20);
+  std::vector<const Lane *> joint_lanes;
+  for (const size_t i : index_.query(center - half_size, center + half_size)) {
+    const Lane & lane = lanes_[i];
     polygon_t polygon;
-    for (auto right : lanelet.rightBound2d()) {
+    for (const Eigen::Vector2f & right : lane.right) {
       polygon.outer().push_back(point_t(right.x() - xyz.x, right.y() - xyz.y));
     }
-    for (auto left : boost::adaptors::reverse(lanelet.leftBound2d())) {
+    for (const Eigen::Vector2f & left : boost::adaptors::reverse(lane.left)) {
       polygon.outer().push_back(point_t(left.x() - xyz.x, left.y() - xyz.y));
     }
 
     if (!bg::disjoint(box, polygon)) {
-      joint_lanes.push_back(lanelet);
+      joint_lanes.push_back(&lane);
       draw_lane(image, polygon);
     }
   }
-  for (auto lanelet : joint_lanes) {
-    draw_line(image, lanelet.rightBound2d(), xyz);
-    draw_line(image, lanelet.leftBound2d(), xyz);
+  for (const Lane * lane : joint_lanes) {
+    draw_line(image, lane->right, xyz);
+    draw_line(image, lane->left, xyz);
   }
 
   return image;
@@ -14,81 +14,101 @@
 
 #include "camera_pose_initializer/lanelet_util.hpp"
 
-#include <lanelet2_core/geometry/Lanelet.h>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <vector>
 
-namespace lanelet
+namespace yabloc
 {
+namespace bgi = boost::geometry::index;
 
-bool get_current_lanelets(
-  const ConstLanelets & lanelets, const Eigen::Vector3f & query_position,
-  ConstLanelets * current_lanelets_ptr)
+LaneIndex::LaneIndex(const std::vector<Lane> & lanes)
 {
-  if (current_lanelets_ptr == nullptr) {
-    std::cerr << "argument closest_lanelet_ptr is null! Failed to find closest lanelet"
-              << std::endl;
-    return false;
+  std::vector<Value> values;
+  values.reserve(lanes.size());
+  for (size_t i = 0; i < lanes.size(); i++) {
+    const Lane & lane = lanes[i];
+    if (lane.right.empty() && lane.left.empty()) continue;
+    values.emplace_back(
+      BgBox(BgPoint(lane.min.x(), lane.min.y()), BgPoint(lane.max.x(), lane.max.y())), i);
   }
+  // The packing constructor bulk-loads a balanced tree
+  rtree_ = decltype(rtree_)(values.begin(), values.end());
+}
+
+std::vector<size_t> LaneIndex::query(const Eigen::Vector2f & min, const Eigen::Vector2f & max) const
+{
+  const BgBox box(BgPoint(min.x(), min.y()), BgPoint(max.x(), max.y()));
+  std::vector<Value> hits;
+  rtree_.query(bgi::intersects(box), std::back_inserter(hits));
+
+  std::vector<size_t> indices;
+  indices.reserve(hits.size());
+  for (const Value & hit : hits) indices.push_back(hit.second);
+  // Keep the order of the map, which does not depend on the shape of the tree
+  std::sort(indices.begin(), indices.end());
+  return indices;
+}
 
-  if (lanelets.empty()) {
+bool is_inside(const Lane & lane, const Eigen::Vector2f & point)
+{
+  if ((point.array() < lane.min.array()).any() || (point.array() > lane.max.array()).any()) {
     return false;
   }
 
-  lanelet::BasicPoint2d search_point(query_position.x(), query_position.y());
-  for (const auto & llt : lanelets) {
-    if (lanelet::geometry::inside(llt, search_point)) {
-      current_lanelets_ptr->push_back(llt);
-    }
+  // The outline goes forward along the right bound and backward along the left bound
+  std::vector<Eigen::Vector2f> polygon(lane.right.begin(), lane.right.end());
+  polygon.insert(polygon.end(), lane.left.rbegin(), lane.left.rend());
+  if (polygon.size() < 3) return false;
+
+  // Count the edges crossing the ray toward +x
+  bool inside = false;
+  for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+    const Eigen::Vector2f & a = polygon[i];
+    const Eigen::Vector2f & b = polygon[j];
+    if ((a.y() > point.y()) == (b.y() > point.y())) continue;
+    const float x = a.x() + (point.y() - a.y()) / (b.y() - a.y()) * (b.x() - a.x());
+    if (point.x() < x) inside = !inside;
   }
-
-  return !current_lanelets_ptr->empty();  // return found
+  return inside;
 }
 
-ConstLineString3d get_closest_segment(
-  const lanelet::BasicPoint2d & search_pt, const lanelet::ConstLineString3d & linestring)
+float distance_to_segment(
+  const Eigen::Vector2f & point, const Eigen::Vector2f & from, const Eigen::Vector2f & to)
 {
-  if (linestring.size() < 2) {
-    return lanelet::LineString3d();
-  }
-
-  lanelet::ConstLineString3d closest_segment;
-  double min_distance = std::numeric_limits<double>::max();
-
-  for (size_t i = 1; i < linestring.size(); i++) {
-    lanelet::BasicPoint3d prev_basic_pt = linestring[i - 1].basicPoint();
-    lanelet::BasicPoint3d current_basic_pt = linestring[i].basicPoint();
-
-    lanelet::Point3d prev_pt(
-      lanelet::InvalId, prev_basic_pt.x(), prev_basic_pt.y(), prev_basic_pt.z());
-    lanelet::Point3d current_pt(
-      lanelet::InvalId, current_basic_pt.x(), current_basic_pt.y(), current_basic_pt.z());
-
-    lanelet::LineString3d current_segment(lanelet::InvalId, {prev_pt, current_pt});
-    double distance = lanelet::geometry::distance2d(
-      lanelet::utils::to2D(current_segment).basicLineString(), search_pt);
-    if (distance < min_distance) {
-      closest_segment = current_segment;
-      min_distance = distance;
-    }
-  }
-  return closest_segment;
+  const Eigen::Vector2f direction = to - from;
+  const float squared_length = direction.squaredNorm();
+  if (squared_length < 1e-6f) return (point - from).norm();
+  const float t = std::clamp((point - from).dot(direction) / squared_length, 0.f, 1.f);
+  return (point - (from + t * direction)).norm();
 }
 
 std::optional<double> get_current_direction(
-  const ConstLanelets & lanelets, const Eigen::Vector3f & query_position)
+  const std::vector<Lane> & lanes, const LaneIndex & index, const Eigen::Vector3f & query_position)
 {
-  ConstLanelets current_lanelets;
-  bool found = get_current_lanelets(lanelets, query_position, &current_lanelets);
-
-  lanelet::BasicPoint2d search_pt(query_position.x(), query_position.y());
-
-  if (found) {
-    auto lanelet = current_lanelets.front();  // TODO: consider all lanelet too
-    lanelet::ConstLineString3d segment = get_closest_segment(search_pt, lanelet.centerline());
-    return std::atan2(
-      segment.back().y() - segment.front().y(), segment.back().x() - segment.front().x());
-  } else {
-    return std::nullopt;
+  const Eigen::Vector2f search_point = query_position.topRows(2);
+
+  // TODO: consider all lanes containing the position too
+  for (const size_t lane_index : index.query(search_point, search_point)) {
+    const Lane & lane = lanes[lane_index];
+    if (lane.centerline.size() < 2 || !is_inside(lane, search_point)) continue;
+
+    float min_distance = std::numeric_limits<float>::max();
+    Eigen::Vector2f closest_direction = Eigen::Vector2f::UnitX();
+    for (size_t i = 1; i < lane.centerline.size(); i++) {
+      const Eigen::Vector2f & from = lane.centerline[i - 1];
+      const Eigen::Vector2f & to = lane.centerline[i];
+      const float distance = distance_to_segment(search_point, from, to);
+      if (distance < min_distance) {
+        min_distance = distance;
+        closest_direction = to - from;
+      }
+    }
+    return std::atan2(closest_direction.y(), closest_direction.x());
   }
+  return std::nullopt;
 }
 
-}  // namespace lanelet
+}  // namespace yabloc
@@ -14,10 +14,13 @@
 
 #include "camera_pose_initializer/projector_module.hpp"
 
-#include <Eigen/Geometry>
 #include <opencv2/imgproc.hpp>
 #include <yabloc_common/cv_decompress.hpp>
 
+#include <set>
+#include <utility>
+#include <vector>
+
 namespace yabloc::initializer
 {
 ProjectorModule::ProjectorModule(rclcpp::Node * node)
@@ -36,49 +39,40 @@ cv::Point2i to_cv_point(const Eigen::Vector3f & v)
   return pt;
 }
 
-cv::Mat ProjectorModule::project_image(const sensor_msgs::msg::Image & image_msg)
+ChannelPoints ProjectorModule::project_contours(const sensor_msgs::msg::Image & image_msg)
 {
   cv::Mat mask_image = common::decompress_to_cv_mat(image_msg);
 
-  // project semantics on plane
   std::vector<cv::Mat> masks;
   cv::split(mask_image, masks);
-  std::vector<cv::Scalar> colors = {
-    cv::Scalar(255, 0, 0), cv::Scalar(0, 255, 0), cv::Scalar(0, 0, 255)};
 
-  cv::Mat projected_image = cv::Mat::zeros(cv::Size(800, 800), CV_8UC3);
+  ChannelPoints channel_points;
   for (int i = 0; i < 3; i++) {
     std::vector<std::vector<cv::Point> > contours;
     cv::findContours(masks[i], contours, cv::RETR_LIST, cv::CHAIN_APPROX_NONE);
 
-    std::vector<std::vector<cv::Point> > projected_contours;
-    for (auto contour : contours) {
-      std::vector<cv::Point> projected;
-      for (auto c : contour) {
-        auto opt = project_func_(c);
+    // Neighboring pixels of the camera image are often projected to the same pixel
+    std::set<std::pair<int, int> > visited;
+    for (const auto & contour : contours) {
+      for (const cv::Point & c : contour) {
+        auto opt = projection_lut_(c);
         if (!opt.has_value()) continue;
 
         cv::Point2i pt = to_cv_point(opt.value());
-        projected.push_back(pt);
-      }
-      if (projected.size() > 2) {
-        projected_contours.push_back(projected);
+        if (!visited.emplace(pt.x, pt.y).second) continue;
+        channel_points[i].emplace_back(pt.x, pt.y);
       }
     }
-    cv::drawContours(projected_image, projected_contours, -1, colors[i], -1);
   }
-  return projected_image;
+  return channel_points;
 }
 
-bool ProjectorModule::define_project_func()
+bool ProjectorModule::update_projection_lut()
 {
-  if (project_func_) return true;
-
   if (info_.is_camera_info_nullopt()) {
     RCLCPP_WARN_STREAM(logger_, "camera info is not ready");
     return false;
   }
-  Eigen::Matrix3f Kinv = info_.intrinsic().inverse();
 
   std::optional<Eigen::Affine3f> camera_extrinsic =
     tf_subscriber_(info_.get_frame_id(), "base_link");
@@ -87,21 +81,8 @@ bool ProjectorModule::define_project_func()
     return false;
   }
 
-  const Eigen::Vector3f t = camera_extrinsic->translation();
-  const Eigen::Quaternionf q(camera_extrinsic->rotation());
-
-  // TODO: This will take into account ground tilt and camera vibration someday.
-  project_func_ = [Kinv, q, t](const cv::Point & u) -> std::optional<Eigen::Vector3f> {
-    Eigen::Vector3f u3(u.x, u.y, 1);
-    Eigen::Vector3f u_bearing = (q * Kinv * u3).normalized();
-    if (u_bearing.z() > -0.01) return std::nullopt;
-    float u_distance = -t.z() / u_bearing.z();
-    Eigen::Vector3f v;
-    v.x() = t.x() + u_bearing.x() * u_distance;
-    v.y() = t.y() + u_bearing.y() * u_distance;
-    v.z() = 0;
-    return v;
-  };
+  const Eigen::Vector2i size = info_.size();
+  projection_lut_.update(cv::Size(size.x(), size.y()), info_.intrinsic(), *camera_extrinsic);
   return true;
 }
 }  // namespace yabloc::initializer
\ No newline at end of file
@@ -0,0 +1,109 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "camera_pose_initializer/rotation_search.hpp"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+
+namespace yabloc::initializer
+{
+RotationScorer::RotationScorer(const cv::Mat & vectormap_image, float max_distance)
+: center_(vectormap_image.cols / 2.f, vectormap_image.rows / 2.f)
+{
+  std::vector<cv::Mat> channels;
+  cv::split(vectormap_image, channels);
+  for (int i = 0; i < 3; i++) {
+    if (cv::countNonZero(channels.at(i)) == 0) continue;
+
+    // Distance to the nearest drawn pixel
+    cv::Mat background = (channels.at(i) == 0);
+    cv::Mat distance;
+    cv::distanceTransform(background, distance, cv::DIST_L2, cv::DIST_MASK_PRECISE);
+    cv::Mat score_map = 1.f - distance / max_distance;
+    score_maps_[i] = cv::max(score_map, 0.0);
+  }
+}
+
+float RotationScorer::operator()(const ChannelPoints & points, double angle_deg) const
+{
+  const cv::Mat rot = cv::getRotationMatrix2D(center_, angle_deg, 1);
+  const double * r = rot.ptr<double>();
+
+  float score = 0;
+  for (int i = 0; i < 3; i++) {
+    const cv::Mat & score_map = score_maps_[i];
+    if (score_map.empty()) continue;
+    for (const cv::Point2f & p : points[i]) {
+      const int x = static_cast<int>(r[0] * p.x + r[1] * p.y + r[2]);
+      const int y = static_cast<int>(r[3] * p.x + r[4] * p.y + r[5]);
+      if (x < 0 || y < 0 || x >= score_map.cols || y >= score_map.rows) continue;
+      score += score_map.at<float>(y, x);
+    }
+  }
+  return score;
+}
+
+namespace
+{
+std::vector<float> score_all(
+  const std::function<float(double)> & score_function, const std::vector<double> & angles_rad,
+  common::ThreadPool * pool)
+{
+  std::vector<float> scores(angles_rad.size());
+  auto score_at = [&](size_t i) { scores[i] = score_function(angles_rad[i]); };
+  if (pool) {
+    pool->parallel_for(angles_rad.size(), score_at);
+  } else {
+    for (size_t i = 0; i < angles_rad.size(); i++) score_at(i);
+  }
+  return scores;
+}
+}  // namespace
+
+RotationSearchResult search_rotation(
+  const std::function<float(double)> & score_function, double center_rad, double range_rad,
+  int resolution, int refine_iterations, common::ThreadPool * pool)
+{
+  RotationSearchResult result;
+  const double step = range_rad / static_cast<double>(resolution);
+  std::vector<double> angles_rad;
+  for (int i = -resolution; i < resolution; i++) {
+    angles_rad.push_back(center_rad + step * static_cast<double>(i));
+  }
+  result.scores = score_all(score_function, angles_rad, pool);
+  result.angles_rad.assign(angles_rad.begin(), angles_rad.end());
+
+  const size_t best_index = std::distance(
+    result.scores.begin(), std::max_element(result.scores.begin(), result.scores.end()));
+  result.angle_rad = angles_rad.at(best_index);
+  result.score = result.scores.at(best_index);
+
+  // The true angle lies within a step of the best grid angle
+  double half = step / 2;
+  for (int k = 0; k < refine_iterations; k++) {
+    const std::vector<double> candidates = {result.angle_rad - half, result.angle_rad + half};
+    const std::vector<float> scores = score_all(score_function, candidates, pool);
+    for (size_t i = 0; i < candidates.size(); i++) {
+      if (scores[i] > result.score) {
+        result.score = scores[i];
+        result.angle_rad = candidates[i];
+      }
+    }
+    half /= 2;
+  }
+  return result;
+}
+}  // namespace yabloc::initializer
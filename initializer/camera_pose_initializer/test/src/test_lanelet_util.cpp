@@ -0,0 +1,55 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "camera_pose_initializer/lanelet_util.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+using yabloc::Lane;
+
+// A straight lane along the x-axis of 4m width, or along the y-axis if vertical
+Lane make_lane(float x, float y, bool vertical)
+{
+  Lane lane;
+  const Eigen::Vector2f d = vertical ? Eigen::Vector2f(0, 10) : Eigen::Vector2f(10, 0);
+  const Eigen::Vector2f n = vertical ? Eigen::Vector2f(-2, 0) : Eigen::Vector2f(0, 2);
+  const Eigen::Vector2f o(x, y);
+  lane.right = {o - n, o - n + d};
+  lane.left = {o + n, o + n + d};
+  lane.centerline = {o, o + d};
+  lane.min = (o - n).cwiseMin(o + n + d);
+  lane.max = (o - n).cwiseMax(o + n + d);
+  return lane;
+}
+
+TEST(LaneletUtilTestSuite, laneIndex)
+{
+  std::vector<Lane> lanes;
+  for (int i = 0; i < 100; i++) lanes.push_back(make_lane(20.f * i, 0, false));
+  lanes.push_back(make_lane(105, -50, true));
+  lanes.push_back(Lane{{}, {}, {}, {0, 0}, {0, 0}});
+
+  const yabloc::LaneIndex index(lanes);
+  EXPECT_EQ(index.query({-100, -100}, {-50, -50}), std::vector<size_t>{});
+  EXPECT_EQ(index.query({25, -1}, {45, 1}), (std::vector<size_t>{1, 2}));
+  // Lanes without bounds are not indexed
+  EXPECT_EQ(index.query({0, 0}, {0, 0}), (std::vector<size_t>{0}));
+
+  EXPECT_NEAR(*yabloc::get_current_direction(lanes, index, {45, 1, 0}), 0, 1e-6);
+  EXPECT_NEAR(*yabloc::get_current_direction(lanes, index, {105, -45, 0}), M_PI / 2, 1e-6);
+  EXPECT_FALSE(yabloc::get_current_direction(lanes, index, {55, 1, 0}).has_value());
+}
@@ -0,0 +1,77 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "camera_pose_initializer/rotation_search.hpp"
+
+#include <opencv2/imgproc.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace init = yabloc::initializer;
+
+TEST(RotationSearchTestSuite, recoverRotation)
+{
+  // An asymmetric lane with boundaries in the red channel and its area in the blue channel
+  cv::Mat vectormap_image = cv::Mat::zeros(cv::Size(800, 800), CV_8UC3);
+  cv::rectangle(vectormap_image, cv::Rect(350, 100, 100, 600), cv::Scalar(255, 0, 0), -1);
+  cv::line(vectormap_image, {350, 100}, {350, 700}, cv::Scalar(0, 0, 255), 2);
+  cv::line(vectormap_image, {450, 100}, {450, 700}, cv::Scalar(0, 0, 255), 2);
+  cv::line(vectormap_image, {450, 400}, {700, 400}, cv::Scalar(0, 0, 255), 2);
+
+  // The observation is the vector map rotated by -20 degrees
+  const double true_angle_deg = 20;
+  const cv::Mat rot = cv::getRotationMatrix2D(cv::Point2f(400, 400), -true_angle_deg, 1);
+  std::vector<cv::Mat> channels;
+  cv::split(vectormap_image, channels);
+  init::ChannelPoints points;
+  for (int i = 0; i < 3; i++) {
+    std::vector<cv::Point> pixels;
+    if (cv::countNonZero(channels[i]) > 0) cv::findNonZero(channels[i], pixels);
+    for (size_t j = 0; j < pixels.size(); j += 7) {
+      const cv::Point2f p = pixels[j];
+      points[i].emplace_back(
+        rot.at<double>(0, 0) * p.x + rot.at<double>(0, 1) * p.y + rot.at<double>(0, 2),
+        rot.at<double>(1, 0) * p.x + rot.at<double>(1, 1) * p.y + rot.at<double>(1, 2));
+    }
+  }
+
+  const init::RotationScorer scorer(vectormap_image, 10.f);
+  EXPECT_GT(scorer(points, true_angle_deg), scorer(points, 0));
+  EXPECT_GT(scorer(points, true_angle_deg), scorer(points, true_angle_deg + 5));
+
+  auto score_function = [&](double angle_rad) { return scorer(points, angle_rad * 180 / M_PI); };
+  const auto result = init::search_rotation(score_function, 0, M_PI / 4, 30, 4);
+  EXPECT_EQ(result.scores.size(), 60u);
+  EXPECT_NEAR(result.angle_rad * 180 / M_PI, true_angle_deg, 0.5);
+
+  // The thread pool does not change the result
+  yabloc::common::ThreadPool pool(4);
+  const auto parallel_result = init::search_rotation(score_function, 0, M_PI / 4, 30, 4, &pool);
+  EXPECT_EQ(parallel_result.angle_rad, result.angle_rad);
+  EXPECT_EQ(parallel_result.scores, result.scores);
+}
+
+TEST(RotationSearchTestSuite, refineBetweenGrid)
+{
+  // A smooth peak which is not on the grid
+  const double peak = 0.123;
+  auto score_function = [peak](double angle) { return -std::abs(angle - peak); };
+
+  const auto coarse = init::search_rotation(score_function, 0, 1, 10, 0);
+  EXPECT_NEAR(coarse.angle_rad, 0.1, 1e-9);
+  const auto refined = init::search_rotation(score_function, 0, 1, 10, 6);
+  EXPECT_NEAR(refined.angle_rad, peak, 0.1 / 64);
+}
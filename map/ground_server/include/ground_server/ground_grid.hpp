@@ -0,0 +1,135 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Core>
+
+#include <ll2_decomposer/map_bundle.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <pcl/kdtree/kdtree_flann.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <optional>
+#include <vector>
+
+namespace yabloc::ground_server
+{
+struct GroundLayer
+{
+  // Height at the cell center
+  float height;
+  Eigen::Vector3f normal;
+
+  // Height of the plane at (x,y), where (dx,dy) is the offset from the cell center
+  float height_at(float dx, float dy) const
+  {
+    return height - (normal.x() * dx + normal.y() * dy) / normal.z();
+  }
+};
+
+/**
+ * Fit a ground plane to the points of the indices
+ *
+ * The inliers are selected by RANSAC, and then the plane is fitted by their covariance.
+ * The normal is reversed to point upward, and replaced with UnitZ if it is NaN or tilted more than
+ * 45 degrees.
+ *
+ * @param[out] used_indices the indices which are used for the final fitting
+ * @return the plane as (centroid, normal)
+ */
+std::pair<Eigen::Vector3f, Eigen::Vector3f> fit_ground_plane(
+  const pcl::PointCloud<pcl::PointXYZ>::ConstPtr & cloud, const std::vector<int> & indices,
+  std::vector<int> * used_indices = nullptr);
+
+// Sample the road markings of the map, which are regarded as lying on the ground, at 1m voxels
+pcl::PointCloud<pcl::PointXYZ>::Ptr sample_ground_cloud(const lanelet::LaneletMap & lanelet_map);
+
+void write_ground_cloud(
+  ll2_decomposer::MapBundleWriter & writer, const pcl::PointCloud<pcl::PointXYZ> & cloud);
+
+// Return nullptr if the bundle has no ground cloud
+pcl::PointCloud<pcl::PointXYZ>::Ptr read_ground_cloud(const ll2_decomposer::MapBundle & bundle);
+
+/**
+ * 2.5D raster of ground planes precomputed from the map
+ *
+ * Every cell keeps one or more layers of (height, normal) so that multi-level roads such as
+ * bridges and overpasses are distinguished. A query picks the layer nearest to the given height in
+ * each of the four surrounding cells and interpolates them bilinearly.
+ */
+class GroundGrid
+{
+public:
+  /**
+   * @param[in] cell_size edge length of a cell [m]
+   * @param[in] K number of neighbors used for the plane fitting of each layer
+   * @param[in] layer_separation minimum height difference [m] between two layers in a cell
+   * @param[in] max_distance cells farther than this [m] from any map point are left empty
+   */
+  GroundGrid(float cell_size, int K, float layer_separation, float max_distance);
+
+  void build(const pcl::PointCloud<pcl::PointXYZ>::ConstPtr & cloud);
+
+  bool empty() const { return layers_.empty(); }
+
+  size_t cell_count() const { return static_cast<size_t>(cols_) * rows_; }
+  size_t layer_count() const { return layers_.size(); }
+
+  /**
+   * @param[in] x,y position in map
+   * @param[in] z current height estimate used to select the layer. -infinity selects the lowest.
+   * @return interpolated (height, normal), or nullopt if no surrounding cell has ground
+   */
+  std::optional<GroundLayer> query(float x, float y, float z) const;
+
+  /**
+   * Batched query() for many positions at once, such as all particles
+   *
+   * @param[in] positions (x,y) and the height used to select the layer
+   * @return heights of the positions, or NaN where no surrounding cell has ground
+   */
+  std::vector<float> query_heights(const std::vector<Eigen::Vector3f> & positions) const;
+
+  void write(ll2_decomposer::MapBundleWriter & writer) const;
+
+  // Return false if the bundle has no grid or it is built with other parameters
+  bool read(const ll2_decomposer::MapBundle & bundle);
+
+private:
+  const float cell_size_;
+  const int K_;
+  const float layer_separation_;
+  const float max_distance_;
+
+  Eigen::Vector2f origin_{0, 0};
+  int cols_{0};
+  int rows_{0};
+
+  // Layers of the cell (c,r) are layers_[offsets_[i]] ~ layers_[offsets_[i+1]-1], i = r*cols_+c
+  std::vector<uint32_t> offsets_;
+  std::vector<GroundLayer> layers_;
+
+  Eigen::Vector2f cell_center(int c, int r) const;
+
+  // Return the layer nearest to z of the cell, or nullptr if the cell is empty or out of range
+  const GroundLayer * nearest_layer(int c, int r, float z) const;
+
+  std::vector<GroundLayer> estimate_layers(
+    const pcl::PointCloud<pcl::PointXYZ>::ConstPtr & cloud,
+    const pcl::KdTreeFLANN<pcl::PointXYZ> & kdtree,
+    const pcl::KdTreeFLANN<pcl::PointXYZ> & flat_kdtree, const Eigen::Vector2f & center) const;
+};
+}  // namespace yabloc::ground_server
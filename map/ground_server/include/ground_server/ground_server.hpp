@@ -15,9 +15,11 @@
 #pragma once
 #include "ground_server/filter/low_pass_filter.hpp"
 #include "ground_server/filter/moving_averaging.hpp"
+#include "ground_server/ground_grid.hpp"
 
 #include <rclcpp/rclcpp.hpp>
 #include <yabloc_common/ground_plane.hpp>
+#include <yabloc_common/status_reporter.hpp>
 
 #include <autoware_auto_mapping_msgs/msg/had_map_bin.hpp>
 #include <geometry_msgs/msg/pose_stamped.hpp>
@@ -26,7 +28,6 @@
 #include <sensor_msgs/msg/point_cloud2.hpp>
 #include <std_msgs/msg/float32.hpp>
 #include <std_msgs/msg/float32_multi_array.hpp>
-#include <std_msgs/msg/string.hpp>
 #include <visualization_msgs/msg/marker_array.hpp>
 
 #include <lanelet2_core/LaneletMap.h>
@@ -35,6 +36,8 @@
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
+#include <string>
+
 namespace yabloc::ground_server
 {
 class GroundServer : public rclcpp::Node
@@ -51,7 +54,6 @@ public:
   using Float32 = std_msgs::msg::Float32;
   using Float32Array = std_msgs::msg::Float32MultiArray;  // TODO: define new msg
   using Marker = visualization_msgs::msg::Marker;
-  using String = std_msgs::msg::String;
   using PointCloud2 = sensor_msgs::msg::PointCloud2;
   using Point = geometry_msgs::msg::Point;
   GroundServer();
@@ -60,6 +62,8 @@ private:
   const bool force_zero_tilt_;
   const float R;
   const int K;
+  // Preprocessed bundle used instead of the vector map if it is made from the same map
+  const std::string map_bundle_path_;
 
   // Service
   rclcpp::Service<Ground>::SharedPtr service_;
@@ -71,11 +75,12 @@ private:
   rclcpp::Publisher<Float32>::SharedPtr pub_ground_height_;
   rclcpp::Publisher<Float32Array>::SharedPtr pub_ground_plane_;
   rclcpp::Publisher<Marker>::SharedPtr pub_marker_;
-  rclcpp::Publisher<String>::SharedPtr pub_string_;
   rclcpp::Publisher<PointCloud2>::SharedPtr pub_near_cloud_;
 
   pcl::PointCloud<pcl::PointXYZ>::Ptr cloud_{nullptr};
   pcl::KdTreeFLANN<pcl::PointXYZ>::Ptr kdtree_{nullptr};
+  // Precomputed planes. Poses outside of it fall back to the online estimation with kdtree_.
+  GroundGrid grid_;
 
   // Smoother
   MovingAveraging normal_filter_;
@@ -83,9 +88,15 @@ private:
 
   // For debug
   std::vector<int> last_indices_;
+  // Recorded at the prediction rate and published at 1 Hz
+  std::unique_ptr<common::StatusReporter> status_;
+  size_t status_height_index_;
+  size_t status_tilt_index_;
 
   // Callback
   void on_map(const HADMapBin & msg);
+  // Return false if the bundle is not available for the map
+  bool load_from_bundle(const HADMapBin & msg);
   void on_initial_pose(const PoseCovStamped & msg);
   void on_pose_stamped(const PoseStamped & msg);
   void on_service(
@@ -94,11 +105,7 @@ private:
   // Body
   GroundPlane estimate_ground(const Point & point);
 
-  // Return inlier indices which are belong to a plane
-  // Sometimes, this return empty indices due to RANSAC failure
-  std::vector<int> estimate_inliers_by_ransac(const std::vector<int> & indices_raw);
-
-  // Return the lowest point's height around given point
+  // Return the lowest ground height at the given point
   float estimate_height_simply(const Point & point) const;
 
   // Visualize estimated ground as plane
@@ -0,0 +1,382 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ground_server/ground_grid.hpp"
+
+#include <pcl/ModelCoefficients.h>
+#include <pcl/common/centroid.h>
+#include <pcl/features/normal_3d.h>
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/sample_consensus/method_types.h>
+#include <pcl/sample_consensus/model_types.h>
+#include <pcl/segmentation/sac_segmentation.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <string>
+
+namespace yabloc::ground_server
+{
+namespace
+{
+struct GridRecord
+{
+  float origin[2];
+  int32_t cols;
+  int32_t rows;
+  float cell_size;
+  int32_t K;
+  float layer_separation;
+  float max_distance;
+};
+
+struct LayerRecord
+{
+  float height;
+  float normal[3];
+};
+
+struct PointRecord
+{
+  float xyz[3];
+};
+
+std::vector<int> estimate_inliers_by_ransac(
+  const pcl::PointCloud<pcl::PointXYZ>::ConstPtr & cloud, const std::vector<int> & indices_raw)
+{
+  pcl::PointIndicesPtr indices(new pcl::PointIndices);
+  indices->indices = indices_raw;
+
+  pcl::ModelCoefficients::Ptr coefficients(new pcl::ModelCoefficients);
+  pcl::PointIndices::Ptr inliers(new pcl::PointIndices);
+
+  pcl::SACSegmentation<pcl::PointXYZ> seg;
+  seg.setOptimizeCoefficients(true);
+  seg.setModelType(pcl::SACMODEL_PLANE);
+  seg.setMethodType(pcl::SAC_RANSAC);
+  seg.setDistanceThreshold(1.0);
+  seg.setProbability(0.6);
+
+  seg.setInputCloud(cloud);
+  seg.setIndices(indices);
+  seg.segment(*inliers, *coefficients);
+  return inliers->indices;
+}
+
+void upsample_line_string(
+  const lanelet::ConstPoint3d & from, const lanelet::ConstPoint3d & to,
+  pcl::PointCloud<pcl::PointXYZ> & cloud)
+{
+  Eigen::Vector3f f(from.x(), from.y(), from.z());
+  Eigen::Vector3f t(to.x(), to.y(), to.z());
+  float length = (t - f).norm();
+  Eigen::Vector3f d = (t - f).normalized();
+  for (float l = 0; l < length; l += 0.5f) {
+    pcl::PointXYZ xyz;
+    xyz.getVector3fMap() = (f + l * d);
+    cloud.push_back(xyz);
+  }
+}
+}  // namespace
+
+std::pair<Eigen::Vector3f, Eigen::Vector3f> fit_ground_plane(
+  const pcl::PointCloud<pcl::PointXYZ>::ConstPtr & cloud, const std::vector<int> & raw_indices,
+  std::vector<int> * used_indices)
+{
+  // Sometimes RANSAC fails and returns empty indices
+  std::vector<int> indices = estimate_inliers_by_ransac(cloud, raw_indices);
+  if (indices.empty()) indices = raw_indices;
+
+  // Estimate normal vector using covariance matrix around the target point
+  Eigen::Matrix3f covariance;
+  Eigen::Vector4f centroid;
+  pcl::compute3DCentroid(*cloud, indices, centroid);
+  pcl::computeCovarianceMatrix(*cloud, indices, centroid, covariance);
+
+  Eigen::Vector4f plane_parameter;
+  float curvature;
+  pcl::solvePlaneParameters(covariance, centroid, plane_parameter, curvature);
+  Eigen::Vector3f normal = plane_parameter.topRows(3).normalized();
+
+  // Reverse if it is upside down
+  if (normal.z() < 0) normal = -normal;
+  // Remove NaN and too large tilt (0.707 = cos(45deg))
+  if (!normal.allFinite() || normal.dot(Eigen::Vector3f::UnitZ()) < 0.707) {
+    normal = Eigen::Vector3f::UnitZ();
+  }
+
+  if (used_indices) *used_indices = std::move(indices);
+  return {centroid.topRows(3), normal};
+}
+
+GroundGrid::GroundGrid(float cell_size, int K, float layer_separation, float max_distance)
+: cell_size_(cell_size), K_(K), layer_separation_(layer_separation), max_distance_(max_distance)
+{
+}
+
+Eigen::Vector2f GroundGrid::cell_center(int c, int r) const
+{
+  return origin_ + cell_size_ * Eigen::Vector2f(c + 0.5f, r + 0.5f);
+}
+
+void GroundGrid::build(const pcl::PointCloud<pcl::PointXYZ>::ConstPtr & cloud)
+{
+  offsets_.clear();
+  layers_.clear();
+  cols_ = rows_ = 0;
+  if (cloud->empty()) return;
+
+  // Candidate layers are found by the neighbors in xy, regardless of their height
+  auto flat_cloud = pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>(*cloud);
+  for (pcl::PointXYZ & p : *flat_cloud) p.z = 0;
+
+  pcl::KdTreeFLANN<pcl::PointXYZ> kdtree, flat_kdtree;
+  kdtree.setInputCloud(cloud);
+  flat_kdtree.setInputCloud(flat_cloud);
+
+  Eigen::Vector2f min_xy = cloud->front().getVector3fMap().topRows(2);
+  Eigen::Vector2f max_xy = min_xy;
+  for (const pcl::PointXYZ & p : *cloud) {
+    min_xy = min_xy.cwiseMin(p.getVector3fMap().topRows(2));
+    max_xy = max_xy.cwiseMax(p.getVector3fMap().topRows(2));
+  }
+  origin_ = min_xy - Eigen::Vector2f::Constant(max_distance_);
+  const Eigen::Vector2f extent = max_xy - min_xy + Eigen::Vector2f::Constant(2 * max_distance_);
+  cols_ = static_cast<int>(std::ceil(extent.x() / cell_size_));
+  rows_ = static_cast<int>(std::ceil(extent.y() / cell_size_));
+
+  offsets_.reserve(cell_count() + 1);
+  offsets_.push_back(0);
+  for (int r = 0; r < rows_; r++) {
+    for (int c = 0; c < cols_; c++) {
+      std::vector<GroundLayer> layers =
+        estimate_layers(cloud, kdtree, flat_kdtree, cell_center(c, r));
+      layers_.insert(layers_.end(), layers.begin(), layers.end());
+      offsets_.push_back(static_cast<uint32_t>(layers_.size()));
+    }
+  }
+}
+
+std::vector<GroundLayer> GroundGrid::estimate_layers(
+  const pcl::PointCloud<pcl::PointXYZ>::ConstPtr & cloud,
+  const pcl::KdTreeFLANN<pcl::PointXYZ> & kdtree,
+  const pcl::KdTreeFLANN<pcl::PointXYZ> & flat_kdtree, const Eigen::Vector2f & center) const
+{
+  std::vector<int> indices;
+  std::vector<float> distances;
+  flat_kdtree.nearestKSearch(pcl::PointXYZ(center.x(), center.y(), 0), K_, indices, distances);
+  if (indices.empty() || distances.front() > max_distance_ * max_distance_) return {};
+
+  // Split the neighbors into clusters of similar heights
+  std::vector<float> heights;
+  for (int index : indices) heights.push_back(cloud->at(index).z);
+  std::sort(heights.begin(), heights.end());
+
+  std::vector<float> seeds;
+  size_t begin = 0;
+  for (size_t i = 1; i <= heights.size(); i++) {
+    if (i < heights.size() && heights[i] - heights[i - 1] < layer_separation_) continue;
+    // A plane needs at least 3 points
+    if (i - begin >= 3) seeds.push_back(heights[(begin + i) / 2]);
+    begin = i;
+  }
+  if (seeds.empty()) seeds.push_back(heights[heights.size() / 2]);
+
+  // Fit a plane for each cluster in the same way as the former per-pose estimation
+  std::vector<GroundLayer> layers;
+  for (float seed : seeds) {
+    std::vector<int> raw_indices;
+    kdtree.nearestKSearch(
+      pcl::PointXYZ(center.x(), center.y(), seed), K_, raw_indices, distances);
+    if (raw_indices.empty()) continue;
+
+    const auto [centroid, normal] = fit_ground_plane(cloud, raw_indices);
+    GroundLayer layer;
+    layer.normal = normal;
+    layer.height =
+      (centroid.dot(normal) - center.x() * normal.x() - center.y() * normal.y()) / normal.z();
+
+    const bool duplicated = std::any_of(layers.begin(), layers.end(), [&](const GroundLayer & l) {
+      return std::abs(l.height - layer.height) < 0.5f * layer_separation_;
+    });
+    if (!duplicated) layers.push_back(layer);
+  }
+
+  std::sort(layers.begin(), layers.end(), [](const GroundLayer & a, const GroundLayer & b) {
+    return a.height < b.height;
+  });
+  return layers;
+}
+
+const GroundLayer * GroundGrid::nearest_layer(int c, int r, float z) const
+{
+  if (c < 0 || r < 0 || c >= cols_ || r >= rows_) return nullptr;
+
+  const size_t i = static_cast<size_t>(r) * cols_ + c;
+  const GroundLayer * nearest = nullptr;
+  float min_gap = std::numeric_limits<float>::infinity();
+  for (uint32_t j = offsets_[i]; j < offsets_[i + 1]; j++) {
+    // NOTE: If z is -infinity, every gap is infinity and the lowest layer is taken
+    const float gap = std::abs(layers_[j].height - z);
+    if (!nearest || gap < min_gap) {
+      min_gap = gap;
+      nearest = &layers_[j];
+    }
+  }
+  return nearest;
+}
+
+std::optional<GroundLayer> GroundGrid::query(float x, float y, float z) const
+{
+  if (empty()) return std::nullopt;
+
+  const float fx = (x - origin_.x()) / cell_size_ - 0.5f;
+  const float fy = (y - origin_.y()) / cell_size_ - 0.5f;
+  const int c0 = static_cast<int>(std::floor(fx));
+  const int r0 = static_cast<int>(std::floor(fy));
+  const float tx = fx - c0;
+  const float ty = fy - r0;
+
+  float sum_weight = 0;
+  float sum_height = 0;
+  Eigen::Vector3f sum_normal = Eigen::Vector3f::Zero();
+  int valid_count = 0;
+  for (int dr = 0; dr < 2; dr++) {
+    for (int dc = 0; dc < 2; dc++) {
+      const GroundLayer * layer = nearest_layer(c0 + dc, r0 + dr, z);
+      if (!layer) continue;
+
+      // Each plane is evaluated at the query position rather than at its cell center
+      const Eigen::Vector2f offset = Eigen::Vector2f(x, y) - cell_center(c0 + dc, r0 + dr);
+      const float weight = (dc ? tx : 1 - tx) * (dr ? ty : 1 - ty);
+      // NOTE: A small constant keeps the result defined when only zero-weighted cells are valid
+      const float w = weight + 1e-6f;
+      sum_weight += w;
+      sum_height += w * layer->height_at(offset.x(), offset.y());
+      sum_normal += w * layer->normal;
+      valid_count++;
+    }
+  }
+  if (valid_count == 0) return std::nullopt;
+
+  GroundLayer result;
+  result.height = sum_height / sum_weight;
+  result.normal = sum_normal.normalized();
+  return result;
+}
+
+std::vector<float> GroundGrid::query_heights(const std::vector<Eigen::Vector3f> & positions) const
+{
+  std::vector<float> heights(positions.size(), std::numeric_limits<float>::quiet_NaN());
+  for (size_t i = 0; i < positions.size(); i++) {
+    const Eigen::Vector3f & p = positions[i];
+    if (const auto layer = query(p.x(), p.y(), p.z())) heights[i] = layer->height;
+  }
+  return heights;
+}
+
+pcl::PointCloud<pcl::PointXYZ>::Ptr sample_ground_cloud(const lanelet::LaneletMap & lanelet_map)
+{
+  // TODO: has to be loaded from rosparm
+  const std::set<std::string> visible_labels = {
+    "zebra_marking",      "virtual",   "line_thin", "line_thick",
+    "pedestrian_marking", "stop_line", "curbstone"};
+
+  pcl::PointCloud<pcl::PointXYZ>::Ptr upsampled_cloud =
+    pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+
+  for (const lanelet::ConstLineString3d & line : lanelet_map.lineStringLayer) {
+    if (!line.hasAttribute(lanelet::AttributeName::Type)) continue;
+
+    lanelet::Attribute attr = line.attribute(lanelet::AttributeName::Type);
+    if (visible_labels.count(attr.value()) == 0) continue;
+
+    lanelet::ConstPoint3d const * from = nullptr;
+    for (const lanelet::ConstPoint3d & p : line) {
+      if (from != nullptr) upsample_line_string(*from, p, *upsampled_cloud);
+      from = &p;
+    }
+  }
+
+  auto cloud = pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+  pcl::VoxelGrid<pcl::PointXYZ> filter;
+  filter.setInputCloud(upsampled_cloud);
+  filter.setLeafSize(1.0f, 1.0f, 1.0f);
+  filter.filter(*cloud);
+  return cloud;
+}
+
+void GroundGrid::write(ll2_decomposer::MapBundleWriter & writer) const
+{
+  const GridRecord grid{
+    {origin_.x(), origin_.y()}, cols_, rows_, cell_size_, K_, layer_separation_, max_distance_};
+  std::vector<LayerRecord> layers;
+  layers.reserve(layers_.size());
+  for (const GroundLayer & layer : layers_) {
+    layers.push_back({layer.height, {layer.normal.x(), layer.normal.y(), layer.normal.z()}});
+  }
+  writer.add_section("ground_grid", std::vector<GridRecord>{grid});
+  writer.add_section("ground_grid_offsets", offsets_);
+  writer.add_section("ground_grid_layers", layers);
+}
+
+bool GroundGrid::read(const ll2_decomposer::MapBundle & bundle)
+{
+  const auto grid = bundle.section<GridRecord>("ground_grid");
+  if (grid.size() != 1) return false;
+  if (grid[0].cell_size != cell_size_ || grid[0].K != K_) return false;
+  if (grid[0].layer_separation != layer_separation_ || grid[0].max_distance != max_distance_) {
+    return false;
+  }
+
+  const auto offsets = bundle.section<uint32_t>("ground_grid_offsets");
+  const auto layers = bundle.section<LayerRecord>("ground_grid_layers");
+  const size_t cells = static_cast<size_t>(grid[0].cols) * grid[0].rows;
+  if (offsets.size() != cells + 1 || offsets[cells] != layers.size()) return false;
+
+  origin_ = Eigen::Vector2f(grid[0].origin[0], grid[0].origin[1]);
+  cols_ = grid[0].cols;
+  rows_ = grid[0].rows;
+  offsets_.assign(offsets.begin(), offsets.end());
+  layers_.clear();
+  layers_.reserve(layers.size());
+  for (const LayerRecord & layer : layers) {
+    layers_.push_back(
+      {layer.height, Eigen::Vector3f(layer.normal[0], layer.normal[1], layer.normal[2])});
+  }
+  return true;
+}
+
+void write_ground_cloud(
+  ll2_decomposer::MapBundleWriter & writer, const pcl::PointCloud<pcl::PointXYZ> & cloud)
+{
+  std::vector<PointRecord> points;
+  points.reserve(cloud.size());
+  for (const pcl::PointXYZ & p : cloud) points.push_back({{p.x, p.y, p.z}});
+  writer.add_section("ground_cloud", points);
+}
+
+pcl::PointCloud<pcl::PointXYZ>::Ptr read_ground_cloud(const ll2_decomposer::MapBundle & bundle)
+{
+  if (!bundle.has_section("ground_cloud")) return nullptr;
+
+  auto cloud = pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+  for (const PointRecord & p : bundle.section<PointRecord>("ground_cloud")) {
+    cloud->push_back(pcl::PointXYZ(p.xyz[0], p.xyz[1], p.xyz[2]));
+  }
+  return cloud;
+}
+}  // namespace yabloc::ground_server
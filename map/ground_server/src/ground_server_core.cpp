@@ -20,13 +20,13 @@
 #include <ll2_decomposer/from_bin_msg.hpp>
 #include <yabloc_common/color.hpp>
 #include <yabloc_common/pub_sub.hpp>
+#include <yabloc_common/timer.hpp>
 
-#include <pcl/ModelCoefficients.h>
 #include <pcl/filters/crop_box.h>
 #include <pcl/filters/voxel_grid.h>
-#include <pcl/sample_consensus/method_types.h>
-#include <pcl/sample_consensus/model_types.h>
-#include <pcl/segmentation/sac_segmentation.h>
+
+#include <limits>
+#include <string>
 
 namespace yabloc ::ground_server
 {
@@ -34,7 +34,12 @@ GroundServer::GroundServer()
 : Node("ground_server"),
   force_zero_tilt_(declare_parameter("force_zero_tilt", false)),
   R(declare_parameter("R", 20)),
-  K(declare_parameter("K", 50))
+  K(declare_parameter("K", 50)),
+  map_bundle_path_(declare_parameter("map_bundle_path", std::string{})),
+  grid_(
+    declare_parameter("grid_cell_size", 1.0), K,
+    declare_parameter("grid_layer_separation", 3.0),
+    declare_parameter("grid_max_distance", 10.0))
 {
   using std::placeholders::_1;
   using std::placeholders::_2;
@@ -52,8 +57,12 @@ GroundServer::GroundServer()
   pub_ground_height_ = create_publisher<Float32>("height", 10);
   pub_ground_plane_ = create_publisher<Float32Array>("ground", 10);
   pub_marker_ = create_publisher<Marker>("ground_marker", 10);
-  pub_string_ = create_publisher<String>("ground_status", 10);
   pub_near_cloud_ = create_publisher<PointCloud2>("near_cloud", 10);
+
+  status_ =
+    std::make_unique<common::StatusReporter>(this, "ground_status", "Ground Estimator Status");
+  status_height_index_ = status_->add("height", 2);
+  status_tilt_index_ = status_->add("tilt", 2, "deg");
 }
 
 void GroundServer::on_initial_pose(const PoseCovStamped & msg)
@@ -77,18 +86,11 @@ void GroundServer::on_pose_stamped(const PoseStamped & msg)
   pub_ground_height_->publish(data);
   pub_ground_plane_->publish(ground_plane.msg());
 
-  // Publish string msg
+  // Record status
   {
-    std::stringstream ss;
-    ss << "--- Ground Estimator Status ----" << std::endl;
-    ss << std::fixed << std::setprecision(2);
-    ss << "height: " << ground_plane.height() << std::endl;
     float cos = ground_plane.normal.dot(Eigen::Vector3f::UnitZ());
-    ss << "tilt: " << std::acos(cos) * 180 / 3.14 << " deg" << std::endl;
-
-    String string_msg;
-    string_msg.data = ss.str();
-    pub_string_->publish(string_msg);
+    status_->set(status_height_index_, ground_plane.height());
+    status_->set(status_tilt_index_, std::acos(cos) * 180 / 3.14);
   }
 
   // Publish nearest point cloud for debug
@@ -103,45 +105,53 @@ void GroundServer::on_pose_stamped(const PoseStamped & msg)
 
 void GroundServer::on_map(const HADMapBin & msg)
 {
-  lanelet::LaneletMapPtr lanelet_map = ll2_decomposer::from_bin_msg(msg);
-
-  // TODO: has to be loaded from rosparm
-  const std::set<std::string> visible_labels = {
-    "zebra_marking",      "virtual",   "line_thin", "line_thick",
-    "pedestrian_marking", "stop_line", "curbstone"};
+  if (!load_from_bundle(msg)) {
+    lanelet::LaneletMapPtr lanelet_map = ll2_decomposer::from_bin_msg(msg);
 
-  pcl::PointCloud<pcl::PointXYZ>::Ptr upsampled_cloud =
-    pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+    cloud_ = sample_ground_cloud(*lanelet_map);
 
-  for (lanelet::LineString3d & line : lanelet_map->lineStringLayer) {
-    if (!line.hasAttribute(lanelet::AttributeName::Type)) continue;
+    // NOTE: Under construction
+    // if (lanelet_map->polygonLayer.size() > 0)
+    //   *cloud_ += sample_from_polygons(lanelet_map->polygonLayer);
 
-    lanelet::Attribute attr = line.attribute(lanelet::AttributeName::Type);
-    if (visible_labels.count(attr.value()) == 0) continue;
-
-    lanelet::ConstPoint3d const * from = nullptr;
-    for (const lanelet::ConstPoint3d & p : line) {
-      if (from != nullptr) upsample_line_string(*from, p, upsampled_cloud);
-      from = &p;
-    }
+    common::Timer timer;
+    grid_.build(cloud_);
+    RCLCPP_INFO_STREAM(
+      get_logger(), "built ground grid with " << grid_.cell_count() << " cells and "
+                                              << grid_.layer_count() << " layers in " << timer);
   }
 
-  // NOTE: Under construction
-  // if (lanelet_map->polygonLayer.size() > 0)
-  //   *upsampled_cloud += sample_from_polygons(lanelet_map->polygonLayer);
-
-  cloud_ = pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
-  pcl::VoxelGrid<pcl::PointXYZ> filter;
-  filter.setInputCloud(upsampled_cloud);
-  filter.setLeafSize(1.0f, 1.0f, 1.0f);
-  filter.filter(*cloud_);
-
   kdtree_ = pcl::make_shared<pcl::KdTreeFLANN<pcl::PointXYZ>>();
   kdtree_->setInputCloud(cloud_);
 }
 
+bool GroundServer::load_from_bundle(const HADMapBin & msg)
+{
+  if (map_bundle_path_.empty()) return false;
+
+  std::string error;
+  const auto bundle = ll2_decomposer::open_map_bundle(map_bundle_path_, msg, &error);
+  if (!bundle) {
+    RCLCPP_WARN_STREAM(get_logger(), error);
+    return false;
+  }
+
+  auto cloud = read_ground_cloud(*bundle);
+  if (!cloud || !grid_.read(*bundle)) {
+    RCLCPP_WARN_STREAM(
+      get_logger(), "map bundle " << map_bundle_path_ << " has no ground grid of the parameters");
+    return false;
+  }
+  cloud_ = cloud;
+  RCLCPP_INFO_STREAM(get_logger(), "loaded ground grid from " << map_bundle_path_);
+  return true;
+}
+
 float GroundServer::estimate_height_simply(const geometry_msgs::msg::Point & point) const
 {
+  const auto layer = grid_.query(point.x, point.y, -std::numeric_limits<float>::infinity());
+  if (layer.has_value()) return layer->height;
+
   // NOTE: Sometimes it might give not-accurate height
   constexpr float sq_radius = 3.0 * 3.0;
   const float x = point.x;
@@ -159,79 +169,30 @@ float GroundServer::estimate_height_simply(const geometry_msgs::msg::Point & poi
   return std::isfinite(height) ? height : 0;
 }
 
-std::vector<int> GroundServer::estimate_inliers_by_ransac(const std::vector<int> & indices_raw)
-{
-  pcl::PointIndicesPtr indices(new pcl::PointIndices);
-  indices->indices = indices_raw;
-
-  pcl::ModelCoefficients::Ptr coefficients(new pcl::ModelCoefficients);
-  pcl::PointIndices::Ptr inliers(new pcl::PointIndices);
-
-  pcl::SACSegmentation<pcl::PointXYZ> seg;
-  seg.setOptimizeCoefficients(true);
-  seg.setModelType(pcl::SACMODEL_PLANE);
-  seg.setMethodType(pcl::SAC_RANSAC);
-  seg.setDistanceThreshold(1.0);
-  seg.setProbability(0.6);
-
-  seg.setInputCloud(cloud_);
-  seg.setIndices(indices);
-  seg.segment(*inliers, *coefficients);
-  return inliers->indices;
-}
-
 GroundServer::GroundPlane GroundServer::estimate_ground(const Point & point)
 {
   const float predicted_z = height_filter_.get_estimate();
-  const pcl::PointXYZ xyz(point.x, point.y, predicted_z);
-
-  std::vector<int> raw_indices;
-  std::vector<float> distances;
-  kdtree_->nearestKSearch(xyz, K, raw_indices, distances);
-
-  std::vector<int> indices = estimate_inliers_by_ransac(raw_indices);
-
-  if (indices.empty()) indices = raw_indices;
-  last_indices_ = indices;
-
-  // Estimate normal vector using covariance matrix around the target point
-  Eigen::Matrix3f covariance;
-  Eigen::Vector4f centroid;
-  pcl::compute3DCentroid(*cloud_, indices, centroid);
-  pcl::computeCovarianceMatrix(*cloud_, indices, centroid, covariance);
-
-  // NOTE: I forgot why I don't use coefficients computeed by SACSegmentation
-  Eigen::Vector4f plane_parameter;
-  float curvature;
-  pcl::solvePlaneParameters(covariance, centroid, plane_parameter, curvature);
-  Eigen::Vector3f normal = plane_parameter.topRows(3).normalized();
-
-  {
-    // Reverse if it is upside down
-    if (normal.z() < 0) normal = -normal;
-
-    // Remove NaN
-    if (!normal.allFinite()) {
-      normal = Eigen::Vector3f::UnitZ();
-      RCLCPP_WARN_STREAM(get_logger(), "Reject NaN tilt");
-    }
-    // Remove too large tilt (0.707 = cos(45deg))
-    if ((normal.dot(Eigen::Vector3f::UnitZ())) < 0.707) {
-      normal = Eigen::Vector3f::UnitZ();
-      RCLCPP_WARN_STREAM(get_logger(), "Reject too large tilt of ground");
-    }
-  }
-
-  const Eigen::Vector3f filt_normal = normal_filter_.update(normal);
 
   GroundPlane plane;
   plane.xyz = Eigen::Vector3f(point.x, point.y, predicted_z);
-  plane.normal = filt_normal;
 
-  // Compute z value by intersection of estimated plane and orthogonal line
-  {
-    Eigen::Vector3f center = centroid.topRows(3);
-    float inner = center.dot(plane.normal);
+  // The layer nearest to the current height is taken, so that overpasses are distinguished
+  if (const auto layer = grid_.query(point.x, point.y, predicted_z)) {
+    last_indices_.clear();
+    plane.normal = normal_filter_.update(layer->normal);
+    plane.xyz.z() = layer->height;
+  } else {
+    // Out of the grid. Estimate from the neighbors in the same way as the grid construction.
+    const pcl::PointXYZ xyz(point.x, point.y, predicted_z);
+    std::vector<int> raw_indices;
+    std::vector<float> distances;
+    kdtree_->nearestKSearch(xyz, K, raw_indices, distances);
+
+    const auto [centroid, normal] = fit_ground_plane(cloud_, raw_indices, &last_indices_);
+    plane.normal = normal_filter_.update(normal);
+
+    // Compute z value by intersection of estimated plane and orthogonal line
+    float inner = centroid.dot(plane.normal);
     float px_nx = point.x * plane.normal.x();
     float py_ny = point.y * plane.normal.y();
     plane.xyz.z() = (inner - px_nx - py_ny) / plane.normal.z();
@@ -0,0 +1,108 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ground_server/ground_grid.hpp"
+
+#include <ll2_decomposer/decompose.hpp>
+#include <ll2_decomposer/from_bin_msg.hpp>
+#include <ll2_decomposer/map_bundle.hpp>
+#include <rclcpp/rclcpp.hpp>
+#include <yabloc_common/timer.hpp>
+
+#include <autoware_auto_mapping_msgs/msg/had_map_bin.hpp>
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace yabloc::ground_server
+{
+/**
+ * Write the map bundle of the vector map, and then exit
+ *
+ * The bundle contains everything ll2_decomposer, ground_server and camera_pose_initializer derive
+ * from the vector map, so that they skip the deserialization and the preprocessing at startup.
+ * Give the same labels and grid parameters as those nodes, since a node falls back to the online
+ * preprocessing if they differ.
+ */
+class MapBundleTool : public rclcpp::Node
+{
+public:
+  using HADMapBin = autoware_auto_mapping_msgs::msg::HADMapBin;
+
+  MapBundleTool()
+  : Node("map_bundle_tool"),
+    output_path_(declare_parameter("output_path", std::string{})),
+    grid_(
+      declare_parameter("grid_cell_size", 1.0), declare_parameter("K", 50),
+      declare_parameter("grid_layer_separation", 3.0), declare_parameter("grid_max_distance", 10.0))
+  {
+    using std::placeholders::_1;
+    const rclcpp::QoS map_qos = rclcpp::QoS(10).transient_local().reliable();
+
+    auto load_lanelet2_labels =
+      [this](const std::string & param_name, std::set<std::string> & labels) -> void {
+      declare_parameter(param_name, std::vector<std::string>{});
+      auto label_array = get_parameter(param_name).as_string_array();
+      for (auto l : label_array) labels.insert(l);
+    };
+    load_lanelet2_labels("road_marking_labels", road_marking_labels_);
+    load_lanelet2_labels("sign_board_labels", sign_board_labels_);
+    load_lanelet2_labels("bounding_box_labels", bounding_box_labels_);
+
+    if (output_path_.empty()) throw std::runtime_error("output_path is not given");
+
+    auto on_map = std::bind(&MapBundleTool::on_map, this, _1);
+    sub_map_ = create_subscription<HADMapBin>("/map/vector_map", map_qos, on_map);
+  }
+
+private:
+  const std::string output_path_;
+  GroundGrid grid_;
+  std::set<std::string> road_marking_labels_;
+  std::set<std::string> sign_board_labels_;
+  std::set<std::string> bounding_box_labels_;
+  rclcpp::Subscription<HADMapBin>::SharedPtr sub_map_;
+
+  void on_map(const HADMapBin & msg)
+  {
+    common::Timer timer;
+    lanelet::LaneletMapPtr lanelet_map = ll2_decomposer::from_bin_msg(msg);
+
+    ll2_decomposer::MapBundleWriter writer;
+    const auto decomposed = ll2_decomposer::decompose(
+      *lanelet_map, road_marking_labels_, sign_board_labels_, bounding_box_labels_);
+    ll2_decomposer::write_decomposed_map(
+      writer, decomposed, road_marking_labels_, sign_board_labels_, bounding_box_labels_);
+    ll2_decomposer::write_lanes(writer, ll2_decomposer::extract_lanes(lanelet_map->laneletLayer));
+
+    const auto cloud = sample_ground_cloud(*lanelet_map);
+    grid_.build(cloud);
+    write_ground_cloud(writer, *cloud);
+    grid_.write(writer);
+
+    writer.write(output_path_, ll2_decomposer::hash_map_bin(msg));
+    RCLCPP_INFO_STREAM(get_logger(), "wrote map bundle " << output_path_ << " in " << timer);
+    rclcpp::shutdown();
+  }
+};
+}  // namespace yabloc::ground_server
+
+int main(int argc, char * argv[])
+{
+  rclcpp::init(argc, argv);
+  rclcpp::spin(std::make_shared<yabloc::ground_server::MapBundleTool>());
+  rclcpp::shutdown();
+  return 0;
+}
@@ -0,0 +1,142 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ground_server/ground_grid.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace ground_server = yabloc::ground_server;
+
+// Points on z = height + slope * x, sampled like voxelized road markings
+void add_plane(
+  pcl::PointCloud<pcl::PointXYZ> & cloud, float x0, float x1, float y0, float y1, float height,
+  float slope)
+{
+  for (float x = x0; x <= x1; x += 1.0f) {
+    for (float y = y0; y <= y1; y += 1.0f) {
+      cloud.push_back(pcl::PointXYZ(x, y, height + slope * x));
+    }
+  }
+}
+
+TEST(GroundGridTestSuite, slope)
+{
+  auto cloud = pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+  add_plane(*cloud, 0, 30, 0, 30, 1.0f, 0.1f);
+
+  ground_server::GroundGrid grid(1.0f, 50, 3.0f, 5.0f);
+  grid.build(cloud);
+  ASSERT_FALSE(grid.empty());
+
+  const Eigen::Vector3f expected_normal = Eigen::Vector3f(-0.1f, 0, 1).normalized();
+  for (float x : {5.3f, 14.5f, 22.8f}) {
+    for (float y : {7.1f, 15.f}) {
+      const auto layer = grid.query(x, y, 0);
+      ASSERT_TRUE(layer.has_value());
+      EXPECT_NEAR(layer->height, 1.0f + 0.1f * x, 0.05f);
+      EXPECT_GT(layer->normal.dot(expected_normal), 0.999f);
+    }
+  }
+
+  // Far from the map
+  EXPECT_FALSE(grid.query(100, 100, 0).has_value());
+}
+
+TEST(GroundGridTestSuite, multiLevel)
+{
+  // An overpass at 8m crosses over the ground road at 0m
+  auto cloud = pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+  add_plane(*cloud, 0, 40, 15, 25, 0.0f, 0.0f);
+  add_plane(*cloud, 15, 25, 0, 40, 8.0f, 0.0f);
+
+  ground_server::GroundGrid grid(1.0f, 50, 3.0f, 5.0f);
+  grid.build(cloud);
+
+  const auto lower = grid.query(20.2f, 20.7f, 1.0f);
+  const auto upper = grid.query(20.2f, 20.7f, 7.0f);
+  ASSERT_TRUE(lower.has_value());
+  ASSERT_TRUE(upper.has_value());
+  EXPECT_NEAR(lower->height, 0.0f, 0.05f);
+  EXPECT_NEAR(upper->height, 8.0f, 0.05f);
+
+  // The lowest layer is selected by -infinity
+  const auto lowest = grid.query(20.2f, 20.7f, -std::numeric_limits<float>::infinity());
+  ASSERT_TRUE(lowest.has_value());
+  EXPECT_NEAR(lowest->height, 0.0f, 0.05f);
+
+  // Only one layer away from the crossing
+  const auto single = grid.query(3.0f, 20.0f, 7.0f);
+  ASSERT_TRUE(single.has_value());
+  EXPECT_NEAR(single->height, 0.0f, 0.05f);
+}
+
+TEST(GroundGridTestSuite, batchQuery)
+{
+  auto cloud = pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+  add_plane(*cloud, 0, 40, 15, 25, 0.0f, 0.0f);
+  add_plane(*cloud, 15, 25, 0, 40, 8.0f, 0.0f);
+
+  ground_server::GroundGrid grid(1.0f, 50, 3.0f, 5.0f);
+  grid.build(cloud);
+
+  // Each position keeps its own layer
+  const std::vector<Eigen::Vector3f> positions = {
+    {20.f, 20.f, 0.5f}, {20.f, 20.f, 7.5f}, {3.f, 20.f, 0.f}, {100.f, 100.f, 0.f}};
+  const std::vector<float> heights = grid.query_heights(positions);
+  ASSERT_EQ(heights.size(), positions.size());
+  for (size_t i = 0; i < 3; i++) {
+    const Eigen::Vector3f & p = positions[i];
+    const auto layer = grid.query(p.x(), p.y(), p.z());
+    ASSERT_TRUE(layer.has_value());
+    EXPECT_FLOAT_EQ(heights[i], layer->height);
+  }
+  EXPECT_NEAR(heights[1], 8.0f, 0.05f);
+  EXPECT_TRUE(std::isnan(heights[3]));
+}
+
+TEST(GroundGridTestSuite, bundle)
+{
+  auto cloud = pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+  add_plane(*cloud, 0, 20, 0, 20, 1.0f, 0.1f);
+
+  ground_server::GroundGrid grid(1.0f, 50, 3.0f, 5.0f);
+  grid.build(cloud);
+
+  const std::string path = ::testing::TempDir() + "/ground_grid.bundle";
+  yabloc::ll2_decomposer::MapBundleWriter writer;
+  grid.write(writer);
+  ground_server::write_ground_cloud(writer, *cloud);
+  writer.write(path, 0);
+
+  const yabloc::ll2_decomposer::MapBundle bundle(path);
+  ground_server::GroundGrid loaded(1.0f, 50, 3.0f, 5.0f);
+  ASSERT_TRUE(loaded.read(bundle));
+  EXPECT_EQ(loaded.cell_count(), grid.cell_count());
+  EXPECT_EQ(loaded.layer_count(), grid.layer_count());
+  const auto loaded_layer = loaded.query(10.3f, 5.6f, 0);
+  const auto built_layer = grid.query(10.3f, 5.6f, 0);
+  ASSERT_TRUE(loaded_layer.has_value());
+  ASSERT_TRUE(built_layer.has_value());
+  EXPECT_FLOAT_EQ(loaded_layer->height, built_layer->height);
+  EXPECT_EQ(ground_server::read_ground_cloud(bundle)->size(), cloud->size());
+
+  // The grid built with other parameters must not be used
+  ground_server::GroundGrid other(0.5f, 50, 3.0f, 5.0f);
+  EXPECT_FALSE(other.read(bundle));
+}
@@ -0,0 +1,132 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "ll2_decomposer/map_bundle.hpp"
+
+#include <Eigen/Core>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace yabloc::ll2_decomposer
+{
+/**
+ * Elements of the map which ll2_decomposer publishes
+ *
+ * A line segment is represented as a PointNormal whose xyz and normal_xyz are its end points.
+ * A polygon is represented as its vertices labeled with the index of the polygon.
+ */
+struct DecomposedMap
+{
+  pcl::PointCloud<pcl::PointNormal> road_marking;
+  pcl::PointCloud<pcl::PointNormal> sign_board;
+  // Only for visualization
+  pcl::PointCloud<pcl::PointNormal> virtual_line;
+  pcl::PointCloud<pcl::PointXYZL> transition_area;
+  pcl::PointCloud<pcl::PointXYZL> bounding_box;
+  pcl::PointCloud<pcl::PointXYZL> road_area;
+};
+
+// 2D outline of a lanelet
+struct Lane
+{
+  std::vector<Eigen::Vector2f> right;
+  std::vector<Eigen::Vector2f> left;
+  std::vector<Eigen::Vector2f> centerline;
+  Eigen::Vector2f min;
+  Eigen::Vector2f max;
+};
+
+/**
+ * Type labels interned as the bit sets of their categories
+ *
+ * A type can belong to several categories, e.g. both road marking and sign board. Every primitive
+ * is classified by a single lookup instead of a lookup per label set.
+ */
+class LabelTable
+{
+public:
+  enum Category : uint8_t {
+    ROAD_MARKING = 1 << 0,
+    SIGN_BOARD = 1 << 1,
+    BOUNDING_BOX = 1 << 2,
+    INIT_AREA = 1 << 3,
+    DEINIT_AREA = 1 << 4,
+    VIRTUAL = 1 << 5,
+  };
+
+  LabelTable(
+    const std::set<std::string> & road_marking_labels,
+    const std::set<std::string> & sign_board_labels,
+    const std::set<std::string> & bounding_box_labels);
+
+  // Return 0 if the type of the primitive is not in any category
+  uint8_t categories(const lanelet::AttributeMap & attributes) const;
+
+private:
+  std::unordered_map<std::string, uint8_t> categories_;
+};
+
+// Primitives of the map sorted by their categories in a single pass over the layers
+struct ClassifiedMap
+{
+  lanelet::ConstLineStrings3d road_marking;
+  lanelet::ConstLineStrings3d sign_board;
+  lanelet::ConstLineStrings3d virtual_line;
+  // Init and deinit areas in the order of the polygon layer
+  lanelet::ConstPolygons3d transition_area;
+  std::vector<bool> is_deinit_area;
+  lanelet::ConstPolygons3d bounding_box;
+};
+
+ClassifiedMap classify(const lanelet::LaneletMap & lanelet_map, const LabelTable & table);
+
+pcl::PointCloud<pcl::PointNormal> split_line_strings(
+  const lanelet::ConstLineStrings3d & line_strings);
+
+DecomposedMap decompose(const ClassifiedMap & classified, const lanelet::LaneletLayer & lanelets);
+
+DecomposedMap decompose(
+  const lanelet::LaneletMap & lanelet_map, const std::set<std::string> & road_marking_labels,
+  const std::set<std::string> & sign_board_labels,
+  const std::set<std::string> & bounding_box_labels);
+
+std::vector<Lane> extract_lanes(const lanelet::LaneletLayer & lanelets);
+
+// Labels are recorded in the metadata, so that a loader can check its own labels
+void write_decomposed_map(
+  MapBundleWriter & writer, const DecomposedMap & decomposed,
+  const std::set<std::string> & road_marking_labels,
+  const std::set<std::string> & sign_board_labels,
+  const std::set<std::string> & bounding_box_labels);
+
+// Return false if the bundle has no decomposed map or it is made with other labels
+bool read_decomposed_map(
+  const MapBundle & bundle, const std::set<std::string> & road_marking_labels,
+  const std::set<std::string> & sign_board_labels,
+  const std::set<std::string> & bounding_box_labels, DecomposedMap * decomposed);
+
+void write_lanes(MapBundleWriter & writer, const std::vector<Lane> & lanes);
+
+// Return false if the bundle has no lanes
+bool read_lanes(const MapBundle & bundle, std::vector<Lane> * lanes);
+}  // namespace yabloc::ll2_decomposer
@@ -20,4 +20,7 @@
 namespace yabloc ::ll2_decomposer
 {
 lanelet::LaneletMapPtr from_bin_msg(const autoware_auto_mapping_msgs::msg::HADMapBin & msg);
+
+// Inverse of from_bin_msg(), e.g. to feed a generated map to the nodes
+autoware_auto_mapping_msgs::msg::HADMapBin to_bin_msg(const lanelet::LaneletMap & map);
 }
\ No newline at end of file
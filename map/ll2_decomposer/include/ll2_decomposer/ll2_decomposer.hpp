@@ -13,9 +13,13 @@
 // limitations under the License.
 
 #pragma once
+#include "ll2_decomposer/decompose.hpp"
+#include "ll2_decomposer/tiled_map.hpp"
+
 #include <rclcpp/rclcpp.hpp>
 
 #include <autoware_auto_mapping_msgs/msg/had_map_bin.hpp>
+#include <geometry_msgs/msg/pose_stamped.hpp>
 #include <sensor_msgs/msg/image.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
 #include <visualization_msgs/msg/marker_array.hpp>
@@ -24,6 +28,10 @@
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
+#include <memory>
+#include <set>
+#include <string>
+
 namespace yabloc::ll2_decomposer
 {
 class Ll2Decomposer : public rclcpp::Node
@@ -33,6 +41,7 @@ public:
   using HADMapBin = autoware_auto_mapping_msgs::msg::HADMapBin;
   using Marker = visualization_msgs::msg::Marker;
   using MarkerArray = visualization_msgs::msg::MarkerArray;
+  using PoseStamped = geometry_msgs::msg::PoseStamped;
 
   Ll2Decomposer();
 
@@ -41,35 +50,30 @@ private:
   rclcpp::Publisher<Cloud2>::SharedPtr pub_sign_board_;
   rclcpp::Publisher<Cloud2>::SharedPtr pub_transition_area_;
   rclcpp::Publisher<Cloud2>::SharedPtr pub_bounding_box_;
+  rclcpp::Publisher<Cloud2>::SharedPtr pub_road_area_;
   rclcpp::Publisher<MarkerArray>::SharedPtr pub_marker_;
 
   rclcpp::Subscription<HADMapBin>::SharedPtr sub_map_;
+  rclcpp::Subscription<PoseStamped>::SharedPtr sub_pose_;
+  // Preprocessed bundle used instead of the vector map if it is made from the same map
+  const std::string map_bundle_path_;
   std::set<std::string> road_marking_labels_;
   std::set<std::string> sign_board_labels_;
   std::set<std::string> bounding_box_labels_;
 
-  void on_map(const HADMapBin & msg);
-
-  pcl::PointNormal to_point_normal(
-    const lanelet::ConstPoint3d & from, const lanelet::ConstPoint3d & to) const;
-
-  pcl::PointCloud<pcl::PointNormal> split_line_strings(
-    const lanelet::ConstLineStrings3d & line_strings);
+  // If it is available, only the tiles within tile_radius_ from the pose are published
+  std::unique_ptr<TiledMap> tiled_map_{nullptr};
+  float tile_radius_{0};
 
-  pcl::PointCloud<pcl::PointXYZL> load_bounding_boxes(const lanelet::PolygonLayer & polygons) const;
+  void on_map(const HADMapBin & msg);
+  void on_pose(const PoseStamped & msg);
 
-  lanelet::ConstLineStrings3d extract_specified_line_string(
-    const lanelet::LineStringLayer & line_strings, const std::set<std::string> & visible_labels);
-  lanelet::ConstPolygons3d extract_specified_polygon(
-    const lanelet::PolygonLayer & polygon_layer, const std::set<std::string> & visible_labels);
+  void publish_decomposed_map(const DecomposedMap & decomposed, const rclcpp::Time & stamp);
 
-  MarkerArray make_sign_marker_msg(
-    const lanelet::LineStringLayer & line_string_layer, const std::set<std::string> & labels,
-    const std::string & ns);
-  MarkerArray make_polygon_marker_msg(
-    const lanelet::PolygonLayer & polygon_layer, const std::set<std::string> & labels,
-    const std::string & ns);
+  // Return false if the bundle is not available for the map
+  bool load_from_bundle(const HADMapBin & msg, DecomposedMap * decomposed);
 
-  void publish_additional_marker(const lanelet::LaneletMapPtr & lanelet_map);
+  // Markers of the decomposed map, which replace all previous markers
+  MarkerArray make_decomposed_marker_msg(const DecomposedMap & decomposed);
 };
 }  // namespace yabloc::ll2_decomposer
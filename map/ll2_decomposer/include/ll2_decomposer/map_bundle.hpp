@@ -0,0 +1,133 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <autoware_auto_mapping_msgs/msg/had_map_bin.hpp>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace yabloc::ll2_decomposer
+{
+// FNV-1a hash of the serialized map, which identifies the map a bundle is made from
+uint64_t hash_map_bin(const autoware_auto_mapping_msgs::msg::HADMapBin & msg);
+
+// Read-only array of records, which refers to the memory of a MapBundle
+template <typename T>
+class SectionView
+{
+public:
+  SectionView() = default;
+  SectionView(const T * data, size_t size) : data_(data), size_(size) {}
+
+  const T * data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const T & operator[](size_t i) const { return data_[i]; }
+  const T * begin() const { return data_; }
+  const T * end() const { return data_ + size_; }
+
+private:
+  const T * data_{nullptr};
+  size_t size_{0};
+};
+
+/**
+ * Preprocessed data derived from a lanelet2 map, stored in a memory mapped file
+ *
+ * The file consists of a header, a table of named sections, and the sections themselves.
+ *   Header       : magic "YLCMAPB\0", version, number of sections, hash of the source map
+ *   SectionEntry : name (32 bytes), offset, size  x number of sections
+ *   sections     : arrays of trivially copyable records, each aligned to 16 bytes
+ * Since all values are stored in the native byte order, a section is read in place.
+ * Key-value strings are stored in the section "metadata".
+ */
+class MapBundle
+{
+public:
+  static constexpr uint32_t VERSION = 2;
+
+  // Throw std::runtime_error if the file is not a bundle of the current version
+  explicit MapBundle(const std::string & path);
+  ~MapBundle();
+  MapBundle(const MapBundle &) = delete;
+  MapBundle & operator=(const MapBundle &) = delete;
+
+  uint64_t source_hash() const { return source_hash_; }
+
+  bool has_section(const std::string & name) const { return sections_.count(name) > 0; }
+
+  // Return an empty view if the section does not exist
+  template <typename T>
+  SectionView<T> section(const std::string & name) const
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const auto itr = sections_.find(name);
+    if (itr == sections_.end()) return {};
+    const auto [data, size] = itr->second;
+    if (size % sizeof(T) != 0) {
+      throw std::runtime_error("map bundle section " + name + " is broken");
+    }
+    return {reinterpret_cast<const T *>(data), size / sizeof(T)};
+  }
+
+  // Return an empty string if the key does not exist
+  std::string metadata(const std::string & key) const;
+
+private:
+  void * mapped_{nullptr};
+  size_t mapped_size_{0};
+  uint64_t source_hash_{0};
+  std::map<std::string, std::pair<const uint8_t *, size_t>> sections_;
+  std::map<std::string, std::string> metadata_;
+};
+
+class MapBundleWriter
+{
+public:
+  template <typename T>
+  void add_section(const std::string & name, const std::vector<T> & records)
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    add_section(name, records.data(), records.size() * sizeof(T));
+  }
+
+  void add_section(const std::string & name, const void * data, size_t size);
+
+  void set_metadata(const std::string & key, const std::string & value);
+
+  // Throw std::runtime_error if the file can not be written
+  void write(const std::string & path, uint64_t source_hash) const;
+
+private:
+  std::map<std::string, std::vector<uint8_t>> sections_;
+  std::map<std::string, std::string> metadata_;
+};
+
+/**
+ * Open the bundle and check that it is made from the map of msg
+ *
+ * @param[out] error the reason if the bundle is not available
+ * @return nullptr if the bundle is not available
+ */
+std::unique_ptr<MapBundle> open_map_bundle(
+  const std::string & path, const autoware_auto_mapping_msgs::msg::HADMapBin & msg,
+  std::string * error);
+}  // namespace yabloc::ll2_decomposer
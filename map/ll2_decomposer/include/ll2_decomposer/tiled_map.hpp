@@ -0,0 +1,84 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "ll2_decomposer/decompose.hpp"
+
+#include <Eigen/Core>
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace yabloc::ll2_decomposer
+{
+/**
+ * Square tiles of the decomposed map, to publish only the neighborhood of the vehicle
+ *
+ * Every line segment and polygon is registered to all tiles its bounding box overlaps. A tile is
+ * active if it overlaps the circle around the current position. Transition areas are few, so they
+ * are not tiled and always extracted.
+ */
+class TiledMap
+{
+public:
+  explicit TiledMap(float tile_size);
+
+  void build(const DecomposedMap & decomposed);
+
+  bool empty() const { return tile_count_ == 0; }
+
+  size_t tile_count() const { return tile_count_; }
+  size_t active_tile_count() const { return active_tiles_.size(); }
+
+  // Return true if the active tiles are changed by the new position
+  bool update(const Eigen::Vector2f & position, float radius);
+
+  // Return the elements in the active tiles. Each element is extracted once.
+  DecomposedMap extract_active() const;
+
+private:
+  // Indices of the elements registered to each tile
+  using TileTable = std::unordered_map<int64_t, std::vector<uint32_t>>;
+  // [begin, end) of the points of each polygon
+  using PolygonRanges = std::vector<std::pair<uint32_t, uint32_t>>;
+
+  const float tile_size_;
+  size_t tile_count_{0};
+  DecomposedMap source_;
+  PolygonRanges bounding_box_ranges_;
+  PolygonRanges road_area_ranges_;
+  TileTable road_marking_tiles_;
+  TileTable sign_board_tiles_;
+  TileTable virtual_line_tiles_;
+  TileTable bounding_box_tiles_;
+  TileTable road_area_tiles_;
+
+  // Sorted keys of the active tiles
+  std::vector<int64_t> active_tiles_;
+
+  int tile_index(float v) const;
+
+  void register_box(
+    const Eigen::Vector2f & min, const Eigen::Vector2f & max, uint32_t index, TileTable & table);
+
+  void register_segments(const pcl::PointCloud<pcl::PointNormal> & segments, TileTable & table);
+
+  PolygonRanges register_polygons(
+    const pcl::PointCloud<pcl::PointXYZL> & polygons, TileTable & table);
+
+  std::vector<uint32_t> collect_active(const TileTable & table) const;
+};
+}  // namespace yabloc::ll2_decomposer
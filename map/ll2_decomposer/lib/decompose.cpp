@@ -0,0 +1,378 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ll2_decomposer/decompose.hpp"
+
+#include <lanelet2_core/primitives/Lanelet.h>
+
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <utility>
+
+namespace yabloc::ll2_decomposer
+{
+namespace
+{
+struct SegmentRecord
+{
+  float from[3];
+  float to[3];
+};
+
+struct LabeledPointRecord
+{
+  float xyz[3];
+  uint32_t label;
+};
+
+struct Point2Record
+{
+  float x;
+  float y;
+};
+
+struct BoundsRecord
+{
+  float min[2];
+  float max[2];
+};
+
+std::string join_labels(const std::set<std::string> & labels)
+{
+  std::string joined;
+  for (const auto & label : labels) joined += (joined.empty() ? "" : ",") + label;
+  return joined;
+}
+
+void add_segments(
+  MapBundleWriter & writer, const std::string & name,
+  const pcl::PointCloud<pcl::PointNormal> & cloud)
+{
+  std::vector<SegmentRecord> records;
+  records.reserve(cloud.size());
+  for (const pcl::PointNormal & pn : cloud) {
+    records.push_back({{pn.x, pn.y, pn.z}, {pn.normal_x, pn.normal_y, pn.normal_z}});
+  }
+  writer.add_section(name, records);
+}
+
+pcl::PointCloud<pcl::PointNormal> read_segments(const MapBundle & bundle, const std::string & name)
+{
+  pcl::PointCloud<pcl::PointNormal> cloud;
+  for (const SegmentRecord & record : bundle.section<SegmentRecord>(name)) {
+    pcl::PointNormal pn;
+    pn.x = record.from[0];
+    pn.y = record.from[1];
+    pn.z = record.from[2];
+    pn.normal_x = record.to[0];
+    pn.normal_y = record.to[1];
+    pn.normal_z = record.to[2];
+    cloud.push_back(pn);
+  }
+  return cloud;
+}
+
+void add_labeled_points(
+  MapBundleWriter & writer, const std::string & name,
+  const pcl::PointCloud<pcl::PointXYZL> & cloud)
+{
+  std::vector<LabeledPointRecord> records;
+  records.reserve(cloud.size());
+  for (const pcl::PointXYZL & p : cloud) records.push_back({{p.x, p.y, p.z}, p.label});
+  writer.add_section(name, records);
+}
+
+pcl::PointCloud<pcl::PointXYZL> read_labeled_points(
+  const MapBundle & bundle, const std::string & name)
+{
+  pcl::PointCloud<pcl::PointXYZL> cloud;
+  for (const LabeledPointRecord & record : bundle.section<LabeledPointRecord>(name)) {
+    pcl::PointXYZL xyzl;
+    xyzl.x = record.xyz[0];
+    xyzl.y = record.xyz[1];
+    xyzl.z = record.xyz[2];
+    xyzl.label = record.label;
+    cloud.push_back(xyzl);
+  }
+  return cloud;
+}
+
+template <typename LineString>
+std::vector<Eigen::Vector2f> to_polyline(const LineString & line_string)
+{
+  std::vector<Eigen::Vector2f> polyline;
+  polyline.reserve(line_string.size());
+  for (const auto & p : line_string) polyline.emplace_back(p.x(), p.y());
+  return polyline;
+}
+}  // namespace
+
+LabelTable::LabelTable(
+  const std::set<std::string> & road_marking_labels,
+  const std::set<std::string> & sign_board_labels,
+  const std::set<std::string> & bounding_box_labels)
+{
+  for (const auto & label : road_marking_labels) categories_[label] |= ROAD_MARKING;
+  for (const auto & label : sign_board_labels) categories_[label] |= SIGN_BOARD;
+  for (const auto & label : bounding_box_labels) categories_[label] |= BOUNDING_BOX;
+  categories_["yabloc_init_area"] |= INIT_AREA;
+  categories_["yabloc_deinit_area"] |= DEINIT_AREA;
+  categories_["virtual"] |= VIRTUAL;
+}
+
+uint8_t LabelTable::categories(const lanelet::AttributeMap & attributes) const
+{
+  const auto attr = attributes.find(lanelet::AttributeName::Type);
+  if (attr == attributes.end()) return 0;
+  const auto itr = categories_.find(attr->second.value());
+  return (itr == categories_.end()) ? 0 : itr->second;
+}
+
+ClassifiedMap classify(const lanelet::LaneletMap & lanelet_map, const LabelTable & table)
+{
+  ClassifiedMap classified;
+  for (const lanelet::ConstLineString3d & line : lanelet_map.lineStringLayer) {
+    const uint8_t categories = table.categories(line.attributes());
+    if (categories == 0) continue;
+    if (categories & LabelTable::ROAD_MARKING) classified.road_marking.push_back(line);
+    if (categories & LabelTable::SIGN_BOARD) classified.sign_board.push_back(line);
+    if (categories & LabelTable::VIRTUAL) classified.virtual_line.push_back(line);
+  }
+  for (const lanelet::ConstPolygon3d & polygon : lanelet_map.polygonLayer) {
+    const uint8_t categories = table.categories(polygon.attributes());
+    if (categories == 0) continue;
+    if (categories & (LabelTable::INIT_AREA | LabelTable::DEINIT_AREA)) {
+      classified.transition_area.push_back(polygon);
+      classified.is_deinit_area.push_back((categories & LabelTable::DEINIT_AREA) != 0);
+    }
+    if (categories & LabelTable::BOUNDING_BOX) classified.bounding_box.push_back(polygon);
+  }
+  return classified;
+}
+
+pcl::PointCloud<pcl::PointNormal> split_line_strings(
+  const lanelet::ConstLineStrings3d & line_strings)
+{
+  size_t segment_count = 0;
+  for (const lanelet::ConstLineString3d & line : line_strings) {
+    if (line.size() > 1) segment_count += line.size() - 1;
+  }
+
+  pcl::PointCloud<pcl::PointNormal> extracted;
+  extracted.reserve(segment_count);
+  for (const lanelet::ConstLineString3d & line : line_strings) {
+    lanelet::ConstPoint3d const * from = nullptr;
+    for (const lanelet::ConstPoint3d & to : line) {
+      if (from != nullptr) {
+        pcl::PointNormal pn;
+        pn.x = from->x();
+        pn.y = from->y();
+        pn.z = from->z();
+        pn.normal_x = to.x();
+        pn.normal_y = to.y();
+        pn.normal_z = to.z();
+        extracted.push_back(pn);
+      }
+      from = &to;
+    }
+  }
+  return extracted;
+}
+
+namespace
+{
+// Each polygon is labeled by its index and the offset of label_offset(index)
+template <typename LabelOffset>
+pcl::PointCloud<pcl::PointXYZL> load_polygons(
+  const lanelet::ConstPolygons3d & polygons, LabelOffset label_offset)
+{
+  pcl::PointCloud<pcl::PointXYZL> cloud;
+  for (size_t index = 0; index < polygons.size(); index++) {
+    for (const lanelet::ConstPoint3d & p : polygons[index]) {
+      pcl::PointXYZL xyzl;
+      xyzl.x = p.x();
+      xyzl.y = p.y();
+      xyzl.z = p.z();
+      xyzl.label = index + label_offset(index);
+      cloud.push_back(xyzl);
+    }
+  }
+  return cloud;
+}
+
+pcl::PointCloud<pcl::PointXYZL> load_road_areas(const lanelet::LaneletLayer & lanelets)
+{
+  pcl::PointCloud<pcl::PointXYZL> cloud;
+  int index = 0;
+
+  // Every lanelet is regarded as a part of the road area
+  for (const lanelet::ConstLanelet & lanelet : lanelets) {
+    for (const lanelet::ConstPoint3d & p : lanelet.polygon3d()) {
+      pcl::PointXYZL xyzl;
+      xyzl.x = p.x();
+      xyzl.y = p.y();
+      xyzl.z = p.z();
+      xyzl.label = index;
+      cloud.push_back(xyzl);
+    }
+    index++;
+  }
+  return cloud;
+}
+}  // namespace
+
+DecomposedMap decompose(const ClassifiedMap & classified, const lanelet::LaneletLayer & lanelets)
+{
+  // The clouds are independent of each other, so they are built concurrently
+  auto road_marking = std::async(std::launch::async, [&classified] {
+    return split_line_strings(classified.road_marking);
+  });
+  auto sign_board = std::async(std::launch::async, [&classified] {
+    return split_line_strings(classified.sign_board);
+  });
+  auto virtual_line = std::async(std::launch::async, [&classified] {
+    return split_line_strings(classified.virtual_line);
+  });
+  auto road_area =
+    std::async(std::launch::async, [&lanelets] { return load_road_areas(lanelets); });
+
+  DecomposedMap decomposed;
+  // Deinit areas are distinguished by the offset of 512
+  decomposed.transition_area = load_polygons(
+    classified.transition_area,
+    [&classified](size_t index) { return classified.is_deinit_area[index] ? 512 : 0; });
+  decomposed.bounding_box = load_polygons(classified.bounding_box, [](size_t) { return 0; });
+  decomposed.road_marking = road_marking.get();
+  decomposed.sign_board = sign_board.get();
+  decomposed.virtual_line = virtual_line.get();
+  decomposed.road_area = road_area.get();
+  return decomposed;
+}
+
+DecomposedMap decompose(
+  const lanelet::LaneletMap & lanelet_map, const std::set<std::string> & road_marking_labels,
+  const std::set<std::string> & sign_board_labels,
+  const std::set<std::string> & bounding_box_labels)
+{
+  const LabelTable table(road_marking_labels, sign_board_labels, bounding_box_labels);
+  return decompose(classify(lanelet_map, table), lanelet_map.laneletLayer);
+}
+
+std::vector<Lane> extract_lanes(const lanelet::LaneletLayer & lanelets)
+{
+  std::vector<Lane> lanes;
+  lanes.reserve(lanelets.size());
+  for (const lanelet::ConstLanelet & lanelet : lanelets) {
+    Lane lane;
+    lane.right = to_polyline(lanelet.rightBound2d());
+    lane.left = to_polyline(lanelet.leftBound2d());
+    lane.centerline = to_polyline(lanelet.centerline2d());
+
+    lane.min.setConstant(std::numeric_limits<float>::max());
+    lane.max.setConstant(std::numeric_limits<float>::lowest());
+    for (const auto * bound : {&lane.right, &lane.left}) {
+      for (const Eigen::Vector2f & p : *bound) {
+        lane.min = lane.min.cwiseMin(p);
+        lane.max = lane.max.cwiseMax(p);
+      }
+    }
+    lanes.push_back(std::move(lane));
+  }
+  return lanes;
+}
+
+void write_decomposed_map(
+  MapBundleWriter & writer, const DecomposedMap & decomposed,
+  const std::set<std::string> & road_marking_labels,
+  const std::set<std::string> & sign_board_labels,
+  const std::set<std::string> & bounding_box_labels)
+{
+  add_segments(writer, "road_marking", decomposed.road_marking);
+  add_segments(writer, "sign_board", decomposed.sign_board);
+  add_segments(writer, "virtual_line", decomposed.virtual_line);
+  add_labeled_points(writer, "transition_area", decomposed.transition_area);
+  add_labeled_points(writer, "bounding_box", decomposed.bounding_box);
+  add_labeled_points(writer, "road_area", decomposed.road_area);
+
+  writer.set_metadata("road_marking_labels", join_labels(road_marking_labels));
+  writer.set_metadata("sign_board_labels", join_labels(sign_board_labels));
+  writer.set_metadata("bounding_box_labels", join_labels(bounding_box_labels));
+}
+
+bool read_decomposed_map(
+  const MapBundle & bundle, const std::set<std::string> & road_marking_labels,
+  const std::set<std::string> & sign_board_labels,
+  const std::set<std::string> & bounding_box_labels, DecomposedMap * decomposed)
+{
+  if (!bundle.has_section("road_marking")) return false;
+  if (bundle.metadata("road_marking_labels") != join_labels(road_marking_labels)) return false;
+  if (bundle.metadata("sign_board_labels") != join_labels(sign_board_labels)) return false;
+  if (bundle.metadata("bounding_box_labels") != join_labels(bounding_box_labels)) return false;
+
+  decomposed->road_marking = read_segments(bundle, "road_marking");
+  decomposed->sign_board = read_segments(bundle, "sign_board");
+  decomposed->virtual_line = read_segments(bundle, "virtual_line");
+  decomposed->transition_area = read_labeled_points(bundle, "transition_area");
+  decomposed->bounding_box = read_labeled_points(bundle, "bounding_box");
+  decomposed->road_area = read_labeled_points(bundle, "road_area");
+  return true;
+}
+
+void write_lanes(MapBundleWriter & writer, const std::vector<Lane> & lanes)
+{
+  // The polylines of the i-th lane are right, left and centerline, whose ranges in lane_points are
+  // given by lane_offsets[3i] ~ lane_offsets[3i+3]
+  std::vector<uint32_t> offsets = {0};
+  std::vector<Point2Record> points;
+  std::vector<BoundsRecord> bounds;
+  for (const Lane & lane : lanes) {
+    for (const auto * polyline : {&lane.right, &lane.left, &lane.centerline}) {
+      for (const Eigen::Vector2f & p : *polyline) points.push_back({p.x(), p.y()});
+      offsets.push_back(points.size());
+    }
+    bounds.push_back({{lane.min.x(), lane.min.y()}, {lane.max.x(), lane.max.y()}});
+  }
+  writer.add_section("lane_offsets", offsets);
+  writer.add_section("lane_points", points);
+  writer.add_section("lane_bounds", bounds);
+}
+
+bool read_lanes(const MapBundle & bundle, std::vector<Lane> * lanes)
+{
+  const auto offsets = bundle.section<uint32_t>("lane_offsets");
+  const auto points = bundle.section<Point2Record>("lane_points");
+  const auto bounds = bundle.section<BoundsRecord>("lane_bounds");
+  if (offsets.empty() || offsets.size() != 3 * bounds.size() + 1) return false;
+  // Every range must lie in lane_points, which holds if the offsets go from 0 to its size in order
+  if (offsets[0] != 0 || offsets[offsets.size() - 1] != points.size()) return false;
+  if (!std::is_sorted(offsets.begin(), offsets.end())) return false;
+
+  lanes->clear();
+  lanes->reserve(bounds.size());
+  for (size_t i = 0; i < bounds.size(); i++) {
+    Lane lane;
+    std::vector<Eigen::Vector2f> * polylines[3] = {&lane.right, &lane.left, &lane.centerline};
+    for (size_t k = 0; k < 3; k++) {
+      for (uint32_t j = offsets[3 * i + k]; j < offsets[3 * i + k + 1]; j++) {
+        polylines[k]->emplace_back(points[j].x, points[j].y);
+      }
+    }
+    lane.min = Eigen::Vector2f(bounds[i].min[0], bounds[i].min[1]);
+    lane.max = Eigen::Vector2f(bounds[i].max[0], bounds[i].max[1]);
+    lanes->push_back(std::move(lane));
+  }
+  return true;
+}
+}  // namespace yabloc::ll2_decomposer
@@ -17,6 +17,7 @@
 #include <lanelet2_extension/regulatory_elements/detection_area.hpp>
 
 #include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
 
 #include <lanelet2_io/io_handlers/Serialize.h>
 
@@ -39,4 +40,19 @@ lanelet::LaneletMapPtr from_bin_msg(const autoware_auto_mapping_msgs::msg::HADMa
   return map;
 }
 
+autoware_auto_mapping_msgs::msg::HADMapBin to_bin_msg(const lanelet::LaneletMap & map)
+{
+  std::stringstream ss;
+  boost::archive::binary_oarchive oa(ss);
+  oa << map;
+  // The id counter follows the map, in the same way as lanelet2_extension does
+  lanelet::Id id_counter = lanelet::utils::getId();
+  oa << id_counter;
+
+  const std::string data_str = ss.str();
+  autoware_auto_mapping_msgs::msg::HADMapBin msg;
+  msg.data.assign(data_str.begin(), data_str.end());
+  return msg;
+}
+
 }  // namespace yabloc::ll2_decomposer
\ No newline at end of file
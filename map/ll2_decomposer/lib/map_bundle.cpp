@@ -0,0 +1,214 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ll2_decomposer/map_bundle.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace yabloc::ll2_decomposer
+{
+namespace
+{
+constexpr char MAGIC[8] = {'Y', 'L', 'C', 'M', 'A', 'P', 'B', '\0'};
+constexpr size_t ALIGNMENT = 16;
+constexpr size_t NAME_LENGTH = 32;
+const std::string METADATA_SECTION = "metadata";
+
+struct Header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t section_count;
+  uint64_t source_hash;
+};
+
+struct SectionEntry
+{
+  char name[NAME_LENGTH];
+  uint64_t offset;
+  uint64_t size;
+};
+
+size_t align(size_t offset) { return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+}  // namespace
+
+uint64_t hash_map_bin(const autoware_auto_mapping_msgs::msg::HADMapBin & msg)
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (const uint8_t byte : msg.data) {
+    hash ^= byte;
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+MapBundle::MapBundle(const std::string & path)
+{
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("failed to open map bundle " + path);
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+    ::close(fd);
+    throw std::runtime_error("map bundle " + path + " is too small");
+  }
+  mapped_size_ = st.st_size;
+  mapped_ = ::mmap(nullptr, mapped_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapped_ == MAP_FAILED) {
+    mapped_ = nullptr;
+    throw std::runtime_error("failed to map map bundle " + path);
+  }
+
+  // The mapping must be released if the constructor throws
+  auto fail = [this, &path](const std::string & reason) {
+    ::munmap(mapped_, mapped_size_);
+    mapped_ = nullptr;
+    return std::runtime_error("map bundle " + path + " " + reason);
+  };
+
+  const auto * bytes = static_cast<const uint8_t *>(mapped_);
+  Header header;
+  std::memcpy(&header, bytes, sizeof(Header));
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) throw fail("has no magic number");
+  if (header.version != VERSION) {
+    throw fail(
+      "is version " + std::to_string(header.version) + " but " + std::to_string(VERSION) +
+      " is required");
+  }
+  source_hash_ = header.source_hash;
+
+  const size_t table_end = sizeof(Header) + header.section_count * sizeof(SectionEntry);
+  if (table_end > mapped_size_) throw fail("has a broken section table");
+
+  for (uint32_t i = 0; i < header.section_count; i++) {
+    SectionEntry entry;
+    std::memcpy(&entry, bytes + sizeof(Header) + i * sizeof(SectionEntry), sizeof(SectionEntry));
+    if (entry.offset % ALIGNMENT != 0 || entry.offset + entry.size > mapped_size_) {
+      throw fail("has a broken section table");
+    }
+    const std::string name(entry.name, strnlen(entry.name, NAME_LENGTH));
+    sections_[name] = {bytes + entry.offset, entry.size};
+  }
+
+  // Parse "key=value" lines
+  const auto text = section<char>(METADATA_SECTION);
+  std::istringstream stream(std::string(text.begin(), text.end()));
+  std::string line;
+  while (std::getline(stream, line)) {
+    const size_t pos = line.find('=');
+    if (pos == std::string::npos) continue;
+    metadata_[line.substr(0, pos)] = line.substr(pos + 1);
+  }
+}
+
+MapBundle::~MapBundle()
+{
+  if (mapped_) ::munmap(mapped_, mapped_size_);
+}
+
+std::string MapBundle::metadata(const std::string & key) const
+{
+  const auto itr = metadata_.find(key);
+  return itr != metadata_.end() ? itr->second : std::string{};
+}
+
+void MapBundleWriter::add_section(const std::string & name, const void * data, size_t size)
+{
+  if (name.size() >= NAME_LENGTH || name == METADATA_SECTION) {
+    throw std::invalid_argument("invalid map bundle section name " + name);
+  }
+  const auto * bytes = static_cast<const uint8_t *>(data);
+  sections_[name].assign(bytes, bytes + size);
+}
+
+void MapBundleWriter::set_metadata(const std::string & key, const std::string & value)
+{
+  if (key.find_first_of("=\n") != std::string::npos || value.find('\n') != std::string::npos) {
+    throw std::invalid_argument("invalid map bundle metadata " + key);
+  }
+  metadata_[key] = value;
+}
+
+void MapBundleWriter::write(const std::string & path, uint64_t source_hash) const
+{
+  std::string metadata;
+  for (const auto & [key, value] : metadata_) metadata += key + "=" + value + "\n";
+
+  std::vector<std::pair<std::string, std::pair<const uint8_t *, size_t>>> sections;
+  for (const auto & [name, bytes] : sections_) {
+    sections.push_back({name, {bytes.data(), bytes.size()}});
+  }
+  sections.push_back(
+    {METADATA_SECTION, {reinterpret_cast<const uint8_t *>(metadata.data()), metadata.size()}});
+
+  Header header;
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = MapBundle::VERSION;
+  header.section_count = sections.size();
+  header.source_hash = source_hash;
+
+  std::vector<SectionEntry> entries;
+  size_t offset = align(sizeof(Header) + sections.size() * sizeof(SectionEntry));
+  for (const auto & [name, data] : sections) {
+    SectionEntry entry{};
+    std::strncpy(entry.name, name.c_str(), NAME_LENGTH - 1);
+    entry.offset = offset;
+    entry.size = data.second;
+    entries.push_back(entry);
+    offset = align(offset + data.second);
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) throw std::runtime_error("failed to open " + path);
+
+  file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+  file.write(
+    reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(SectionEntry));
+  size_t written = sizeof(Header) + entries.size() * sizeof(SectionEntry);
+  const char padding[ALIGNMENT] = {};
+  for (size_t i = 0; i < sections.size(); i++) {
+    file.write(padding, entries[i].offset - written);
+    file.write(reinterpret_cast<const char *>(sections[i].second.first), entries[i].size);
+    written = entries[i].offset + entries[i].size;
+  }
+  if (!file) throw std::runtime_error("failed to write " + path);
+}
+
+std::unique_ptr<MapBundle> open_map_bundle(
+  const std::string & path, const autoware_auto_mapping_msgs::msg::HADMapBin & msg,
+  std::string * error)
+{
+  std::unique_ptr<MapBundle> bundle;
+  try {
+    bundle = std::make_unique<MapBundle>(path);
+  } catch (const std::runtime_error & e) {
+    if (error) *error = e.what();
+    return nullptr;
+  }
+
+  if (bundle->source_hash() != hash_map_bin(msg)) {
+    if (error) *error = "map bundle " + path + " is made from another map";
+    return nullptr;
+  }
+  return bundle;
+}
+}  // namespace yabloc::ll2_decomposer
@@ -0,0 +1,162 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ll2_decomposer/tiled_map.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+namespace yabloc::ll2_decomposer
+{
+namespace
+{
+int64_t tile_key(int x, int y)
+{
+  return (static_cast<int64_t>(x) << 32) | static_cast<uint32_t>(y);
+}
+}  // namespace
+
+TiledMap::TiledMap(float tile_size) : tile_size_(tile_size) {}
+
+int TiledMap::tile_index(float v) const { return static_cast<int>(std::floor(v / tile_size_)); }
+
+void TiledMap::register_box(
+  const Eigen::Vector2f & min, const Eigen::Vector2f & max, uint32_t index, TileTable & table)
+{
+  for (int x = tile_index(min.x()); x <= tile_index(max.x()); x++) {
+    for (int y = tile_index(min.y()); y <= tile_index(max.y()); y++) {
+      table[tile_key(x, y)].push_back(index);
+    }
+  }
+}
+
+void TiledMap::register_segments(
+  const pcl::PointCloud<pcl::PointNormal> & segments, TileTable & table)
+{
+  for (uint32_t i = 0; i < segments.size(); i++) {
+    const Eigen::Vector2f from = segments.at(i).getVector3fMap().topRows(2);
+    const Eigen::Vector2f to = segments.at(i).getNormalVector3fMap().topRows(2);
+    register_box(from.cwiseMin(to), from.cwiseMax(to), i, table);
+  }
+}
+
+TiledMap::PolygonRanges TiledMap::register_polygons(
+  const pcl::PointCloud<pcl::PointXYZL> & polygons, TileTable & table)
+{
+  // The consecutive points which share the same label form a polygon
+  PolygonRanges ranges;
+  for (uint32_t begin = 0; begin < polygons.size();) {
+    uint32_t end = begin;
+    Eigen::Vector2f min = polygons.at(begin).getVector3fMap().topRows(2);
+    Eigen::Vector2f max = min;
+    while (end < polygons.size() && polygons.at(end).label == polygons.at(begin).label) {
+      min = min.cwiseMin(polygons.at(end).getVector3fMap().topRows(2));
+      max = max.cwiseMax(polygons.at(end).getVector3fMap().topRows(2));
+      end++;
+    }
+    register_box(min, max, ranges.size(), table);
+    ranges.emplace_back(begin, end);
+    begin = end;
+  }
+  return ranges;
+}
+
+void TiledMap::build(const DecomposedMap & decomposed)
+{
+  source_ = decomposed;
+  road_marking_tiles_.clear();
+  sign_board_tiles_.clear();
+  virtual_line_tiles_.clear();
+  bounding_box_tiles_.clear();
+  road_area_tiles_.clear();
+  active_tiles_.clear();
+
+  register_segments(source_.road_marking, road_marking_tiles_);
+  register_segments(source_.sign_board, sign_board_tiles_);
+  register_segments(source_.virtual_line, virtual_line_tiles_);
+  bounding_box_ranges_ = register_polygons(source_.bounding_box, bounding_box_tiles_);
+  road_area_ranges_ = register_polygons(source_.road_area, road_area_tiles_);
+
+  std::unordered_set<int64_t> keys;
+  for (const TileTable * table :
+       {&road_marking_tiles_, &sign_board_tiles_, &virtual_line_tiles_, &bounding_box_tiles_,
+        &road_area_tiles_}) {
+    for (const auto & entry : *table) keys.insert(entry.first);
+  }
+  tile_count_ = keys.size();
+}
+
+bool TiledMap::update(const Eigen::Vector2f & position, float radius)
+{
+  std::vector<int64_t> tiles;
+  const float squared_radius = radius * radius;
+  for (int x = tile_index(position.x() - radius); x <= tile_index(position.x() + radius); x++) {
+    for (int y = tile_index(position.y() - radius); y <= tile_index(position.y() + radius); y++) {
+      // Distance from the position to the nearest point of the tile
+      const Eigen::Vector2f min(x * tile_size_, y * tile_size_);
+      const Eigen::Vector2f max = min + Eigen::Vector2f::Constant(tile_size_);
+      const Eigen::Vector2f gap = (min - position).cwiseMax(position - max).cwiseMax(0.f);
+      if (gap.squaredNorm() <= squared_radius) tiles.push_back(tile_key(x, y));
+    }
+  }
+  std::sort(tiles.begin(), tiles.end());
+
+  if (tiles == active_tiles_) return false;
+  active_tiles_ = std::move(tiles);
+  return true;
+}
+
+std::vector<uint32_t> TiledMap::collect_active(const TileTable & table) const
+{
+  std::vector<uint32_t> indices;
+  for (const int64_t key : active_tiles_) {
+    const auto itr = table.find(key);
+    if (itr == table.end()) continue;
+    indices.insert(indices.end(), itr->second.begin(), itr->second.end());
+  }
+  // Keep the original order so that the output is the same as the whole map within the radius
+  std::sort(indices.begin(), indices.end());
+  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+  return indices;
+}
+
+DecomposedMap TiledMap::extract_active() const
+{
+  DecomposedMap active;
+  for (const uint32_t i : collect_active(road_marking_tiles_)) {
+    active.road_marking.push_back(source_.road_marking.at(i));
+  }
+  for (const uint32_t i : collect_active(sign_board_tiles_)) {
+    active.sign_board.push_back(source_.sign_board.at(i));
+  }
+  for (const uint32_t i : collect_active(virtual_line_tiles_)) {
+    active.virtual_line.push_back(source_.virtual_line.at(i));
+  }
+  for (const uint32_t i : collect_active(bounding_box_tiles_)) {
+    const auto [begin, end] = bounding_box_ranges_.at(i);
+    for (uint32_t j = begin; j < end; j++) {
+      active.bounding_box.push_back(source_.bounding_box.at(j));
+    }
+  }
+  for (const uint32_t i : collect_active(road_area_tiles_)) {
+    const auto [begin, end] = road_area_ranges_.at(i);
+    for (uint32_t j = begin; j < end; j++) {
+      active.road_area.push_back(source_.road_area.at(j));
+    }
+  }
+  active.transition_area = source_.transition_area;
+  return active;
+}
+}  // namespace yabloc::ll2_decomposer
@@ -16,6 +16,7 @@
 #include "ll2_decomposer/ll2_decomposer.hpp"
 
 #include <yabloc_common/color.hpp>
+#include <yabloc_common/line_segments_msg.hpp>
 #include <yabloc_common/pub_sub.hpp>
 
 #include <geometry_msgs/msg/polygon.hpp>
@@ -24,7 +25,8 @@
 
 namespace yabloc::ll2_decomposer
 {
-Ll2Decomposer::Ll2Decomposer() : Node("ll2_to_image")
+Ll2Decomposer::Ll2Decomposer()
+: Node("ll2_to_image"), map_bundle_path_(declare_parameter("map_bundle_path", std::string{}))
 {
   using std::placeholders::_1;
   const rclcpp::QoS latch_qos = rclcpp::QoS(10).transient_local();
@@ -35,6 +37,7 @@ Ll2Decomposer::Ll2Decomposer() : Node("ll2_to_image")
   pub_sign_board_ = create_publisher<Cloud2>("ll2_sign_board", latch_qos);
   pub_transition_area_ = create_publisher<Cloud2>("ll2_transition_area", latch_qos);
   pub_bounding_box_ = create_publisher<Cloud2>("ll2_bounding_box", latch_qos);
+  pub_road_area_ = create_publisher<Cloud2>("ll2_road_area", latch_qos);
   pub_marker_ = create_publisher<MarkerArray>("sign_board_marker", latch_qos);
 
   // Subscriber
@@ -56,6 +59,14 @@ Ll2Decomposer::Ll2Decomposer() : Node("ll2_to_image")
     RCLCPP_FATAL_STREAM(
       get_logger(), "There are no road marking labels. No LL2 elements will publish");
   }
+
+  // Optional modules
+  if (declare_parameter("use_tiles", false)) {
+    tiled_map_ = std::make_unique<TiledMap>(declare_parameter("tile_size", 100.0));
+    tile_radius_ = declare_parameter("tile_radius", 300.0);
+    auto cb_pose = std::bind(&Ll2Decomposer::on_pose, this, _1);
+    sub_pose_ = create_subscription<PoseStamped>("pose", 10, cb_pose);
+  }
 }
 
 void print_attr(const lanelet::LaneletMapPtr & lanelet_map, const rclcpp::Logger & logger)
@@ -79,217 +90,147 @@ void print_attr(const lanelet::LaneletMapPtr & lanelet_map, const rclcpp::Logger
   }
 }
 
-pcl::PointCloud<pcl::PointXYZL> Ll2Decomposer::load_bounding_boxes(
-  const lanelet::PolygonLayer & polygons) const
-{
-  pcl::PointCloud<pcl::PointXYZL> cloud;
-  int index = 0;
-
-  for (const lanelet::ConstPolygon3d & polygon : polygons) {
-    if (!polygon.hasAttribute(lanelet::AttributeName::Type)) continue;
-    lanelet::Attribute attr = polygon.attribute(lanelet::AttributeName::Type);
-    if (bounding_box_labels_.count(attr.value()) == 0) continue;
-
-    for (const lanelet::ConstPoint3d & p : polygon) {
-      pcl::PointXYZL xyzl;
-      xyzl.x = p.x();
-      xyzl.y = p.y();
-      xyzl.z = p.z();
-      xyzl.label = index;
-      cloud.push_back(xyzl);
-    }
-    index++;
-  }
-  return cloud;
-}
-
-pcl::PointCloud<pcl::PointXYZL> load_transition_areas(const lanelet::PolygonLayer & polygons)
-{
-  pcl::PointCloud<pcl::PointXYZL> cloud;
-  int index = 0;
-
-  for (const lanelet::ConstPolygon3d & polygon : polygons) {
-    if (!polygon.hasAttribute(lanelet::AttributeName::Type)) continue;
-    lanelet::Attribute attr = polygon.attribute(lanelet::AttributeName::Type);
-    bool is_init_label = (attr.value() == "yabloc_init_area");
-    bool is_deinit_label = (attr.value() == "yabloc_deinit_area");
-    if (!is_init_label && !is_deinit_label) continue;
-
-    for (const lanelet::ConstPoint3d & p : polygon) {
-      pcl::PointXYZL xyzl;
-      xyzl.x = p.x();
-      xyzl.y = p.y();
-      xyzl.z = p.z();
-      xyzl.label = (is_deinit_label) ? index + (512) : index;
-      cloud.push_back(xyzl);
-    }
-    index++;
-  }
-  return cloud;
-}
-
 void Ll2Decomposer::on_map(const HADMapBin & msg)
 {
   RCLCPP_INFO_STREAM(get_logger(), "subscribed binary vector map");
-  lanelet::LaneletMapPtr lanelet_map = from_bin_msg(msg);
-  print_attr(lanelet_map, get_logger());
-
   const rclcpp::Time stamp = msg.header.stamp;
 
-  const auto & ls_layer = lanelet_map->lineStringLayer;
-  const auto & po_layer = lanelet_map->polygonLayer;
-  auto tmp1 = extract_specified_line_string(ls_layer, sign_board_labels_);
-  auto tmp2 = extract_specified_line_string(ls_layer, road_marking_labels_);
-  pcl::PointCloud<pcl::PointNormal> ll2_sign_board = split_line_strings(tmp1);
-  pcl::PointCloud<pcl::PointNormal> ll2_road_marking = split_line_strings(tmp2);
-  pcl::PointCloud<pcl::PointXYZL> ll2_transition_area = load_transition_areas(po_layer);
-  pcl::PointCloud<pcl::PointXYZL> ll2_bounding_box = load_bounding_boxes(po_layer);
+  DecomposedMap decomposed;
+  if (!load_from_bundle(msg, &decomposed)) {
+    lanelet::LaneletMapPtr lanelet_map = from_bin_msg(msg);
+    print_attr(lanelet_map, get_logger());
 
-  publish_additional_marker(lanelet_map);
+    const LabelTable table(road_marking_labels_, sign_board_labels_, bounding_box_labels_);
+    const ClassifiedMap classified = classify(*lanelet_map, table);
+    decomposed = decompose(classified, lanelet_map->laneletLayer);
+  }
 
-  common::publish_cloud(*pub_road_marking_, ll2_road_marking, stamp);
-  common::publish_cloud(*pub_sign_board_, ll2_sign_board, stamp);
-  common::publish_cloud(*pub_transition_area_, ll2_transition_area, stamp);
-  common::publish_cloud(*pub_bounding_box_, ll2_bounding_box, stamp);
+  if (tiled_map_) {
+    // Nothing is published until the first pose arrives
+    tiled_map_->build(decomposed);
+    RCLCPP_INFO_STREAM(get_logger(), "indexed map by " << tiled_map_->tile_count() << " tiles");
+    return;
+  }
 
+  publish_decomposed_map(decomposed, stamp);
+  pub_marker_->publish(make_decomposed_marker_msg(decomposed));
   RCLCPP_INFO_STREAM(get_logger(), "successed map decomposing");
 }
 
-pcl::PointCloud<pcl::PointNormal> Ll2Decomposer::split_line_strings(
-  const lanelet::ConstLineStrings3d & line_strings)
+void Ll2Decomposer::on_pose(const PoseStamped & msg)
 {
-  pcl::PointCloud<pcl::PointNormal> extracted;
-  for (const lanelet::ConstLineString3d & line : line_strings) {
-    lanelet::ConstPoint3d const * from = nullptr;
-    for (const lanelet::ConstPoint3d & to : line) {
-      if (from != nullptr) {
-        pcl::PointNormal pn = to_point_normal(*from, to);
-        extracted.push_back(pn);
-      }
-      from = &to;
-    }
-  }
-  return extracted;
+  if (tiled_map_->empty()) return;
+
+  const Eigen::Vector2f position(msg.pose.position.x, msg.pose.position.y);
+  if (!tiled_map_->update(position, tile_radius_)) return;
+
+  // All the messages are replaced, so the elements of the inactive tiles are removed
+  const DecomposedMap active = tiled_map_->extract_active();
+  publish_decomposed_map(active, msg.header.stamp);
+  pub_marker_->publish(make_decomposed_marker_msg(active));
+  RCLCPP_INFO_STREAM(
+    get_logger(), "published " << tiled_map_->active_tile_count() << " tiles with "
+                               << active.road_marking.size() << " road markings");
 }
 
-lanelet::ConstLineStrings3d Ll2Decomposer::extract_specified_line_string(
-  const lanelet::LineStringLayer & line_string_layer, const std::set<std::string> & visible_labels)
+void Ll2Decomposer::publish_decomposed_map(
+  const DecomposedMap & decomposed, const rclcpp::Time & stamp)
 {
-  lanelet::ConstLineStrings3d line_strings;
-  for (const lanelet::ConstLineString3d & line : line_string_layer) {
-    if (!line.hasAttribute(lanelet::AttributeName::Type)) continue;
-    lanelet::Attribute attr = line.attribute(lanelet::AttributeName::Type);
-    if (visible_labels.count(attr.value()) == 0) continue;
-    line_strings.push_back(line);
-  }
-  return line_strings;
+  common::publish_line_segments(*pub_road_marking_, decomposed.road_marking, stamp);
+  common::publish_line_segments(*pub_sign_board_, decomposed.sign_board, stamp);
+  common::publish_cloud(*pub_transition_area_, decomposed.transition_area, stamp);
+  common::publish_cloud(*pub_bounding_box_, decomposed.bounding_box, stamp);
+  common::publish_cloud(*pub_road_area_, decomposed.road_area, stamp);
 }
 
-lanelet::ConstPolygons3d Ll2Decomposer::extract_specified_polygon(
-  const lanelet::PolygonLayer & polygon_layer, const std::set<std::string> & visible_labels)
+bool Ll2Decomposer::load_from_bundle(const HADMapBin & msg, DecomposedMap * decomposed)
 {
-  lanelet::ConstPolygons3d polygons;
-  for (const lanelet::ConstPolygon3d & polygon : polygon_layer) {
-    if (!polygon.hasAttribute(lanelet::AttributeName::Type)) continue;
-    lanelet::Attribute attr = polygon.attribute(lanelet::AttributeName::Type);
-    if (visible_labels.count(attr.value()) == 0) continue;
-    polygons.push_back(polygon);
-  }
-  return polygons;
-}
+  if (map_bundle_path_.empty()) return false;
 
-pcl::PointNormal Ll2Decomposer::to_point_normal(
-  const lanelet::ConstPoint3d & from, const lanelet::ConstPoint3d & to) const
-{
-  pcl::PointNormal pn;
-  pn.x = from.x();
-  pn.y = from.y();
-  pn.z = from.z();
-  pn.normal_x = to.x();
-  pn.normal_y = to.y();
-  pn.normal_z = to.z();
-  return pn;
+  std::string error;
+  const auto bundle = open_map_bundle(map_bundle_path_, msg, &error);
+  if (!bundle) {
+    RCLCPP_WARN_STREAM(get_logger(), error);
+    return false;
+  }
+  if (!read_decomposed_map(
+        *bundle, road_marking_labels_, sign_board_labels_, bounding_box_labels_, decomposed)) {
+    RCLCPP_WARN_STREAM(get_logger(), "map bundle " << map_bundle_path_ << " has other labels");
+    return false;
+  }
+  RCLCPP_INFO_STREAM(get_logger(), "loaded decomposed map from " << map_bundle_path_);
+  return true;
 }
 
-Ll2Decomposer::MarkerArray Ll2Decomposer::make_sign_marker_msg(
-  const lanelet::LineStringLayer & line_string_layer, const std::set<std::string> & labels,
-  const std::string & ns)
+Ll2Decomposer::MarkerArray Ll2Decomposer::make_decomposed_marker_msg(
+  const DecomposedMap & decomposed)
 {
-  lanelet::ConstLineStrings3d line_strings =
-    extract_specified_line_string(line_string_layer, labels);
-
   MarkerArray marker_array;
-  int id = 0;
-  for (const lanelet::ConstLineString3d & line_string : line_strings) {
+  {
     Marker marker;
-    marker.header.frame_id = "map";
-    marker.header.stamp = get_clock()->now();
-    marker.type = Marker::LINE_STRIP;
-    marker.color = common::Color(0.6f, 0.6f, 0.6f, 0.999f);
-    marker.scale.x = 0.1;
-    marker.ns = ns;
-    marker.id = id++;
-
-    for (const lanelet::ConstPoint3d & p : line_string) {
-      geometry_msgs::msg::Point gp;
-      gp.x = p.x();
-      gp.y = p.y();
-      gp.z = p.z();
-      marker.points.push_back(gp);
-    }
+    marker.action = Marker::DELETEALL;
     marker_array.markers.push_back(marker);
   }
-  return marker_array;
-}
 
-Ll2Decomposer::MarkerArray Ll2Decomposer::make_polygon_marker_msg(
-  const lanelet::PolygonLayer & polygon_layer, const std::set<std::string> & labels,
-  const std::string & ns)
-{
-  lanelet::ConstPolygons3d polygons = extract_specified_polygon(polygon_layer, labels);
+  auto gen_point = [](const auto & p) -> geometry_msgs::msg::Point {
+    geometry_msgs::msg::Point gp;
+    gp.x = p.x;
+    gp.y = p.y;
+    gp.z = p.z;
+    return gp;
+  };
 
-  MarkerArray marker_array;
-  int id = 0;
-  for (const lanelet::ConstPolygon3d & polygon : polygons) {
+  // Each segment is drawn as a pair of points of a line list
+  auto add_segments = [&](
+                        const pcl::PointCloud<pcl::PointNormal> & segments,
+                        const std::string & ns) {
     Marker marker;
     marker.header.frame_id = "map";
     marker.header.stamp = get_clock()->now();
-    marker.type = Marker::LINE_STRIP;
-    marker.color = common::Color(0.4f, 0.4f, 0.8f, 0.999f);
-    marker.scale.x = 0.2;
+    marker.type = Marker::LINE_LIST;
+    marker.color = common::Color(0.6f, 0.6f, 0.6f, 0.999f);
+    marker.scale.x = 0.1;
     marker.ns = ns;
-    marker.id = id++;
-
-    auto gen_point = [](const lanelet::ConstPoint3d & p) -> geometry_msgs::msg::Point {
-      geometry_msgs::msg::Point gp;
-      gp.x = p.x();
-      gp.y = p.y();
-      gp.z = p.z();
-      return gp;
-    };
-
-    for (const lanelet::ConstPoint3d & p : polygon) marker.points.push_back(gen_point(p));
-    marker.points.push_back(gen_point(polygon.front()));
+    for (const pcl::PointNormal & pn : segments) {
+      marker.points.push_back(gen_point(pn));
+      geometry_msgs::msg::Point to;
+      to.x = pn.normal_x;
+      to.y = pn.normal_y;
+      to.z = pn.normal_z;
+      marker.points.push_back(to);
+    }
+    if (!marker.points.empty()) marker_array.markers.push_back(marker);
+  };
+  add_segments(decomposed.sign_board, "sign_board");
+  add_segments(decomposed.virtual_line, "virtual");
+
+  // The consecutive points which share the same label form a polygon
+  auto add_polygons = [&](
+                        const pcl::PointCloud<pcl::PointXYZL> & polygons, const std::string & ns) {
+    int id = 0;
+    for (size_t begin = 0; begin < polygons.size();) {
+      Marker marker;
+      marker.header.frame_id = "map";
+      marker.header.stamp = get_clock()->now();
+      marker.type = Marker::LINE_STRIP;
+      marker.color = common::Color(0.4f, 0.4f, 0.8f, 0.999f);
+      marker.scale.x = 0.2;
+      marker.ns = ns;
+      marker.id = id++;
+
+      size_t end = begin;
+      while (end < polygons.size() && polygons.at(end).label == polygons.at(begin).label) {
+        marker.points.push_back(gen_point(polygons.at(end++)));
+      }
+      marker.points.push_back(gen_point(polygons.at(begin)));
+      marker_array.markers.push_back(marker);
+      begin = end;
+    }
+  };
+  add_polygons(decomposed.transition_area, "transition_area");
+  add_polygons(decomposed.bounding_box, "bounding_box");
 
-    marker_array.markers.push_back(marker);
-  }
   return marker_array;
 }
 
-void Ll2Decomposer::publish_additional_marker(const lanelet::LaneletMapPtr & lanelet_map)
-{
-  auto marker1 =
-    make_sign_marker_msg(lanelet_map->lineStringLayer, sign_board_labels_, "sign_board");
-  auto marker2 = make_sign_marker_msg(lanelet_map->lineStringLayer, {"virtual"}, "virtual");
-  auto marker3 = make_polygon_marker_msg(
-    lanelet_map->polygonLayer, {"yabloc_init_area", "yabloc_deinit_area"}, "transition_area");
-  auto marker4 =
-    make_polygon_marker_msg(lanelet_map->polygonLayer, {"bounding_box"}, "bounding_box");
-
-  std::copy(marker2.markers.begin(), marker2.markers.end(), std::back_inserter(marker1.markers));
-  std::copy(marker3.markers.begin(), marker3.markers.end(), std::back_inserter(marker1.markers));
-  std::copy(marker4.markers.begin(), marker4.markers.end(), std::back_inserter(marker1.markers));
-  pub_marker_->publish(marker1);
-}
-
-}  // namespace yabloc::ll2_decomposer
\ No newline at end of file
+}  // namespace yabloc::ll2_decomposer
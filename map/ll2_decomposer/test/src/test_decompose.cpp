@@ -0,0 +1,98 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ll2_decomposer/decompose.hpp"
+
+#include <gtest/gtest.h>
+#include <lanelet2_core/utility/Utilities.h>
+
+#include <string>
+
+namespace ll2 = yabloc::ll2_decomposer;
+
+lanelet::LineString3d make_line_string(const std::string & type, double y)
+{
+  lanelet::LineString3d line(
+    lanelet::utils::getId(), {lanelet::Point3d(lanelet::utils::getId(), 0, y, 0),
+                              lanelet::Point3d(lanelet::utils::getId(), 1, y, 0),
+                              lanelet::Point3d(lanelet::utils::getId(), 2, y, 0)});
+  line.attributes()[lanelet::AttributeName::Type] = type;
+  return line;
+}
+
+lanelet::Polygon3d make_polygon(const std::string & type, double x)
+{
+  lanelet::Polygon3d polygon(
+    lanelet::utils::getId(), {lanelet::Point3d(lanelet::utils::getId(), x, 0, 0),
+                              lanelet::Point3d(lanelet::utils::getId(), x + 1, 0, 0),
+                              lanelet::Point3d(lanelet::utils::getId(), x + 1, 1, 0)});
+  polygon.attributes()[lanelet::AttributeName::Type] = type;
+  return polygon;
+}
+
+TEST(DecomposeTestSuite, labelTable)
+{
+  const ll2::LabelTable table({"line_thin", "pedestrian_marking"}, {"pedestrian_marking"}, {});
+
+  lanelet::AttributeMap attributes;
+  EXPECT_EQ(table.categories(attributes), 0);
+  attributes[lanelet::AttributeName::Type] = "line_thin";
+  EXPECT_EQ(table.categories(attributes), ll2::LabelTable::ROAD_MARKING);
+  attributes[lanelet::AttributeName::Type] = "pedestrian_marking";
+  EXPECT_EQ(
+    table.categories(attributes), ll2::LabelTable::ROAD_MARKING | ll2::LabelTable::SIGN_BOARD);
+  attributes[lanelet::AttributeName::Type] = "yabloc_deinit_area";
+  EXPECT_EQ(table.categories(attributes), ll2::LabelTable::DEINIT_AREA);
+  attributes[lanelet::AttributeName::Type] = "curbstone";
+  EXPECT_EQ(table.categories(attributes), 0);
+}
+
+TEST(DecomposeTestSuite, singlePass)
+{
+  lanelet::LaneletMap map;
+  map.add(make_line_string("line_thin", 0));
+  map.add(make_line_string("sign-board", 1));
+  map.add(make_line_string("virtual", 2));
+  map.add(make_line_string("curbstone", 3));
+  map.add(make_polygon("yabloc_init_area", 0));
+  map.add(make_polygon("bounding_box", 10));
+  map.add(make_polygon("yabloc_deinit_area", 20));
+
+  const ll2::LabelTable table({"line_thin"}, {"sign-board"}, {"bounding_box"});
+  const ll2::ClassifiedMap classified = ll2::classify(map, table);
+  EXPECT_EQ(classified.road_marking.size(), 1u);
+  EXPECT_EQ(classified.sign_board.size(), 1u);
+  EXPECT_EQ(classified.virtual_line.size(), 1u);
+  ASSERT_EQ(classified.transition_area.size(), 2u);
+  EXPECT_EQ(classified.bounding_box.size(), 1u);
+
+  const ll2::DecomposedMap decomposed = ll2::decompose(classified, map.laneletLayer);
+  // A line string of 3 points is split into 2 segments
+  ASSERT_EQ(decomposed.road_marking.size(), 2u);
+  EXPECT_FLOAT_EQ(decomposed.road_marking.at(1).normal_x, 2);
+  ASSERT_EQ(decomposed.sign_board.size(), 2u);
+  EXPECT_FLOAT_EQ(decomposed.sign_board.at(0).y, 1);
+  ASSERT_EQ(decomposed.virtual_line.size(), 2u);
+  EXPECT_FLOAT_EQ(decomposed.virtual_line.at(0).y, 2);
+
+  // The deinit area is labeled with the offset of 512
+  ASSERT_EQ(decomposed.transition_area.size(), 6u);
+  const uint32_t init_label = decomposed.transition_area.at(0).label;
+  const uint32_t deinit_label = decomposed.transition_area.at(5).label;
+  EXPECT_LT(init_label, 512u);
+  EXPECT_GE(deinit_label, 512u);
+
+  EXPECT_EQ(decomposed.bounding_box.size(), 3u);
+  EXPECT_TRUE(decomposed.road_area.empty());
+}
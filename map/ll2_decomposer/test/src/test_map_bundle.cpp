@@ -0,0 +1,182 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ll2_decomposer/decompose.hpp"
+#include "ll2_decomposer/map_bundle.hpp"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ll2 = yabloc::ll2_decomposer;
+using HADMapBin = autoware_auto_mapping_msgs::msg::HADMapBin;
+
+std::string temporary_path(const std::string & name) { return ::testing::TempDir() + "/" + name; }
+
+HADMapBin make_map_bin(uint8_t seed)
+{
+  HADMapBin msg;
+  for (int i = 0; i < 100; i++) msg.data.push_back(static_cast<uint8_t>(seed + i));
+  return msg;
+}
+
+TEST(MapBundleTestSuite, sections)
+{
+  const std::string path = temporary_path("sections.bundle");
+  const std::vector<float> floats = {1.f, 2.f, 3.f};
+  const std::vector<uint32_t> integers = {7, 8, 9, 10, 11};
+  const std::vector<uint8_t> bytes = {1};
+
+  ll2::MapBundleWriter writer;
+  writer.add_section("floats", floats);
+  writer.add_section("integers", integers);
+  writer.add_section("bytes", bytes);
+  writer.add_section("empty", std::vector<float>{});
+  writer.set_metadata("key", "value=1");
+  writer.write(path, 1234);
+
+  ll2::MapBundle bundle(path);
+  EXPECT_EQ(bundle.source_hash(), 1234u);
+  EXPECT_EQ(bundle.metadata("key"), "value=1");
+  EXPECT_EQ(bundle.metadata("unknown"), "");
+
+  const auto float_view = bundle.section<float>("floats");
+  EXPECT_EQ(std::vector<float>(float_view.begin(), float_view.end()), floats);
+  const auto integer_view = bundle.section<uint32_t>("integers");
+  EXPECT_EQ(std::vector<uint32_t>(integer_view.begin(), integer_view.end()), integers);
+
+  // Every section is aligned so that it is read in place
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(integer_view.data()) % 16, 0u);
+
+  EXPECT_TRUE(bundle.has_section("empty"));
+  EXPECT_TRUE(bundle.section<float>("empty").empty());
+  EXPECT_FALSE(bundle.has_section("unknown"));
+  EXPECT_TRUE(bundle.section<float>("unknown").empty());
+  EXPECT_THROW(bundle.section<uint32_t>("bytes"), std::runtime_error);
+}
+
+TEST(MapBundleTestSuite, validation)
+{
+  const std::string path = temporary_path("validation.bundle");
+  const HADMapBin map = make_map_bin(0);
+  ll2::MapBundleWriter().write(path, ll2::hash_map_bin(map));
+
+  std::string error;
+  EXPECT_NE(ll2::open_map_bundle(path, map, &error), nullptr);
+  EXPECT_EQ(ll2::open_map_bundle(path, make_map_bin(1), &error), nullptr);
+  EXPECT_FALSE(error.empty());
+
+  error.clear();
+  EXPECT_EQ(ll2::open_map_bundle(temporary_path("missing.bundle"), map, &error), nullptr);
+  EXPECT_FALSE(error.empty());
+
+  const std::string broken_path = temporary_path("broken.bundle");
+  std::ofstream(broken_path) << "this is not a map bundle";
+  EXPECT_THROW(ll2::MapBundle{broken_path}, std::runtime_error);
+}
+
+TEST(MapBundleTestSuite, decomposedMap)
+{
+  const std::set<std::string> road_marking_labels = {"line_thin", "stop_line"};
+  const std::set<std::string> sign_board_labels = {"sign-board"};
+  const std::set<std::string> bounding_box_labels = {"bounding_box"};
+
+  ll2::DecomposedMap decomposed;
+  pcl::PointNormal pn;
+  pn.getVector3fMap() << 1, 2, 3;
+  pn.getNormalVector3fMap() << 4, 5, 6;
+  decomposed.road_marking.push_back(pn);
+  decomposed.virtual_line.push_back(pn);
+  pcl::PointXYZL xyzl;
+  xyzl.getVector3fMap() << 7, 8, 9;
+  xyzl.label = 512;
+  decomposed.transition_area.push_back(xyzl);
+
+  const std::string path = temporary_path("decomposed.bundle");
+  ll2::MapBundleWriter writer;
+  ll2::write_decomposed_map(
+    writer, decomposed, road_marking_labels, sign_board_labels, bounding_box_labels);
+  writer.write(path, 0);
+
+  ll2::MapBundle bundle(path);
+  ll2::DecomposedMap loaded;
+  ASSERT_TRUE(ll2::read_decomposed_map(
+    bundle, road_marking_labels, sign_board_labels, bounding_box_labels, &loaded));
+  ASSERT_EQ(loaded.road_marking.size(), 1u);
+  EXPECT_EQ(loaded.road_marking.at(0).getVector3fMap(), pn.getVector3fMap());
+  EXPECT_EQ(loaded.road_marking.at(0).getNormalVector3fMap(), pn.getNormalVector3fMap());
+  EXPECT_TRUE(loaded.sign_board.empty());
+  // The virtual lines are stored for the markers
+  ASSERT_EQ(loaded.virtual_line.size(), 1u);
+  EXPECT_EQ(loaded.virtual_line.at(0).getNormalVector3fMap(), pn.getNormalVector3fMap());
+  ASSERT_EQ(loaded.transition_area.size(), 1u);
+  EXPECT_EQ(loaded.transition_area.at(0).getVector3fMap(), xyzl.getVector3fMap());
+  EXPECT_EQ(loaded.transition_area.at(0).label, 512u);
+
+  // The bundle made with other labels must not be used
+  EXPECT_FALSE(ll2::read_decomposed_map(
+    bundle, {"line_thin"}, sign_board_labels, bounding_box_labels, &loaded));
+}
+
+TEST(MapBundleTestSuite, lanes)
+{
+  ll2::Lane lane;
+  lane.right = {{0, 0}, {10, 0}};
+  lane.left = {{0, 3}, {5, 3}, {10, 3}};
+  lane.centerline = {{0, 1.5}, {10, 1.5}};
+  lane.min = {0, 0};
+  lane.max = {10, 3};
+  const std::vector<ll2::Lane> lanes = {lane, ll2::Lane{{}, {}, {}, {1, 1}, {1, 1}}, lane};
+
+  const std::string path = temporary_path("lanes.bundle");
+  ll2::MapBundleWriter writer;
+  ll2::write_lanes(writer, lanes);
+  writer.write(path, 0);
+
+  std::vector<ll2::Lane> loaded;
+  ASSERT_TRUE(ll2::read_lanes(ll2::MapBundle(path), &loaded));
+  ASSERT_EQ(loaded.size(), lanes.size());
+  for (size_t i = 0; i < lanes.size(); i++) {
+    EXPECT_EQ(loaded[i].right, lanes[i].right);
+    EXPECT_EQ(loaded[i].left, lanes[i].left);
+    EXPECT_EQ(loaded[i].centerline, lanes[i].centerline);
+    EXPECT_EQ(loaded[i].min, lanes[i].min);
+    EXPECT_EQ(loaded[i].max, lanes[i].max);
+  }
+}
+
+TEST(MapBundleTestSuite, rejectBrokenLaneOffsets)
+{
+  ll2::Lane lane;
+  lane.right = {{0, 0}, {10, 0}};
+  lane.left = {{0, 3}, {10, 3}};
+  lane.centerline = {{0, 1.5}, {10, 1.5}};
+
+  // The last offset is right, but the ranges run backward or out of lane_points
+  const std::vector<std::vector<uint32_t>> broken_offsets = {
+    {0, 5, 2, 6}, {0, 7, 4, 6}, {1, 2, 4, 6}};
+  for (const std::vector<uint32_t> & offsets : broken_offsets) {
+    const std::string path = temporary_path("broken_lanes.bundle");
+    ll2::MapBundleWriter writer;
+    ll2::write_lanes(writer, {lane});
+    writer.add_section("lane_offsets", offsets);
+    writer.write(path, 0);
+
+    std::vector<ll2::Lane> loaded;
+    EXPECT_FALSE(ll2::read_lanes(ll2::MapBundle(path), &loaded));
+  }
+}
@@ -0,0 +1,79 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ll2_decomposer/tiled_map.hpp"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+
+namespace ll2 = yabloc::ll2_decomposer;
+
+pcl::PointNormal make_segment(float x0, float y0, float x1, float y1)
+{
+  pcl::PointNormal pn;
+  pn.getVector3fMap() << x0, y0, 0;
+  pn.getNormalVector3fMap() << x1, y1, 0;
+  return pn;
+}
+
+void add_square(pcl::PointCloud<pcl::PointXYZL> & cloud, float x, float y, float size, int label)
+{
+  for (const auto & [dx, dy] : {std::pair{0.f, 0.f}, {size, 0.f}, {size, size}, {0.f, size}}) {
+    pcl::PointXYZL p;
+    p.getVector3fMap() << x + dx, y + dy, 0;
+    p.label = label;
+    cloud.push_back(p);
+  }
+}
+
+TEST(TiledMapTestSuite, extractNeighborhood)
+{
+  ll2::DecomposedMap decomposed;
+  // Segments every 100m along the x-axis, and one long segment across all tiles
+  for (int i = 0; i < 10; i++) {
+    decomposed.road_marking.push_back(make_segment(100 * i + 10, 5, 100 * i + 20, 5));
+  }
+  decomposed.road_marking.push_back(make_segment(0, 50, 1000, 50));
+  add_square(decomposed.bounding_box, 10, 10, 20, 0);
+  add_square(decomposed.bounding_box, 810, 10, 20, 1);
+  add_square(decomposed.transition_area, 500, 10, 20, 0);
+
+  ll2::TiledMap tiled_map(100.f);
+  tiled_map.build(decomposed);
+  EXPECT_EQ(tiled_map.tile_count(), 11u);
+
+  // All of the 3x3 tiles around (50,50) touch the circle of radius 140m
+  ASSERT_TRUE(tiled_map.update({50, 50}, 140));
+  EXPECT_EQ(tiled_map.active_tile_count(), 9u);
+  ll2::DecomposedMap active = tiled_map.extract_active();
+  ASSERT_EQ(active.road_marking.size(), 3u);
+  EXPECT_FLOAT_EQ(active.road_marking.at(0).x, 10);
+  EXPECT_FLOAT_EQ(active.road_marking.at(1).x, 110);
+  EXPECT_FLOAT_EQ(active.road_marking.at(2).normal_x, 1000);
+  ASSERT_EQ(active.bounding_box.size(), 4u);
+  EXPECT_EQ(active.bounding_box.at(0).label, 0u);
+  EXPECT_EQ(active.transition_area.size(), 4u);
+
+  // A small move within the same tiles does not change anything
+  EXPECT_FALSE(tiled_map.update({55, 50}, 140));
+
+  // The tiles x=7,...,10 on y=0 touch the circle
+  ASSERT_TRUE(tiled_map.update({860, 50}, 140));
+  active = tiled_map.extract_active();
+  ASSERT_EQ(active.road_marking.size(), 4u);
+  EXPECT_FLOAT_EQ(active.road_marking.at(0).x, 710);
+  ASSERT_EQ(active.bounding_box.size(), 4u);
+  EXPECT_EQ(active.bounding_box.at(0).label, 1u);
+}
@@ -0,0 +1,105 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Core>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace yabloc::synthetic_map
+{
+/**
+ * Road network of the generated map
+ *
+ * GRID places the intersections on a regular grid. IRREGULAR moves them randomly and removes some
+ * roads, while keeping every intersection reachable.
+ */
+struct MapConfig
+{
+  enum class Layout { GRID, IRREGULAR };
+
+  Layout layout{Layout::GRID};
+  int blocks_x{4};
+  int blocks_y{4};
+  double block_size{100.0};  // Distance between the intersections
+  double lane_width{3.5};
+  double point_interval{5.0};  // Interval of the vertices of the lane boundaries
+  double jitter{20.0};         // Max displacement of the intersections in IRREGULAR
+  double road_removal{0.2};    // Probability to remove a road in IRREGULAR
+  double crosswalk_probability{0.5};
+  double bounding_box_probability{0.3};
+  double slope{0.0};  // The height of every point is slope * x
+  uint32_t seed{0};
+};
+
+struct GeneratedMap
+{
+  lanelet::LaneletMapPtr map;
+  // Intersections and the roads between them, which trajectories follow
+  std::vector<Eigen::Vector2d> nodes;
+  std::vector<std::pair<int, int>> roads;
+  double lane_width;
+  double slope;
+};
+
+struct TrajectoryConfig
+{
+  double duration{60.0};  // [s]
+  double speed{10.0};     // [m/s]
+  double rate{10.0};      // [Hz]
+  uint32_t seed{0};
+};
+
+struct TrajectoryPoint
+{
+  double stamp;
+  Eigen::Vector3d position;
+  double yaw;
+};
+
+struct ObservationConfig
+{
+  double max_range{20.0};
+  double noise_sigma{0.05};  // Noise of every end point [m]
+  double dropout{0.1};       // Probability to miss a segment
+  int clutter_count{10};     // Random segments which are not in the map
+  uint32_t seed{0};
+};
+
+// The same config always generates the same map
+GeneratedMap generate_map(const MapConfig & config);
+
+// The vehicle drives on the right lane and turns randomly at every intersection
+std::vector<TrajectoryPoint> generate_trajectory(
+  const GeneratedMap & generated, const TrajectoryConfig & config);
+
+/**
+ * Line segments seen from the vehicle in its ground frame, like those of the line segment detector
+ *
+ * @param[in] road_marking Road marking segments of the map, e.g. by ll2_decomposer::decompose()
+ * @param[in] pose Pose of the vehicle
+ * @param[in] config Noise and clutter
+ * @param[in,out] engine Random engine shared over the frames of a trajectory
+ */
+pcl::PointCloud<pcl::PointNormal> generate_observation(
+  const pcl::PointCloud<pcl::PointNormal> & road_marking, const TrajectoryPoint & pose,
+  const ObservationConfig & config, std::mt19937 & engine);
+}  // namespace yabloc::synthetic_map
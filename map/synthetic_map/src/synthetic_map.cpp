@@ -0,0 +1,334 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "synthetic_map/synthetic_map.hpp"
+
+#include <Eigen/Geometry>
+
+#include <lanelet2_core/primitives/Lanelet.h>
+#include <lanelet2_core/utility/Utilities.h>
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <string>
+
+namespace yabloc::synthetic_map
+{
+namespace
+{
+// Roads stop short of the intersections by this margin, so that they do not overlap each other
+double intersection_margin(const MapConfig & config) { return 2 * config.lane_width + 2.0; }
+
+std::vector<std::vector<int>> make_adjacency(
+  size_t node_count, const std::vector<std::pair<int, int>> & roads)
+{
+  std::vector<std::vector<int>> adjacency(node_count);
+  for (const auto & [a, b] : roads) {
+    adjacency[a].push_back(b);
+    adjacency[b].push_back(a);
+  }
+  return adjacency;
+}
+
+bool is_connected(size_t node_count, const std::vector<std::pair<int, int>> & roads)
+{
+  const auto adjacency = make_adjacency(node_count, roads);
+  std::vector<bool> visited(node_count, false);
+  std::queue<int> queue;
+  queue.push(0);
+  visited[0] = true;
+  size_t visited_count = 1;
+  while (!queue.empty()) {
+    const int node = queue.front();
+    queue.pop();
+    for (const int next : adjacency[node]) {
+      if (visited[next]) continue;
+      visited[next] = true;
+      visited_count++;
+      queue.push(next);
+    }
+  }
+  return visited_count == node_count;
+}
+
+class MapBuilder
+{
+public:
+  explicit MapBuilder(double slope) : slope_(slope), map_(std::make_shared<lanelet::LaneletMap>())
+  {
+  }
+
+  lanelet::Point3d make_point(const Eigen::Vector2d & p)
+  {
+    return lanelet::Point3d(lanelet::utils::getId(), p.x(), p.y(), slope_ * p.x());
+  }
+
+  // Vertices are placed at the interval from `from` to `to`
+  lanelet::LineString3d add_line_string(
+    const Eigen::Vector2d & from, const Eigen::Vector2d & to, double interval,
+    const std::string & type, const std::string & subtype = "")
+  {
+    const int division = std::max(1, static_cast<int>(std::ceil((to - from).norm() / interval)));
+    lanelet::LineString3d line(lanelet::utils::getId());
+    for (int i = 0; i <= division; i++) {
+      line.push_back(make_point(from + (to - from) * i / division));
+    }
+    line.attributes()[lanelet::AttributeName::Type] = type;
+    if (!subtype.empty()) line.attributes()[lanelet::AttributeName::Subtype] = subtype;
+    map_->add(line);
+    return line;
+  }
+
+  void add_lanelet(const lanelet::LineString3d & left, const lanelet::LineString3d & right)
+  {
+    lanelet::Lanelet lanelet(lanelet::utils::getId(), left, right);
+    lanelet.attributes()[lanelet::AttributeName::Type] = "lanelet";
+    lanelet.attributes()[lanelet::AttributeName::Subtype] = "road";
+    map_->add(lanelet);
+  }
+
+  void add_polygon(const std::vector<Eigen::Vector2d> & vertices, const std::string & type)
+  {
+    lanelet::Polygon3d polygon(lanelet::utils::getId());
+    for (const Eigen::Vector2d & v : vertices) polygon.push_back(make_point(v));
+    polygon.attributes()[lanelet::AttributeName::Type] = type;
+    map_->add(polygon);
+  }
+
+  lanelet::LaneletMapPtr map() const { return map_; }
+
+private:
+  const double slope_;
+  lanelet::LaneletMapPtr map_;
+};
+
+void add_road(
+  MapBuilder & builder, const Eigen::Vector2d & a, const Eigen::Vector2d & b,
+  const MapConfig & config, std::mt19937 & engine)
+{
+  const double margin = intersection_margin(config);
+  const Eigen::Vector2d d = (b - a).normalized();
+  const Eigen::Vector2d n(-d.y(), d.x());  // Left side of a->b
+  if ((b - a).norm() < 2 * margin + config.lane_width) return;
+
+  const Eigen::Vector2d s = a + d * margin;
+  const Eigen::Vector2d e = b - d * margin;
+  const double w = config.lane_width;
+  const double interval = config.point_interval;
+
+  const auto right = builder.add_line_string(s - n * w, e - n * w, interval, "line_thin", "solid");
+  const auto center = builder.add_line_string(s, e, interval, "line_thin", "dashed");
+  const auto left = builder.add_line_string(s + n * w, e + n * w, interval, "line_thin", "solid");
+
+  // Lane a->b on the right side, and lane b->a on the left side
+  builder.add_lanelet(center, right);
+  builder.add_lanelet(center.invert(), left.invert());
+
+  std::bernoulli_distribution crosswalk(config.crosswalk_probability);
+  if (crosswalk(engine)) {
+    // Zebra stripes across the road at the end b, and the stop line of the lane a->b before them
+    for (double offset = -w + 0.5; offset < w; offset += 1.0) {
+      builder.add_line_string(
+        e - d * 4.0 + n * offset, e - d * 1.0 + n * offset, interval, "pedestrian_marking");
+    }
+    builder.add_line_string(e - d * 6.0 - n * w, e - d * 6.0, interval, "stop_line");
+  }
+}
+}  // namespace
+
+GeneratedMap generate_map(const MapConfig & config)
+{
+  std::mt19937 engine(config.seed);
+  const bool irregular = (config.layout == MapConfig::Layout::IRREGULAR);
+
+  GeneratedMap generated;
+  generated.lane_width = config.lane_width;
+  generated.slope = config.slope;
+
+  const int nx = config.blocks_x + 1;
+  const int ny = config.blocks_y + 1;
+  auto node_index = [ny](int i, int j) { return i * ny + j; };
+
+  std::uniform_real_distribution<double> jitter(-config.jitter, config.jitter);
+  for (int i = 0; i < nx; i++) {
+    for (int j = 0; j < ny; j++) {
+      Eigen::Vector2d node(i * config.block_size, j * config.block_size);
+      if (irregular) node += Eigen::Vector2d(jitter(engine), jitter(engine));
+      generated.nodes.push_back(node);
+    }
+  }
+
+  for (int i = 0; i < nx; i++) {
+    for (int j = 0; j < ny; j++) {
+      if (i + 1 < nx) generated.roads.emplace_back(node_index(i, j), node_index(i + 1, j));
+      if (j + 1 < ny) generated.roads.emplace_back(node_index(i, j), node_index(i, j + 1));
+    }
+  }
+
+  if (irregular) {
+    // Remove roads in a random order unless an intersection becomes unreachable
+    std::shuffle(generated.roads.begin(), generated.roads.end(), engine);
+    std::bernoulli_distribution removal(config.road_removal);
+    for (size_t i = 0; i < generated.roads.size();) {
+      if (!removal(engine)) {
+        i++;
+        continue;
+      }
+      auto candidate = generated.roads;
+      candidate.erase(candidate.begin() + i);
+      if (is_connected(generated.nodes.size(), candidate)) {
+        generated.roads = std::move(candidate);
+      } else {
+        i++;
+      }
+    }
+  }
+
+  MapBuilder builder(config.slope);
+  for (const auto & [a, b] : generated.roads) {
+    add_road(builder, generated.nodes[a], generated.nodes[b], config, engine);
+  }
+
+  // Bounding boxes cover some blocks entirely
+  std::bernoulli_distribution bounding_box(config.bounding_box_probability);
+  for (int i = 0; i + 1 < nx; i++) {
+    for (int j = 0; j + 1 < ny; j++) {
+      if (!bounding_box(engine)) continue;
+      builder.add_polygon(
+        {generated.nodes[node_index(i, j)], generated.nodes[node_index(i + 1, j)],
+         generated.nodes[node_index(i + 1, j + 1)], generated.nodes[node_index(i, j + 1)]},
+        "bounding_box");
+    }
+  }
+
+  generated.map = builder.map();
+  return generated;
+}
+
+std::vector<TrajectoryPoint> generate_trajectory(
+  const GeneratedMap & generated, const TrajectoryConfig & config)
+{
+  std::vector<TrajectoryPoint> trajectory;
+  if (generated.roads.empty()) return trajectory;
+
+  std::mt19937 engine(config.seed);
+  const auto adjacency = make_adjacency(generated.nodes.size(), generated.roads);
+  const double total_length = config.duration * config.speed;
+
+  // Waypoints on the center of the right lane
+  std::uniform_int_distribution<size_t> first_road(0, generated.roads.size() - 1);
+  auto [previous, current] = generated.roads[first_road(engine)];
+  std::vector<Eigen::Vector2d> waypoints;
+  double length = 0;
+  while (length < total_length) {
+    const Eigen::Vector2d & a = generated.nodes[previous];
+    const Eigen::Vector2d & b = generated.nodes[current];
+    const Eigen::Vector2d d = (b - a).normalized();
+    const Eigen::Vector2d right(d.y(), -d.x());
+    const Eigen::Vector2d offset = right * generated.lane_width / 2;
+
+    // Going straight through an intersection, the last waypoint is the same as the next one
+    if (waypoints.empty() || (a + offset - waypoints.back()).norm() > 1e-6) {
+      if (!waypoints.empty()) length += (a + offset - waypoints.back()).norm();
+      waypoints.push_back(a + offset);
+    }
+    waypoints.push_back(b + offset);
+    length += (b - a).norm();
+
+    // Turn randomly, but do not go back unless it is a dead end
+    std::vector<int> candidates;
+    for (const int next : adjacency[current]) {
+      if (next != previous) candidates.push_back(next);
+    }
+    if (candidates.empty()) candidates.push_back(previous);
+    std::uniform_int_distribution<size_t> choice(0, candidates.size() - 1);
+    previous = current;
+    current = candidates[choice(engine)];
+  }
+
+  // Resample the waypoints at the constant speed
+  const double step = config.speed / config.rate;
+  const int count = static_cast<int>(total_length / step) + 1;
+  size_t index = 0;
+  double travelled = 0;  // Distance to waypoints[index]
+  for (int k = 0; k < count; k++) {
+    const double s = k * step;
+    while (index + 2 < waypoints.size() &&
+           travelled + (waypoints[index + 1] - waypoints[index]).norm() < s) {
+      travelled += (waypoints[index + 1] - waypoints[index]).norm();
+      index++;
+    }
+    const Eigen::Vector2d from = waypoints[index];
+    const Eigen::Vector2d to = waypoints[index + 1];
+    const double segment_length = std::max((to - from).norm(), 1e-6);
+    const double ratio = std::clamp((s - travelled) / segment_length, 0.0, 1.0);
+    const Eigen::Vector2d p = from + (to - from) * ratio;
+
+    TrajectoryPoint point;
+    point.stamp = k / config.rate;
+    point.position = Eigen::Vector3d(p.x(), p.y(), generated.slope * p.x());
+    point.yaw = std::atan2(to.y() - from.y(), to.x() - from.x());
+    trajectory.push_back(point);
+  }
+  return trajectory;
+}
+
+pcl::PointCloud<pcl::PointNormal> generate_observation(
+  const pcl::PointCloud<pcl::PointNormal> & road_marking, const TrajectoryPoint & pose,
+  const ObservationConfig & config, std::mt19937 & engine)
+{
+  const Eigen::Rotation2Df rotation_inv(-static_cast<float>(pose.yaw));
+  const Eigen::Vector2f position = pose.position.topRows(2).cast<float>();
+  const float max_range = config.max_range;
+
+  std::normal_distribution<float> noise(0.f, config.noise_sigma);
+  std::bernoulli_distribution dropout(config.dropout);
+
+  auto make_segment = [](const Eigen::Vector2f & from, const Eigen::Vector2f & to) {
+    pcl::PointNormal pn;
+    pn.getVector3fMap() << from.x(), from.y(), 0.f;
+    pn.getNormalVector3fMap() << to.x(), to.y(), 0.f;
+    return pn;
+  };
+
+  // Only the segments in front of the vehicle are visible, as the camera looks forward
+  auto is_visible = [max_range](const Eigen::Vector2f & p) {
+    return p.x() > 0 && p.norm() < max_range;
+  };
+
+  pcl::PointCloud<pcl::PointNormal> observation;
+  for (const pcl::PointNormal & pn : road_marking) {
+    const Eigen::Vector2f from = rotation_inv * (pn.getVector3fMap().topRows(2) - position);
+    const Eigen::Vector2f to = rotation_inv * (pn.getNormalVector3fMap().topRows(2) - position);
+    if (!is_visible(from) || !is_visible(to)) continue;
+    if (dropout(engine)) continue;
+    const Eigen::Vector2f from_noise(noise(engine), noise(engine));
+    const Eigen::Vector2f to_noise(noise(engine), noise(engine));
+    observation.push_back(make_segment(from + from_noise, to + to_noise));
+  }
+
+  std::uniform_real_distribution<float> forward(0.f, max_range);
+  std::uniform_real_distribution<float> lateral(-max_range / 2, max_range / 2);
+  std::uniform_real_distribution<float> angle(-M_PI, M_PI);
+  std::uniform_real_distribution<float> clutter_length(0.5f, 3.0f);
+  for (int i = 0; i < config.clutter_count; i++) {
+    const Eigen::Vector2f from(forward(engine), lateral(engine));
+    const Eigen::Vector2f to =
+      from + Eigen::Rotation2Df(angle(engine)) * Eigen::Vector2f(clutter_length(engine), 0.f);
+    observation.push_back(make_segment(from, to));
+  }
+  return observation;
+}
+}  // namespace yabloc::synthetic_map
@@ -0,0 +1,115 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "synthetic_map/synthetic_map.hpp"
+
+#include <ll2_decomposer/decompose.hpp>
+
+#include <lanelet2_io/Io.h>
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+namespace
+{
+void print_usage()
+{
+  std::cout << "usage: synthetic_map_generator --output <directory> [options]\n"
+            << "  --layout <grid|irregular>  (default: grid)\n"
+            << "  --blocks <n>               blocks along each axis (default: 4)\n"
+            << "  --block_size <m>           (default: 100)\n"
+            << "  --slope <ratio>            (default: 0)\n"
+            << "  --duration <s>             length of the trajectory (default: 60)\n"
+            << "  --speed <m/s>              (default: 10)\n"
+            << "  --noise <m>                noise of the observations (default: 0.05)\n"
+            << "  --clutter <n>              clutter segments per frame (default: 10)\n"
+            << "  --seed <n>                 (default: 0)\n"
+            << "It writes map.osm, trajectory.csv and observations.csv to the directory.\n";
+}
+}  // namespace
+
+int main(int argc, char * argv[])
+{
+  namespace sm = yabloc::synthetic_map;
+
+  std::map<std::string, std::string> args;
+  for (int i = 1; i + 1 < argc; i += 2) args[argv[i]] = argv[i + 1];
+  auto arg = [&args](const std::string & key, const std::string & fallback) {
+    const auto itr = args.find("--" + key);
+    return (itr == args.end()) ? fallback : itr->second;
+  };
+
+  if (argc % 2 == 0 || args.count("--output") == 0) {
+    print_usage();
+    return 1;
+  }
+  const std::string output = arg("output", "");
+  const uint32_t seed = std::stoul(arg("seed", "0"));
+
+  sm::MapConfig map_config;
+  map_config.layout =
+    (arg("layout", "grid") == "irregular") ? sm::MapConfig::Layout::IRREGULAR
+                                           : sm::MapConfig::Layout::GRID;
+  map_config.blocks_x = map_config.blocks_y = std::stoi(arg("blocks", "4"));
+  map_config.block_size = std::stod(arg("block_size", "100"));
+  map_config.slope = std::stod(arg("slope", "0"));
+  map_config.seed = seed;
+  const sm::GeneratedMap generated = sm::generate_map(map_config);
+
+  // Autoware loads the local coordinates of the points as they are
+  for (lanelet::Point3d point : generated.map->pointLayer) {
+    point.attributes()["local_x"] = point.x();
+    point.attributes()["local_y"] = point.y();
+  }
+  lanelet::ErrorMessages errors;
+  lanelet::write(output + "/map.osm", *generated.map, lanelet::Origin({0.0, 0.0}), &errors);
+  for (const auto & error : errors) std::cerr << error << std::endl;
+
+  sm::TrajectoryConfig trajectory_config;
+  trajectory_config.duration = std::stod(arg("duration", "60"));
+  trajectory_config.speed = std::stod(arg("speed", "10"));
+  trajectory_config.seed = seed;
+  const auto trajectory = sm::generate_trajectory(generated, trajectory_config);
+
+  std::ofstream trajectory_file(output + "/trajectory.csv");
+  trajectory_file << "stamp,x,y,z,yaw\n";
+  for (const sm::TrajectoryPoint & p : trajectory) {
+    trajectory_file << p.stamp << "," << p.position.x() << "," << p.position.y() << ","
+                    << p.position.z() << "," << p.yaw << "\n";
+  }
+
+  sm::ObservationConfig observation_config;
+  observation_config.noise_sigma = std::stod(arg("noise", "0.05"));
+  observation_config.clutter_count = std::stoi(arg("clutter", "10"));
+  const auto decomposed = yabloc::ll2_decomposer::decompose(
+    *generated.map, {"line_thin", "pedestrian_marking", "stop_line"}, {}, {"bounding_box"});
+
+  std::mt19937 engine(seed);
+  std::ofstream observation_file(output + "/observations.csv");
+  observation_file << "stamp,x0,y0,x1,y1\n";
+  for (const sm::TrajectoryPoint & p : trajectory) {
+    for (const auto & pn : sm::generate_observation(
+           decomposed.road_marking, p, observation_config, engine)) {
+      observation_file << p.stamp << "," << pn.x << "," << pn.y << "," << pn.normal_x << ","
+                       << pn.normal_y << "\n";
+    }
+  }
+
+  std::cout << "generated " << generated.map->laneletLayer.size() << " lanelets, "
+            << decomposed.road_marking.size() << " road marking segments and "
+            << trajectory.size() << " poses in " << output << std::endl;
+  return 0;
+}
@@ -0,0 +1,92 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "synthetic_map/synthetic_map.hpp"
+
+#include <ll2_decomposer/decompose.hpp>
+
+#include <gtest/gtest.h>
+
+namespace sm = yabloc::synthetic_map;
+
+TEST(SyntheticMapTestSuite, deterministic)
+{
+  sm::MapConfig config;
+  config.layout = sm::MapConfig::Layout::IRREGULAR;
+  config.seed = 3;
+
+  const auto first = sm::generate_map(config);
+  const auto second = sm::generate_map(config);
+  EXPECT_EQ(first.roads, second.roads);
+  EXPECT_EQ(first.map->lineStringLayer.size(), second.map->lineStringLayer.size());
+  EXPECT_EQ(first.map->polygonLayer.size(), second.map->polygonLayer.size());
+
+  // Some roads are removed, but the network is still a single component
+  EXPECT_LT(first.roads.size(), 40u);
+  EXPECT_GE(first.roads.size(), first.nodes.size() - 1);
+}
+
+TEST(SyntheticMapTestSuite, scale)
+{
+  sm::MapConfig config;
+  config.blocks_x = config.blocks_y = 4;
+  const auto small = sm::generate_map(config);
+  config.blocks_x = config.blocks_y = 40;
+  const auto large = sm::generate_map(config);
+
+  // Two lanelets per road
+  EXPECT_EQ(small.roads.size(), 40u);
+  EXPECT_EQ(small.map->laneletLayer.size(), 80u);
+  EXPECT_EQ(large.roads.size(), 3280u);
+  EXPECT_EQ(large.map->laneletLayer.size(), 6560u);
+}
+
+TEST(SyntheticMapTestSuite, trajectoryAndObservation)
+{
+  sm::MapConfig map_config;
+  map_config.slope = 0.01;
+  const auto generated = sm::generate_map(map_config);
+
+  sm::TrajectoryConfig trajectory_config;
+  trajectory_config.duration = 30;
+  const auto trajectory = sm::generate_trajectory(generated, trajectory_config);
+  ASSERT_EQ(trajectory.size(), 301u);
+  for (size_t i = 1; i < trajectory.size(); i++) {
+    const double distance = (trajectory[i].position - trajectory[i - 1].position).norm();
+    EXPECT_LT(distance, 1.0 + 1e-3);
+  }
+  EXPECT_NEAR(trajectory.back().position.z(), trajectory.back().position.x() * 0.01, 1e-6);
+
+  const auto decomposed = yabloc::ll2_decomposer::decompose(
+    *generated.map, {"line_thin", "pedestrian_marking", "stop_line"}, {}, {"bounding_box"});
+  ASSERT_FALSE(decomposed.road_marking.empty());
+
+  sm::ObservationConfig observation_config;
+  observation_config.dropout = 0;
+  observation_config.clutter_count = 5;
+  std::mt19937 engine(0);
+  size_t observed = 0;
+  for (const auto & pose : trajectory) {
+    const auto observation =
+      sm::generate_observation(decomposed.road_marking, pose, observation_config, engine);
+    // The clutter segments follow those of the map
+    ASSERT_GE(observation.size(), 5u);
+    observed += observation.size() - 5;
+    for (size_t i = 0; i + 5 < observation.size(); i++) {
+      EXPECT_LT(observation.at(i).getVector3fMap().norm(), observation_config.max_range + 1.f);
+    }
+  }
+  // The lane boundaries on both sides are always visible
+  EXPECT_GT(observed, trajectory.size() * 2);
+}
@@ -15,23 +15,32 @@
 #pragma once
 
 #include <ll2_cost_map/hierarchical_cost_map.hpp>
+#include <ll2_cost_map/pose_scorer.hpp>
+#include <ll2_cost_map/relocalizer.hpp>
 #include <modularized_particle_filter/correction/abst_corrector.hpp>
 #include <opencv4/opencv2/core.hpp>
-#include <std_srvs/srv/set_bool.hpp>
+#include <sophus/geometry.hpp>
+#include <std_srvs/srv/trigger.hpp>
+#include <yabloc_common/status_reporter.hpp>
+#include <yabloc_common/thread_pool.hpp>
 
+#include <geometry_msgs/msg/pose_array.hpp>
 #include <geometry_msgs/msg/pose_stamped.hpp>
+#include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
 #include <sensor_msgs/msg/image.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
 #include <std_msgs/msg/bool.hpp>
-#include <std_msgs/msg/string.hpp>
 
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
+#include <deque>
+#include <future>
+#include <vector>
+
 namespace yabloc::modularized_particle_filter
 {
 cv::Point2f cv2pt(const Eigen::Vector3f v);
-float abs_cos(const Eigen::Vector3f & t, float deg);
 
 class CameraParticleCorrector : public modularized_particle_filter::AbstCorrector
 {
@@ -44,20 +53,22 @@ public:
   using MarkerArray = visualization_msgs::msg::MarkerArray;
   using Pose = geometry_msgs::msg::Pose;
   using Bool = std_msgs::msg::Bool;
-  using String = std_msgs::msg::String;
-  using SetBool = std_srvs::srv::SetBool;
+  using Trigger = std_srvs::srv::Trigger;
+  using PoseArray = geometry_msgs::msg::PoseArray;
+  using PoseCovStamped = geometry_msgs::msg::PoseWithCovarianceStamped;
   CameraParticleCorrector();
 
 private:
   const float min_prob_;
   const float far_weight_gain_;
   HierarchicalCostMap cost_map_;
+  PoseScorer pose_scorer_;
 
   rclcpp::Subscription<PointCloud2>::SharedPtr sub_bounding_box_;
   rclcpp::Subscription<PointCloud2>::SharedPtr sub_line_segments_cloud_;
   rclcpp::Subscription<PointCloud2>::SharedPtr sub_ll2_;
   rclcpp::Subscription<PoseStamped>::SharedPtr sub_pose_;
-  rclcpp::Service<SetBool>::SharedPtr switch_service_;
+  rclcpp::Service<Trigger>::SharedPtr relocalize_service_;
   rclcpp::TimerBase::SharedPtr timer_;
 
   rclcpp::Publisher<Image>::SharedPtr pub_image_;
@@ -65,27 +76,50 @@ private:
   rclcpp::Publisher<MarkerArray>::SharedPtr pub_marker_;
   rclcpp::Publisher<PointCloud2>::SharedPtr pub_scored_cloud_;
   rclcpp::Publisher<PointCloud2>::SharedPtr pub_scored_posteriori_cloud_;
-  rclcpp::Publisher<String>::SharedPtr pub_string_;
+  rclcpp::Publisher<PoseArray>::SharedPtr pub_hypotheses_;
+  rclcpp::Publisher<PoseCovStamped>::SharedPtr pub_relocalized_pose_;
 
   Eigen::Vector3f last_mean_position_;
   std::optional<PoseStamped> latest_pose_{std::nullopt};
   std::function<float(float)> score_converter_;
 
-  bool enable_switch_{true};
+  // Recorded per frame and published at 1 Hz
+  std::unique_ptr<common::StatusReporter> status_;
+  size_t status_enabled_index_;
+  size_t status_time_index_;
+
+  // Relocalization is enabled by the parameter use_relocalization
+  std::unique_ptr<common::ThreadPool> relocalization_pool_{nullptr};
+  std::unique_ptr<Relocalizer> relocalizer_{nullptr};
+  float relocalization_radius_{0};
+  size_t relocalization_accumulation_{0};
+  // Line segments of the recent frames and the mean pose of the particles at each frame
+  std::deque<std::pair<Sophus::SE3f, LineSegments>> accumulated_line_segments_;
+  // The search in progress. It is the last member so that it finishes before the others are gone.
+  std::future<void> relocalization_task_;
 
   void on_line_segments(const PointCloud2 & msg);
   void on_ll2(const PointCloud2 & msg);
   void on_bounding_box(const PointCloud2 & msg);
   void on_pose(const PoseStamped & msg);
   void on_timer();
-  void on_service(SetBool::Request::ConstSharedPtr request, SetBool::Response::SharedPtr response);
+  void on_suspend() override;
+  void on_resume() override;
+  void subscribe_line_segments();
+  // The response is deferred until the search finishes
+  void on_relocalize(
+    const std::shared_ptr<rmw_request_id_t> request_header,
+    const Trigger::Request::SharedPtr request);
+  // Run off the executor with the cost field rasterized beforehand
+  Trigger::Response relocalize(
+    const LineSegments & line_segments, const std::vector<CostMapValue> & field,
+    const Eigen::Vector3f & center);
 
   std::pair<LineSegments, LineSegments> split_line_segments(const PointCloud2 & msg);
 
-  float compute_logit(const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position);
-
+  // Points of the line segments at the pose colored by their probability, for visualization
   pcl::PointCloud<pcl::PointXYZI> evaluate_cloud(
-    const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position);
+    const LineSegments & line_segments_cloud, const Sophus::SE3f & pose);
 
   std::pair<LineSegments, LineSegments> filt(const LineSegments & lines);
 };
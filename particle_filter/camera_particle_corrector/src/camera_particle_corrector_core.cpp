@@ -13,72 +13,199 @@
 // limitations under the License.
 
 #include "camera_particle_corrector/camera_particle_corrector.hpp"
-#include "camera_particle_corrector/fast_cos.hpp"
 #include "camera_particle_corrector/logit.hpp"
 
 #include <opencv4/opencv2/imgproc.hpp>
 #include <yabloc_common/color.hpp>
+#include <yabloc_common/line_segments_msg.hpp>
 #include <yabloc_common/pose_conversions.hpp>
 #include <yabloc_common/pub_sub.hpp>
 #include <yabloc_common/timer.hpp>
 #include <yabloc_common/transform_line_segments.hpp>
 
-#include <pcl_conversions/pcl_conversions.h>
+#include <sstream>
+#include <tuple>
 
 namespace yabloc::modularized_particle_filter
 {
-FastCosSin fast_math;
-
 CameraParticleCorrector::CameraParticleCorrector()
 : AbstCorrector("camera_particle_corrector"),
   min_prob_(declare_parameter<float>("min_prob", 0.01)),
   far_weight_gain_(declare_parameter<float>("far_weight_gain", 0.001)),
-  cost_map_(this)
+  cost_map_(this),
+  pose_scorer_({0.1f, far_weight_gain_, 0.2f})
 {
   using std::placeholders::_1;
   using std::placeholders::_2;
 
-  enable_switch_ = declare_parameter<bool>("enabled_at_first", true);
-
   // Publication
   pub_image_ = create_publisher<Image>("match_image", 10);
   pub_map_image_ = create_publisher<Image>("cost_map_image", 10);
   pub_marker_ = create_publisher<MarkerArray>("cost_map_range", 10);
-  pub_string_ = create_publisher<String>("state_string", 10);
   pub_scored_cloud_ = create_publisher<PointCloud2>("scored_cloud", 10);
   pub_scored_posteriori_cloud_ = create_publisher<PointCloud2>("scored_post_cloud", 10);
 
   // Subscription
-  auto on_line_segments = std::bind(&CameraParticleCorrector::on_line_segments, this, _1);
   auto on_ll2 = std::bind(&CameraParticleCorrector::on_ll2, this, _1);
   auto on_bounding_box = std::bind(&CameraParticleCorrector::on_bounding_box, this, _1);
   auto on_pose = std::bind(&CameraParticleCorrector::on_pose, this, _1);
-  sub_line_segments_cloud_ =
-    create_subscription<PointCloud2>("line_segments_cloud", 10, on_line_segments);
+  subscribe_line_segments();
   sub_ll2_ = create_subscription<PointCloud2>("ll2_road_marking", 10, on_ll2);
   sub_bounding_box_ = create_subscription<PointCloud2>("ll2_bounding_box", 10, on_bounding_box);
   sub_pose_ = create_subscription<PoseStamped>("pose", 10, on_pose);
 
-  auto on_service = std::bind(&CameraParticleCorrector::on_service, this, _1, _2);
-  switch_service_ = create_service<SetBool>("switch_srv", on_service);
+  // Relocalization
+  if (declare_parameter("use_relocalization", false)) {
+    relocalization_radius_ = declare_parameter<float>("relocalization.search_radius", 30.0);
+    relocalization_accumulation_ = declare_parameter<int>("relocalization.accumulation", 10);
+    Relocalizer::Parameters parameters;
+    parameters.resolution = declare_parameter<float>("relocalization.resolution", 0.5);
+    parameters.depth = declare_parameter<int>("relocalization.depth", 5);
+    parameters.yaw_count = declare_parameter<int>("relocalization.yaw_count", 72);
+    parameters.top_k = declare_parameter<int>("relocalization.top_k", 5);
+    parameters.min_distance = declare_parameter<float>("relocalization.min_distance", 2.0);
+    parameters.far_weight_gain = far_weight_gain_;
+    relocalization_pool_ =
+      std::make_unique<common::ThreadPool>(declare_parameter("relocalization.thread_count", 0));
+    relocalizer_ = std::make_unique<Relocalizer>(parameters, relocalization_pool_.get());
+
+    pub_hypotheses_ = create_publisher<PoseArray>("relocalization_hypotheses", 10);
+    pub_relocalized_pose_ = create_publisher<PoseCovStamped>("relocalized_pose", 10);
+    auto on_relocalize = std::bind(&CameraParticleCorrector::on_relocalize, this, _1, _2);
+    relocalize_service_ = create_service<Trigger>("relocalize_srv", on_relocalize);
+  }
+
+  status_ =
+    std::make_unique<common::StatusReporter>(this, "state_string", "Camera particle corrector");
+  status_enabled_index_ = status_->add_label("state", {"disabled", "ENABLED"});
+  status_time_index_ = status_->add("time", 0, "ms");
 
   // Timer callback
   auto on_timer = std::bind(&CameraParticleCorrector::on_timer, this);
   timer_ =
     rclcpp::create_timer(this, this->get_clock(), rclcpp::Rate(1).period(), std::move(on_timer));
+
+  initialize_suspension();
+  status_->set(status_enabled_index_, !is_suspended());
+}
+
+void CameraParticleCorrector::subscribe_line_segments()
+{
+  using std::placeholders::_1;
+  auto on_line_segments = std::bind(&CameraParticleCorrector::on_line_segments, this, _1);
+  sub_line_segments_cloud_ =
+    create_subscription<PointCloud2>("line_segments_cloud", 10, on_line_segments);
+}
+
+void CameraParticleCorrector::on_suspend()
+{
+  // The cost map is kept, so that the correction restarts without rebuilding it
+  sub_line_segments_cloud_.reset();
+  accumulated_line_segments_.clear();
+  status_->set(status_enabled_index_, false);
+}
+
+void CameraParticleCorrector::on_resume()
+{
+  subscribe_line_segments();
+  status_->set(status_enabled_index_, true);
 }
 
 void CameraParticleCorrector::on_pose(const PoseStamped & msg) { latest_pose_ = msg; }
 
-void CameraParticleCorrector::on_service(
-  SetBool::Request::ConstSharedPtr request, SetBool::Response::SharedPtr response)
+void CameraParticleCorrector::on_relocalize(
+  const std::shared_ptr<rmw_request_id_t> request_header, const Trigger::Request::SharedPtr)
 {
-  enable_switch_ = request->data;
-  response->success = true;
-  if (enable_switch_)
-    RCLCPP_INFO_STREAM(get_logger(), "camera_corrector is enabled");
-  else
-    RCLCPP_INFO_STREAM(get_logger(), "camera_corrector is disabled");
+  using namespace std::chrono_literals;
+  Trigger::Response response;
+  response.success = false;
+  const bool running = relocalization_task_.valid() &&
+                       relocalization_task_.wait_for(0s) != std::future_status::ready;
+  if (running) {
+    response.message = "relocalization is already running";
+    relocalize_service_->send_response(*request_header, response);
+    return;
+  }
+  if (accumulated_line_segments_.empty()) {
+    response.message = "no line segments are accumulated";
+    relocalize_service_->send_response(*request_header, response);
+    return;
+  }
+
+  // Gather the line segments in the frame of the latest mean pose
+  const Sophus::SE3f latest_pose = accumulated_line_segments_.back().first;
+  LineSegments line_segments;
+  for (const auto & [pose, segments] : accumulated_line_segments_) {
+    line_segments += common::transform_line_segments(segments, latest_pose.inverse() * pose);
+  }
+
+  // The cost map is not thread-safe, so the search area is rasterized here at once instead of
+  // building all the tiles which cover it
+  const Eigen::Vector3f center = latest_pose.translation();
+  const Relocalizer::FieldArea area =
+    relocalizer_->field_area(line_segments, center.topRows(2), relocalization_radius_);
+  std::vector<CostMapValue> field = cost_map_.rasterize(area.origin, area.resolution, area.size);
+
+  // The search takes seconds, so the executor is not blocked by it
+  relocalization_task_ = std::async(
+    std::launch::async, [this, request_header, line_segments = std::move(line_segments),
+                         field = std::move(field), center]() {
+      Trigger::Response response = relocalize(line_segments, field, center);
+      relocalize_service_->send_response(*request_header, response);
+    });
+}
+
+CameraParticleCorrector::Trigger::Response CameraParticleCorrector::relocalize(
+  const LineSegments & line_segments, const std::vector<CostMapValue> & field,
+  const Eigen::Vector3f & center)
+{
+  Trigger::Response response;
+  response.success = false;
+
+  common::Timer timer;
+  auto field_sampler = [&field](const Eigen::Vector2f &, float, int) { return field; };
+  const std::vector<RelocalizationHypothesis> hypotheses =
+    relocalizer_->search(field_sampler, line_segments, center.topRows(2), relocalization_radius_);
+  RCLCPP_INFO_STREAM(
+    get_logger(), "relocalization found " << hypotheses.size() << " hypotheses in " << timer);
+  if (hypotheses.empty()) {
+    response.message = "no hypothesis is found";
+    return response;
+  }
+
+  PoseArray array_msg;
+  array_msg.header.stamp = now();
+  array_msg.header.frame_id = "map";
+  std::stringstream ss;
+  for (const RelocalizationHypothesis & h : hypotheses) {
+    Pose pose;
+    pose.position.x = h.position.x();
+    pose.position.y = h.position.y();
+    pose.position.z = center.z();
+    pose.orientation.w = std::cos(h.yaw / 2.f);
+    pose.orientation.z = std::sin(h.yaw / 2.f);
+    array_msg.poses.push_back(pose);
+    ss << h.position.x() << " " << h.position.y() << " " << h.yaw << " " << h.score << "\n";
+  }
+  pub_hypotheses_->publish(array_msg);
+
+  // The best hypothesis is spread by the rivals, so that the predictor can be initialized with it.
+  // It is only remapped to the initial pose of the predictor if the launch file is asked to.
+  PoseCovStamped pose_msg;
+  pose_msg.header = array_msg.header;
+  pose_msg.pose.pose = array_msg.poses.front();
+  const Eigen::Matrix3f covariance = relocalizer_->covariance(hypotheses);
+  const int indices[3] = {0, 1, 5};  // x, y and yaw in the 6x6 covariance
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 3; c++) {
+      pose_msg.pose.covariance.at(6 * indices[r] + indices[c]) = covariance(r, c);
+    }
+  }
+  pub_relocalized_pose_->publish(pose_msg);
+
+  response.success = true;
+  response.message = ss.str();
+  return response;
 }
 
 void CameraParticleCorrector::on_bounding_box(const PointCloud2 & msg)
@@ -93,11 +220,14 @@ void CameraParticleCorrector::on_bounding_box(const PointCloud2 & msg)
 std::pair<CameraParticleCorrector::LineSegments, CameraParticleCorrector::LineSegments>
 CameraParticleCorrector::split_line_segments(const PointCloud2 & msg)
 {
-  LineSegments all_line_segments_cloud;
-  pcl::fromROSMsg(msg, all_line_segments_cloud);
+  const common::LineSegmentsView all_line_segments(msg);
   LineSegments reliable_cloud, iffy_cloud;
   {
-    for (const auto & p : all_line_segments_cloud) {
+    for (size_t i = 0; i < all_line_segments.size(); i++) {
+      LineSegment p;
+      p.getVector3fMap() = all_line_segments.from(i);
+      p.getNormalVector3fMap() = all_line_segments.to(i);
+      p.label = all_line_segments.label(i);
       if (p.label == 0)
         iffy_cloud.push_back(p);
       else
@@ -140,7 +270,15 @@ void CameraParticleCorrector::on_line_segments(const PointCloud2 & line_segments
     RCLCPP_WARN_STREAM(get_logger(), text << dt.seconds());
   }
 
-  auto [line_segments_cloud, iffy_line_segments_cloud] = split_line_segments(line_segments_msg);
+  LineSegments line_segments_cloud, iffy_line_segments_cloud;
+  try {
+    std::tie(line_segments_cloud, iffy_line_segments_cloud) =
+      split_line_segments(line_segments_msg);
+  } catch (const std::runtime_error & e) {
+    RCLCPP_WARN_STREAM_THROTTLE(
+      get_logger(), *get_clock(), 1000, "drop line segments: " << e.what());
+    return;
+  }
   ParticleArray weighted_particles = opt_array.value();
 
   bool publish_weighted_particles = true;
@@ -161,22 +299,31 @@ void CameraParticleCorrector::on_line_segments(const PointCloud2 & line_segments
 
   cost_map_.set_height(meaned_pose.position.z);
 
+  LineSegments line_segments = line_segments_cloud;
+  line_segments += iffy_line_segments_cloud;
+
+  if (relocalizer_) {
+    // The relative motion between the frames is reliable even if the absolute pose is not
+    accumulated_line_segments_.emplace_back(common::pose_to_se3(meaned_pose), line_segments);
+    while (accumulated_line_segments_.size() > relocalization_accumulation_) {
+      accumulated_line_segments_.pop_front();
+    }
+  }
+
   if (publish_weighted_particles) {
-    for (auto & particle : weighted_particles.particles) {
-      Sophus::SE3f transform = common::pose_to_se3(particle.pose);
-      LineSegments transformed_line_segments =
-        common::transform_line_segments(line_segments_cloud, transform);
-      LineSegments transformed_iffy_line_segments =
-        common::transform_line_segments(iffy_line_segments_cloud, transform);
-      transformed_line_segments += transformed_iffy_line_segments;
-
-      float logit = compute_logit(transformed_line_segments, transform.translation());
-      particle.weight = logit_to_prob(logit, 0.01f);
+    std::vector<Sophus::SE3f> poses;
+    poses.reserve(weighted_particles.particles.size());
+    for (const auto & particle : weighted_particles.particles) {
+      poses.push_back(common::pose_to_se3(particle.pose));
     }
 
-    if (enable_switch_) {
-      this->set_weighted_particle_array(weighted_particles);
+    auto sampler = [this](const Eigen::Vector2f & p) -> CostMapValue { return cost_map_.at(p); };
+    const std::vector<float> logits = pose_scorer_.score(sampler, line_segments, poses);
+    for (size_t i = 0; i < logits.size(); ++i) {
+      weighted_particles.particles[i].weight = logit_to_prob(logits[i], 0.01f);
     }
+
+    this->set_weighted_particle_array(weighted_particles);
   }
 
   cost_map_.erase_obsolete();  // NOTE:
@@ -187,11 +334,9 @@ void CameraParticleCorrector::on_line_segments(const PointCloud2 & line_segments
     Pose meaned_pose = mean_pose(weighted_particles);
     Sophus::SE3f transform = common::pose_to_se3(meaned_pose);
 
-    pcl::PointCloud<pcl::PointXYZI> cloud = evaluate_cloud(
-      common::transform_line_segments(line_segments_cloud, transform), transform.translation());
-    pcl::PointCloud<pcl::PointXYZI> iffy_cloud = evaluate_cloud(
-      common::transform_line_segments(iffy_line_segments_cloud, transform),
-      transform.translation());
+    pcl::PointCloud<pcl::PointXYZI> cloud = evaluate_cloud(line_segments_cloud, transform);
+    pcl::PointCloud<pcl::PointXYZI> iffy_cloud =
+      evaluate_cloud(iffy_line_segments_cloud, transform);
 
     pcl::PointCloud<pcl::PointXYZRGB> rgb_cloud;
     pcl::PointCloud<pcl::PointXYZRGB> rgb_cloud2;
@@ -220,24 +365,15 @@ void CameraParticleCorrector::on_line_segments(const PointCloud2 & line_segments
 
   if (timer.milli_seconds() > 80) {
     RCLCPP_WARN_STREAM(get_logger(), "on_line_segments: " << timer);
-  } else {
-    RCLCPP_INFO_STREAM(get_logger(), "on_line_segments: " << timer);
   }
 
-  // Publish status as string
-  {
-    String msg;
-    std::stringstream ss;
-    ss << "-- Camera particle corrector --" << std::endl;
-    ss << (enable_switch_ ? "ENABLED" : "disabled") << std::endl;
-    ss << "time: " << timer << std::endl;
-    msg.data = ss.str();
-    pub_string_->publish(msg);
-  }
+  // Record status
+  status_->set(status_time_index_, timer.milli_seconds());
 }
 
 void CameraParticleCorrector::on_timer()
 {
+  if (is_suspended()) return;
   if (latest_pose_.has_value())
     common::publish_image(
       *pub_map_image_, cost_map_.get_map_image(latest_pose_->pose), latest_pose_->header.stamp);
@@ -245,76 +381,21 @@ void CameraParticleCorrector::on_timer()
 
 void CameraParticleCorrector::on_ll2(const PointCloud2 & ll2_msg)
 {
-  pcl::PointCloud<pcl::PointNormal> ll2_cloud;
-  pcl::fromROSMsg(ll2_msg, ll2_cloud);
-  cost_map_.set_cloud(ll2_cloud);
-  RCLCPP_INFO_STREAM(get_logger(), "Set LL2 cloud into Hierarchical cost map");
-}
-
-float abs_cos(const Eigen::Vector3f & t, float deg)
-{
-  // NOTE: use pre-computed table for std::cos & std::sin
-  Eigen::Vector2f x(t.x(), t.y());
-  Eigen::Vector2f y(fast_math.cos(deg), fast_math.sin(deg));
-  x.normalize();
-  return std::abs(x.dot(y));
-}
-
-float CameraParticleCorrector::compute_logit(
-  const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position)
-{
-  float logit = 0;
-  for (const LineSegment & pn : line_segments_cloud) {
-    const Eigen::Vector3f tangent = (pn.getNormalVector3fMap() - pn.getVector3fMap()).normalized();
-    const float length = (pn.getVector3fMap() - pn.getNormalVector3fMap()).norm();
-
-    for (float distance = 0; distance < length; distance += 0.1f) {
-      Eigen::Vector3f p = pn.getVector3fMap() + tangent * distance;
-
-      // NOTE: Close points are prioritized
-      float squared_norm = (p - self_position).topRows(2).squaredNorm();
-      float gain = exp(-far_weight_gain_ * squared_norm);  // 0 < gain < 1
-
-      const CostMapValue v3 = cost_map_.at(p.topRows(2));
-
-      if (v3.unmapped) {
-        // logit does not change if target pixel is unmapped
-        continue;
-      }
-      if (pn.label == 0) {  // posteriori
-        logit += 0.2f * gain * (abs_cos(tangent, v3.angle) * v3.intensity - 0.5f);
-      } else {  // apriori
-        logit += gain * (abs_cos(tangent, v3.angle) * v3.intensity - 0.5f);
-      }
-    }
+  try {
+    cost_map_.set_cloud(common::LineSegmentsView(ll2_msg));
+  } catch (const std::runtime_error & e) {
+    RCLCPP_WARN_STREAM_THROTTLE(get_logger(), *get_clock(), 1000, "drop LL2 cloud: " << e.what());
+    return;
   }
-  return logit;
+  RCLCPP_INFO_STREAM(get_logger(), "Set LL2 cloud into Hierarchical cost map");
 }
 
 pcl::PointCloud<pcl::PointXYZI> CameraParticleCorrector::evaluate_cloud(
-  const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position)
+  const LineSegments & line_segments_cloud, const Sophus::SE3f & pose)
 {
-  pcl::PointCloud<pcl::PointXYZI> cloud;
-  for (const LineSegment & pn : line_segments_cloud) {
-    Eigen::Vector3f tangent = (pn.getNormalVector3fMap() - pn.getVector3fMap()).normalized();
-    float length = (pn.getVector3fMap() - pn.getNormalVector3fMap()).norm();
-
-    for (float distance = 0; distance < length; distance += 0.1f) {
-      Eigen::Vector3f p = pn.getVector3fMap() + tangent * distance;
-
-      // NOTE: Close points are prioritized
-      float squared_norm = (p - self_position).topRows(2).squaredNorm();
-      float gain = std::exp(-far_weight_gain_ * squared_norm);
-
-      CostMapValue v3 = cost_map_.at(p.topRows(2));
-      float logit = 0;
-      if (!v3.unmapped) logit = gain * (abs_cos(tangent, v3.angle) * v3.intensity - 0.5f);
-
-      pcl::PointXYZI xyzi(logit_to_prob(logit, 10.f));
-      xyzi.getVector3fMap() = p;
-      cloud.push_back(xyzi);
-    }
-  }
+  auto sampler = [this](const Eigen::Vector2f & p) -> CostMapValue { return cost_map_.at(p); };
+  pcl::PointCloud<pcl::PointXYZI> cloud = pose_scorer_.evaluate(sampler, line_segments_cloud, pose);
+  for (pcl::PointXYZI & p : cloud) p.intensity = logit_to_prob(p.intensity, 10.f);
   return cloud;
 }
 }  // namespace yabloc::modularized_particle_filter
\ No newline at end of file
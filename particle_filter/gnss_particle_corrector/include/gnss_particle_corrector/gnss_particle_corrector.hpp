@@ -45,6 +45,7 @@ public:
 private:
   const bool ignore_less_than_float_;
   const float mahalanobis_distance_threshold_;
+  const bool use_ublox_msg_;
   const WeightManager weight_manager_;
 
   rclcpp::Subscription<Float32>::SharedPtr height_sub_;
@@ -58,6 +59,10 @@ private:
   void on_ublox(const NavPVT::ConstSharedPtr ublox_msg);
   void on_pose(const PoseCovStamped::ConstSharedPtr pose_msg);
 
+  void on_suspend() override;
+  void on_resume() override;
+  void subscribe_gnss();
+
   void process(
     const Eigen::Vector3f & gnss_position, const rclcpp::Time & stamp, const bool is_rtk_fixed);
 
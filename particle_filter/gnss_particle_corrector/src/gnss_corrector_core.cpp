@@ -25,25 +25,40 @@ GnssParticleCorrector::GnssParticleCorrector()
 : AbstCorrector("gnss_particle_corrector"),
   ignore_less_than_float_(declare_parameter<bool>("ignore_less_than_float", true)),
   mahalanobis_distance_threshold_(declare_parameter<float>("mahalanobis_distance_threshold", 20.0)),
+  use_ublox_msg_(declare_parameter<bool>("use_ublox_msg", true)),
   weight_manager_(this)
 {
-  using std::placeholders::_1;
-
   // Subscriber
+  auto on_height = [this](const Float32 & height) { this->latest_height_ = height; };
+  subscribe_gnss();
+  height_sub_ = create_subscription<Float32>("input/height", 10, on_height);
+
+  // Publisher
+  marker_pub_ = create_publisher<MarkerArray>("gnss/range_marker", 10);
+
+  initialize_suspension();
+}
+
+void GnssParticleCorrector::subscribe_gnss()
+{
+  using std::placeholders::_1;
   auto on_pose = std::bind(&GnssParticleCorrector::on_pose, this, _1);
   auto on_ublox = std::bind(&GnssParticleCorrector::on_ublox, this, _1);
-  auto on_height = [this](const Float32 & height) { this->latest_height_ = height; };
-  if (declare_parameter<bool>("use_ublox_msg", true)) {
+  if (use_ublox_msg_) {
     ublox_sub_ = create_subscription<NavPVT>("input/navpvt", 10, on_ublox);
   } else {
     pose_sub_ = create_subscription<PoseCovStamped>("input/pose_with_covariance", 10, on_pose);
   }
-  height_sub_ = create_subscription<Float32>("input/height", 10, on_height);
+}
 
-  // Publisher
-  marker_pub_ = create_publisher<MarkerArray>("gnss/range_marker", 10);
+void GnssParticleCorrector::on_suspend()
+{
+  ublox_sub_.reset();
+  pose_sub_.reset();
 }
 
+void GnssParticleCorrector::on_resume() { subscribe_gnss(); }
+
 Eigen::Vector3f extract_enu_vel(const GnssParticleCorrector::NavPVT & msg)
 {
   Eigen::Vector3f enu_vel;
@@ -60,7 +75,7 @@ bool GnssParticleCorrector::is_gnss_observation_valid(
   diff.z() = 0;
 
   float mahalanobis_distance = std::sqrt(diff.dot(inv_sigma * diff));
-  RCLCPP_INFO_STREAM(get_logger(), "mahalanobis: " << mahalanobis_distance);
+  RCLCPP_DEBUG_STREAM(get_logger(), "mahalanobis: " << mahalanobis_distance);
 
   if (mahalanobis_distance > mahalanobis_distance_threshold_) {
     RCLCPP_WARN_STREAM(
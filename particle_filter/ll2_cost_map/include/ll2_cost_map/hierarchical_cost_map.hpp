@@ -17,6 +17,7 @@
 #include <opencv4/opencv2/core.hpp>
 #include <rclcpp/node.hpp>
 #include <yabloc_common/gamma_converter.hpp>
+#include <yabloc_common/line_segments_msg.hpp>
 
 #include <visualization_msgs/msg/marker_array.hpp>
 
@@ -95,6 +96,8 @@ public:
 
   HierarchicalCostMap(rclcpp::Node * node);
 
+  // Only the end points are kept, in the compact form of common::LineSegment
+  void set_cloud(const common::LineSegmentsView & cloud);
   void set_cloud(const pcl::PointCloud<pcl::PointNormal> & cloud);
   void set_bounding_box(const pcl::PointCloud<pcl::PointXYZL> & cloud);
 
@@ -106,6 +109,18 @@ public:
    */
   CostMapValue at(const Eigen::Vector2f & position);
 
+  /**
+   * Rasterize the square area at once, without building or caching any tile
+   *
+   * The intensity falls off over the same distance in meters as at(), whatever the resolution is.
+   * @param[in] origin Real scale position of the corner of the cell (0, 0)
+   * @param[in] resolution Cell size [m]
+   * @param[in] size Number of the cells along each axis
+   * @return Values at the cells in row-major order of (x, y)
+   */
+  std::vector<CostMapValue> rasterize(
+    const Eigen::Vector2f & origin, float resolution, int size) const;
+
   MarkerArray show_map_range() const;
 
   cv::Mat get_map_image(const Pose & pose);
@@ -126,13 +141,22 @@ private:
   std::unordered_map<Area, bool, Area> map_accessed_;
 
   std::list<Area> generated_map_history_;
-  std::optional<pcl::PointCloud<pcl::PointNormal>> cloud_;
+  std::optional<std::vector<common::LineSegment>> cloud_;
   std::vector<BgPolygon> bounding_boxes_;
   std::unordered_map<Area, cv::Mat, Area> cost_maps_;
 
-  cv::Point to_cv_point(const Area & are, const Eigen::Vector2f) const;
+  // Cell size of the tiles [m]
+  float tile_resolution() const { return max_range_ / image_size_; }
+
+  cv::Point to_cv_point(
+    const Eigen::Vector2f & origin, float resolution, const Eigen::Vector2f & p) const;
   void build_map(const Area & area);
+  void reset_cost_maps();
+
+  // 3-channel cost map of the square area whose corner is origin
+  cv::Mat render(const Eigen::Vector2f & origin, float resolution, int size) const;
 
-  cv::Mat create_available_area_image(const Area & area) const;
+  cv::Mat create_available_area_image(
+    const Eigen::Vector2f & origin, float resolution, int size) const;
 };
 }  // namespace yabloc
\ No newline at end of file
@@ -0,0 +1,110 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "ll2_cost_map/hierarchical_cost_map.hpp"
+
+#include <Eigen/Core>
+#include <sophus/geometry.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <array>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace yabloc
+{
+/**
+ * Scoring of vehicle poses against the cost map, shared by the correctors
+ *
+ * The score of a pose is the sum over the points sampled along the line segments of
+ * weight * gain * (|cos| * intensity - 0.5), where |cos| is between the segment and the map, the
+ * gain decays with the distance from the vehicle and the weight is iffy_weight for the segments
+ * whose label is 0. The line segments are sampled once per call in the vehicle frame, so scoring a
+ * batch of poses only transforms the sampled points for each pose.
+ */
+class PoseScorer
+{
+public:
+  using LineSegment = pcl::PointXYZLNormal;
+  using LineSegments = pcl::PointCloud<LineSegment>;
+  using Sampler = std::function<CostMapValue(const Eigen::Vector2f &)>;
+
+  struct Parameters
+  {
+    float sample_interval{0.1f};  // interval of the points along the segments [m]
+    float far_weight_gain{0.001f};
+    float iffy_weight{0.2f};  // weight of the segments whose label is 0
+  };
+
+  explicit PoseScorer(const Parameters & parameters);
+
+  /**
+   * @param[in] sampler Cost map value at the world position. It is called on the calling thread
+   * only, so HierarchicalCostMap::at() can be used as it is.
+   * @param[in] line_segments Line segments in the ground frame of the vehicle
+   * @param[in] poses Poses of the vehicle in the world frame
+   * @return The score of each pose
+   */
+  std::vector<float> score(
+    const Sampler & sampler, const LineSegments & line_segments,
+    const std::vector<Sophus::SE3f> & poses) const;
+
+  float score(
+    const Sampler & sampler, const LineSegments & line_segments, const Sophus::SE3f & pose) const;
+
+  /**
+   * Per-point logit of the pose, for visualization
+   *
+   * @return The points sampled along the line segments in the world frame, whose intensity is
+   * gain * (|cos| * intensity - 0.5), or 0 if unmapped. The weight of the label is not applied.
+   */
+  pcl::PointCloud<pcl::PointXYZI> evaluate(
+    const Sampler & sampler, const LineSegments & line_segments, const Sophus::SE3f & pose) const;
+
+  /**
+   * Split the line segments into the ones which agree with the cost map at the pose and the others
+   *
+   * @return The pair of the agreeing line segments and the others
+   */
+  std::pair<LineSegments, LineSegments> filter(
+    const Sampler & sampler, const LineSegments & line_segments, const Sophus::SE3f & pose) const;
+
+private:
+  struct Point
+  {
+    Eigen::Vector3f position;
+    Eigen::Vector3f tangent;
+    float weight;
+  };
+
+  const Parameters parameters_;
+  // Unit vector of each angle of the cost map [deg]
+  std::array<Eigen::Vector2f, 360> directions_;
+
+  std::vector<Point> sample_points(const LineSegments & line_segments) const;
+
+  // Logit of one point without its weight, or nullopt if unmapped
+  std::optional<float> point_logit(
+    const Sampler & sampler, const Point & point, const Eigen::Matrix3f & R,
+    const Eigen::Vector3f & t) const;
+
+  float score_points(
+    const Sampler & sampler, const std::vector<Point> & points, const Sophus::SE3f & pose) const;
+};
+}  // namespace yabloc
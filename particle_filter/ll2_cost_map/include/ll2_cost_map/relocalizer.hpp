@@ -0,0 +1,167 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "ll2_cost_map/hierarchical_cost_map.hpp"
+
+#include <Eigen/Core>
+#include <yabloc_common/thread_pool.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <cmath>
+#include <functional>
+#include <vector>
+
+namespace yabloc
+{
+struct RelocalizationHypothesis
+{
+  Eigen::Vector2f position;
+  float yaw;    // radians
+  float score;  // weighted mean of the per-point score of the corrector, -0.5~0.5
+};
+
+/**
+ * Global search of (x, y, yaw) which matches the line segments with the cost map best
+ *
+ * The cost field around the search area is sampled once at the finest resolution, and the coarser
+ * levels take the maximum of 2^level x 2^level cells of it. Since the maximum of the intensity is
+ * never less than the score of any translation inside the cell block, the sum over the points
+ * bounds the score from above and the branch and bound search over the translation visits only
+ * the blocks which can still beat the top-K hypotheses. The score of a leaf is the same as
+ * CameraParticleCorrector::compute_logit() except that it is normalized by the sum of the weights.
+ *
+ * Each yaw is searched independently on the pool, and the results are merged in the order of the
+ * yaw, so the hypotheses do not depend on the scheduling.
+ */
+class Relocalizer
+{
+public:
+  using LineSegment = pcl::PointXYZLNormal;
+  using LineSegments = pcl::PointCloud<LineSegment>;
+  using Sampler = std::function<CostMapValue(const Eigen::Vector2f &)>;
+  // Values of the size x size cells whose centers are origin + resolution * ((x, y) + 0.5), in
+  // row-major order of (x, y)
+  using FieldSampler = std::function<std::vector<CostMapValue>(
+    const Eigen::Vector2f & origin, float resolution, int size)>;
+
+  struct Parameters
+  {
+    float resolution{0.5f};  // cell size of the finest level [m]
+    int depth{5};            // number of the coarser levels
+    int yaw_count{72};       // number of the yaw hypotheses per turn
+    int top_k{5};
+    float min_distance{2.0f};            // hypotheses closer than this [m] ...
+    float min_yaw_distance{M_PI / 8.f};  // ... and this [rad] are merged
+    float sample_interval{0.5f};         // interval of the points along the segments [m]
+    float far_weight_gain{0.001f};
+    float iffy_weight{0.2f};  // weight of the segments whose label is 0
+  };
+
+  // Cells of the cost field which search() samples, as given to FieldSampler
+  struct FieldArea
+  {
+    Eigen::Vector2f origin;
+    float resolution;
+    int size;
+  };
+
+  explicit Relocalizer(const Parameters & parameters, common::ThreadPool * pool = nullptr);
+
+  // Return the area which search() samples for the same arguments, so that it can be prepared in
+  // advance. The size is 0 if there is no point to match.
+  FieldArea field_area(
+    const LineSegments & line_segments, const Eigen::Vector2f & center, float radius) const;
+
+  /**
+   * @param[in] field_sampler Cost map values of the search area. It is called once on the calling
+   * thread, e.g. HierarchicalCostMap::rasterize().
+   * @param[in] line_segments Line segments in the ground frame of the vehicle
+   * @param[in] center Center of the translation search [m]
+   * @param[in] radius Half width of the translation search [m]
+   * @param[in] yaw_center Center of the yaw search [rad]
+   * @param[in] yaw_range The yaw is searched in [yaw_center - yaw_range, yaw_center + yaw_range)
+   * @return At most top_k hypotheses in descending order of the score
+   */
+  std::vector<RelocalizationHypothesis> search(
+    const FieldSampler & field_sampler, const LineSegments & line_segments,
+    const Eigen::Vector2f & center, float radius, float yaw_center = 0.f,
+    float yaw_range = M_PI) const;
+
+  // Same as above, but every cell is sampled at its center one by one
+  std::vector<RelocalizationHypothesis> search(
+    const Sampler & sampler, const LineSegments & line_segments, const Eigen::Vector2f & center,
+    float radius, float yaw_center = 0.f, float yaw_range = M_PI) const;
+
+  /**
+   * Covariance of (x, y, yaw) around the best hypothesis
+   *
+   * The other hypotheses are weighted by their positive score, so that rivals which match as well
+   * as the best one spread it and weak ones hardly do. The variance of the search step, i.e.
+   * resolution^2 and (2 pi / yaw_count)^2, is always added.
+   *
+   * @param[in] hypotheses Result of search(), in descending order of the score
+   */
+  Eigen::Matrix3f covariance(const std::vector<RelocalizationHypothesis> & hypotheses) const;
+
+private:
+  struct Point
+  {
+    Eigen::Vector2f position;
+    Eigen::Vector2f tangent;
+    float weight;
+  };
+
+  // Sampled cost field, stored in row-major order of (x, y)
+  struct Field
+  {
+    int size;
+    std::vector<float> intensity;  // intensity - 0.5, or 0 if unmapped
+    std::vector<Eigen::Vector2f> direction;  // unit vector of the angle, or zero if unmapped
+    // levels[h] is the maximum of intensity in the 2^h x 2^h cells
+    std::vector<std::vector<float>> levels;
+  };
+
+  struct Candidate
+  {
+    int x, y;
+    float score;
+  };
+
+  const Parameters parameters_;
+  common::ThreadPool * pool_;
+
+  // The translation (x, y) moves the vehicle to center + resolution * ((x, y) - half_count), and
+  // the field cell (0, 0) is at the translation (0, 0) shifted by -margin
+  struct Layout
+  {
+    int half_count;
+    int translation_count;
+    int margin;
+    FieldArea area;
+  };
+
+  std::vector<Point> sample_points(const LineSegments & line_segments) const;
+
+  Layout make_layout(
+    const std::vector<Point> & points, const Eigen::Vector2f & center, float radius) const;
+
+  // Top-K translations of the points which are already rotated and discretized
+  std::vector<Candidate> search_translation(
+    const Field & field, const std::vector<Eigen::Vector2i> & cells,
+    const std::vector<Point> & points, int translation_count) const;
+};
+}  // namespace yabloc
@@ -37,11 +37,12 @@ HierarchicalCostMap::HierarchicalCostMap(rclcpp::Node * node)
   gamma_converter.reset(gamma);
 }
 
-cv::Point2i HierarchicalCostMap::to_cv_point(const Area & area, const Eigen::Vector2f p) const
+cv::Point2i HierarchicalCostMap::to_cv_point(
+  const Eigen::Vector2f & origin, float resolution, const Eigen::Vector2f & p) const
 {
-  Eigen::Vector2f relative = p - area.real_scale();
-  float px = relative.x() / max_range_ * image_size_;
-  float py = relative.y() / max_range_ * image_size_;
+  Eigen::Vector2f relative = p - origin;
+  float px = relative.x() / resolution;
+  float py = relative.y() / resolution;
   return {static_cast<int>(px), static_cast<int>(py)};
 }
 
@@ -57,7 +58,7 @@ CostMapValue HierarchicalCostMap::at(const Eigen::Vector2f & position)
   }
   map_accessed_[key] = true;
 
-  cv::Point2i tmp = to_cv_point(key, position);
+  cv::Point2i tmp = to_cv_point(key.real_scale(), tile_resolution(), position);
   cv::Vec3b b3 = cost_maps_.at(key).ptr<cv::Vec3b>(tmp.y)[tmp.x];
   return {b3[0] / 255.f, b3[1], b3[2] == 1};
 }
@@ -65,18 +66,24 @@ CostMapValue HierarchicalCostMap::at(const Eigen::Vector2f & position)
 void HierarchicalCostMap::set_height(float height)
 {
   if (height_) {
-    if (std::abs(*height_ - height) > 2) {
-      generated_map_history_.clear();
-      cost_maps_.clear();
-      map_accessed_.clear();
-    }
+    if (std::abs(*height_ - height) > 2) reset_cost_maps();
   }
 
   height_ = height;
 }
 
+void HierarchicalCostMap::reset_cost_maps()
+{
+  generated_map_history_.clear();
+  cost_maps_.clear();
+  map_accessed_.clear();
+}
+
 void HierarchicalCostMap::set_bounding_box(const pcl::PointCloud<pcl::PointXYZL> & cloud)
 {
+  // A republished map replaces the previous one, e.g. when the map is streamed by tiles
+  bounding_boxes_.clear();
+  reset_cost_maps();
   if (cloud.empty()) return;
   BgPolygon poly;
 
@@ -94,31 +101,70 @@ void HierarchicalCostMap::set_bounding_box(const pcl::PointCloud<pcl::PointXYZL>
   bounding_boxes_.push_back(poly);
 }
 
+void HierarchicalCostMap::set_cloud(const common::LineSegmentsView & cloud)
+{
+  cloud_ = std::vector<common::LineSegment>(cloud.begin(), cloud.end());
+  reset_cost_maps();
+}
+
 void HierarchicalCostMap::set_cloud(const pcl::PointCloud<pcl::PointNormal> & cloud)
 {
-  cloud_ = cloud;
+  std::vector<common::LineSegment> segments;
+  segments.reserve(cloud.size());
+  for (const pcl::PointNormal & pn : cloud) {
+    segments.push_back({pn.getVector3fMap(), pn.getNormalVector3fMap(), 0});
+  }
+  cloud_ = std::move(segments);
+  reset_cost_maps();
 }
 
 void HierarchicalCostMap::build_map(const Area & area)
 {
   if (!cloud_.has_value()) return;
 
-  cv::Mat image = 255 * cv::Mat::ones(cv::Size(image_size_, image_size_), CV_8UC1);
-  cv::Mat orientation = cv::Mat::zeros(cv::Size(image_size_, image_size_), CV_8UC1);
+  cost_maps_[area] = render(area.real_scale(), tile_resolution(), image_size_);
+  generated_map_history_.push_back(area);
+
+  RCLCPP_INFO_STREAM(
+    logger_, "successed to build map " << area(area) << " " << area.real_scale().transpose());
+}
+
+std::vector<CostMapValue> HierarchicalCostMap::rasterize(
+  const Eigen::Vector2f & origin, float resolution, int size) const
+{
+  if (!cloud_.has_value()) return std::vector<CostMapValue>(size * size, {0.5f, 0, true});
+
+  const cv::Mat directed_cost_map = render(origin, resolution, size);
+  std::vector<CostMapValue> values;
+  values.reserve(size * size);
+  for (int x = 0; x < size; x++) {
+    for (int y = 0; y < size; y++) {
+      const cv::Vec3b b3 = directed_cost_map.at<cv::Vec3b>(y, x);
+      values.emplace_back(b3[0] / 255.f, b3[1], b3[2] == 1);
+    }
+  }
+  return values;
+}
 
-  auto cvPoint = [this, area](const Eigen::Vector3f & p) -> cv::Point {
-    return this->to_cv_point(area, p.topRows(2));
+cv::Mat HierarchicalCostMap::render(
+  const Eigen::Vector2f & origin, float resolution, int size) const
+{
+  cv::Mat image = 255 * cv::Mat::ones(cv::Size(size, size), CV_8UC1);
+  cv::Mat orientation = cv::Mat::zeros(cv::Size(size, size), CV_8UC1);
+
+  auto cvPoint = [this, origin, resolution](const Eigen::Vector3f & p) -> cv::Point {
+    return this->to_cv_point(origin, resolution, p.topRows(2));
   };
 
   // TODO: We can speed up by skipping too far line_segments
-  for (const auto pn : cloud_.value()) {
+  for (const common::LineSegment & segment : cloud_.value()) {
     if (height_) {
-      if (std::abs(pn.z - *height_) > 4) continue;
-      if (std::abs(pn.normal_z - *height_) > 4) continue;
+      if (std::abs(segment.from.z() - *height_) > 4) continue;
+      if (std::abs(segment.to.z() - *height_) > 4) continue;
     }
 
-    cv::Point2i from = cvPoint(pn.getVector3fMap());
-    cv::Point2i to = cvPoint(pn.getNormalVector3fMap());
+    cv::Point2i from = cvPoint(segment.from);
+    cv::Point2i to = cvPoint(segment.to);
 
     float radian = std::atan2(from.y - to.y, from.x - to.x);
     if (radian < 0) radian += M_PI;
@@ -129,8 +175,10 @@ void HierarchicalCostMap::build_map(const Area & area)
   }
 
   // channel-1
+  // The distance is converted to the pixels of the tiles, which the truncation is defined in
   cv::Mat distance;
   cv::distanceTransform(image, distance, cv::DIST_L2, 3);
+  distance *= resolution / tile_resolution();
   cv::threshold(distance, distance, 100, 100, cv::THRESH_TRUNC);
   distance.convertTo(distance, CV_8UC1, -2.55, 255);
 
@@ -138,18 +186,13 @@ void HierarchicalCostMap::build_map(const Area & area)
   cv::Mat whole_orientation = direct_cost_map(orientation, image);
 
   // channel-3
-  cv::Mat available_area = create_available_area_image(area);
+  cv::Mat available_area = create_available_area_image(origin, resolution, size);
 
   cv::Mat directed_cost_map;
   cv::merge(
     std::vector<cv::Mat>{gamma_converter(distance), whole_orientation, available_area},
     directed_cost_map);
-
-  cost_maps_[area] = directed_cost_map;
-  generated_map_history_.push_back(area);
-
-  RCLCPP_INFO_STREAM(
-    logger_, "successed to build map " << area(area) << " " << area.real_scale().transpose());
+  return directed_cost_map;
 }
 
 HierarchicalCostMap::MarkerArray HierarchicalCostMap::show_map_range() const
@@ -233,18 +276,19 @@ void HierarchicalCostMap::erase_obsolete()
   map_accessed_.clear();
 }
 
-cv::Mat HierarchicalCostMap::create_available_area_image(const Area & area) const
+cv::Mat HierarchicalCostMap::create_available_area_image(
+  const Eigen::Vector2f & origin, float resolution, int size) const
 {
-  cv::Mat available_area = cv::Mat::zeros(cv::Size(image_size_, image_size_), CV_8UC1);
+  cv::Mat available_area = cv::Mat::zeros(cv::Size(size, size), CV_8UC1);
   if (bounding_boxes_.empty()) return available_area;
 
   // Define current area
   using BgBox = boost::geometry::model::box<BgPoint>;
 
   BgBox area_polygon;
-  std::array<Eigen::Vector2f, 2> area_bounding_box = area.real_scale_boundary();
-  area_polygon.min_corner() = {area_bounding_box[0].x(), area_bounding_box[0].y()};
-  area_polygon.max_corner() = {area_bounding_box[1].x(), area_bounding_box[1].y()};
+  const Eigen::Vector2f area_max = origin + Eigen::Vector2f::Constant(size * resolution);
+  area_polygon.min_corner() = {origin.x(), origin.y()};
+  area_polygon.max_corner() = {area_max.x(), area_max.y()};
 
   std::vector<std::vector<cv::Point2i>> contours;
 
@@ -254,7 +298,7 @@ cv::Mat HierarchicalCostMap::create_available_area_image(const Area & area) cons
     }
     std::vector<cv::Point2i> contour;
     for (BgPoint p : box.outer()) {
-      contour.push_back(to_cv_point(area, {p.x(), p.y()}));
+      contour.push_back(to_cv_point(origin, resolution, {p.x(), p.y()}));
     }
     contours.push_back(contour);
   }
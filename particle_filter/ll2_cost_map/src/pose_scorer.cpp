@@ -0,0 +1,165 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ll2_cost_map/pose_scorer.hpp"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace yabloc
+{
+namespace
+{
+// 1 if t is parallel to the angle, 0 if perpendicular and linear in between
+float linear_abs_cos(const Eigen::Vector3f & t, float deg)
+{
+  float diff = std::atan2(t.y(), t.x()) - deg * M_PI / 180;
+  diff = std::fmod(diff, M_PI);
+
+  if (diff < 0) diff = -diff;
+
+  if (diff < M_PI_2) {
+    return 1 - diff / M_PI_2;
+  } else if (diff < M_PI) {
+    return diff / M_PI_2 - 1;
+  } else {
+    throw std::runtime_error("0?" + std::to_string(diff));
+  }
+}
+}  // namespace
+
+PoseScorer::PoseScorer(const Parameters & parameters) : parameters_(parameters)
+{
+  if (parameters_.sample_interval <= 0) {
+    throw std::runtime_error("sample_interval of PoseScorer must be positive");
+  }
+  for (size_t deg = 0; deg < directions_.size(); ++deg) {
+    const float radian = deg * M_PI / 180.f;
+    directions_[deg] = Eigen::Vector2f(std::cos(radian), std::sin(radian));
+  }
+}
+
+std::vector<PoseScorer::Point> PoseScorer::sample_points(const LineSegments & line_segments) const
+{
+  std::vector<Point> points;
+  for (const LineSegment & pn : line_segments) {
+    const Eigen::Vector3f from = pn.getVector3fMap();
+    const float length = (pn.getNormalVector3fMap() - from).norm();
+    if (length < std::numeric_limits<float>::epsilon()) continue;
+    const Eigen::Vector3f tangent = (pn.getNormalVector3fMap() - from) / length;
+    const float label_weight = pn.label == 0 ? parameters_.iffy_weight : 1.f;
+
+    for (float distance = 0; distance < length; distance += parameters_.sample_interval) {
+      points.push_back({from + tangent * distance, tangent, label_weight});
+    }
+  }
+  return points;
+}
+
+std::optional<float> PoseScorer::point_logit(
+  const Sampler & sampler, const Point & point, const Eigen::Matrix3f & R,
+  const Eigen::Vector3f & t) const
+{
+  const Eigen::Vector3f offset = R * point.position;
+  const CostMapValue v3 = sampler((offset + t).topRows(2));
+  if (v3.unmapped) return std::nullopt;
+
+  // NOTE: Close points are prioritized
+  const float gain = std::exp(-parameters_.far_weight_gain * offset.topRows(2).squaredNorm());
+  const Eigen::Vector2f tangent = (R * point.tangent).topRows(2).normalized();
+  const int deg = ((v3.angle % 360) + 360) % 360;
+  const float abs_cos = std::abs(tangent.dot(directions_[deg]));
+  return gain * (abs_cos * v3.intensity - 0.5f);
+}
+
+float PoseScorer::score_points(
+  const Sampler & sampler, const std::vector<Point> & points, const Sophus::SE3f & pose) const
+{
+  const Eigen::Matrix3f R = pose.so3().matrix();
+  const Eigen::Vector3f t = pose.translation();
+
+  float logit = 0;
+  for (const Point & point : points) {
+    // logit does not change if target pixel is unmapped
+    if (const std::optional<float> l = point_logit(sampler, point, R, t)) {
+      logit += point.weight * l.value();
+    }
+  }
+  return logit;
+}
+
+pcl::PointCloud<pcl::PointXYZI> PoseScorer::evaluate(
+  const Sampler & sampler, const LineSegments & line_segments, const Sophus::SE3f & pose) const
+{
+  const Eigen::Matrix3f R = pose.so3().matrix();
+  const Eigen::Vector3f t = pose.translation();
+
+  pcl::PointCloud<pcl::PointXYZI> cloud;
+  for (const Point & point : sample_points(line_segments)) {
+    pcl::PointXYZI xyzi(point_logit(sampler, point, R, t).value_or(0.f));
+    xyzi.getVector3fMap() = R * point.position + t;
+    cloud.push_back(xyzi);
+  }
+  return cloud;
+}
+
+std::vector<float> PoseScorer::score(
+  const Sampler & sampler, const LineSegments & line_segments,
+  const std::vector<Sophus::SE3f> & poses) const
+{
+  const std::vector<Point> points = sample_points(line_segments);
+  std::vector<float> scores;
+  scores.reserve(poses.size());
+  for (const Sophus::SE3f & pose : poses) {
+    scores.push_back(score_points(sampler, points, pose));
+  }
+  return scores;
+}
+
+float PoseScorer::score(
+  const Sampler & sampler, const LineSegments & line_segments, const Sophus::SE3f & pose) const
+{
+  return score_points(sampler, sample_points(line_segments), pose);
+}
+
+std::pair<PoseScorer::LineSegments, PoseScorer::LineSegments> PoseScorer::filter(
+  const Sampler & sampler, const LineSegments & line_segments, const Sophus::SE3f & pose) const
+{
+  LineSegments good, bad;
+  for (const LineSegment & line : line_segments) {
+    const Eigen::Vector3f p1 = line.getVector3fMap();
+    const Eigen::Vector3f p2 = line.getNormalVector3fMap();
+    const float length = (p1 - p2).norm();
+    const Eigen::Vector3f tangent = (p1 - p2).normalized();
+
+    float score = 0;
+    int count = 0;
+    for (float distance = 0; distance < length; distance += parameters_.sample_interval) {
+      Eigen::Vector3f px = pose * (p2 + tangent * distance);
+      CostMapValue v3 = sampler(px.topRows(2));
+      score += linear_abs_cos(pose.so3() * tangent, v3.angle) * v3.intensity;
+      count++;
+    }
+
+    if (score / count > 0.5f) {
+      good.push_back(line);
+    } else {
+      bad.push_back(line);
+    }
+  }
+  return {good, bad};
+}
+}  // namespace yabloc
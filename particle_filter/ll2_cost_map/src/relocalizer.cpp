@@ -0,0 +1,351 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ll2_cost_map/relocalizer.hpp"
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace yabloc
+{
+Relocalizer::Relocalizer(const Parameters & parameters, common::ThreadPool * pool)
+: parameters_(parameters), pool_(pool)
+{
+  if (parameters_.resolution <= 0 || parameters_.sample_interval <= 0) {
+    throw std::runtime_error("resolution and sample_interval of Relocalizer must be positive");
+  }
+  if (parameters_.depth < 0 || parameters_.yaw_count <= 0 || parameters_.top_k <= 0) {
+    throw std::runtime_error("invalid depth, yaw_count or top_k of Relocalizer");
+  }
+}
+
+std::vector<Relocalizer::Point> Relocalizer::sample_points(const LineSegments & line_segments) const
+{
+  std::vector<Point> points;
+  for (const LineSegment & pn : line_segments) {
+    const Eigen::Vector2f from = pn.getVector3fMap().topRows(2);
+    const Eigen::Vector2f to = pn.getNormalVector3fMap().topRows(2);
+    const float length = (to - from).norm();
+    if (length < std::numeric_limits<float>::epsilon()) continue;
+    const Eigen::Vector2f tangent = (to - from) / length;
+    const float label_weight = pn.label == 0 ? parameters_.iffy_weight : 1.f;
+
+    for (float distance = 0; distance < length; distance += parameters_.sample_interval) {
+      const Eigen::Vector2f p = from + tangent * distance;
+      // NOTE: Close points are prioritized as well as the corrector
+      const float gain = std::exp(-parameters_.far_weight_gain * p.squaredNorm());
+      points.push_back({p, tangent, label_weight * gain});
+    }
+  }
+  return points;
+}
+
+Relocalizer::Layout Relocalizer::make_layout(
+  const std::vector<Point> & points, const Eigen::Vector2f & center, float radius) const
+{
+  float reach = 0;
+  for (const Point & p : points) reach = std::max(reach, p.position.norm());
+
+  const float resolution = parameters_.resolution;
+  Layout layout;
+  layout.half_count = static_cast<int>(std::ceil(radius / resolution));
+  layout.translation_count = 2 * layout.half_count + 1;
+  layout.margin = static_cast<int>(std::ceil(reach / resolution)) + 1;
+  layout.area.origin =
+    center - Eigen::Vector2f::Constant((layout.half_count + layout.margin) * resolution);
+  layout.area.resolution = resolution;
+  layout.area.size = layout.translation_count + 2 * layout.margin + (1 << parameters_.depth);
+  return layout;
+}
+
+Relocalizer::FieldArea Relocalizer::field_area(
+  const LineSegments & line_segments, const Eigen::Vector2f & center, float radius) const
+{
+  const std::vector<Point> points = sample_points(line_segments);
+  if (points.empty()) return {center, parameters_.resolution, 0};
+  return make_layout(points, center, radius).area;
+}
+
+Eigen::Matrix3f Relocalizer::covariance(
+  const std::vector<RelocalizationHypothesis> & hypotheses) const
+{
+  const float yaw_step = 2 * M_PI / parameters_.yaw_count;
+  Eigen::Matrix3f floor = Eigen::Matrix3f::Zero();
+  floor.diagonal() << std::pow(parameters_.resolution, 2), std::pow(parameters_.resolution, 2),
+    std::pow(yaw_step, 2);
+  if (hypotheses.empty()) return floor;
+
+  float weight_sum = 0;
+  for (const RelocalizationHypothesis & h : hypotheses) weight_sum += std::max(h.score, 0.f);
+  // NOTE: If no hypothesis matches better than it mismatches, the rivals are as likely as the best
+  const bool uniform = weight_sum < std::numeric_limits<float>::epsilon();
+  if (uniform) weight_sum = static_cast<float>(hypotheses.size());
+
+  const RelocalizationHypothesis & best = hypotheses.front();
+  Eigen::Matrix3f spread = Eigen::Matrix3f::Zero();
+  for (const RelocalizationHypothesis & h : hypotheses) {
+    const float weight = uniform ? 1.f : std::max(h.score, 0.f);
+    Eigen::Vector3f d;
+    d << h.position - best.position, std::remainder(h.yaw - best.yaw, 2 * M_PI);
+    spread += weight * d * d.transpose();
+  }
+  return spread / weight_sum + floor;
+}
+
+std::vector<Relocalizer::Candidate> Relocalizer::search_translation(
+  const Field & field, const std::vector<Eigen::Vector2i> & cells,
+  const std::vector<Point> & points, int translation_count) const
+{
+  const float min_squared_distance = std::pow(parameters_.min_distance / parameters_.resolution, 2);
+
+  auto bound = [&](int level, int x, int y) -> float {
+    const std::vector<float> & pooled = field.levels.at(level);
+    float sum = 0;
+    for (size_t k = 0; k < cells.size(); k++) {
+      sum += points[k].weight * pooled[(x + cells[k].x()) * field.size + y + cells[k].y()];
+    }
+    return sum;
+  };
+
+  auto score = [&](int x, int y) -> float {
+    float sum = 0;
+    for (size_t k = 0; k < cells.size(); k++) {
+      const int index = (x + cells[k].x()) * field.size + y + cells[k].y();
+      const Eigen::Vector2f & direction = field.direction[index];
+      if (direction.isZero()) continue;  // unmapped
+      const float abs_cos = std::abs(points[k].tangent.dot(direction));
+      sum += points[k].weight * (abs_cos * (field.intensity[index] + 0.5f) - 0.5f);
+    }
+    return sum;
+  };
+
+  // The hypotheses are kept in descending order of the score, and the close ones are merged
+  std::vector<Candidate> kept;
+  auto threshold = [&]() -> float {
+    if (kept.size() < static_cast<size_t>(parameters_.top_k)) {
+      return -std::numeric_limits<float>::max();
+    }
+    return kept.back().score;
+  };
+  auto insert = [&](const Candidate & candidate) -> void {
+    for (auto itr = kept.begin(); itr != kept.end();) {
+      const float squared_distance =
+        Eigen::Vector2f(itr->x - candidate.x, itr->y - candidate.y).squaredNorm();
+      if (squared_distance >= min_squared_distance) {
+        ++itr;
+      } else if (itr->score >= candidate.score) {
+        return;
+      } else {
+        itr = kept.erase(itr);
+      }
+    }
+    auto position = std::upper_bound(
+      kept.begin(), kept.end(), candidate,
+      [](const Candidate & a, const Candidate & b) { return a.score > b.score; });
+    kept.insert(position, candidate);
+    if (kept.size() > static_cast<size_t>(parameters_.top_k)) kept.pop_back();
+  };
+
+  // Depth first search, which visits the child blocks in descending order of the bound
+  struct Node
+  {
+    int level, x, y;
+    float bound;
+  };
+  auto push_children = [&](std::vector<Node> & stack, int level, int x, int y) -> void {
+    const int width = 1 << level;
+    std::vector<Node> children;
+    for (int dx = 0; dx < 2 * width; dx += width) {
+      for (int dy = 0; dy < 2 * width; dy += width) {
+        if (x + dx >= translation_count || y + dy >= translation_count) continue;
+        children.push_back({level, x + dx, y + dy, bound(level, x + dx, y + dy)});
+      }
+    }
+    // The best child is popped first
+    std::stable_sort(children.begin(), children.end(), [](const Node & a, const Node & b) {
+      return a.bound < b.bound;
+    });
+    stack.insert(stack.end(), children.begin(), children.end());
+  };
+
+  const int depth = parameters_.depth;
+  const int root_width = 1 << depth;
+  std::vector<Node> stack;
+  {
+    std::vector<Node> roots;
+    for (int x = 0; x < translation_count; x += root_width) {
+      for (int y = 0; y < translation_count; y += root_width) {
+        roots.push_back({depth, x, y, bound(depth, x, y)});
+      }
+    }
+    std::stable_sort(roots.begin(), roots.end(), [](const Node & a, const Node & b) {
+      return a.bound < b.bound;
+    });
+    stack = std::move(roots);
+  }
+
+  while (!stack.empty()) {
+    const Node node = stack.back();
+    stack.pop_back();
+    if (node.bound <= threshold()) continue;
+
+    if (node.level == 0) {
+      const float s = score(node.x, node.y);
+      if (s > threshold()) insert({node.x, node.y, s});
+    } else {
+      push_children(stack, node.level - 1, node.x, node.y);
+    }
+  }
+  return kept;
+}
+
+std::vector<RelocalizationHypothesis> Relocalizer::search(
+  const Sampler & sampler, const LineSegments & line_segments, const Eigen::Vector2f & center,
+  float radius, float yaw_center, float yaw_range) const
+{
+  auto field_sampler = [&sampler](const Eigen::Vector2f & origin, float resolution, int size) {
+    std::vector<CostMapValue> values;
+    values.reserve(size * size);
+    for (int x = 0; x < size; x++) {
+      for (int y = 0; y < size; y++) {
+        values.push_back(sampler(origin + resolution * Eigen::Vector2f(x + 0.5f, y + 0.5f)));
+      }
+    }
+    return values;
+  };
+  return search(
+    FieldSampler(field_sampler), line_segments, center, radius, yaw_center, yaw_range);
+}
+
+std::vector<RelocalizationHypothesis> Relocalizer::search(
+  const FieldSampler & field_sampler, const LineSegments & line_segments,
+  const Eigen::Vector2f & center, float radius, float yaw_center, float yaw_range) const
+{
+  const std::vector<Point> points = sample_points(line_segments);
+  if (points.empty()) return {};
+
+  float total_weight = 0;
+  for (const Point & p : points) total_weight += p.weight;
+
+  const float resolution = parameters_.resolution;
+  const Layout layout = make_layout(points, center, radius);
+  const int half_count = layout.half_count;
+  const int translation_count = layout.translation_count;
+  const int margin = layout.margin;
+
+  // Sample the cost field. The last root_width cells are only referred to by the bounds of the
+  // blocks at the edge.
+  Field field;
+  field.size = layout.area.size;
+  const size_t cell_count = field.size * field.size;
+  const std::vector<CostMapValue> values =
+    field_sampler(layout.area.origin, resolution, layout.area.size);
+  if (values.size() != cell_count) {
+    throw std::runtime_error("field sampler of Relocalizer returned a wrong number of cells");
+  }
+  field.intensity.resize(cell_count);
+  field.direction.resize(cell_count);
+  for (size_t index = 0; index < cell_count; index++) {
+    const CostMapValue & v3 = values[index];
+    if (v3.unmapped) {
+      field.intensity[index] = 0;
+      field.direction[index].setZero();
+    } else {
+      const float radian = v3.angle * M_PI / 180.f;
+      field.intensity[index] = v3.intensity - 0.5f;
+      field.direction[index] = Eigen::Vector2f(std::cos(radian), std::sin(radian));
+    }
+  }
+
+  // Build the coarser levels from the finer one. The blocks are clipped at the edge of the field.
+  field.levels.push_back(field.intensity);
+  for (int level = 1; level <= parameters_.depth; level++) {
+    const std::vector<float> & finer = field.levels.back();
+    const int offset = 1 << (level - 1);
+    std::vector<float> coarser = finer;
+    for (int x = 0; x < field.size; x++) {
+      for (int y = 0; y < field.size; y++) {
+        float & value = coarser[x * field.size + y];
+        if (x + offset < field.size) {
+          value = std::max(value, finer[(x + offset) * field.size + y]);
+        }
+        if (y + offset < field.size) {
+          value = std::max(value, finer[x * field.size + y + offset]);
+        }
+        if (x + offset < field.size && y + offset < field.size) {
+          value = std::max(value, finer[(x + offset) * field.size + y + offset]);
+        }
+      }
+    }
+    field.levels.push_back(std::move(coarser));
+  }
+
+  // Search each yaw
+  const float yaw_step = 2 * M_PI / parameters_.yaw_count;
+  const int yaw_hypothesis_count =
+    std::max(1, static_cast<int>(std::round(2 * yaw_range / yaw_step)));
+  std::vector<std::vector<Candidate>> candidates(yaw_hypothesis_count);
+  auto search_yaw = [&](size_t i) -> void {
+    const Eigen::Rotation2Df rotation(yaw_center - yaw_range + i * yaw_step);
+    std::vector<Eigen::Vector2i> cells;
+    std::vector<Point> rotated;
+    cells.reserve(points.size());
+    rotated.reserve(points.size());
+    for (const Point & p : points) {
+      const Eigen::Vector2f q = rotation * p.position;
+      cells.emplace_back(
+        margin + static_cast<int>(std::floor(q.x() / resolution)),
+        margin + static_cast<int>(std::floor(q.y() / resolution)));
+      rotated.push_back({q, rotation * p.tangent, p.weight});
+    }
+    candidates[i] = search_translation(field, cells, rotated, translation_count);
+  };
+  if (pool_) {
+    pool_->parallel_for(yaw_hypothesis_count, search_yaw);
+  } else {
+    for (int i = 0; i < yaw_hypothesis_count; i++) search_yaw(i);
+  }
+
+  // Merge the hypotheses of all yaws
+  std::vector<RelocalizationHypothesis> all;
+  for (int i = 0; i < yaw_hypothesis_count; i++) {
+    for (const Candidate & c : candidates[i]) {
+      const Eigen::Vector2f offset(c.x - half_count, c.y - half_count);
+      const float yaw = yaw_center - yaw_range + i * yaw_step;
+      all.push_back({center + resolution * offset, yaw, c.score / total_weight});
+    }
+  }
+  std::stable_sort(
+    all.begin(), all.end(),
+    [](const RelocalizationHypothesis & a, const RelocalizationHypothesis & b) {
+      return a.score > b.score;
+    });
+
+  std::vector<RelocalizationHypothesis> hypotheses;
+  for (const RelocalizationHypothesis & h : all) {
+    if (hypotheses.size() >= static_cast<size_t>(parameters_.top_k)) break;
+    const bool duplicated =
+      std::any_of(hypotheses.begin(), hypotheses.end(), [&](const RelocalizationHypothesis & o) {
+        const float yaw_distance = std::abs(std::remainder(h.yaw - o.yaw, 2 * M_PI));
+        return (h.position - o.position).norm() < parameters_.min_distance &&
+               yaw_distance < parameters_.min_yaw_distance;
+      });
+    if (!duplicated) hypotheses.push_back(h);
+  }
+  return hypotheses;
+}
+}  // namespace yabloc
@@ -0,0 +1,161 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ll2_cost_map/pose_scorer.hpp"
+
+#include <Eigen/Geometry>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+using yabloc::CostMapValue;
+using yabloc::PoseScorer;
+
+// The intensity decreases linearly with the distance to the lines y = 0 and x = 10
+CostMapValue sample(const Eigen::Vector2f & p)
+{
+  if (p.x() < -20) return {0, 0, true};
+  const float to_horizontal = std::abs(p.y());
+  const float to_vertical = std::abs(p.x() - 10);
+  if (to_horizontal < to_vertical) return {std::max(0.f, 1.f - to_horizontal / 4.f), 0, false};
+  return {std::max(0.f, 1.f - to_vertical / 4.f), 90, false};
+}
+
+PoseScorer::LineSegments make_segments()
+{
+  auto make = [](Eigen::Vector3f from, Eigen::Vector3f to, int label) {
+    PoseScorer::LineSegment pn;
+    pn.getVector3fMap() = from;
+    pn.getNormalVector3fMap() = to;
+    pn.label = label;
+    return pn;
+  };
+  PoseScorer::LineSegments segments;
+  segments.push_back(make({-30, 0, 0}, {8, 0, 0}, 1));
+  segments.push_back(make({10, -5, 0}, {10, 5, 0}, 1));
+  segments.push_back(make({2, 3, 0}, {6, 3.5, 0}, 0));
+  return segments;
+}
+
+Sophus::SE3f make_pose(float x, float y, float yaw, float pitch = 0)
+{
+  const Eigen::Matrix3f R = (Eigen::AngleAxisf(yaw, Eigen::Vector3f::UnitZ()) *
+                             Eigen::AngleAxisf(pitch, Eigen::Vector3f::UnitY()))
+                              .toRotationMatrix();
+  return Sophus::SE3f(R, Eigen::Vector3f(x, y, 0));
+}
+
+// The per-pose loop of the correctors: transform the line segments and then sample them
+float reference_logit(
+  const PoseScorer::LineSegments & segments, const Sophus::SE3f & pose, float far_weight_gain)
+{
+  float logit = 0;
+  for (const PoseScorer::LineSegment & pn : segments) {
+    const Eigen::Vector3f from = pose * Eigen::Vector3f(pn.getVector3fMap());
+    const Eigen::Vector3f to = pose * Eigen::Vector3f(pn.getNormalVector3fMap());
+    const Eigen::Vector3f tangent = (to - from).normalized();
+    const float length = (to - from).norm();
+    for (float distance = 0; distance < length; distance += 0.1f) {
+      const Eigen::Vector3f p = from + tangent * distance;
+      const float squared_norm = (p - pose.translation()).topRows(2).squaredNorm();
+      const float gain = std::exp(-far_weight_gain * squared_norm);
+      const CostMapValue v3 = sample(p.topRows(2));
+      if (v3.unmapped) continue;
+      const float radian = v3.angle * M_PI / 180.f;
+      const Eigen::Vector2f direction(std::cos(radian), std::sin(radian));
+      const float abs_cos = std::abs(tangent.topRows(2).normalized().dot(direction));
+      const float weight = pn.label == 0 ? 0.2f : 1.f;
+      logit += weight * gain * (abs_cos * v3.intensity - 0.5f);
+    }
+  }
+  return logit;
+}
+}  // namespace
+
+TEST(PoseScorerTestSuite, sameAsPerPoseLoop)
+{
+  const PoseScorer scorer({});
+  const PoseScorer::LineSegments segments = make_segments();
+
+  std::vector<Sophus::SE3f> poses;
+  for (float yaw = -0.3f; yaw < 0.3f; yaw += 0.1f) {
+    poses.push_back(make_pose(0.5f, -0.7f, yaw));
+    poses.push_back(make_pose(-1.f, 1.2f, yaw, 0.05f));
+  }
+
+  const std::vector<float> scores = scorer.score(sample, segments, poses);
+  ASSERT_EQ(scores.size(), poses.size());
+  for (size_t i = 0; i < poses.size(); ++i) {
+    const float expected = reference_logit(segments, poses[i], 0.001f);
+    EXPECT_NEAR(scores[i], expected, 1e-3f * std::max(1.f, std::abs(expected)));
+    EXPECT_FLOAT_EQ(scores[i], scorer.score(sample, segments, poses[i]));
+  }
+}
+
+TEST(PoseScorerTestSuite, truePoseScoresBest)
+{
+  const PoseScorer scorer({});
+  const std::vector<Sophus::SE3f> poses = {
+    make_pose(0, 0, 0), make_pose(1, 0, 0), make_pose(0, 1.5f, 0), make_pose(0, 0, 0.2f)};
+  const std::vector<float> scores = scorer.score(sample, make_segments(), poses);
+  EXPECT_EQ(std::max_element(scores.begin(), scores.end()) - scores.begin(), 0);
+}
+
+TEST(PoseScorerTestSuite, emptyInput)
+{
+  const PoseScorer scorer({});
+  EXPECT_TRUE(scorer.score(sample, make_segments(), std::vector<Sophus::SE3f>{}).empty());
+  const std::vector<Sophus::SE3f> poses = {make_pose(0, 0, 0)};
+  const std::vector<float> scores = scorer.score(sample, PoseScorer::LineSegments{}, poses);
+  ASSERT_EQ(scores.size(), 1u);
+  EXPECT_FLOAT_EQ(scores.front(), 0.f);
+}
+
+TEST(PoseScorerTestSuite, filter)
+{
+  const PoseScorer scorer({});
+  const auto [good, bad] = scorer.filter(sample, make_segments(), make_pose(0, 0, 0));
+  // The segments on the lines agree with the map, but the one off the lines does not
+  ASSERT_EQ(good.size(), 2u);
+  ASSERT_EQ(bad.size(), 1u);
+  EXPECT_EQ(bad.front().label, 0u);
+}
+
+TEST(PoseScorerTestSuite, evaluate)
+{
+  const PoseScorer scorer({});
+  PoseScorer::LineSegments segments = make_segments();
+  for (PoseScorer::LineSegment & pn : segments) pn.label = 1;
+  const Sophus::SE3f pose = make_pose(0.5f, -0.7f, 0.2f);
+
+  // The per-point logits sum up to the score without the label weights
+  const pcl::PointCloud<pcl::PointXYZI> cloud = scorer.evaluate(sample, segments, pose);
+  float sum = 0;
+  for (const pcl::PointXYZI & p : cloud) {
+    sum += p.intensity;
+    if (sample(p.getVector3fMap().topRows(2)).unmapped) {
+      EXPECT_FLOAT_EQ(p.intensity, 0.f);
+    }
+  }
+  EXPECT_NEAR(sum, scorer.score(sample, segments, pose), 1e-4f);
+
+  // The points are in the world frame
+  EXPECT_TRUE(cloud.front().getVector3fMap().isApprox(pose * segments.front().getVector3fMap()));
+}
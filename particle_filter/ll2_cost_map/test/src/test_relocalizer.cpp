@@ -0,0 +1,210 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ll2_cost_map/relocalizer.hpp"
+
+#include <Eigen/Geometry>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+using yabloc::CostMapValue;
+using yabloc::Relocalizer;
+using Segment = std::pair<Eigen::Vector2f, Eigen::Vector2f>;
+
+// Asymmetric layout so that only one pose matches
+std::vector<Segment> make_map()
+{
+  return {
+    {{0, 0}, {30, 0}},    {{0, 3.5}, {30, 3.5}},   {{0, 7}, {20, 7}},   {{20, 7}, {20, 25}},
+    {{23.5, 7}, {23.5, 25}}, {{5, 10}, {8, 10}}, {{5, 10}, {5, 15}}, {{12, -6}, {16, -2}},
+  };
+}
+
+// The intensity decreases linearly with the distance to the nearest segment
+CostMapValue sample(const std::vector<Segment> & map, const Eigen::Vector2f & p)
+{
+  float min_distance = std::numeric_limits<float>::max();
+  int angle = 0;
+  for (const auto & [a, b] : map) {
+    const Eigen::Vector2f ab = b - a;
+    const float t = std::clamp((p - a).dot(ab) / ab.squaredNorm(), 0.f, 1.f);
+    const float distance = (a + t * ab - p).norm();
+    if (distance < min_distance) {
+      min_distance = distance;
+      float radian = std::atan2(ab.y(), ab.x());
+      if (radian < 0) radian += M_PI;
+      angle = static_cast<int>(std::round(radian * 180 / M_PI)) % 180;
+    }
+  }
+  return {std::max(0.f, 1.f - min_distance / 4.f), angle, false};
+}
+
+// Segments of the map observed from the pose, in the ground frame of the vehicle
+Relocalizer::LineSegments observe(
+  const std::vector<Segment> & map, const Eigen::Vector2f & position, float yaw)
+{
+  const Eigen::Rotation2Df inverse(-yaw);
+  Relocalizer::LineSegments segments;
+  for (const auto & [a, b] : map) {
+    Relocalizer::LineSegment pn;
+    pn.getVector3fMap() << inverse * (a - position), 0;
+    pn.getNormalVector3fMap() << inverse * (b - position), 0;
+    pn.label = 1;
+    segments.push_back(pn);
+  }
+  return segments;
+}
+}  // namespace
+
+TEST(RelocalizerTestSuite, recoverPose)
+{
+  const std::vector<Segment> map = make_map();
+  const Eigen::Vector2f truth(14, 4);
+  const float truth_yaw = 0.7;
+  auto sampler = [&map](const Eigen::Vector2f & p) { return sample(map, p); };
+
+  Relocalizer::Parameters parameters;
+  parameters.yaw_count = 36;
+  Relocalizer relocalizer(parameters);
+  // The search starts far from the truth, e.g. from the last GNSS fix before a tunnel
+  const auto hypotheses = relocalizer.search(
+    sampler, observe(map, truth, truth_yaw), truth + Eigen::Vector2f(6, -5), 12.f);
+
+  ASSERT_FALSE(hypotheses.empty());
+  EXPECT_LE(hypotheses.size(), 5u);
+  EXPECT_LT((hypotheses.front().position - truth).norm(), 1.5f);
+  EXPECT_LT(std::abs(std::remainder(hypotheses.front().yaw - truth_yaw, 2 * M_PI)), 0.1f);
+  for (size_t i = 1; i < hypotheses.size(); i++) {
+    EXPECT_GE(hypotheses.at(i - 1).score, hypotheses.at(i).score);
+  }
+}
+
+TEST(RelocalizerTestSuite, sameAsExhaustiveSearch)
+{
+  const std::vector<Segment> map = make_map();
+  auto sampler = [&map](const Eigen::Vector2f & p) { return sample(map, p); };
+  const auto segments = observe(map, Eigen::Vector2f(10, 2), -0.3);
+
+  // Without the coarser levels every translation is scored
+  Relocalizer::Parameters exhaustive_parameters;
+  exhaustive_parameters.depth = 0;
+  exhaustive_parameters.yaw_count = 24;
+  Relocalizer::Parameters parameters = exhaustive_parameters;
+  parameters.depth = 4;
+
+  yabloc::common::ThreadPool pool(4);
+  const Eigen::Vector2f center(12, 0);
+  const auto expected = Relocalizer(exhaustive_parameters).search(sampler, segments, center, 8.f);
+  const auto actual = Relocalizer(parameters, &pool).search(sampler, segments, center, 8.f);
+
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_FLOAT_EQ(expected.at(i).score, actual.at(i).score);
+    EXPECT_EQ(expected.at(i).position, actual.at(i).position);
+    EXPECT_FLOAT_EQ(expected.at(i).yaw, actual.at(i).yaw);
+  }
+}
+
+TEST(RelocalizerTestSuite, emptySegments)
+{
+  Relocalizer relocalizer(Relocalizer::Parameters{});
+  auto sampler = [](const Eigen::Vector2f &) { return CostMapValue{0.5f, 0, true}; };
+  EXPECT_TRUE(
+    relocalizer.search(sampler, Relocalizer::LineSegments{}, Eigen::Vector2f::Zero(), 10.f)
+      .empty());
+}
+
+TEST(RelocalizerTestSuite, fieldSampler)
+{
+  const std::vector<Segment> map = make_map();
+  auto sampler = [&map](const Eigen::Vector2f & p) { return sample(map, p); };
+  const auto segments = observe(map, Eigen::Vector2f(10, 2), -0.3);
+
+  // The whole field is requested at once, e.g. to rasterize the cost map only once
+  int call_count = 0;
+  Relocalizer::FieldArea requested{Eigen::Vector2f::Zero(), 0.f, 0};
+  auto field_sampler = [&](const Eigen::Vector2f & origin, float resolution, int size) {
+    call_count++;
+    requested = {origin, resolution, size};
+    std::vector<CostMapValue> values;
+    for (int x = 0; x < size; x++) {
+      for (int y = 0; y < size; y++) {
+        values.push_back(sample(map, origin + resolution * Eigen::Vector2f(x + 0.5f, y + 0.5f)));
+      }
+    }
+    return values;
+  };
+
+  Relocalizer::Parameters parameters;
+  parameters.yaw_count = 24;
+  const Relocalizer relocalizer(parameters);
+  const Eigen::Vector2f center(12, 0);
+  const auto expected = relocalizer.search(sampler, segments, center, 8.f);
+  const auto actual = relocalizer.search(field_sampler, segments, center, 8.f);
+  EXPECT_EQ(call_count, 1);
+
+  // The area can be known before the search
+  const Relocalizer::FieldArea area = relocalizer.field_area(segments, center, 8.f);
+  EXPECT_EQ(area.origin, requested.origin);
+  EXPECT_FLOAT_EQ(area.resolution, requested.resolution);
+  EXPECT_EQ(area.size, requested.size);
+
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_FLOAT_EQ(expected.at(i).score, actual.at(i).score);
+    EXPECT_EQ(expected.at(i).position, actual.at(i).position);
+  }
+
+  // A sampler which returns a wrong number of cells is rejected
+  auto broken_sampler = [](const Eigen::Vector2f &, float, int) {
+    return std::vector<CostMapValue>{};
+  };
+  EXPECT_THROW(relocalizer.search(broken_sampler, segments, center, 8.f), std::runtime_error);
+}
+
+TEST(RelocalizerTestSuite, covariance)
+{
+  Relocalizer::Parameters parameters;
+  parameters.resolution = 0.5f;
+  parameters.yaw_count = 72;
+  const Relocalizer relocalizer(parameters);
+  const float yaw_step = 2 * M_PI / 72;
+
+  // A lone hypothesis is as uncertain as the search step
+  std::vector<yabloc::RelocalizationHypothesis> hypotheses{{{10, 0}, 0.f, 0.3f}};
+  Eigen::Matrix3f covariance = relocalizer.covariance(hypotheses);
+  EXPECT_FLOAT_EQ(covariance(0, 0), 0.25f);
+  EXPECT_FLOAT_EQ(covariance(1, 1), 0.25f);
+  EXPECT_FLOAT_EQ(covariance(2, 2), yaw_step * yaw_step);
+
+  // A rival as good as the best spreads it along the offset, and a weaker one does less
+  hypotheses.push_back({{10, 4}, 0.f, 0.3f});
+  covariance = relocalizer.covariance(hypotheses);
+  EXPECT_FLOAT_EQ(covariance(0, 0), 0.25f);
+  EXPECT_FLOAT_EQ(covariance(1, 1), 8.25f);
+
+  hypotheses.back().score = 0.1f;
+  EXPECT_FLOAT_EQ(relocalizer.covariance(hypotheses)(1, 1), 4.25f);
+
+  // The yaw difference wraps around
+  hypotheses.back() = {{10, 0}, 2 * M_PI - 0.2f, 0.3f};
+  EXPECT_NEAR(relocalizer.covariance(hypotheses)(2, 2), 0.02f + yaw_step * yaw_step, 1e-4);
+}
@@ -19,6 +19,7 @@
 #include "modularized_particle_filter/common/visualize.hpp"
 
 #include <rclcpp/rclcpp.hpp>
+#include <std_srvs/srv/set_bool.hpp>
 
 #include <modularized_particle_filter_msgs/msg/particle_array.hpp>
 
@@ -33,6 +34,7 @@ class AbstCorrector : public rclcpp::Node
 public:
   using Particle = modularized_particle_filter_msgs::msg::Particle;
   using ParticleArray = modularized_particle_filter_msgs::msg::ParticleArray;
+  using SetBool = std_srvs::srv::SetBool;
 
   AbstCorrector(const std::string & node_name);
 
@@ -50,8 +52,30 @@ protected:
 
   void set_weighted_particle_array(const ParticleArray & particle_array);
 
+  /**
+   * Suspension by switch_srv
+   *
+   * While the corrector is suspended, the predicted particles are not subscribed at all, and the
+   * derived class should tear down the subscriptions of its observations in on_suspend() so that
+   * nothing is processed. The map and the other cached states should be kept, so that on_resume()
+   * only has to subscribe the observations again.
+   *
+   * The derived class must call initialize_suspension() at the end of its constructor.
+   */
+  bool is_suspended() const { return suspended_; }
+  void initialize_suspension();
+  virtual void on_suspend() {}
+  virtual void on_resume() {}
+
 private:
+  bool suspended_{false};
+  rclcpp::Service<SetBool>::SharedPtr switch_service_;
+
   void on_particle_array(const ParticleArray & particle_array);
+  void on_switch(SetBool::Request::ConstSharedPtr request, SetBool::Response::SharedPtr response);
+  void subscribe_particle_array();
+  void suspend();
+  void resume();
 };
 }  // namespace modularized_particle_filter
 }  // namespace yabloc
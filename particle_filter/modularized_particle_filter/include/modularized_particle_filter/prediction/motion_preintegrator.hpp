@@ -0,0 +1,78 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MODULARIZED_PARTICLE_FILTER__PREDICTION__MOTION_PREINTEGRATOR_HPP_
+#define MODULARIZED_PARTICLE_FILTER__PREDICTION__MOTION_PREINTEGRATOR_HPP_
+
+#include <Eigen/Core>
+
+#include <deque>
+
+namespace yabloc::modularized_particle_filter
+{
+// Planar motion expressed in the frame of the vehicle at the beginning
+struct MotionDelta
+{
+  Eigen::Vector2f translation{Eigen::Vector2f::Zero()};
+  float yaw{0};
+  // Covariance of (x, y, yaw)
+  Eigen::Matrix3f covariance{Eigen::Matrix3f::Zero()};
+};
+
+/**
+ * Buffer of the velocity samples which integrates the planar motion between arbitrary stamps
+ *
+ * Each sample holds until the next one, and the first and the last samples are extended to the
+ * outside of the buffer. The motion of each interval is integrated as an arc, so the delta does not
+ * depend on how often it is queried.
+ *
+ * The standard deviations of the velocities diffuse the pose as a random walk. The variance of an
+ * interval dt is std^2 * dt * noise_period, which is the same as the noise applied per prediction
+ * of the period noise_period. So the spread of the particles does not depend on the prediction
+ * rate either.
+ */
+class MotionPreintegrator
+{
+public:
+  MotionPreintegrator(float noise_period, size_t max_sample_count = 1000);
+
+  // The samples must be added in the order of the stamp. Otherwise the sample is ignored.
+  void add(double stamp, float linear_x, float angular_z, float linear_std, float angular_std);
+
+  bool empty() const { return samples_.empty(); }
+  size_t size() const { return samples_.size(); }
+
+  // Throw std::runtime_error if no sample is added
+  MotionDelta integrate(double begin, double end) const;
+
+  // Erase the samples which are not needed to integrate from the stamp
+  void erase_before(double stamp);
+
+private:
+  struct Sample
+  {
+    double stamp;
+    float linear_x;
+    float angular_z;
+    float linear_std;
+    float angular_std;
+  };
+
+  const float noise_period_;
+  const size_t max_sample_count_;
+  std::deque<Sample> samples_;
+};
+}  // namespace yabloc::modularized_particle_filter
+
+#endif  // MODULARIZED_PARTICLE_FILTER__PREDICTION__MOTION_PREINTEGRATOR_HPP_
@@ -17,10 +17,13 @@
 
 #include "modularized_particle_filter/common/visualize.hpp"
 #include "modularized_particle_filter/prediction/experimental/suspension_adaptor.hpp"
+#include "modularized_particle_filter/prediction/motion_preintegrator.hpp"
 #include "modularized_particle_filter/prediction/resampler.hpp"
 
+#include <ground_server/ground_grid.hpp>
 #include <rclcpp/rclcpp.hpp>
 
+#include <autoware_auto_mapping_msgs/msg/had_map_bin.hpp>
 #include <geometry_msgs/msg/pose_stamped.hpp>
 #include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
 #include <geometry_msgs/msg/twist_stamped.hpp>
@@ -30,6 +33,10 @@
 
 #include <tf2_ros/transform_broadcaster.h>
 
+#include <functional>
+#include <future>
+#include <memory>
+
 namespace yabloc::modularized_particle_filter
 {
 class Predictor : public rclcpp::Node
@@ -40,6 +47,7 @@ public:
   using PoseCovStamped = geometry_msgs::msg::PoseWithCovarianceStamped;
   using TwistCovStamped = geometry_msgs::msg::TwistWithCovarianceStamped;
   using TwistStamped = geometry_msgs::msg::TwistStamped;
+  using HADMapBin = autoware_auto_mapping_msgs::msg::HADMapBin;
 
   Predictor();
 
@@ -58,6 +66,7 @@ private:
   rclcpp::Subscription<TwistCovStamped>::SharedPtr twist_cov_sub_;
   rclcpp::Subscription<ParticleArray>::SharedPtr particles_sub_;
   rclcpp::Subscription<std_msgs::msg::Float32>::SharedPtr height_sub_;
+  rclcpp::Subscription<HADMapBin>::SharedPtr map_sub_;
 
   // Publisher
   rclcpp::Publisher<ParticleArray>::SharedPtr predicted_particles_pub_;
@@ -78,19 +87,35 @@ private:
   std::unique_ptr<ParticleVisualizer> visualizer_ptr_{nullptr};
   std::unique_ptr<RetroactiveResampler> resampler_ptr_{nullptr};
   std::unique_ptr<SwapModeAdaptor> swap_mode_adaptor_ptr_{nullptr};
+  // If it is available, the height of each particle is looked up instead of ground_height_
+  std::unique_ptr<ground_server::GroundGrid> ground_grid_ptr_{nullptr};
+  // The ground grid is loaded or built by this task, apart from the executor
+  std::future<std::unique_ptr<ground_server::GroundGrid>> ground_grid_task_;
+  std::function<std::unique_ptr<ground_server::GroundGrid>()> make_ground_grid_;
+  // If it is available, the particles move by all twists since the last prediction
+  std::unique_ptr<MotionPreintegrator> preintegrator_ptr_{nullptr};
+  std::string map_bundle_path_;
 
   // Callback
   void on_initial_pose(const PoseCovStamped::ConstSharedPtr initialpose);
   void on_twist_cov(const TwistCovStamped::ConstSharedPtr twist);
   void on_weighted_particles(const ParticleArray::ConstSharedPtr weighted_particles);
+  void on_map(const HADMapBin & msg);
   void on_timer();
 
+  // Run in ground_grid_task_
+  std::unique_ptr<ground_server::GroundGrid> load_ground_grid(const HADMapBin & msg) const;
+
   //
   void initialize_particles(const PoseCovStamped & initialpose);
   //
   void update_with_dynamic_noise(
     ParticleArray & particle_array, const TwistCovStamped & twist, double dt);
   //
+  void update_with_motion_delta(ParticleArray & particle_array, const MotionDelta & delta);
+  //
+  void update_height(ParticleArray & particle_array) const;
+  //
   void publish_mean_pose(const geometry_msgs::msg::Pose & mean_pose, const rclcpp::Time & stamp);
 };
 
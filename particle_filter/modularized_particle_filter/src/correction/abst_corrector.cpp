@@ -23,11 +23,50 @@ AbstCorrector::AbstCorrector(const std::string & node_name)
   logger_(rclcpp::get_logger("abst_corrector"))
 {
   using std::placeholders::_1;
+  using std::placeholders::_2;
   particle_pub_ = create_publisher<ParticleArray>("weighted_particles", 10);
+  subscribe_particle_array();
+
+  auto on_switch = std::bind(&AbstCorrector::on_switch, this, _1, _2);
+  switch_service_ = create_service<SetBool>("switch_srv", on_switch);
+
+  if (visualize_) visualizer_ = std::make_shared<ParticleVisualizer>(*this);
+}
+
+void AbstCorrector::subscribe_particle_array()
+{
+  using std::placeholders::_1;
   particle_sub_ = create_subscription<ParticleArray>(
     "predicted_particles", 10, std::bind(&AbstCorrector::on_particle_array, this, _1));
+}
 
-  if (visualize_) visualizer_ = std::make_shared<ParticleVisualizer>(*this);
+void AbstCorrector::initialize_suspension()
+{
+  if (!declare_parameter<bool>("enabled_at_first", true)) suspend();
+}
+
+void AbstCorrector::on_switch(
+  SetBool::Request::ConstSharedPtr request, SetBool::Response::SharedPtr response)
+{
+  if (request->data && suspended_) resume();
+  if (!request->data && !suspended_) suspend();
+  response->success = true;
+  RCLCPP_INFO_STREAM(get_logger(), get_name() << (suspended_ ? " is suspended" : " is resumed"));
+}
+
+void AbstCorrector::suspend()
+{
+  suspended_ = true;
+  particle_sub_.reset();
+  particle_array_buffer_.clear();
+  on_suspend();
+}
+
+void AbstCorrector::resume()
+{
+  suspended_ = false;
+  subscribe_particle_array();
+  on_resume();
 }
 
 void AbstCorrector::on_particle_array(const ParticleArray & particle_array)
@@ -0,0 +1,102 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "modularized_particle_filter/prediction/motion_preintegrator.hpp"
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace yabloc::modularized_particle_filter
+{
+MotionPreintegrator::MotionPreintegrator(float noise_period, size_t max_sample_count)
+: noise_period_(noise_period), max_sample_count_(max_sample_count)
+{
+}
+
+void MotionPreintegrator::add(
+  double stamp, float linear_x, float angular_z, float linear_std, float angular_std)
+{
+  if (!samples_.empty()) {
+    if (stamp < samples_.back().stamp) return;
+    if (stamp == samples_.back().stamp) samples_.pop_back();
+  }
+  samples_.push_back({stamp, linear_x, angular_z, linear_std, angular_std});
+  while (samples_.size() > max_sample_count_) samples_.pop_front();
+}
+
+MotionDelta MotionPreintegrator::integrate(double begin, double end) const
+{
+  if (samples_.empty()) {
+    throw std::runtime_error("MotionPreintegrator has no sample to integrate");
+  }
+
+  MotionDelta delta;
+  // The sample which holds at the beginning
+  auto next = std::upper_bound(
+    samples_.begin(), samples_.end(), begin,
+    [](double stamp, const Sample & sample) { return stamp < sample.stamp; });
+  auto current = next == samples_.begin() ? next : std::prev(next);
+
+  double time = begin;
+  while (time < end) {
+    const double until = (next == samples_.end()) ? end : std::min(next->stamp, end);
+    // NOTE: The long interval is divided so that the covariance is propagated along the arc
+    const int division = std::max(1, static_cast<int>(std::ceil((until - time) / noise_period_)));
+    const float dt = static_cast<float>(until - time) / division;
+
+    // Arc in the frame of the vehicle at the beginning of each division
+    const float yaw = current->angular_z * dt;
+    Eigen::Vector2f step(current->linear_x * dt, 0);
+    if (std::abs(yaw) > 1e-6f) {
+      const float radius = current->linear_x / current->angular_z;
+      step = radius * Eigen::Vector2f(std::sin(yaw), 1 - std::cos(yaw));
+    }
+    const Eigen::Vector2f variance(
+      current->linear_std * current->linear_std, current->angular_std * current->angular_std);
+    const Eigen::Matrix2f Q = (variance * dt * noise_period_).asDiagonal();
+
+    for (int i = 0; i < division; i++) {
+      const Eigen::Rotation2Df rotation(delta.yaw);
+      const Eigen::Vector2f global_step = rotation * step;
+
+      // Propagate the covariance. The noise of the distance is along the heading, and the noise of
+      // the yaw bends the step around its middle.
+      Eigen::Matrix3f F = Eigen::Matrix3f::Identity();
+      F(0, 2) = -global_step.y();
+      F(1, 2) = global_step.x();
+      Eigen::Matrix<float, 3, 2> G = Eigen::Matrix<float, 3, 2>::Zero();
+      G.block<2, 1>(0, 0) = rotation * Eigen::Vector2f::UnitX();
+      G.block<2, 1>(0, 1) = 0.5f * Eigen::Vector2f(-global_step.y(), global_step.x());
+      G(2, 1) = 1;
+      delta.covariance = F * delta.covariance * F.transpose() + G * Q * G.transpose();
+
+      delta.translation += global_step;
+      delta.yaw += yaw;
+    }
+
+    time = until;
+    if (next != samples_.end() && next->stamp <= time) current = next++;
+  }
+  return delta;
+}
+
+void MotionPreintegrator::erase_before(double stamp)
+{
+  // Keep the last sample whose stamp is not after the stamp, since it holds at the stamp
+  while (samples_.size() >= 2 && samples_.at(1).stamp <= stamp) samples_.pop_front();
+}
+}  // namespace yabloc::modularized_particle_filter
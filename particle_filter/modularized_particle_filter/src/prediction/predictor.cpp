@@ -19,17 +19,39 @@
 #include "modularized_particle_filter/prediction/resampler.hpp"
 
 #include <Eigen/Core>
+#include <Eigen/Eigenvalues>
+#include <ll2_decomposer/from_bin_msg.hpp>
+#include <ll2_decomposer/map_bundle.hpp>
 #include <sophus/geometry.hpp>
 #include <yabloc_common/pose_conversions.hpp>
+#include <yabloc_common/timer.hpp>
 
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
 
 #include <tf2/utils.h>
 
+#include <cmath>
 #include <numeric>
+#include <string>
 
 namespace yabloc::modularized_particle_filter
 {
+namespace
+{
+// Standard deviations of linear & angular velocity, which are truncated by the linear velocity
+std::pair<float, float> truncated_std(const Predictor::TwistCovStamped & twist)
+{
+  const float linear_x = twist.twist.twist.linear.x;
+  const float std_linear_x = std::sqrt(twist.twist.covariance[6 * 0 + 0]);
+  const float std_angular_z = std::sqrt(twist.twist.covariance[6 * 5 + 5]);
+  // 1[rad/s] = 60[deg/s]
+  // 1[m/s] = 3.6[km/h]
+  const float truncated_angular_std =
+    std_angular_z * std::clamp(std::sqrt(std::abs(linear_x)), 0.1f, 1.0f);
+  const float truncated_linear_std = std::clamp(std_linear_x * linear_x, 0.1f, 2.0f);
+  return {truncated_linear_std, truncated_angular_std};
+}
+}  // namespace
 
 Predictor::Predictor()
 : Node("predictor"),
@@ -70,6 +92,62 @@ Predictor::Predictor()
   if (declare_parameter("is_swap_mode", false)) {
     swap_mode_adaptor_ptr_ = std::make_unique<SwapModeAdaptor>(this);
   }
+  if (declare_parameter("use_ground_grid", false)) {
+    // NOTE: These are given by ground_grid.param.yaml, which ground_server also reads
+    const float cell_size = declare_parameter("grid_cell_size", 1.0);
+    const int K = declare_parameter("K", 50);
+    const float layer_separation = declare_parameter("grid_layer_separation", 3.0);
+    const float max_distance = declare_parameter("grid_max_distance", 10.0);
+    make_ground_grid_ = [=]() -> std::unique_ptr<ground_server::GroundGrid> {
+      return std::make_unique<ground_server::GroundGrid>(
+        cell_size, K, layer_separation, max_distance);
+    };
+    map_bundle_path_ = declare_parameter("map_bundle_path", std::string{});
+    const rclcpp::QoS map_qos = rclcpp::QoS(10).transient_local().reliable();
+    auto on_map = std::bind(&Predictor::on_map, this, _1);
+    map_sub_ = create_subscription<HADMapBin>("/map/vector_map", map_qos, on_map);
+  }
+  if (declare_parameter("use_preintegration", false)) {
+    // NOTE: The default noise period keeps the spread of the particles of the 50 Hz prediction
+    preintegrator_ptr_ = std::make_unique<MotionPreintegrator>(
+      declare_parameter("preintegration_noise_period", 0.02));
+  }
+}
+
+void Predictor::on_map(const HADMapBin & msg)
+{
+  if (ground_grid_task_.valid()) {
+    RCLCPP_WARN_STREAM(get_logger(), "ignore the map since the ground grid is being built");
+    return;
+  }
+
+  // Building the grid takes seconds for a large map, which would stall the prediction.
+  // Until on_timer() takes the grid, the particles follow the height from ground_server.
+  ground_grid_task_ =
+    std::async(std::launch::async, [this, msg]() { return load_ground_grid(msg); });
+}
+
+std::unique_ptr<ground_server::GroundGrid> Predictor::load_ground_grid(const HADMapBin & msg) const
+{
+  std::unique_ptr<ground_server::GroundGrid> grid = make_ground_grid_();
+
+  // The bundle made by map_bundle_tool has the same grid as ground_server uses
+  if (!map_bundle_path_.empty()) {
+    std::string error;
+    const auto bundle = ll2_decomposer::open_map_bundle(map_bundle_path_, msg, &error);
+    if (bundle && grid->read(*bundle)) {
+      RCLCPP_INFO_STREAM(get_logger(), "loaded ground grid from " << map_bundle_path_);
+      return grid;
+    }
+    RCLCPP_WARN_STREAM(get_logger(), "ground grid is built online. " << error);
+  }
+
+  common::Timer timer;
+  lanelet::LaneletMapPtr lanelet_map = ll2_decomposer::from_bin_msg(msg);
+  grid->build(ground_server::sample_ground_cloud(*lanelet_map));
+  RCLCPP_INFO_STREAM(
+    get_logger(), "built ground grid with " << grid->layer_count() << " layers in " << timer);
+  return grid;
 }
 
 void Predictor::on_initial_pose(const PoseCovStamped::ConstSharedPtr initialpose)
@@ -129,6 +207,13 @@ void Predictor::on_twist_cov(const TwistCovStamped::ConstSharedPtr twist_cov)
   twist_covariance.twist.covariance.at(28) = 1e4;
   twist_covariance.twist.covariance.at(35) = static_angular_covariance_;
   latest_twist_opt_ = twist_covariance;
+
+  if (preintegrator_ptr_) {
+    const auto [linear_std, angular_std] = truncated_std(twist_covariance);
+    preintegrator_ptr_->add(
+      rclcpp::Time(twist_cov->header.stamp).seconds(), twist.twist.linear.x,
+      twist.twist.angular.z, linear_std, angular_std);
+  }
 }
 
 void Predictor::update_with_dynamic_noise(
@@ -137,14 +222,7 @@ void Predictor::update_with_dynamic_noise(
   // linear & angular velocity
   const float linear_x = twist.twist.twist.linear.x;
   const float angular_z = twist.twist.twist.angular.z;
-  // standard deviation of linear & angular velocity
-  const float std_linear_x = std::sqrt(twist.twist.covariance[6 * 0 + 0]);
-  const float std_angular_z = std::sqrt(twist.twist.covariance[6 * 5 + 5]);
-  // 1[rad/s] = 60[deg/s]
-  // 1[m/s] = 3.6[km/h]
-  const float truncated_angular_std =
-    std_angular_z * std::clamp(std::sqrt(std::abs(linear_x)), 0.1f, 1.0f);
-  const float truncated_linear_std = std::clamp(std_linear_x * linear_x, 0.1f, 2.0f);
+  const auto [truncated_linear_std, truncated_angular_std] = truncated_std(twist);
 
   for (auto & particle : particle_array.particles) {
     Sophus::SE3f se3_pose = common::pose_to_se3(particle.pose);
@@ -155,13 +233,63 @@ void Predictor::update_with_dynamic_noise(
     se3_pose *= Sophus::SE3f::exp(noised_xi * dt);
 
     geometry_msgs::msg::Pose pose = common::se3_to_pose(se3_pose);
-    pose.position.z = ground_height_;
+    // With the ground grid, the last height is kept to select the layer in update_height()
+    if (!ground_grid_ptr_ || ground_grid_ptr_->empty()) pose.position.z = ground_height_;
+    particle.pose = pose;
+  }
+}
+
+void Predictor::update_with_motion_delta(ParticleArray & particle_array, const MotionDelta & delta)
+{
+  // Square root of the covariance, which may be singular, e.g. when the vehicle stops
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> solver(delta.covariance);
+  const Eigen::Matrix3f sqrt_covariance =
+    solver.eigenvectors() * solver.eigenvalues().cwiseMax(0).cwiseSqrt().asDiagonal();
+
+  for (auto & particle : particle_array.particles) {
+    const Eigen::Vector3f noise =
+      sqrt_covariance * Eigen::Vector3f(util::nrand(1.f), util::nrand(1.f), util::nrand(1.f));
+    Eigen::Vector3f translation;
+    translation << delta.translation + noise.topRows(2), 0;
+    const Sophus::SO3f rotation = Sophus::SO3f::rotZ(delta.yaw + noise.z());
+
+    Sophus::SE3f se3_pose = common::pose_to_se3(particle.pose);
+    se3_pose *= Sophus::SE3f(rotation, translation);
+
+    geometry_msgs::msg::Pose pose = common::se3_to_pose(se3_pose);
+    // With the ground grid, the last height is kept to select the layer in update_height()
+    if (!ground_grid_ptr_ || ground_grid_ptr_->empty()) pose.position.z = ground_height_;
     particle.pose = pose;
   }
 }
 
+void Predictor::update_height(ParticleArray & particle_array) const
+{
+  // Query all particles at once. Each particle keeps the layer nearest to its last height.
+  std::vector<Eigen::Vector3f> positions;
+  positions.reserve(particle_array.particles.size());
+  for (const auto & particle : particle_array.particles) {
+    const auto & p = particle.pose.position;
+    positions.push_back(Eigen::Vector3d(p.x, p.y, p.z).cast<float>());
+  }
+
+  const std::vector<float> heights = ground_grid_ptr_->query_heights(positions);
+  for (size_t i = 0; i < heights.size(); i++) {
+    auto & position = particle_array.particles[i].pose.position;
+    position.z = std::isfinite(heights[i]) ? heights[i] : ground_height_;
+  }
+}
+
 void Predictor::on_timer()
 {
+  // Take the ground grid once it is ready
+  if (ground_grid_task_.valid()) {
+    using namespace std::literals::chrono_literals;
+    if (ground_grid_task_.wait_for(0s) == std::future_status::ready) {
+      ground_grid_ptr_ = ground_grid_task_.get();
+    }
+  }
+
   // ==========================================================================
   // Pre-check section
   // TODO: Refactor
@@ -197,7 +325,18 @@ void Predictor::on_timer()
     return;
   }
 
-  update_with_dynamic_noise(particle_array, latest_twist_opt_.value(), dt);
+  if (preintegrator_ptr_) {
+    // The twists since the last prediction are applied in one step
+    const double begin = msg_time.seconds();
+    const double end = current_time.seconds();
+    update_with_motion_delta(particle_array, preintegrator_ptr_->integrate(begin, end));
+    preintegrator_ptr_->erase_before(end);
+  } else {
+    update_with_dynamic_noise(particle_array, latest_twist_opt_.value(), dt);
+  }
+  if (ground_grid_ptr_ && !ground_grid_ptr_->empty()) {
+    update_height(particle_array);
+  }
 
   // ==========================================================================
   // Post-process section
@@ -0,0 +1,91 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "modularized_particle_filter/prediction/motion_preintegrator.hpp"
+
+#include <Eigen/Geometry>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace mpf = yabloc::modularized_particle_filter;
+
+TEST(MotionPreintegratorTestSuite, arc)
+{
+  mpf::MotionPreintegrator preintegrator(0.02f);
+  for (int i = 0; i <= 100; i++) preintegrator.add(i * 0.01, 5.f, 0.5f, 0.1f, 0.01f);
+
+  const mpf::MotionDelta delta = preintegrator.integrate(0.0, 1.0);
+  EXPECT_NEAR(delta.yaw, 0.5f, 1e-5f);
+  EXPECT_NEAR(delta.translation.x(), 10.f * std::sin(0.5f), 1e-4f);
+  EXPECT_NEAR(delta.translation.y(), 10.f * (1 - std::cos(0.5f)), 1e-4f);
+}
+
+TEST(MotionPreintegratorTestSuite, independentOfQueryRate)
+{
+  mpf::MotionPreintegrator preintegrator(0.02f);
+  for (int i = 0; i < 200; i++) {
+    preintegrator.add(i * 0.005, 3.f + std::sin(i * 0.1f), 0.2f * std::cos(i * 0.05f), 0.5f, 0.05f);
+  }
+  const mpf::MotionDelta whole = preintegrator.integrate(0.1, 0.9);
+
+  // Compose the deltas of 50 Hz queries
+  Eigen::Vector2f translation = Eigen::Vector2f::Zero();
+  float yaw = 0;
+  for (int i = 0; i < 40; i++) {
+    const mpf::MotionDelta delta = preintegrator.integrate(0.1 + i * 0.02, 0.1 + (i + 1) * 0.02);
+    translation += Eigen::Rotation2Df(yaw) * delta.translation;
+    yaw += delta.yaw;
+  }
+  EXPECT_NEAR(whole.yaw, yaw, 1e-4f);
+  EXPECT_NEAR((whole.translation - translation).norm(), 0.f, 1e-3f);
+}
+
+TEST(MotionPreintegratorTestSuite, covariance)
+{
+  mpf::MotionPreintegrator preintegrator(0.02f);
+  preintegrator.add(0.0, 10.f, 0.f, 1.f, 0.1f);
+
+  // Straight motion diffuses along the heading, and the yaw noise spreads it laterally
+  const mpf::MotionDelta delta = preintegrator.integrate(0.0, 2.0);
+  EXPECT_NEAR(delta.covariance(0, 0), 1.f * 2.f * 0.02f, 1e-5f);
+  EXPECT_NEAR(delta.covariance(2, 2), 0.01f * 2.f * 0.02f, 1e-6f);
+  EXPECT_GT(delta.covariance(1, 1), 0.f);
+  EXPECT_GT(delta.covariance(1, 2), 0.f);
+  EXPECT_TRUE(delta.covariance.isApprox(delta.covariance.transpose()));
+
+  // Zero length interval
+  EXPECT_TRUE(preintegrator.integrate(1.0, 1.0).covariance.isZero());
+}
+
+TEST(MotionPreintegratorTestSuite, buffer)
+{
+  mpf::MotionPreintegrator preintegrator(0.02f);
+  EXPECT_THROW(preintegrator.integrate(0.0, 1.0), std::runtime_error);
+
+  preintegrator.add(1.0, 1.f, 0.f, 0.1f, 0.1f);
+  preintegrator.add(2.0, 2.f, 0.f, 0.1f, 0.1f);
+  preintegrator.add(1.5, 9.f, 0.f, 0.1f, 0.1f);  // out of order
+  EXPECT_EQ(preintegrator.size(), 2u);
+
+  // The first sample holds before it, and the last one after it
+  EXPECT_NEAR(preintegrator.integrate(0.0, 3.0).translation.x(), 2.f * 1.f + 1.f * 2.f, 1e-5f);
+
+  preintegrator.erase_before(1.5);
+  EXPECT_EQ(preintegrator.size(), 2u);
+  preintegrator.erase_before(2.5);
+  EXPECT_EQ(preintegrator.size(), 1u);
+  EXPECT_NEAR(preintegrator.integrate(2.5, 3.0).translation.x(), 1.f, 1e-5f);
+}
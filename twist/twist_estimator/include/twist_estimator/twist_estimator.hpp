@@ -15,6 +15,7 @@
 #pragma once
 #include <Eigen/Core>
 #include <rclcpp/rclcpp.hpp>
+#include <yabloc_common/status_reporter.hpp>
 
 #include <autoware_auto_vehicle_msgs/msg/velocity_report.hpp>
 #include <geometry_msgs/msg/pose_stamped.hpp>
@@ -23,7 +24,6 @@
 #include <sensor_msgs/msg/imu.hpp>
 #include <sensor_msgs/msg/nav_sat_fix.hpp>
 #include <std_msgs/msg/float32.hpp>
-#include <std_msgs/msg/string.hpp>
 #include <ublox_msgs/msg/nav_pvt.hpp>
 
 #include <optional>
@@ -40,7 +40,6 @@ public:
   using Imu = sensor_msgs::msg::Imu;
   using NavPVT = ublox_msgs::msg::NavPVT;
   using PoseStamped = geometry_msgs::msg::PoseStamped;
-  using String = std_msgs::msg::String;
   using Float = std_msgs::msg::Float32;
 
   TwistEstimator();
@@ -54,7 +53,6 @@ private:
   };
 
   rclcpp::Publisher<PoseStamped>::SharedPtr pub_pose_;
-  rclcpp::Publisher<String>::SharedPtr pub_string_;
   rclcpp::Publisher<Float>::SharedPtr pub_doppler_vel_;
   rclcpp::Publisher<TwistCovStamped>::SharedPtr pub_twist_cov_;
 
@@ -80,6 +78,14 @@ private:
   float last_wheel_vel_;
 
   bool scale_covariance_reset_flag{false};
+
+  // Recorded on every IMU sample and published at 1 Hz
+  std::unique_ptr<common::StatusReporter> status_;
+  struct
+  {
+    size_t angle, velocity, bias, scale, doppler, wheel, rtk;
+  } status_index_;
+
   void on_timer();
 
   void on_imu(const Imu & msg);
@@ -92,7 +98,7 @@ private:
 
   void publish_twist(const Imu & msg);
   void publish_doppler(const NavPVT & msg);
-  void publish_string();
+  void record_status();
 
   Eigen::MatrixXf rectify_positive_semi_definite(const Eigen::MatrixXf & matrix);
 
@@ -42,7 +42,6 @@ TwistEstimator::TwistEstimator()
   sub_navpvt_ = create_subscription<NavPVT>("/sensing/gnss/ublox/navpvt", 10, cb_pvt);
 
   pub_pose_ = create_publisher<PoseStamped>("doppler", 10);
-  pub_string_ = create_publisher<String>("status", 10);
   pub_doppler_vel_ = create_publisher<Float>("doppler_vel", 10);
   pub_twist_cov_ = create_publisher<TwistCovStamped>("twist_with_cov", 10);
 
@@ -51,6 +50,15 @@ TwistEstimator::TwistEstimator()
   cov_ = Eigen::Vector4f(81, 400, 1e-6f, 1e-5f).asDiagonal();
   cov_predict_ = Eigen::Vector4f(0.01, 100, 1e-4f, 1e-4f).asDiagonal();
 
+  status_ = std::make_unique<common::StatusReporter>(this, "status", "Twist Estimator Status");
+  status_index_.angle = status_->add("angle");
+  status_index_.velocity = status_->add("vel");
+  status_index_.bias = status_->add("bias");
+  status_index_.scale = status_->add("scale");
+  status_index_.doppler = status_->add("doppler");
+  status_index_.wheel = status_->add("wheel");
+  status_index_.rtk = status_->add_label("RTK", {"UNRELIABLE", "FLOAT", "FIX"});
+
   auto cb_timer = std::bind(&TwistEstimator::on_timer, this);
   timer_ = rclcpp::create_timer(this, this->get_clock(), 3s, std::move(cb_timer));
 }
@@ -90,7 +98,7 @@ void TwistEstimator::on_imu(const Imu & raw_msg)
   cov_ = F * cov_ * F.transpose() + cov_predict_ * dt * dt;
 
   publish_twist(msg);
-  publish_string();
+  record_status();
 
   if (std::abs(state_[VELOCITY]) > stop_vel_threshold_) return;
 
@@ -275,33 +283,16 @@ void TwistEstimator::publish_doppler(const NavPVT & navpvt)
   last_doppler_vel_ = vel;
 }
 
-void TwistEstimator::publish_string()
+void TwistEstimator::record_status()
 {
-  std::stringstream ss;
-  ss << "--- Twist Estimator Status ----" << std::endl;
-  ss << std::fixed << std::setprecision(3);
-  ss << "angle: " << state_[0] << std::endl;
-  ss << "vel: " << state_[1] << std::endl;
-  ss << "bias: " << state_[2] << std::endl;
-  ss << "scale: " << state_[3] << std::endl;
-  ss << std::endl;
-  ss << "doppler: " << last_doppler_vel_.norm() << std::endl;
-  ss << "wheel: " << last_wheel_vel_ << std::endl;
-
-  switch (last_rtk_quality_) {
-    case 2:
-      ss << "RTK: FIX" << std::endl;
-      break;
-    case 1:
-      ss << "RTK: FLOAT" << std::endl;
-      break;
-    default:
-      ss << "RTK: UNRELIABLE" << std::endl;
-  }
-
-  String msg;
-  msg.data = ss.str();
-  pub_string_->publish(msg);
+  // NOTE: This is called on every IMU sample, so only the values are recorded here
+  status_->set(status_index_.angle, state_[ANGLE]);
+  status_->set(status_index_.velocity, state_[VELOCITY]);
+  status_->set(status_index_.bias, state_[BIAS]);
+  status_->set(status_index_.scale, state_[SCALE]);
+  status_->set(status_index_.doppler, last_doppler_vel_.norm());
+  status_->set(status_index_.wheel, last_wheel_vel_);
+  status_->set(status_index_.rtk, last_rtk_quality_);
 }
 
 Eigen::MatrixXf TwistEstimator::rectify_positive_semi_definite(const Eigen::MatrixXf & matrix)
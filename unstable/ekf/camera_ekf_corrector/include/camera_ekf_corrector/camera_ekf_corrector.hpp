@@ -14,8 +14,8 @@
 
 #pragma once
 
-#include "camera_ekf_corrector/hierarchical_cost_map.hpp"
-
+#include <ll2_cost_map/hierarchical_cost_map.hpp>
+#include <ll2_cost_map/pose_scorer.hpp>
 #include <opencv4/opencv2/core.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <std_srvs/srv/set_bool.hpp>
@@ -33,7 +33,6 @@
 namespace yabloc::ekf_corrector
 {
 cv::Point2f cv2pt(const Eigen::Vector3f v);
-float abs_cos(const Eigen::Vector3f & t, float deg);
 
 class CameraEkfCorrector : public rclcpp::Node
 {
@@ -60,6 +59,7 @@ private:
   const float logit_gain_;
 
   HierarchicalCostMap cost_map_;
+  PoseScorer pose_scorer_;
 
   rclcpp::Subscription<PointCloud2>::SharedPtr sub_bounding_box_;
   rclcpp::Subscription<PointCloud2>::SharedPtr sub_line_segments_cloud_;
@@ -87,8 +87,6 @@ private:
 
   std::pair<LineSegments, LineSegments> split_line_segments(const PointCloud2 & msg);
 
-  float compute_logit(const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position);
-
   std::pair<LineSegments, LineSegments> filt(const LineSegments & lines);
   std::optional<PoseCovStamped> get_synchronized_pose(const rclcpp::Time & stamp);
 
@@ -98,7 +96,8 @@ private:
     const PoseCovStamped & init, const LineSegments & line_segments_cloud,
     const LineSegments & iffy_line_segments_cloud);
 
+  // Points of the line segments at the pose colored by their probability, for visualization
   pcl::PointCloud<pcl::PointXYZI> evaluate_cloud(
-    const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position);
+    const LineSegments & line_segments_cloud, const Sophus::SE3f & pose);
 };
 }  // namespace yabloc::ekf_corrector
\ No newline at end of file
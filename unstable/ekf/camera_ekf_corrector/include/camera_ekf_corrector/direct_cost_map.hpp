@@ -1,24 +0,0 @@
-// Copyright 2023 TIER IV, Inc.
-//
-// Licensed under the Apache License, Version 2.0 (the "License");
-// you may not use this file except in compliance with the License.
-// You may obtain a copy of the License at
-//
-//     http://www.apache.org/licenses/LICENSE-2.0
-//
-// Unless required by applicable law or agreed to in writing, software
-// distributed under the License is distributed on an "AS IS" BASIS,
-// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-// See the License for the specific language governing permissions and
-// limitations under the License.
-
-#pragma once
-#include <opencv4/opencv2/imgproc.hpp>
-
-namespace yabloc::ekf_corrector
-{
-cv::Mat direct_cost_map(const cv::Mat & cost_map, const cv::Mat & intensity);
-
-cv::Mat visualize_direction_map(const cv::Mat & cost_map);
-
-}  // namespace yabloc::ekf_corrector
\ No newline at end of file
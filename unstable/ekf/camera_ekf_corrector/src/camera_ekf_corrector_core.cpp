@@ -13,7 +13,6 @@
 // limitations under the License.
 
 #include "camera_ekf_corrector/camera_ekf_corrector.hpp"
-#include "camera_ekf_corrector/fast_cos.hpp"
 #include "camera_ekf_corrector/logit.hpp"
 #include "camera_ekf_corrector/sampling.hpp"
 
@@ -22,19 +21,17 @@
 #include <yabloc_common/pose_conversions.hpp>
 #include <yabloc_common/pub_sub.hpp>
 #include <yabloc_common/timer.hpp>
-#include <yabloc_common/transform_line_segments.hpp>
 
 #include <pcl_conversions/pcl_conversions.h>
 
 namespace yabloc::ekf_corrector
 {
-FastCosSin fast_math;
-
 CameraEkfCorrector::CameraEkfCorrector()
 : Node("camera_particle_corrector"),
   far_weight_gain_(declare_parameter<float>("far_weight_gain", 0.001)),
   logit_gain_(declare_parameter<float>("logit_gain", 0.1)),
-  cost_map_(this)
+  cost_map_(this),
+  pose_scorer_({0.1f, far_weight_gain_, 0.2f})
 {
   using std::placeholders::_1;
   using std::placeholders::_2;
@@ -181,8 +178,7 @@ void CameraEkfCorrector::on_line_segments(const PointCloud2 & line_segments_msg)
 
   {
     Sophus::SE3f transform = common::pose_to_se3(opt_synched_pose->pose.pose);
-    pcl::PointCloud<pcl::PointXYZI> cloud = evaluate_cloud(
-      common::transform_line_segments(line_segments_cloud, transform), transform.translation());
+    pcl::PointCloud<pcl::PointXYZI> cloud = evaluate_cloud(line_segments_cloud, transform);
 
     pcl::PointCloud<pcl::PointXYZRGB> rgb_cloud;
 
@@ -258,16 +254,21 @@ CameraEkfCorrector::PoseCovStamped CameraEkfCorrector::estimate_pose_with_covari
   }
 
   // Find weights for every pose candidates
-  for (auto & particle : particles.particles) {
-    Sophus::SE3f transform = common::pose_to_se3(particle.pose);
-    LineSegments transformed_line_segments =
-      common::transform_line_segments(line_segments_cloud, transform);
-    LineSegments transformed_iffy_line_segments =
-      common::transform_line_segments(iffy_line_segments_cloud, transform);
-    transformed_line_segments += transformed_iffy_line_segments;
-
-    float logit = compute_logit(transformed_line_segments, transform.translation());
-    particle.weight = logit_to_prob(logit, logit_gain_);
+  {
+    LineSegments line_segments = line_segments_cloud;
+    line_segments += iffy_line_segments_cloud;
+
+    std::vector<Sophus::SE3f> poses;
+    poses.reserve(particles.particles.size());
+    for (const auto & particle : particles.particles) {
+      poses.push_back(common::pose_to_se3(particle.pose));
+    }
+
+    auto sampler = [this](const Eigen::Vector2f & p) -> CostMapValue { return cost_map_.at(p); };
+    const std::vector<float> logits = pose_scorer_.score(sampler, line_segments, poses);
+    for (size_t i = 0; i < logits.size(); ++i) {
+      particles.particles[i].weight = logit_to_prob(logits[i], logit_gain_);
+    }
   }
 
   // visualize
@@ -356,70 +357,12 @@ void CameraEkfCorrector::on_ll2(const PointCloud2 & ll2_msg)
   RCLCPP_INFO_STREAM(get_logger(), "Set LL2 cloud into Hierarchical cost map");
 }
 
-float abs_cos(const Eigen::Vector3f & t, float deg)
-{
-  // NOTE: use pre-computed table for std::cos & std::sin
-  Eigen::Vector2f x(t.x(), t.y());
-  Eigen::Vector2f y(fast_math.cos(deg), fast_math.sin(deg));
-  x.normalize();
-  return std::abs(x.dot(y));
-}
-
-float CameraEkfCorrector::compute_logit(
-  const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position)
-{
-  float logit = 0;
-  for (const LineSegment & pn : line_segments_cloud) {
-    const Eigen::Vector3f tangent = (pn.getNormalVector3fMap() - pn.getVector3fMap()).normalized();
-    const float length = (pn.getVector3fMap() - pn.getNormalVector3fMap()).norm();
-
-    for (float distance = 0; distance < length; distance += 0.1f) {
-      Eigen::Vector3f p = pn.getVector3fMap() + tangent * distance;
-
-      // NOTE: Close points are prioritized
-      float squared_norm = (p - self_position).topRows(2).squaredNorm();
-      float gain = exp(-far_weight_gain_ * squared_norm);  // 0 < gain < 1
-
-      const CostMapValue v3 = cost_map_.at(p.topRows(2));
-
-      if (v3.unmapped) {
-        // logit does not change if target pixel is unmapped
-        continue;
-      }
-      if (pn.label == 0) {  // posteriori
-        logit += 0.2f * gain * (abs_cos(tangent, v3.angle) * v3.intensity - 0.5f);
-      } else {  // apriori
-        logit += gain * (abs_cos(tangent, v3.angle) * v3.intensity - 0.5f);
-      }
-    }
-  }
-  return logit;
-}
-
 pcl::PointCloud<pcl::PointXYZI> CameraEkfCorrector::evaluate_cloud(
-  const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position)
+  const LineSegments & line_segments_cloud, const Sophus::SE3f & pose)
 {
-  pcl::PointCloud<pcl::PointXYZI> cloud;
-  for (const LineSegment & pn : line_segments_cloud) {
-    Eigen::Vector3f tangent = (pn.getNormalVector3fMap() - pn.getVector3fMap()).normalized();
-    float length = (pn.getVector3fMap() - pn.getNormalVector3fMap()).norm();
-
-    for (float distance = 0; distance < length; distance += 0.1f) {
-      Eigen::Vector3f p = pn.getVector3fMap() + tangent * distance;
-
-      // NOTE: Close points are prioritized
-      float squared_norm = (p - self_position).topRows(2).squaredNorm();
-      float gain = std::exp(-far_weight_gain_ * squared_norm);
-
-      CostMapValue v3 = cost_map_.at(p.topRows(2));
-      float logit = 0;
-      if (!v3.unmapped) logit = gain * (abs_cos(tangent, v3.angle) * v3.intensity - 0.5f);
-
-      pcl::PointXYZI xyzi(logit_to_prob(logit, 10.f));
-      xyzi.getVector3fMap() = p;
-      cloud.push_back(xyzi);
-    }
-  }
+  auto sampler = [this](const Eigen::Vector2f & p) -> CostMapValue { return cost_map_.at(p); };
+  pcl::PointCloud<pcl::PointXYZI> cloud = pose_scorer_.evaluate(sampler, line_segments_cloud, pose);
+  for (pcl::PointXYZI & p : cloud) p.intensity = logit_to_prob(p.intensity, 10.f);
   return cloud;
 }
 
@@ -27,6 +27,9 @@ struct RefineConfig
     long_bound_ = 0.1;
     late_bound_ = 1.0;
     height_bound_ = 0.1;
+    num_threads_ = 1;
+    analytic_jacobian_ = true;
+    warm_start_ = true;
   }
   bool verbose_;
   int max_iteration_;
@@ -34,6 +37,10 @@ struct RefineConfig
   double long_bound_;
   double late_bound_;
   double height_bound_;
+
+  int num_threads_;
+  bool analytic_jacobian_;
+  bool warm_start_;
 };
 
 }  // namespace refine_optimizer
\ No newline at end of file
@@ -19,6 +19,8 @@
 #include <ceres/cubic_interpolation.h>
 #include <ceres/rotation.h>
 
+#include <algorithm>
+
 namespace refine_optimizer
 {
 using Grid = ceres::Grid2D<uint8_t>;
@@ -84,4 +86,111 @@ struct ProjectionCost
   const Sophus::SE3d & extrinsic_;
   const Sophus::SE3d & pose_;
 };
+
+// Same residual as ProjectionCost, but the Jacobians are given in closed form.
+// d(residual)/d(param) = -d(cost)/d(pixel) * d(pixel)/d(camera) * d(camera)/d(param)
+// where d(cost)/d(pixel) comes from the interpolator itself.
+class AnalyticProjectionCost : public ceres::SizedCostFunction<1, 3, 3>
+{
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  AnalyticProjectionCost(
+    const Interpolator & interpolator, const Eigen::Vector3d & point,
+    const Eigen::Matrix3d & intrinsic, const Sophus::SE3d & extrinsic, const Sophus::SE3d & pose)
+  : interpolator_(interpolator),
+    intrinsic_(intrinsic),
+    extrinsic_(extrinsic),
+    from_biased_base_link_(pose.inverse() * point)
+  {
+  }
+
+  bool Evaluate(
+    double const * const * parameters, double * residuals, double ** jacobians) const override
+  {
+    using Matrix3d = Eigen::Matrix3d;
+    using Vector3d = Eigen::Vector3d;
+    using RowVector3d = Eigen::RowVector3d;
+
+    Eigen::Map<const Vector3d> position(parameters[0]);
+    Matrix3d dR[3];
+    const Matrix3d R = rotationAndDerivatives(parameters[1], dR);
+
+    const Vector3d from_pose = from_biased_base_link_ - position;
+    const Vector3d from_base_link = R.transpose() * from_pose;
+    const Matrix3d extrinsic_R_inv = extrinsic_.so3().inverse().matrix();
+    const Vector3d from_camera = extrinsic_.inverse() * from_base_link;
+
+    if (from_camera.z() < 1e-3) {
+      residuals[0] = 255.0;
+      if (jacobians == nullptr) return true;
+      for (int i = 0; i < 2; ++i) {
+        if (jacobians[i]) std::fill_n(jacobians[i], 3, 0.0);
+      }
+      return true;
+    }
+
+    // NOTE: Interpolator is ROW-major
+    const double inv_z = 1.0 / from_camera.z();
+    const Vector3d pixel = intrinsic_ * from_camera * inv_z;
+    double v, dv_drow, dv_dcol;
+    interpolator_.Evaluate(pixel.y(), pixel.x(), &v, &dv_drow, &dv_dcol);
+    residuals[0] = 255.0 - v;
+
+    if (jacobians == nullptr) return true;
+
+    // d(pixel.xy)/d(from_camera) for pixel = K * c / c.z
+    Eigen::Matrix<double, 2, 3> dpixel_dcamera = intrinsic_.topRows<2>() * inv_z;
+    dpixel_dcamera.col(2) -= pixel.head<2>() * inv_z;
+
+    const RowVector3d dr_dcamera = -Eigen::RowVector2d(dv_dcol, dv_drow) * dpixel_dcamera;
+    const RowVector3d dr_dbase_link = dr_dcamera * extrinsic_R_inv;
+
+    if (jacobians[0]) {
+      Eigen::Map<RowVector3d> j(jacobians[0]);
+      j = -dr_dbase_link * R.transpose();
+    }
+    if (jacobians[1]) {
+      Eigen::Map<RowVector3d> j(jacobians[1]);
+      for (int axis = 0; axis < 3; ++axis) {
+        j(axis) = dr_dbase_link.dot(dR[axis].transpose() * from_pose);
+      }
+    }
+    return true;
+  }
+
+  static ceres::CostFunction * Create(
+    const Interpolator & interpolator, const Eigen::Vector3d & point,
+    const Eigen::Matrix3d & intrinsic, const Sophus::SE3d & extrinsic, const Sophus::SE3d & pose)
+  {
+    return new AnalyticProjectionCost(interpolator, point, intrinsic, extrinsic, pose);
+  }
+
+private:
+  // Same convention as ceres::EulerAnglesToRotationMatrix: the angles are (pitch, roll, yaw)
+  // in degrees and R = Rz(yaw) * Ry(roll) * Rx(pitch)
+  static Eigen::Matrix3d rotationAndDerivatives(const double * euler, Eigen::Matrix3d * dR)
+  {
+    constexpr double deg_to_rad = M_PI / 180.0;
+    const Eigen::Matrix3d Rx =
+      Eigen::AngleAxisd(euler[0] * deg_to_rad, Eigen::Vector3d::UnitX()).toRotationMatrix();
+    const Eigen::Matrix3d Ry =
+      Eigen::AngleAxisd(euler[1] * deg_to_rad, Eigen::Vector3d::UnitY()).toRotationMatrix();
+    const Eigen::Matrix3d Rz =
+      Eigen::AngleAxisd(euler[2] * deg_to_rad, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+
+    auto hat = [](const Eigen::Vector3d & w) -> Eigen::Matrix3d {
+      return Sophus::SO3d::hat(w) * deg_to_rad;
+    };
+    dR[0] = Rz * Ry * Rx * hat(Eigen::Vector3d::UnitX());
+    dR[1] = Rz * Ry * hat(Eigen::Vector3d::UnitY()) * Rx;
+    dR[2] = hat(Eigen::Vector3d::UnitZ()) * Rz * Ry * Rx;
+    return Rz * Ry * Rx;
+  }
+
+  const Interpolator & interpolator_;
+  const Eigen::Matrix3d & intrinsic_;
+  const Sophus::SE3d & extrinsic_;
+  const Eigen::Vector3d from_biased_base_link_;
+};
 }  // namespace refine_optimizer
\ No newline at end of file
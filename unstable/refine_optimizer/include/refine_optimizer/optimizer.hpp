@@ -44,6 +44,8 @@ private:
     const Eigen::Vector3d & param_t, const Eigen::Vector3d & param_euler,
     const ceres::Solver::Summary & summary);
 
+  Eigen::Vector3d bound_t() const;
+
   std::optional<Sophus::SE3d> extrinsic_{std::nullopt};
   std::optional<Eigen::Matrix3d> intrinsic_{std::nullopt};
 
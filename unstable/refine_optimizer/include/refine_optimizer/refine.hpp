@@ -20,10 +20,10 @@
 #include <opencv4/opencv2/core.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <sophus/geometry.hpp>
-#include <vml_common/gamma_converter.hpp>
-#include <vml_common/ground_plane.hpp>
-#include <vml_common/static_tf_subscriber.hpp>
-#include <vml_common/synchro_subscriber.hpp>
+#include <yabloc_common/gamma_converter.hpp>
+#include <yabloc_common/ground_plane.hpp>
+#include <yabloc_common/static_tf_subscriber.hpp>
+#include <yabloc_common/synchro_subscriber.hpp>
 
 #include <geometry_msgs/msg/pose_stamped.hpp>
 #include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
@@ -60,13 +60,14 @@ public:
 protected:
   const int pixel_interval_;
   const bool show_grad_image_;
+  const int roi_margin_;
   boost::circular_buffer<PoseStamped> pose_buffer_;
 
-  vml_common::GammaConverter gamma_converter_{5.0};
+  yabloc::common::GammaConverter gamma_converter_{5.0};
   std::shared_ptr<Optimizer> optimizer_;
 
-  vml_common::StaticTfSubscriber tf_subscriber_;
-  vml_common::GroundPlane ground_plane_;
+  yabloc::common::StaticTfSubscriber tf_subscriber_;
+  yabloc::common::GroundPlane ground_plane_;
 
   rclcpp::Subscription<PoseStamped>::SharedPtr sub_pose_;
   rclcpp::Subscription<CameraInfo>::SharedPtr sub_info_;
@@ -80,7 +81,7 @@ protected:
   std::optional<CameraInfo> info_{std::nullopt};
   std::optional<Sophus::SE3f> camera_extrinsic_{std::nullopt};
   LineSegments ll2_cloud_;
-  SynchroSubscriber<Image, PointCloud2>::SharedPtr sub_synchro_;
+  yabloc::common::SynchroSubscriber<Image, PointCloud2>::SharedPtr sub_synchro_;
 
   void infoCallback(const CameraInfo & msg);
 
@@ -89,7 +90,8 @@ protected:
   LineSegments extractNaerLineSegments(
     const Sophus::SE3f & pose, const LineSegments & line_segments);
 
-  cv::Mat makeCostMap(LineSegments & line_segments);
+  cv::Rect computeRoi(const Sophus::SE3f & pose, const pcl::PointCloud<pcl::PointXYZ> & samples);
+  cv::Mat makeCostMap(const LineSegments & line_segments, const cv::Rect & roi);
 
   pcl::PointCloud<pcl::PointXYZ> sampleUniformlyOnImage(
     const Sophus::SE3f & pose, const LineSegments & segments);
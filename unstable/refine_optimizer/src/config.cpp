@@ -25,6 +25,10 @@ RefineConfig::RefineConfig(rclcpp::Node * node)
   long_bound_ = node->declare_parameter<double>("refine.long_bound", 0.1);
   late_bound_ = node->declare_parameter<double>("refine.late_bound", 1.0);
   height_bound_ = node->declare_parameter<double>("refine.height_bound", 0.1);
+
+  num_threads_ = node->declare_parameter<int>("refine.num_threads", 1);
+  analytic_jacobian_ = node->declare_parameter<bool>("refine.analytic_jacobian", true);
+  warm_start_ = node->declare_parameter<bool>("refine.warm_start", true);
 }
 
 }  // namespace refine_optimizer
\ No newline at end of file
@@ -43,6 +43,19 @@ Sophus::SE3f Optimizer::execute(
   // Convert types from something float to double*
   const Sophus::SE3d pose_d = pose.cast<double>();
 
+  // The previous solution is the correction of the previous input pose. Because the input pose
+  // drifts slowly, it is a much better initial guess than the identity.
+  if (!config_.warm_start_ || !param_t_.allFinite() || !param_euler_.allFinite()) {
+    param_t_.setZero();
+    param_euler_.setZero();
+  }
+  param_t_ = param_t_.cwiseMax(-bound_t()).cwiseMin(bound_t());
+  if (config_.euler_bound_ > 0) {
+    param_euler_ = param_euler_.cwiseMax(-config_.euler_bound_).cwiseMin(config_.euler_bound_);
+  } else {
+    param_euler_.setZero();
+  }
+
   // Declare optimization problem and variables
   ceres::Problem problem;
 
@@ -55,15 +68,13 @@ Sophus::SE3f Optimizer::execute(
 
   // Add boundary conditions
   {
-    double lon = config_.long_bound_;
-    double lat = config_.late_bound_;
-    double hei = config_.height_bound_;
-    problem.SetParameterLowerBound(param_t_.data(), 0, -lon);  // longitudinal
-    problem.SetParameterUpperBound(param_t_.data(), 0, lon);   // longitudinal
-    problem.SetParameterLowerBound(param_t_.data(), 1, -lat);  // lateral
-    problem.SetParameterUpperBound(param_t_.data(), 1, lat);   // lateral
-    problem.SetParameterLowerBound(param_t_.data(), 2, -hei);  // height
-    problem.SetParameterUpperBound(param_t_.data(), 2, hei);   // height
+    const Eigen::Vector3d bound = bound_t();
+    problem.SetParameterLowerBound(param_t_.data(), 0, -bound.x());  // longitudinal
+    problem.SetParameterUpperBound(param_t_.data(), 0, bound.x());   // longitudinal
+    problem.SetParameterLowerBound(param_t_.data(), 1, -bound.y());  // lateral
+    problem.SetParameterUpperBound(param_t_.data(), 1, bound.y());   // lateral
+    problem.SetParameterLowerBound(param_t_.data(), 2, -bound.z());  // height
+    problem.SetParameterUpperBound(param_t_.data(), 2, bound.z());   // height
     if (config_.euler_bound_ > 0) {
       for (int axis = 0; axis < 3; ++axis) {
         problem.SetParameterLowerBound(param_euler_.data(), axis, -config_.euler_bound_);
@@ -77,18 +88,31 @@ Sophus::SE3f Optimizer::execute(
   // Add residual blocks
   for (const pcl::PointXYZ & p : samples) {
     Eigen::Vector3d p_d = p.getVector3fMap().cast<double>();
-    problem.AddResidualBlock(
-      ProjectionCost::Create(interpolator, p_d, intrinsic_.value(), extrinsic_.value(), pose_d),
-      nullptr, param_t_.data(), param_euler_.data());
+    ceres::CostFunction * cost_function;
+    if (config_.analytic_jacobian_) {
+      cost_function = AnalyticProjectionCost::Create(
+        interpolator, p_d, intrinsic_.value(), extrinsic_.value(), pose_d);
+    } else {
+      cost_function =
+        ProjectionCost::Create(interpolator, p_d, intrinsic_.value(), extrinsic_.value(), pose_d);
+    }
+    problem.AddResidualBlock(cost_function, nullptr, param_t_.data(), param_euler_.data());
   }
 
   // Solve the optimization problem
   ceres::Solver::Options options;
   options.max_num_iterations = config_.max_iteration_;
+  options.num_threads = config_.num_threads_;
   ceres::Solver::Summary summary;
   ceres::Solve(options, &problem, &summary);
   if (config_.verbose_) std::cout << summary.BriefReport() << std::endl;
 
+  // Never carry a broken solution over to the next frame
+  if (summary.termination_type == ceres::FAILURE) {
+    param_t_.setZero();
+    param_euler_.setZero();
+  }
+
   // Assemble status string
   *summary_text = makeSummaryText(param_t_, param_euler_, summary);
 
@@ -102,6 +126,11 @@ Sophus::SE3f Optimizer::execute(
   }
 }
 
+Eigen::Vector3d Optimizer::bound_t() const
+{
+  return {config_.long_bound_, config_.late_bound_, config_.height_bound_};
+}
+
 std::string Optimizer::makeSummaryText(
   const Eigen::Vector3d & param_t, const Eigen::Vector3d & param_euler,
   const ceres::Solver::Summary & summary)
@@ -21,9 +21,9 @@
 #include <opencv4/opencv2/highgui.hpp>
 #include <opencv4/opencv2/imgproc.hpp>
 #include <sophus/geometry.hpp>
-#include <vml_common/cv_decompress.hpp>
-#include <vml_common/pose_conversions.hpp>
-#include <vml_common/pub_sub.hpp>
+#include <yabloc_common/cv_decompress.hpp>
+#include <yabloc_common/pose_conversions.hpp>
+#include <yabloc_common/pub_sub.hpp>
 
 #include <boost/functional/hash.hpp>
 
@@ -35,15 +35,16 @@ RefineOptimizer::RefineOptimizer()
 : Node("refine"),
   pixel_interval_(declare_parameter<int>("refine.pixel_interval", 10)),
   show_grad_image_(declare_parameter<bool>("refine.show_grad_image", false)),
+  roi_margin_(declare_parameter<int>("refine.roi_margin", 100)),
   pose_buffer_{40},
   tf_subscriber_(get_clock())
 {
   using std::placeholders::_1, std::placeholders::_2;
 
   auto cb_synchro = std::bind(&RefineOptimizer::imageAndLsdCallback, this, _1, _2);
-  using MySynchroSub = SynchroSubscriber<Image, PointCloud2>;
+  using MySynchroSub = yabloc::common::SynchroSubscriber<Image, PointCloud2>;
   sub_synchro_ = std::make_shared<MySynchroSub>(this, "/src_image", "/line_segments_cloud");
-  sub_synchro_->setCallback(cb_synchro);
+  sub_synchro_->set_callback(cb_synchro);
 
   // Subscriber
   auto cb_info = std::bind(&RefineOptimizer::infoCallback, this, _1);
@@ -75,7 +76,8 @@ void RefineOptimizer::infoCallback(const CameraInfo & msg)
   camera_extrinsic_ = tf_subscriber_.se3f(info_->header.frame_id, "base_link");
 }
 
-void RefineOptimizer::imageAndLsdCallback(const Image & image_msg, const PointCloud2 & line_segments_msg)
+void RefineOptimizer::imageAndLsdCallback(
+  const Image & image_msg, const PointCloud2 & line_segments_msg)
 {
   const rclcpp::Time stamp = line_segments_msg.header.stamp;
 
@@ -92,14 +94,14 @@ void RefineOptimizer::imageAndLsdCallback(const Image & image_msg, const PointCl
   }
   if (min_dt > 0.1) return;
 
-  LineSegments line_segments;
-  pcl::fromROSMsg(line_segments_msg, line_segments);
-  cv::Mat cost_image = makeCostMap(line_segments);
-
-  Sophus::SE3f raw_pose = vml_common::pose2Se3(synched_pose.pose);
+  Sophus::SE3f raw_pose = yabloc::common::pose_to_se3(synched_pose.pose);
   auto line_segments = extractNaerLineSegments(raw_pose, ll2_cloud_);
   pcl::PointCloud<pcl::PointXYZ> samples = sampleUniformlyOnImage(raw_pose, line_segments);
 
+  LineSegments lsd_segments;
+  pcl::fromROSMsg(line_segments_msg, lsd_segments);
+  cv::Mat cost_image = makeCostMap(lsd_segments, computeRoi(raw_pose, samples));
+
   Sophus::SE3f opt_pose = raw_pose;
   std::string summary_text;
   {
@@ -115,7 +117,7 @@ void RefineOptimizer::imageAndLsdCallback(const Image & image_msg, const PointCl
   if (show_grad_image_) {
     cv::applyColorMap(cost_image, rgb_image, cv::COLORMAP_JET);
   } else {
-    rgb_image = vml_common::decompress2CvMat(image_msg);
+    rgb_image = yabloc::common::decompress_to_cv_mat(image_msg);
   }
   drawOverlayPoints(rgb_image, raw_pose, samples, cv::Scalar::all(0));
   drawOverlayLineSegments(rgb_image, opt_pose, line_segments, cv::Scalar(255, 255, 255));
@@ -128,12 +130,12 @@ void RefineOptimizer::imageAndLsdCallback(const Image & image_msg, const PointCl
     pub_string_->publish(msg);
   }
 
-  vml_common::publishImage(*pub_image_, rgb_image, stamp);
+  yabloc::common::publish_image(*pub_image_, rgb_image, stamp);
 
   PoseStamped pose_stamped;
   pose_stamped.header.frame_id = "map";
   pose_stamped.header.stamp = stamp;
-  pose_stamped.pose = vml_common::se32Pose(opt_pose);
+  pose_stamped.pose = yabloc::common::se3_to_pose(opt_pose);
   pub_pose_->publish(pose_stamped);
   {
     PoseCovStamped cov_msg;
@@ -159,7 +161,7 @@ void RefineOptimizer::drawOverlayLineSegments(
     Eigen::Map<Eigen::Matrix<double, 3, 3>>(info_->k.data()).cast<float>().transpose();
   Sophus::SE3f T = camera_extrinsic_.value();
 
-  Sophus::SE3f transform = ground_plane_.alignWithSlope(pose_affine);
+  Sophus::SE3f transform = ground_plane_.align_with_slope(pose_affine);
 
   auto project = [K, T, transform](const Eigen::Vector3f & xyz) -> std::optional<cv::Point2i> {
     Eigen::Vector3f from_camera = K * (T.inverse() * transform.inverse() * xyz);
@@ -183,7 +185,7 @@ void RefineOptimizer::drawOverlayPoints(
     Eigen::Map<Eigen::Matrix<double, 3, 3>>(info_->k.data()).cast<float>().transpose();
   Sophus::SE3f T = camera_extrinsic_.value();
 
-  Sophus::SE3f transform = ground_plane_.alignWithSlope(pose_affine);
+  Sophus::SE3f transform = ground_plane_.align_with_slope(pose_affine);
 
   auto project = [K, T, transform](const Eigen::Vector3f & xyz) -> std::optional<cv::Point2i> {
     Eigen::Vector3f from_camera = K * (T.inverse() * transform.inverse() * xyz);
@@ -235,13 +237,48 @@ RefineOptimizer::LineSegments RefineOptimizer::extractNaerLineSegments(
   return near_linestrings;
 }
 
-cv::Mat RefineOptimizer::makeCostMap(LineSegments & line_segments)
+cv::Rect RefineOptimizer::computeRoi(
+  const Sophus::SE3f & pose, const pcl::PointCloud<pcl::PointXYZ> & samples)
 {
-  const cv::Size size(info_->width, info_->height);
-  cv::Mat image = 255 * cv::Mat::ones(size, CV_8UC1);
+  Eigen::Matrix3f intrinsic =
+    Eigen::Map<Eigen::Matrix<double, 3, 3>>(info_->k.data()).cast<float>().transpose();
+  Sophus::SE3f extrinsic = camera_extrinsic_.value();
+  const Sophus::SE3f transform = (pose * extrinsic).inverse();
+
+  Eigen::Vector2f min_uv = Eigen::Vector2f::Constant(std::numeric_limits<float>::max());
+  Eigen::Vector2f max_uv = Eigen::Vector2f::Constant(std::numeric_limits<float>::lowest());
+  for (const pcl::PointXYZ & p : samples) {
+    Eigen::Vector3f from_camera = transform * p.getVector3fMap();
+    if (from_camera.z() < 1e-3f) continue;
+    Eigen::Vector2f uv = (intrinsic * from_camera / from_camera.z()).topRows(2);
+    min_uv = min_uv.cwiseMin(uv);
+    max_uv = max_uv.cwiseMax(uv);
+  }
 
-  auto cvPoint = [](const Eigen::Vector3f & p) -> cv::Point2f { return cv::Point2f(p.x(), p.y()); };
-  for (const auto pn : line_segments) {
+  if ((min_uv.array() > max_uv.array()).any()) return cv::Rect();
+
+  const float margin = static_cast<float>(roi_margin_);
+  cv::Point2i top_left(std::floor(min_uv.x() - margin), std::floor(min_uv.y() - margin));
+  cv::Point2i bottom_right(std::ceil(max_uv.x() + margin), std::ceil(max_uv.y() + margin));
+  return cv::Rect(top_left, bottom_right) & cv::Rect(0, 0, info_->width, info_->height);
+}
+
+cv::Mat RefineOptimizer::makeCostMap(const LineSegments & line_segments, const cv::Rect & roi)
+{
+  // Pixels outside of the ROI are never sampled by the optimizer. They have the lowest value,
+  // which is the same as one farther than the truncation distance.
+  const cv::Size size(info_->width, info_->height);
+  cv::Mat cost_image = cv::Mat::zeros(size, CV_8UC1);
+  if (roi.empty()) return cost_image;
+
+  // Because the distance is truncated at 100 pixels, a line segment out of the ROI does not
+  // change the value on the projected samples as long as the margin is no less than that.
+  cv::Mat image = 255 * cv::Mat::ones(roi.size(), CV_8UC1);
+  const cv::Point2f offset(roi.x, roi.y);
+  auto cvPoint = [offset](const Eigen::Vector3f & p) -> cv::Point2f {
+    return cv::Point2f(p.x(), p.y()) - offset;
+  };
+  for (const auto & pn : line_segments) {
     cv::Point2f from = cvPoint(pn.getVector3fMap());
     cv::Point2f to = cvPoint(pn.getNormalVector3fMap());
     cv::line(image, from, to, cv::Scalar::all(0), 1);
@@ -251,7 +288,8 @@ cv::Mat RefineOptimizer::makeCostMap(LineSegments & line_segments)
   cv::threshold(distance, distance, 100, 100, cv::THRESH_TRUNC);
   distance.convertTo(distance, CV_8UC1, -2.55, 255);
 
-  return gamma_converter_(distance);
+  gamma_converter_(distance).copyTo(cost_image(roi));
+  return cost_image;
 }
 
 pcl::PointCloud<pcl::PointXYZ> RefineOptimizer::sampleUniformlyOnImage(
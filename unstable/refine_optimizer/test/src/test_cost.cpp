@@ -0,0 +1,140 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "refine_optimizer/cost.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr int ROWS = 480;
+constexpr int COLS = 640;
+
+// A smooth cost image so that the bicubic gradient is meaningful everywhere
+std::vector<uint8_t> make_cost_image()
+{
+  std::vector<uint8_t> image(ROWS * COLS);
+  for (int r = 0; r < ROWS; ++r) {
+    for (int c = 0; c < COLS; ++c) {
+      const double v = 127.5 + 60 * std::sin(c * 0.031) + 60 * std::cos(r * 0.023 + c * 0.011);
+      image[r * COLS + c] = static_cast<uint8_t>(std::clamp(v, 0.0, 255.0));
+    }
+  }
+  return image;
+}
+
+struct Evaluation
+{
+  double residual;
+  Eigen::Vector3d dp;
+  Eigen::Vector3d dq;
+};
+
+Evaluation evaluate(const ceres::CostFunction & cost, const double * p, const double * q)
+{
+  const double * parameters[2] = {p, q};
+  Evaluation e;
+  double * jacobians[2] = {e.dp.data(), e.dq.data()};
+  EXPECT_TRUE(cost.Evaluate(parameters, &e.residual, jacobians));
+  return e;
+}
+}  // namespace
+
+using refine_optimizer::AnalyticProjectionCost;
+using refine_optimizer::Grid;
+using refine_optimizer::Interpolator;
+using refine_optimizer::ProjectionCost;
+
+class ProjectionCostTest : public ::testing::Test
+{
+protected:
+  ProjectionCostTest() : image_(make_cost_image()), grid_(image_.data(), 0, ROWS, 0, COLS)
+  {
+    interpolator_ = std::make_unique<Interpolator>(grid_);
+    intrinsic_ << 500, 0, 320, 0, 500, 240, 0, 0, 1;
+
+    // Camera looking forward along the x-axis of base_link, 1.5m above it
+    Eigen::Matrix3d R;
+    R << 0, 0, 1, -1, 0, 0, 0, -1, 0;
+    extrinsic_ = Sophus::SE3d(R, Eigen::Vector3d(0, 0, 1.5));
+  }
+
+  std::vector<uint8_t> image_;
+  Grid grid_;
+  std::unique_ptr<Interpolator> interpolator_;
+  Eigen::Matrix3d intrinsic_;
+  Sophus::SE3d extrinsic_;
+};
+
+TEST_F(ProjectionCostTest, analyticJacobianMatchesAutoDiff)
+{
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<double> unit(-1, 1);
+
+  for (int trial = 0; trial < 50; ++trial) {
+    // Both cost functions keep a reference to the pose
+    const Eigen::Vector3d position(10 * unit(engine), 10 * unit(engine), 0);
+    const Sophus::SE3d pose(Sophus::SO3d::rotZ(M_PI * unit(engine)), position);
+
+    // A point on the road some meters ahead of the vehicle
+    const Eigen::Vector3d ahead(8 + 4 * unit(engine), 3 * unit(engine), 0.2 * unit(engine));
+    const Eigen::Vector3d point = pose * ahead;
+
+    const double p[3] = {0.1 * unit(engine), 0.5 * unit(engine), 0.1 * unit(engine)};
+    const double q[3] = {2 * unit(engine), 2 * unit(engine), 5 * unit(engine)};
+
+    std::unique_ptr<ceres::CostFunction> autodiff(
+      ProjectionCost::Create(*interpolator_, point, intrinsic_, extrinsic_, pose));
+    std::unique_ptr<ceres::CostFunction> analytic(
+      AnalyticProjectionCost::Create(*interpolator_, point, intrinsic_, extrinsic_, pose));
+
+    const Evaluation expected = evaluate(*autodiff, p, q);
+    const Evaluation actual = evaluate(*analytic, p, q);
+
+    EXPECT_NEAR(actual.residual, expected.residual, 1e-6);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_NEAR(actual.dp(i), expected.dp(i), 1e-6 * (1 + std::abs(expected.dp(i))));
+      EXPECT_NEAR(actual.dq(i), expected.dq(i), 1e-6 * (1 + std::abs(expected.dq(i))));
+    }
+  }
+}
+
+TEST_F(ProjectionCostTest, behindCamera)
+{
+  const Sophus::SE3d pose;
+  const Eigen::Vector3d point(-5, 0, 0);
+  const double p[3] = {0, 0, 0};
+  const double q[3] = {0, 0, 0};
+
+  std::unique_ptr<ceres::CostFunction> autodiff(
+    ProjectionCost::Create(*interpolator_, point, intrinsic_, extrinsic_, pose));
+  std::unique_ptr<ceres::CostFunction> analytic(
+    AnalyticProjectionCost::Create(*interpolator_, point, intrinsic_, extrinsic_, pose));
+
+  const Evaluation expected = evaluate(*autodiff, p, q);
+  const Evaluation actual = evaluate(*analytic, p, q);
+
+  EXPECT_DOUBLE_EQ(expected.residual, 255.0);
+  EXPECT_DOUBLE_EQ(actual.residual, 255.0);
+  EXPECT_TRUE(actual.dp.isZero());
+  EXPECT_TRUE(actual.dq.isZero());
+  EXPECT_TRUE(expected.dp.isZero());
+  EXPECT_TRUE(expected.dq.isZero());
+}
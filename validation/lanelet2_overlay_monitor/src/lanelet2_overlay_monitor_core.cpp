@@ -21,11 +21,10 @@
 #include <opencv4/opencv2/imgproc.hpp>
 #include <yabloc_common/cv_decompress.hpp>
 #include <yabloc_common/extract_line_segments.hpp>
+#include <yabloc_common/line_segments_msg.hpp>
 #include <yabloc_common/pose_conversions.hpp>
 #include <yabloc_common/pub_sub.hpp>
 
-#include <pcl_conversions/pcl_conversions.h>
-
 namespace yabloc::lanelet2_overlay
 {
 Lanelet2Overlay::Lanelet2Overlay()
@@ -47,11 +46,21 @@ Lanelet2Overlay::Lanelet2Overlay()
     create_subscription<PointCloud2>("projected_line_segments_cloud", 10, cb_line_segments);
   sub_info_ = create_subscription<CameraInfo>("src_info", 10, cb_info);
   sub_sign_board_ = create_subscription<PointCloud2>(
-    "ll2_sign_board", 10,
-    [this](const PointCloud2 & msg) -> void { pcl::fromROSMsg(msg, sign_board_); });
+    "ll2_sign_board", 10, [this](const PointCloud2 & msg) -> void {
+      try {
+        sign_board_ = common::to_point_normal_cloud(common::LineSegmentsView(msg));
+      } catch (const std::runtime_error & e) {
+        RCLCPP_WARN_STREAM_THROTTLE(get_logger(), *get_clock(), 1000, "drop: " << e.what());
+      }
+    });
   sub_ll2_ = create_subscription<PointCloud2>(
-    "ll2_road_marking", 10,
-    [this](const PointCloud2 & msg) -> void { pcl::fromROSMsg(msg, ll2_cloud_); });
+    "ll2_road_marking", 10, [this](const PointCloud2 & msg) -> void {
+      try {
+        ll2_cloud_ = common::to_point_normal_cloud(common::LineSegmentsView(msg));
+      } catch (const std::runtime_error & e) {
+        RCLCPP_WARN_STREAM_THROTTLE(get_logger(), *get_clock(), 1000, "drop: " << e.what());
+      }
+    });
 
   // Publisher
   pub_vis_ = create_publisher<Marker>("projected_marker", 10);
@@ -104,11 +113,12 @@ void Lanelet2Overlay::on_line_segments(const PointCloud2 & msg)
   if (min_dt > 0.1) return;
   auto latest_pose_stamp = rclcpp::Time(pose_buffer_.back().header.stamp);
 
-  std::vector<int> a;
-
-  LineSegments line_segments_cloud;
-  pcl::fromROSMsg(msg, line_segments_cloud);
-  make_vis_marker(line_segments_cloud, synched_pose.pose, stamp);
+  try {
+    make_vis_marker(common::LineSegmentsView(msg), synched_pose.pose, stamp);
+  } catch (const std::runtime_error & e) {
+    RCLCPP_WARN_STREAM_THROTTLE(
+      get_logger(), *get_clock(), 1000, "drop line segments: " << e.what());
+  }
 }
 
 void Lanelet2Overlay::draw_overlay(
@@ -183,7 +193,7 @@ void Lanelet2Overlay::draw_overlay_line_segments(
 }
 
 void Lanelet2Overlay::make_vis_marker(
-  const LineSegments & ls, const Pose & pose, const rclcpp::Time & stamp)
+  const common::LineSegmentsView & ls, const Pose & pose, const rclcpp::Time & stamp)
 {
   Marker marker;
   marker.type = Marker::LINE_LIST;
@@ -196,14 +206,16 @@ void Lanelet2Overlay::make_vis_marker(
   marker.color.b = 0.0f;
   marker.color.a = 0.7f;
 
-  for (const auto pn : ls) {
+  for (size_t i = 0; i < ls.size(); i++) {
+    const auto from = ls.from(i);
+    const auto to = ls.to(i);
     geometry_msgs::msg::Point p1, p2;
-    p1.x = pn.x;
-    p1.y = pn.y;
-    p1.z = pn.z;
-    p2.x = pn.normal_x;
-    p2.y = pn.normal_y;
-    p2.z = pn.normal_z;
+    p1.x = from.x();
+    p1.y = from.y();
+    p1.z = from.z();
+    p2.x = to.x();
+    p2.y = to.y();
+    p2.z = to.z();
     marker.points.push_back(p1);
     marker.points.push_back(p2);
   }
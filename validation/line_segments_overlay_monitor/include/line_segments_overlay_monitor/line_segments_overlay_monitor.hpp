@@ -18,9 +18,6 @@
 #include <sensor_msgs/msg/image.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
 
-#include <pcl/point_cloud.h>
-#include <pcl/point_types.h>
-
 namespace yabloc::line_segments_overlay
 {
 class LineSegmentsOverlay : public rclcpp::Node
@@ -28,8 +25,6 @@ class LineSegmentsOverlay : public rclcpp::Node
 public:
   using PointCloud2 = sensor_msgs::msg::PointCloud2;
   using Image = sensor_msgs::msg::Image;
-  using LineSegment = pcl::PointXYZLNormal;
-  using LineSegments = pcl::PointCloud<LineSegment>;
   LineSegmentsOverlay();
 
 private:
@@ -22,9 +22,15 @@ namespace yabloc::common
 {
 cv::Mat decompress_to_cv_mat(const sensor_msgs::msg::Image & img);
 
+// Copy `img` into `dst`. `dst` is re-allocated only if its size or type is different
+void decompress_to_cv_mat(const sensor_msgs::msg::Image & img, cv::Mat & dst);
+
 sensor_msgs::msg::Image::ConstSharedPtr decompress_to_ros_msg(
   const sensor_msgs::msg::CompressedImage & compressed_img, const std::string & encoding = "bgr8");
 
 cv::Mat decompress_to_cv_mat(const sensor_msgs::msg::CompressedImage & compressed_img);
 
+// Decode `compressed_img` into `dst`. `dst` is re-allocated only if its size or type is different
+void decompress_to_cv_mat(const sensor_msgs::msg::CompressedImage & compressed_img, cv::Mat & dst);
+
 }  // namespace yabloc::common
\ No newline at end of file
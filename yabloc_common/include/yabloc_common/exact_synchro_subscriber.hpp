@@ -0,0 +1,129 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <rclcpp/rclcpp.hpp>
+
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <optional>
+
+namespace yabloc::common
+{
+/**
+ * Pair two kinds of messages which have exactly the same stamp
+ *
+ * Unlike message_filters::ApproximateTime, it holds only the messages which wait for their partner,
+ * keyed by their stamps. It assumes that each topic is received in the order of stamps.
+ * The capacity must be larger than the lag between the two topics in frames, or the messages are
+ * evicted before their partner arrives.
+ */
+template <typename Msg1, typename Msg2>
+class ExactStampSynchronizer
+{
+public:
+  using Msg1ConstPtr = typename Msg1::ConstSharedPtr;
+  using Msg2ConstPtr = typename Msg2::ConstSharedPtr;
+  using UserCallback = std::function<void(const Msg1 &, const Msg2 &)>;
+  // The same as the queue of SynchroSubscriber
+  static constexpr size_t DEFAULT_CAPACITY = 80;
+
+  // All counts are per stamp, i.e. per camera frame
+  struct Counter
+  {
+    // Pairs which are passed to the callback
+    size_t matched{0};
+    // Messages which are discarded because their partner did not come in time
+    size_t unmatched{0};
+    // Messages which are discarded on arrival because they are older than the last pair
+    size_t dropped{0};
+  };
+
+  explicit ExactStampSynchronizer(size_t capacity) : capacity_(capacity) {}
+
+  void set_callback(const UserCallback & callback) { user_callback_ = callback; }
+
+  void add(const Msg1ConstPtr & msg) { add_impl(msg, nullptr); }
+
+  void add(const Msg2ConstPtr & msg) { add_impl(nullptr, msg); }
+
+  const Counter & counter() const { return counter_; }
+
+  size_t size() const { return entries_.size(); }
+
+  // Return true if a message of the stamp waits for its partner, i.e. the partner is not stored
+  bool is_waiting(const rclcpp::Time & stamp) const
+  {
+    return entries_.count(stamp.nanoseconds()) > 0;
+  }
+
+private:
+  struct Entry
+  {
+    Msg1ConstPtr msg1{nullptr};
+    Msg2ConstPtr msg2{nullptr};
+  };
+
+  const size_t capacity_;
+  std::map<int64_t, Entry> entries_;
+  std::optional<int64_t> last_matched_stamp_{std::nullopt};
+  std::optional<UserCallback> user_callback_{std::nullopt};
+  Counter counter_;
+
+  template <typename T>
+  static int64_t to_nanoseconds(const T & msg)
+  {
+    return rclcpp::Time(msg->header.stamp).nanoseconds();
+  }
+
+  void add_impl(const Msg1ConstPtr & msg1, const Msg2ConstPtr & msg2)
+  {
+    const int64_t stamp = msg1 ? to_nanoseconds(msg1) : to_nanoseconds(msg2);
+    if (last_matched_stamp_.has_value() && stamp <= last_matched_stamp_.value()) {
+      counter_.dropped++;
+      return;
+    }
+
+    Entry & entry = entries_[stamp];
+    if (msg1) entry.msg1 = msg1;
+    if (msg2) entry.msg2 = msg2;
+
+    if (entry.msg1 && entry.msg2) {
+      const Entry matched = entry;
+      entries_.erase(stamp);
+      counter_.matched++;
+      last_matched_stamp_ = stamp;
+      erase_older_than(stamp);
+      if (user_callback_.has_value()) user_callback_.value()(*matched.msg1, *matched.msg2);
+      return;
+    }
+
+    // Evict the oldest one
+    if (entries_.size() > capacity_) {
+      counter_.unmatched++;
+      entries_.erase(entries_.begin());
+    }
+  }
+
+  // Since each topic arrives in order, messages older than the last pair never find the partner
+  void erase_older_than(int64_t stamp)
+  {
+    const auto end = entries_.lower_bound(stamp);
+    counter_.unmatched += std::distance(entries_.begin(), end);
+    entries_.erase(entries_.begin(), end);
+  }
+};
+}  // namespace yabloc::common
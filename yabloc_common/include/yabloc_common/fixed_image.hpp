@@ -0,0 +1,103 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include <opencv4/opencv2/core.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <sensor_msgs/msg/image.hpp>
+#include <std_msgs/msg/header.hpp>
+#include <yabloc_image_msgs/msg/fixed_image.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace yabloc::common
+{
+// Image of a received message. `image` refers to the memory of the message without copying it.
+struct ImageFrame
+{
+  using ConstSharedPtr = std::shared_ptr<const ImageFrame>;
+  std_msgs::msg::Header header;
+  cv::Mat image;
+};
+
+/**
+ * Publish CV_8UC1 or CV_8UC3 images as sensor_msgs/Image, or as loaned FixedImage
+ *
+ * If `use_fixed_image` is true and the middleware can loan FixedImage, the image is written into
+ * a loaned message on "<topic>/fixed", which shared-memory middlewares deliver without copies.
+ * sensor_msgs/Image is still published on `topic` for its own subscribers, such as monitors.
+ * Otherwise only sensor_msgs/Image is published, by common::publish_image().
+ */
+class ImagePublisher
+{
+public:
+  using Image = sensor_msgs::msg::Image;
+  using FixedImage = yabloc_image_msgs::msg::FixedImage;
+
+  ImagePublisher(
+    rclcpp::Node * node, const std::string & topic, bool use_fixed_image,
+    const rclcpp::QoS & qos = rclcpp::QoS(10));
+
+  // Throw std::runtime_error if FixedImage is used and the image exceeds its MAX_DATA_SIZE
+  void publish(
+    const cv::Mat & image, const rclcpp::Time & stamp, const std::string & frame_id = "map");
+
+private:
+  rclcpp::Publisher<Image>::SharedPtr pub_image_;
+  rclcpp::Publisher<FixedImage>::SharedPtr pub_fixed_image_{nullptr};
+};
+
+/**
+ * Subscribe images published by ImagePublisher
+ *
+ * If `use_fixed_image` is true and the middleware can loan FixedImage, "<topic>/fixed" is
+ * subscribed instead of `topic`. Both sides decide it by the same middleware capability, so the
+ * publisher and the subscribers agree as long as they have the same `use_fixed_image`.
+ *
+ * The frame passed to the callback is valid only in the callback, since a loaned message is
+ * returned to the middleware after it. Clone the image to keep it.
+ */
+class ImageSubscriber
+{
+public:
+  using Image = sensor_msgs::msg::Image;
+  using FixedImage = yabloc_image_msgs::msg::FixedImage;
+  using Callback = std::function<void(const ImageFrame &)>;
+
+  ImageSubscriber(
+    rclcpp::Node * node, const std::string & topic, bool use_fixed_image, Callback callback,
+    const rclcpp::QoS & qos = rclcpp::QoS(10));
+
+  bool uses_fixed_image() const { return sub_fixed_image_ != nullptr; }
+
+private:
+  rclcpp::Subscription<Image>::SharedPtr sub_image_{nullptr};
+  rclcpp::Subscription<FixedImage>::SharedPtr sub_fixed_image_{nullptr};
+};
+
+// Return true if the image fits in FixedImage
+bool fits_fixed_image(const cv::Mat & image);
+
+// Copy CV_8UC1 or CV_8UC3 image into `msg`. The image must fit in it.
+void fill_fixed_image_msg(
+  yabloc_image_msgs::msg::FixedImage & msg, const cv::Mat & image, const rclcpp::Time & stamp);
+
+// Refer to the pixels of the message without copying them
+ImageFrame to_image_frame(const yabloc_image_msgs::msg::FixedImage & msg);
+ImageFrame to_image_frame(const sensor_msgs::msg::Image & msg);
+}  // namespace yabloc::common
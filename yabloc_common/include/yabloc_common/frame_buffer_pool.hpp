@@ -0,0 +1,65 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <opencv4/opencv2/core.hpp>
+
+#include <sensor_msgs/msg/camera_info.hpp>
+
+#include <vector>
+
+namespace yabloc::common
+{
+/**
+ * Per-node set of cv::Mat which are reused across frames.
+ *
+ * Each image processing stage writes its output into a fixed slot instead of a fresh cv::Mat.
+ * Storage is allocated only when the camera resolution (or the requested type) changes,
+ * so steady-state processing does not touch the heap for these buffers.
+ *
+ * Only the images are pooled. Outputs whose size changes every frame, such as the lines of
+ * cv::LineSegmentDetector, and the messages handed over to the middleware are still allocated.
+ */
+class FrameBufferPool
+{
+public:
+  using CameraInfo = sensor_msgs::msg::CameraInfo;
+
+  explicit FrameBufferPool(size_t slot_count);
+
+  // Set frame size from camera_info. Buffers are re-allocated lazily only if the size changes
+  void reserve(const CameraInfo & info);
+  void reserve(const cv::Size & frame_size);
+
+  bool is_ready() const;
+
+  cv::Size frame_size() const;
+
+  /**
+   * Get the buffer of the specified slot
+   *
+   * @param[in] slot index of the buffer (must be less than slot_count)
+   * @param[in] type OpenCV matrix type such as CV_8UC1
+   * @param[in] scale ratio of the buffer size to the frame size
+   * @return reference to the buffer whose size and type are guaranteed
+   */
+  cv::Mat & buffer(size_t slot, int type, double scale = 1.0);
+
+  cv::Mat & buffer(size_t slot, const cv::Size & size, int type);
+
+private:
+  cv::Size frame_size_;
+  std::vector<cv::Mat> buffers_;
+};
+}  // namespace yabloc::common
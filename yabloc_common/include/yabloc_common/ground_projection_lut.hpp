@@ -0,0 +1,79 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Geometry>
+#include <opencv4/opencv2/core.hpp>
+
+#include <optional>
+
+namespace yabloc::common
+{
+/**
+ * Project a pixel onto the flat ground of base_link
+ *
+ * @param[in] Kinv inverse of the camera intrinsic matrix
+ * @param[in] extrinsic camera pose in base_link
+ * @param[in] u pixel coordinate
+ * @return the point on the ground, or nullopt if the ray does not hit the ground
+ */
+std::optional<Eigen::Vector3f> project_to_ground(
+  const Eigen::Matrix3f & Kinv, const Eigen::Affine3f & extrinsic, const Eigen::Vector2f & u);
+
+/**
+ * Per-pixel look-up table of project_to_ground()
+ *
+ * The table holds the ground points of every `step` pixels and interpolates them bilinearly.
+ * It is rebuilt only when the image size, the intrinsic or the extrinsic changes.
+ * Pixels outside of the image are projected exactly without the table.
+ *
+ * TODO: This will take into account ground tilt and camera vibration someday.
+ */
+class GroundProjectionLut
+{
+public:
+  explicit GroundProjectionLut(int step = 1);
+
+  // Return true if the table is rebuilt
+  bool update(
+    const cv::Size & image_size, const Eigen::Matrix3f & intrinsic,
+    const Eigen::Affine3f & extrinsic);
+
+  bool is_ready() const { return !table_.empty(); }
+
+  std::optional<Eigen::Vector3f> operator()(float u, float v) const;
+
+  // NOTE: u.z() is ignored. This overload accepts endpoints of line segments cloud as they are.
+  std::optional<Eigen::Vector3f> operator()(const Eigen::Vector3f & u) const
+  {
+    return (*this)(u.x(), u.y());
+  }
+
+  std::optional<Eigen::Vector3f> operator()(const cv::Point2i & u) const
+  {
+    return (*this)(static_cast<float>(u.x), static_cast<float>(u.y));
+  }
+
+private:
+  const int step_;
+  cv::Size image_size_;
+  Eigen::Matrix3f intrinsic_;
+  Eigen::Affine3f extrinsic_;
+  // Rotation of the extrinsic times the inverse of the intrinsic, which maps pixels to rays
+  Eigen::Matrix3f ray_matrix_;
+
+  // CV_32FC2 ground (x,y) at every `step_` pixels. NaN if the ray does not hit the ground.
+  cv::Mat table_;
+};
+}  // namespace yabloc::common
@@ -0,0 +1,142 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Core>
+#include <rclcpp/rclcpp.hpp>
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+namespace yabloc::common
+{
+struct LineSegment
+{
+  Eigen::Vector3f from;
+  Eigen::Vector3f to;
+  uint32_t label{0};
+};
+
+/**
+ * Read-only view of line segments stored in a PointCloud2, without any conversion
+ *
+ * The end points are read from the fields "x,y,z" and "normal_x,normal_y,normal_z", and the label
+ * from the optional field "label". Since only these fields are referred to by their offsets, it
+ * accepts both the compact layout made by to_line_segments_msg() and the layout of
+ * pcl::PointNormal or pcl::PointXYZLNormal made by pcl::toROSMsg().
+ *
+ * The view refers to the buffer of the message, so the message must outlive the view.
+ */
+class LineSegmentsView
+{
+public:
+  using PointCloud2 = sensor_msgs::msg::PointCloud2;
+  using ConstVector3fMap = Eigen::Map<const Eigen::Vector3f>;
+
+  // Throw std::runtime_error if the message does not have the end point fields
+  explicit LineSegmentsView(const PointCloud2 & msg);
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  bool has_label() const { return label_offset_ >= 0; }
+
+  ConstVector3fMap from(size_t i) const
+  {
+    return ConstVector3fMap(reinterpret_cast<const float *>(at(i) + from_offset_));
+  }
+
+  ConstVector3fMap to(size_t i) const
+  {
+    return ConstVector3fMap(reinterpret_cast<const float *>(at(i) + to_offset_));
+  }
+
+  // Return 0 if the message does not have the label field
+  uint32_t label(size_t i) const
+  {
+    if (label_offset_ < 0) return 0;
+    return *reinterpret_cast<const uint32_t *>(at(i) + label_offset_);
+  }
+
+  LineSegment operator[](size_t i) const { return {from(i), to(i), label(i)}; }
+
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = LineSegment;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const LineSegment *;
+    using reference = LineSegment;
+
+    const_iterator(const LineSegmentsView * view, size_t index) : view_(view), index_(index) {}
+    LineSegment operator*() const { return (*view_)[index_]; }
+    const_iterator & operator++()
+    {
+      ++index_;
+      return *this;
+    }
+    bool operator==(const const_iterator & other) const { return index_ == other.index_; }
+    bool operator!=(const const_iterator & other) const { return index_ != other.index_; }
+
+  private:
+    const LineSegmentsView * view_;
+    size_t index_;
+  };
+
+  const_iterator begin() const { return {this, 0}; }
+  const_iterator end() const { return {this, size_}; }
+
+private:
+  const uint8_t * data_;
+  size_t size_;
+  size_t point_step_;
+  int from_offset_;
+  int to_offset_;
+  int label_offset_;
+
+  const uint8_t * at(size_t i) const { return data_ + i * point_step_; }
+};
+
+/**
+ * Pack line segments into the compact layout of PointCloud2
+ *
+ * Each segment occupies 24 bytes (6 x float32), or 28 bytes with the label, instead of 48 bytes
+ * of the padded pcl point types. The field names are the same as pcl::PointNormal, so
+ * pcl::fromROSMsg() and rviz still accept it.
+ */
+sensor_msgs::msg::PointCloud2 to_line_segments_msg(
+  const pcl::PointCloud<pcl::PointNormal> & cloud, const rclcpp::Time & stamp,
+  const std::string & frame_id = "map");
+
+sensor_msgs::msg::PointCloud2 to_line_segments_msg(
+  const pcl::PointCloud<pcl::PointXYZLNormal> & cloud, const rclcpp::Time & stamp,
+  const std::string & frame_id = "map");
+
+template <typename PointT>
+void publish_line_segments(
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2> & publisher,
+  const pcl::PointCloud<PointT> & cloud, const rclcpp::Time & stamp)
+{
+  publisher.publish(to_line_segments_msg(cloud, stamp));
+}
+
+// Copy the viewed segments into a pcl cloud, for the consumers which still need it
+pcl::PointCloud<pcl::PointNormal> to_point_normal_cloud(const LineSegmentsView & view);
+}  // namespace yabloc::common
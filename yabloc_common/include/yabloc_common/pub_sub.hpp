@@ -24,9 +24,16 @@
 
 namespace yabloc::common
 {
+/**
+ * Publish CV_8UC1 or CV_8UC3 image
+ *
+ * The image is copied into a message once and handed over as unique_ptr, so that
+ * intra-process subscribers receive it without further copies. sensor_msgs/Image is never loaned
+ * by the middleware; use ImagePublisher in fixed_image.hpp for the loaned path.
+ */
 void publish_image(
   rclcpp::Publisher<sensor_msgs::msg::Image> & publisher, const cv::Mat & image,
-  const rclcpp::Time & stamp);
+  const rclcpp::Time & stamp, const std::string & frame_id = "map");
 
 template <typename PointT>
 void publish_cloud(
@@ -0,0 +1,116 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <rclcpp/rclcpp.hpp>
+
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+#include <std_msgs/msg/string.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace yabloc::common
+{
+/**
+ * Fixed set of named numeric fields
+ *
+ * The fields are registered once, and then set() only stores the value, so it can be called at
+ * the sensor rate. The values are formatted only when format() or key_values() is called.
+ */
+class StatusFields
+{
+public:
+  using KeyValues = std::vector<std::pair<std::string, std::string>>;
+
+  // Return the index of the field, which is passed to set()
+  size_t add(const std::string & name, int precision = 3, const std::string & unit = "");
+  // The value is shown as labels[value], e.g. for an enumeration
+  size_t add_label(const std::string & name, const std::vector<std::string> & labels);
+
+  void set(size_t index, double value)
+  {
+    Field & field = fields_[index];
+    field.value.store(value, std::memory_order_relaxed);
+    field.recorded.store(true, std::memory_order_relaxed);
+  }
+
+  size_t size() const { return fields_.size(); }
+
+  // "--- title ----" and then "name: value unit" for each field. "-" if it is not set yet.
+  std::string format(const std::string & title) const;
+  KeyValues key_values() const;
+
+private:
+  struct Field
+  {
+    Field(const std::string & name, int precision, const std::string & unit)
+    : name(name), precision(precision), unit(unit)
+    {
+    }
+    std::string name;
+    int precision;
+    std::string unit;
+    std::vector<std::string> labels;
+    std::atomic<double> value{0};
+    std::atomic<bool> recorded{false};
+  };
+  // NOTE: std::deque does not move the elements on emplace_back()
+  std::deque<Field> fields_;
+
+  std::string format_value(const Field & field) const;
+};
+
+/**
+ * Publish the status fields of a node at a low rate
+ *
+ * The fields are published as std_msgs/String on the topic, and as diagnostic_msgs on
+ * /diagnostics, every period. Hot callbacks only record the values by set().
+ */
+class StatusReporter
+{
+public:
+  using String = std_msgs::msg::String;
+  using DiagnosticArray = diagnostic_msgs::msg::DiagnosticArray;
+
+  StatusReporter(
+    rclcpp::Node * node, const std::string & topic, const std::string & title,
+    std::chrono::nanoseconds period = std::chrono::seconds(1));
+
+  size_t add(const std::string & name, int precision = 3, const std::string & unit = "")
+  {
+    return fields_.add(name, precision, unit);
+  }
+  size_t add_label(const std::string & name, const std::vector<std::string> & labels)
+  {
+    return fields_.add_label(name, labels);
+  }
+  void set(size_t index, double value) { fields_.set(index, value); }
+
+  void publish();
+
+private:
+  const std::string title_;
+  const std::string hardware_id_;
+  rclcpp::Clock::SharedPtr clock_;
+  StatusFields fields_;
+  rclcpp::Publisher<String>::SharedPtr pub_string_;
+  rclcpp::Publisher<DiagnosticArray>::SharedPtr pub_diagnostics_;
+  rclcpp::TimerBase::SharedPtr timer_;
+};
+}  // namespace yabloc::common
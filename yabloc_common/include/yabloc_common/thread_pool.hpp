@@ -0,0 +1,62 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yabloc::common
+{
+/**
+ * Fixed set of worker threads for data parallel loops
+ *
+ * parallel_for() blocks until every index is processed. Each index is processed exactly once, so
+ * writing the result of index i to the i-th element of a pre-sized vector and reducing it on the
+ * calling thread afterwards gives the same result regardless of the scheduling.
+ * parallel_for() must not be called from several threads at once.
+ */
+class ThreadPool
+{
+public:
+  // If thread_count is 0, the number of hardware threads is used
+  explicit ThreadPool(size_t thread_count = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool & operator=(const ThreadPool &) = delete;
+
+  size_t size() const { return workers_.size(); }
+
+  void parallel_for(size_t count, const std::function<void(size_t)> & function);
+
+private:
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable job_available_;
+  std::condition_variable job_done_;
+
+  // The current job, which is shared by all workers
+  const std::function<void(size_t)> * function_{nullptr};
+  size_t count_{0};
+  size_t next_index_{0};
+  size_t finished_count_{0};
+  size_t generation_{0};
+  bool stop_{false};
+
+  void work();
+};
+}  // namespace yabloc::common
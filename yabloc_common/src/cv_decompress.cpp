@@ -23,35 +23,47 @@
 
 namespace yabloc::common
 {
-cv::Mat decompress_image(const sensor_msgs::msg::CompressedImage & compressed_img)
+namespace
+{
+void decode_image(const sensor_msgs::msg::CompressedImage & compressed_img, cv::Mat & dst)
 {
-  cv::Mat raw_image;
-
   const std::string & format = compressed_img.format;
   const std::string encoding = format.substr(0, format.find(";"));
 
   constexpr int DECODE_GRAY = 0;
   constexpr int DECODE_RGB = 1;
 
+  // NOTE: This refers to the message buffer without copying it
+  const cv::Mat buffer(compressed_img.data);
+
+  // NOTE: imdecode() re-allocates `dst` only if its size or type is different
   bool encoding_is_bayer = encoding.find("bayer") != std::string::npos;
   if (!encoding_is_bayer) {
-    return cv::imdecode(cv::Mat(compressed_img.data), DECODE_RGB);
+    cv::imdecode(buffer, DECODE_RGB, &dst);
+    return;
   }
 
-  raw_image = cv::imdecode(cv::Mat(compressed_img.data), DECODE_GRAY);
+  cv::Mat raw_image = cv::imdecode(buffer, DECODE_GRAY);
   if (encoding == "bayer_rggb8")
-    cv::cvtColor(raw_image, raw_image, cv::COLOR_BayerBG2BGR);
+    cv::cvtColor(raw_image, dst, cv::COLOR_BayerBG2BGR);
   else if (encoding == "bayer_bggr8")
-    cv::cvtColor(raw_image, raw_image, cv::COLOR_BayerRG2BGR);
+    cv::cvtColor(raw_image, dst, cv::COLOR_BayerRG2BGR);
   else if (encoding == "bayer_grbg8")
-    cv::cvtColor(raw_image, raw_image, cv::COLOR_BayerGB2BGR);
+    cv::cvtColor(raw_image, dst, cv::COLOR_BayerGB2BGR);
   else if (encoding == "bayer_gbrg8")
-    cv::cvtColor(raw_image, raw_image, cv::COLOR_BayerGR2BGR);
+    cv::cvtColor(raw_image, dst, cv::COLOR_BayerGR2BGR);
   else {
     std::cerr << encoding << " is not supported encoding" << std::endl;
     std::cerr << "Please implement additional decoding in " << __FUNCTION__ << std::endl;
     exit(EXIT_FAILURE);
   }
+}
+}  // namespace
+
+cv::Mat decompress_image(const sensor_msgs::msg::CompressedImage & compressed_img)
+{
+  cv::Mat raw_image;
+  decode_image(compressed_img, raw_image);
   return raw_image;
 }
 
@@ -60,11 +72,22 @@ cv::Mat decompress_to_cv_mat(const sensor_msgs::msg::CompressedImage & compresse
   return decompress_image(compressed_img);
 }
 
+void decompress_to_cv_mat(const sensor_msgs::msg::CompressedImage & compressed_img, cv::Mat & dst)
+{
+  decode_image(compressed_img, dst);
+}
+
 cv::Mat decompress_to_cv_mat(const sensor_msgs::msg::Image & img)
 {
   return cv_bridge::toCvCopy(std::make_shared<sensor_msgs::msg::Image>(img), img.encoding)->image;
 }
 
+void decompress_to_cv_mat(const sensor_msgs::msg::Image & img, cv::Mat & dst)
+{
+  // NOTE: toCvShare() does not copy the pixels because the encoding is the same
+  cv_bridge::toCvShare(img, nullptr, img.encoding)->image.copyTo(dst);
+}
+
 sensor_msgs::msg::Image::ConstSharedPtr decompress_to_ros_msg(
   const sensor_msgs::msg::CompressedImage & compressed_img, const std::string & encoding)
 {
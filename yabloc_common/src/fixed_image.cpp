@@ -0,0 +1,138 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/fixed_image.hpp"
+
+#include "yabloc_common/pub_sub.hpp"
+
+#include <cv_bridge/cv_bridge.h>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace yabloc::common
+{
+using FixedImage = yabloc_image_msgs::msg::FixedImage;
+
+namespace
+{
+std::string fixed_topic_name(rclcpp::Node * node, const std::string & topic)
+{
+  // NOTE: Resolve the remapping of `topic` first, so that "<topic>/fixed" follows it
+  return node->get_node_topics_interface()->resolve_topic_name(topic) + "/fixed";
+}
+}  // namespace
+
+bool fits_fixed_image(const cv::Mat & image)
+{
+  const size_t size = image.total() * image.elemSize();
+  return size <= FixedImage::MAX_DATA_SIZE;
+}
+
+void fill_fixed_image_msg(FixedImage & msg, const cv::Mat & image, const rclcpp::Time & stamp)
+{
+  if (image.type() != CV_8UC1 && image.type() != CV_8UC3) {
+    throw std::runtime_error("FixedImage can hold only CV_8UC1 or CV_8UC3");
+  }
+  if (!fits_fixed_image(image)) {
+    throw std::runtime_error("image is too large for FixedImage");
+  }
+
+  msg.stamp = stamp;
+  msg.height = image.rows;
+  msg.width = image.cols;
+  msg.encoding = (image.channels() == 3) ? FixedImage::BGR8 : FixedImage::MONO8;
+  msg.step = image.cols * image.elemSize();
+
+  if (image.isContinuous()) {
+    std::memcpy(msg.data.data(), image.data, msg.step * image.rows);
+    return;
+  }
+  for (int r = 0; r < image.rows; r++) {
+    std::memcpy(msg.data.data() + r * msg.step, image.ptr(r), msg.step);
+  }
+}
+
+ImageFrame to_image_frame(const FixedImage & msg)
+{
+  int type = CV_8UC1;
+  if (msg.encoding == FixedImage::BGR8)
+    type = CV_8UC3;
+  else if (msg.encoding != FixedImage::MONO8)
+    throw std::runtime_error("FixedImage has unknown encoding");
+
+  ImageFrame frame;
+  frame.header.stamp = msg.stamp;
+  // NOTE: cv::Mat takes a non-const pointer, but the frame is passed to the callback as const
+  frame.image =
+    cv::Mat(msg.height, msg.width, type, const_cast<uint8_t *>(msg.data.data()), msg.step);
+  return frame;
+}
+
+ImageFrame to_image_frame(const sensor_msgs::msg::Image & msg)
+{
+  ImageFrame frame;
+  frame.header = msg.header;
+  frame.image = cv::Mat(
+    msg.height, msg.width, cv_bridge::getCvType(msg.encoding),
+    const_cast<uint8_t *>(msg.data.data()), msg.step);
+  return frame;
+}
+
+ImagePublisher::ImagePublisher(
+  rclcpp::Node * node, const std::string & topic, bool use_fixed_image, const rclcpp::QoS & qos)
+{
+  pub_image_ = node->create_publisher<Image>(topic, qos);
+  if (use_fixed_image) {
+    pub_fixed_image_ = node->create_publisher<FixedImage>(fixed_topic_name(node, topic), qos);
+  }
+}
+
+void ImagePublisher::publish(
+  const cv::Mat & image, const rclcpp::Time & stamp, const std::string & frame_id)
+{
+  bool loaned = false;
+  if (pub_fixed_image_ && pub_fixed_image_->can_loan_messages()) {
+    auto msg = pub_fixed_image_->borrow_loaned_message();
+    fill_fixed_image_msg(msg.get(), image, stamp);
+    pub_fixed_image_->publish(std::move(msg));
+    loaned = true;
+  }
+
+  // sensor_msgs/Image is the fallback, and also feeds the subscribers which do not know FixedImage
+  if (!loaned || pub_image_->get_subscription_count() > 0) {
+    publish_image(*pub_image_, image, stamp, frame_id);
+  }
+}
+
+ImageSubscriber::ImageSubscriber(
+  rclcpp::Node * node, const std::string & topic, bool use_fixed_image, Callback callback,
+  const rclcpp::QoS & qos)
+{
+  if (use_fixed_image) {
+    auto on_fixed_image = [callback](const FixedImage & msg) { callback(to_image_frame(msg)); };
+    sub_fixed_image_ = node->create_subscription<FixedImage>(
+      fixed_topic_name(node, topic), qos, std::move(on_fixed_image));
+
+    // The publisher does not publish FixedImage either if the middleware can not loan it
+    if (sub_fixed_image_->can_loan_messages()) return;
+    RCLCPP_WARN_STREAM(
+      node->get_logger(), "FixedImage can not be loaned, so " << topic << " is subscribed");
+    sub_fixed_image_.reset();
+  }
+
+  auto on_image = [callback](const Image & msg) { callback(to_image_frame(msg)); };
+  sub_image_ = node->create_subscription<Image>(topic, qos, std::move(on_image));
+}
+}  // namespace yabloc::common
@@ -0,0 +1,55 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/frame_buffer_pool.hpp"
+
+namespace yabloc::common
+{
+FrameBufferPool::FrameBufferPool(size_t slot_count) : frame_size_(0, 0), buffers_(slot_count) {}
+
+void FrameBufferPool::reserve(const CameraInfo & info)
+{
+  reserve(cv::Size(info.width, info.height));
+}
+
+void FrameBufferPool::reserve(const cv::Size & frame_size)
+{
+  if (frame_size == frame_size_) return;
+  frame_size_ = frame_size;
+  // NOTE: Existing buffers are kept. They will be re-created by buffer() at the next access.
+}
+
+bool FrameBufferPool::is_ready() const { return frame_size_.area() > 0; }
+
+cv::Size FrameBufferPool::frame_size() const { return frame_size_; }
+
+cv::Mat & FrameBufferPool::buffer(size_t slot, int type, double scale)
+{
+  if (!is_ready()) {
+    throw std::runtime_error("frame buffer pool is not reserved but it's accessed");
+  }
+  // NOTE: Rounding is the same as cv::resize() with scale factors
+  const cv::Size size(cvRound(frame_size_.width * scale), cvRound(frame_size_.height * scale));
+  return buffer(slot, size, type);
+}
+
+cv::Mat & FrameBufferPool::buffer(size_t slot, const cv::Size & size, int type)
+{
+  cv::Mat & mat = buffers_.at(slot);
+  // cv::Mat::create() does nothing if both size and type are the same as before
+  mat.create(size, type);
+  return mat;
+}
+
+}  // namespace yabloc::common
@@ -0,0 +1,115 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/ground_projection_lut.hpp"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace yabloc::common
+{
+namespace
+{
+// `ray_matrix` is the rotation of the extrinsic times K^{-1}, and `t` is its translation
+std::optional<Eigen::Vector3f> project_ray_to_ground(
+  const Eigen::Matrix3f & ray_matrix, const Eigen::Vector3f & t, const Eigen::Vector2f & u)
+{
+  Eigen::Vector3f u3(u.x(), u.y(), 1);
+  Eigen::Vector3f u_bearing = (ray_matrix * u3).normalized();
+  if (u_bearing.z() > -0.01) return std::nullopt;
+  float u_distance = -t.z() / u_bearing.z();
+  Eigen::Vector3f v;
+  v.x() = t.x() + u_bearing.x() * u_distance;
+  v.y() = t.y() + u_bearing.y() * u_distance;
+  v.z() = 0;
+  return v;
+}
+}  // namespace
+
+std::optional<Eigen::Vector3f> project_to_ground(
+  const Eigen::Matrix3f & Kinv, const Eigen::Affine3f & extrinsic, const Eigen::Vector2f & u)
+{
+  // NOTE: linear() is the rotation of a rigid transform. rotation() would run an SVD.
+  return project_ray_to_ground(extrinsic.linear() * Kinv, extrinsic.translation(), u);
+}
+
+GroundProjectionLut::GroundProjectionLut(int step) : step_(step)
+{
+  if (step_ < 1) throw std::runtime_error("step of GroundProjectionLut must be positive");
+}
+
+bool GroundProjectionLut::update(
+  const cv::Size & image_size, const Eigen::Matrix3f & intrinsic, const Eigen::Affine3f & extrinsic)
+{
+  if (
+    is_ready() && image_size == image_size_ && intrinsic == intrinsic_ &&
+    extrinsic.matrix() == extrinsic_.matrix()) {
+    return false;
+  }
+
+  image_size_ = image_size;
+  intrinsic_ = intrinsic;
+  extrinsic_ = extrinsic;
+  ray_matrix_ = extrinsic.linear() * intrinsic.inverse();
+
+  // One more node than needed so that the last pixel always has its right and bottom neighbors
+  const int cols = (image_size.width - 1) / step_ + 2;
+  const int rows = (image_size.height - 1) / step_ + 2;
+  table_.create(rows, cols, CV_32FC2);
+
+  constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+  const Eigen::Vector3f t = extrinsic.translation();
+  for (int r = 0; r < rows; r++) {
+    cv::Vec2f * ptr = table_.ptr<cv::Vec2f>(r);
+    for (int c = 0; c < cols; c++) {
+      const Eigen::Vector2f u(static_cast<float>(c * step_), static_cast<float>(r * step_));
+      const std::optional<Eigen::Vector3f> opt = project_ray_to_ground(ray_matrix_, t, u);
+      ptr[c] = opt.has_value() ? cv::Vec2f(opt->x(), opt->y()) : cv::Vec2f(nan, nan);
+    }
+  }
+  return true;
+}
+
+std::optional<Eigen::Vector3f> GroundProjectionLut::operator()(float u, float v) const
+{
+  if (!is_ready()) throw std::runtime_error("GroundProjectionLut is not ready but it's accessed");
+
+  const float fu = u / step_;
+  const float fv = v / step_;
+  const int c = static_cast<int>(std::floor(fu));
+  const int r = static_cast<int>(std::floor(fv));
+  if (c < 0 || r < 0 || c + 1 >= table_.cols || r + 1 >= table_.rows) {
+    return project_ray_to_ground(ray_matrix_, extrinsic_.translation(), Eigen::Vector2f(u, v));
+  }
+
+  const float du = fu - c;
+  const float dv = fv - r;
+  const float weights[4] = {(1 - du) * (1 - dv), du * (1 - dv), (1 - du) * dv, du * dv};
+  const cv::Vec2f * upper = table_.ptr<cv::Vec2f>(r) + c;
+  const cv::Vec2f * lower = table_.ptr<cv::Vec2f>(r + 1) + c;
+  const cv::Vec2f corners[4] = {upper[0], upper[1], lower[0], lower[1]};
+
+  Eigen::Vector3f ground = Eigen::Vector3f::Zero();
+  for (int i = 0; i < 4; i++) {
+    // NOTE: Corners of zero weight must be skipped, since 0 * NaN is NaN
+    if (weights[i] <= 0) continue;
+    if (std::isnan(corners[i][0])) return std::nullopt;
+    ground.x() += weights[i] * corners[i][0];
+    ground.y() += weights[i] * corners[i][1];
+  }
+  return ground;
+}
+
+}  // namespace yabloc::common
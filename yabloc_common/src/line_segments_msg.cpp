@@ -0,0 +1,154 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/line_segments_msg.hpp"
+
+#include <sensor_msgs/msg/point_field.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace yabloc::common
+{
+using PointField = sensor_msgs::msg::PointField;
+
+namespace
+{
+// Return the offset of the field, or -1 if it does not exist
+int find_field(const sensor_msgs::msg::PointCloud2 & msg, const std::string & name, uint8_t type)
+{
+  for (const PointField & field : msg.fields) {
+    if (field.name != name) continue;
+    if (field.datatype != type || field.count != 1) {
+      throw std::runtime_error("line segments field '" + name + "' has unexpected type");
+    }
+    return static_cast<int>(field.offset);
+  }
+  return -1;
+}
+
+// Return the offset of three consecutive float32 fields
+int find_vector3f_field(
+  const sensor_msgs::msg::PointCloud2 & msg, const std::string & x, const std::string & y,
+  const std::string & z)
+{
+  const int offset_x = find_field(msg, x, PointField::FLOAT32);
+  const int offset_y = find_field(msg, y, PointField::FLOAT32);
+  const int offset_z = find_field(msg, z, PointField::FLOAT32);
+  if (offset_x < 0 || offset_y != offset_x + 4 || offset_z != offset_x + 8) {
+    throw std::runtime_error("line segments message does not have consecutive " + x + y + z);
+  }
+  return offset_x;
+}
+}  // namespace
+
+LineSegmentsView::LineSegmentsView(const PointCloud2 & msg)
+: data_(msg.data.data()),
+  size_(static_cast<size_t>(msg.width) * msg.height),
+  point_step_(msg.point_step),
+  from_offset_(find_vector3f_field(msg, "x", "y", "z")),
+  to_offset_(find_vector3f_field(msg, "normal_x", "normal_y", "normal_z")),
+  label_offset_(find_field(msg, "label", PointField::UINT32))
+{
+  if (msg.is_bigendian) {
+    throw std::runtime_error("big endian line segments message is not supported");
+  }
+  if (msg.height > 1 && msg.row_step != msg.width * msg.point_step) {
+    throw std::runtime_error("line segments message must not have row padding");
+  }
+  if (msg.data.size() < size_ * point_step_) {
+    throw std::runtime_error("line segments message is shorter than its width and height");
+  }
+}
+
+template <typename PointT>
+sensor_msgs::msg::PointCloud2 to_line_segments_msg_impl(
+  const pcl::PointCloud<PointT> & cloud, const rclcpp::Time & stamp,
+  const std::string & frame_id, bool with_label)
+{
+  sensor_msgs::msg::PointCloud2 msg;
+  msg.header.stamp = stamp;
+  msg.header.frame_id = frame_id;
+  msg.height = 1;
+  msg.width = cloud.size();
+  msg.is_bigendian = false;
+  msg.is_dense = true;
+
+  const char * names[] = {"x", "y", "z", "normal_x", "normal_y", "normal_z"};
+  uint32_t offset = 0;
+  for (const char * name : names) {
+    PointField field;
+    field.name = name;
+    field.offset = offset;
+    field.datatype = PointField::FLOAT32;
+    field.count = 1;
+    msg.fields.push_back(field);
+    offset += sizeof(float);
+  }
+  if (with_label) {
+    PointField field;
+    field.name = "label";
+    field.offset = offset;
+    field.datatype = PointField::UINT32;
+    field.count = 1;
+    msg.fields.push_back(field);
+    offset += sizeof(uint32_t);
+  }
+
+  msg.point_step = offset;
+  msg.row_step = msg.point_step * msg.width;
+  msg.data.resize(msg.row_step);
+
+  uint8_t * ptr = msg.data.data();
+  for (const PointT & p : cloud) {
+    std::memcpy(ptr, p.data, 3 * sizeof(float));
+    std::memcpy(ptr + 3 * sizeof(float), p.data_n, 3 * sizeof(float));
+    ptr += msg.point_step;
+  }
+  return msg;
+}
+
+sensor_msgs::msg::PointCloud2 to_line_segments_msg(
+  const pcl::PointCloud<pcl::PointNormal> & cloud, const rclcpp::Time & stamp,
+  const std::string & frame_id)
+{
+  return to_line_segments_msg_impl(cloud, stamp, frame_id, false);
+}
+
+sensor_msgs::msg::PointCloud2 to_line_segments_msg(
+  const pcl::PointCloud<pcl::PointXYZLNormal> & cloud, const rclcpp::Time & stamp,
+  const std::string & frame_id)
+{
+  sensor_msgs::msg::PointCloud2 msg = to_line_segments_msg_impl(cloud, stamp, frame_id, true);
+  uint8_t * ptr = msg.data.data() + 6 * sizeof(float);
+  for (const pcl::PointXYZLNormal & p : cloud) {
+    std::memcpy(ptr, &p.label, sizeof(uint32_t));
+    ptr += msg.point_step;
+  }
+  return msg;
+}
+
+pcl::PointCloud<pcl::PointNormal> to_point_normal_cloud(const LineSegmentsView & view)
+{
+  pcl::PointCloud<pcl::PointNormal> cloud;
+  cloud.reserve(view.size());
+  for (size_t i = 0; i < view.size(); i++) {
+    pcl::PointNormal pn;
+    pn.getVector3fMap() = view.from(i);
+    pn.getNormalVector3fMap() = view.to(i);
+    cloud.push_back(pn);
+  }
+  return cloud;
+}
+}  // namespace yabloc::common
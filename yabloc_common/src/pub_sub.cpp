@@ -14,29 +14,54 @@
 
 #include "yabloc_common/pub_sub.hpp"
 
-#include <cv_bridge/cv_bridge.h>
 #include <pcl_conversions/pcl_conversions.h>
 
+#include <cstring>
+
 namespace yabloc::common
 {
-void publish_image(
-  rclcpp::Publisher<sensor_msgs::msg::Image> & publisher, const cv::Mat & image,
-  const rclcpp::Time & stamp)
+namespace
 {
-  cv_bridge::CvImage raw_image;
-  raw_image.header.stamp = stamp;
-  raw_image.header.frame_id = "map";
+void fill_image_msg(
+  sensor_msgs::msg::Image & msg, const cv::Mat & image, const rclcpp::Time & stamp,
+  const std::string & frame_id)
+{
+  msg.header.stamp = stamp;
+  msg.header.frame_id = frame_id;
+  msg.height = image.rows;
+  msg.width = image.cols;
   if (image.channels() == 3)
-    raw_image.encoding = "bgr8";
+    msg.encoding = "bgr8";
   else
-    raw_image.encoding = "mono8";
+    msg.encoding = "mono8";
+  msg.is_bigendian = false;
+  msg.step = image.cols * image.elemSize();
+  msg.data.resize(msg.step * image.rows);
 
+  if (image.isContinuous()) {
+    std::memcpy(msg.data.data(), image.data, msg.data.size());
+    return;
+  }
+  for (int r = 0; r < image.rows; r++) {
+    std::memcpy(msg.data.data() + r * msg.step, image.ptr(r), msg.step);
+  }
+}
+}  // namespace
+
+void publish_image(
+  rclcpp::Publisher<sensor_msgs::msg::Image> & publisher, const cv::Mat & image,
+  const rclcpp::Time & stamp, const std::string & frame_id)
+{
   if (image.depth() != CV_8U) {
     throw std::runtime_error("publish_image can publish only CV_8U");
   }
 
-  raw_image.image = image;
-  publisher.publish(*raw_image.toImageMsg());
+  // NOTE: sensor_msgs/Image has unbounded data, so it is never loaned by the middleware.
+  // ImagePublisher publishes FixedImage instead when loaning is available.
+  // Copy the image once into a message which the middleware can take over.
+  auto msg = std::make_unique<sensor_msgs::msg::Image>();
+  fill_image_msg(*msg, image, stamp, frame_id);
+  publisher.publish(std::move(msg));
 }
 
 template <typename PointT>
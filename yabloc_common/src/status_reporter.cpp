@@ -0,0 +1,102 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/status_reporter.hpp"
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace yabloc::common
+{
+size_t StatusFields::add(const std::string & name, int precision, const std::string & unit)
+{
+  fields_.emplace_back(name, precision, unit);
+  return fields_.size() - 1;
+}
+
+size_t StatusFields::add_label(const std::string & name, const std::vector<std::string> & labels)
+{
+  fields_.emplace_back(name, 0, "");
+  fields_.back().labels = labels;
+  return fields_.size() - 1;
+}
+
+std::string StatusFields::format_value(const Field & field) const
+{
+  if (!field.recorded.load(std::memory_order_relaxed)) return "-";
+  const double value = field.value.load(std::memory_order_relaxed);
+
+  if (!field.labels.empty()) {
+    const long index = std::lround(value);
+    if (index < 0 || index >= static_cast<long>(field.labels.size())) return "UNKNOWN";
+    return field.labels.at(index);
+  }
+
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(field.precision) << value;
+  if (!field.unit.empty()) ss << " " << field.unit;
+  return ss.str();
+}
+
+std::string StatusFields::format(const std::string & title) const
+{
+  std::stringstream ss;
+  ss << "--- " << title << " ----" << std::endl;
+  for (const Field & field : fields_) {
+    ss << field.name << ": " << format_value(field) << std::endl;
+  }
+  return ss.str();
+}
+
+StatusFields::KeyValues StatusFields::key_values() const
+{
+  KeyValues key_values;
+  for (const Field & field : fields_) key_values.emplace_back(field.name, format_value(field));
+  return key_values;
+}
+
+StatusReporter::StatusReporter(
+  rclcpp::Node * node, const std::string & topic, const std::string & title,
+  std::chrono::nanoseconds period)
+: title_(title), hardware_id_(node->get_fully_qualified_name()), clock_(node->get_clock())
+{
+  pub_string_ = node->create_publisher<String>(topic, 10);
+  pub_diagnostics_ = node->create_publisher<DiagnosticArray>("/diagnostics", 10);
+  timer_ = rclcpp::create_timer(node, clock_, period, [this]() -> void { this->publish(); });
+}
+
+void StatusReporter::publish()
+{
+  String string_msg;
+  string_msg.data = fields_.format(title_);
+  pub_string_->publish(string_msg);
+
+  diagnostic_msgs::msg::DiagnosticStatus status;
+  status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+  status.name = hardware_id_ + ": " + title_;
+  status.hardware_id = hardware_id_;
+  for (const auto & [key, value] : fields_.key_values()) {
+    diagnostic_msgs::msg::KeyValue key_value;
+    key_value.key = key;
+    key_value.value = value;
+    status.values.push_back(key_value);
+  }
+
+  DiagnosticArray array_msg;
+  array_msg.header.stamp = clock_->now();
+  array_msg.status.push_back(status);
+  pub_diagnostics_->publish(array_msg);
+}
+}  // namespace yabloc::common
@@ -0,0 +1,75 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/thread_pool.hpp"
+
+#include <algorithm>
+
+namespace yabloc::common
+{
+ThreadPool::ThreadPool(size_t thread_count)
+{
+  if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+  for (size_t i = 0; i < thread_count; i++) workers_.emplace_back([this] { work(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  job_available_.notify_all();
+  for (std::thread & worker : workers_) worker.join();
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)> & function)
+{
+  if (count == 0) return;
+  if (count == 1) {
+    function(0);
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  function_ = &function;
+  count_ = count;
+  next_index_ = 0;
+  finished_count_ = 0;
+  generation_++;
+  job_available_.notify_all();
+  job_done_.wait(lock, [this] { return finished_count_ == count_; });
+  function_ = nullptr;
+}
+
+void ThreadPool::work()
+{
+  size_t last_generation = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    job_available_.wait(lock, [&] { return stop_ || generation_ != last_generation; });
+    if (stop_) return;
+    last_generation = generation_;
+
+    // Take indices one by one, since the cost of each index can vary
+    while (next_index_ < count_) {
+      const size_t index = next_index_++;
+      lock.unlock();
+      (*function_)(index);
+      lock.lock();
+      if (++finished_count_ == count_) job_done_.notify_one();
+    }
+  }
+}
+}  // namespace yabloc::common
@@ -0,0 +1,141 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/exact_synchro_subscriber.hpp"
+
+#include <sensor_msgs/msg/image.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace common = yabloc::common;
+using Image = sensor_msgs::msg::Image;
+using PointCloud2 = sensor_msgs::msg::PointCloud2;
+using Synchronizer = common::ExactStampSynchronizer<PointCloud2, Image>;
+
+template <typename Msg>
+std::shared_ptr<const Msg> make_msg(int sec)
+{
+  auto msg = std::make_shared<Msg>();
+  msg->header.stamp.sec = sec;
+  return msg;
+}
+
+TEST(ExactSynchroTestSuite, pairSameStamp)
+{
+  Synchronizer synchronizer(4);
+  std::vector<int> paired;
+  synchronizer.set_callback([&paired](const PointCloud2 & cloud, const Image & image) {
+    EXPECT_EQ(cloud.header.stamp, image.header.stamp);
+    paired.push_back(cloud.header.stamp.sec);
+  });
+
+  // Either topic may come first
+  synchronizer.add(make_msg<PointCloud2>(1));
+  synchronizer.add(make_msg<Image>(1));
+  synchronizer.add(make_msg<Image>(2));
+  synchronizer.add(make_msg<PointCloud2>(2));
+
+  EXPECT_EQ(paired, std::vector<int>({1, 2}));
+  EXPECT_EQ(synchronizer.size(), 0u);
+  EXPECT_EQ(synchronizer.counter().matched, 2u);
+  EXPECT_EQ(synchronizer.counter().unmatched, 0u);
+  EXPECT_EQ(synchronizer.counter().dropped, 0u);
+}
+
+TEST(ExactSynchroTestSuite, countUnmatchedAndDropped)
+{
+  Synchronizer synchronizer(2);
+  int paired_count = 0;
+  synchronizer.set_callback(
+    [&paired_count](const PointCloud2 &, const Image &) { paired_count++; });
+
+  // The image of stamp 1 is lost
+  synchronizer.add(make_msg<PointCloud2>(1));
+  synchronizer.add(make_msg<PointCloud2>(2));
+  synchronizer.add(make_msg<Image>(2));
+  EXPECT_EQ(paired_count, 1);
+  EXPECT_EQ(synchronizer.counter().unmatched, 1u);
+  EXPECT_EQ(synchronizer.size(), 0u);
+
+  // Too late
+  synchronizer.add(make_msg<Image>(1));
+  EXPECT_EQ(synchronizer.counter().dropped, 1u);
+
+  // The buffer never exceeds its capacity
+  for (int sec = 3; sec < 10; sec++) synchronizer.add(make_msg<Image>(sec));
+  EXPECT_EQ(synchronizer.size(), 2u);
+  EXPECT_EQ(synchronizer.counter().unmatched, 6u);
+
+  synchronizer.add(make_msg<PointCloud2>(9));
+  EXPECT_EQ(paired_count, 2);
+  EXPECT_EQ(synchronizer.counter().matched, 2u);
+  // The image of stamp 8 never finds its partner
+  EXPECT_EQ(synchronizer.counter().unmatched, 7u);
+  EXPECT_EQ(synchronizer.size(), 0u);
+}
+
+TEST(ExactSynchroTestSuite, pairLaggingTopic)
+{
+  // The masks lag the line segments by several frames, as graph_segment does behind lsd
+  // The line segments of `lag + 1` frames wait for their masks at most
+  constexpr int lag = 6;
+  Synchronizer synchronizer(lag + 1);
+  int paired_count = 0;
+  synchronizer.set_callback(
+    [&paired_count](const PointCloud2 &, const Image &) { paired_count++; });
+
+  for (int sec = 0; sec < 20; sec++) {
+    synchronizer.add(make_msg<PointCloud2>(sec));
+    if (sec >= lag) synchronizer.add(make_msg<Image>(sec - lag));
+  }
+  EXPECT_EQ(paired_count, 20 - lag);
+  EXPECT_EQ(synchronizer.counter().matched, 20u - lag);
+  EXPECT_EQ(synchronizer.counter().unmatched, 0u);
+}
+
+TEST(ExactSynchroTestSuite, evictByLag)
+{
+  // Too small capacity for the lag loses every pair
+  constexpr int lag = 6;
+  Synchronizer synchronizer(lag);
+  int paired_count = 0;
+  synchronizer.set_callback(
+    [&paired_count](const PointCloud2 &, const Image &) { paired_count++; });
+
+  for (int sec = 0; sec < 20; sec++) {
+    synchronizer.add(make_msg<PointCloud2>(sec));
+    if (sec >= lag) synchronizer.add(make_msg<Image>(sec - lag));
+  }
+  EXPECT_EQ(paired_count, 0);
+  EXPECT_EQ(synchronizer.counter().matched, 0u);
+  EXPECT_GT(synchronizer.counter().unmatched, 0u);
+}
+
+TEST(ExactSynchroTestSuite, isWaiting)
+{
+  Synchronizer synchronizer(4);
+  const rclcpp::Time stamp(1, 0, RCL_ROS_TIME);
+  EXPECT_FALSE(synchronizer.is_waiting(stamp));
+
+  // The partner of a waiting message is passed to the callback without being stored
+  synchronizer.add(make_msg<PointCloud2>(1));
+  EXPECT_TRUE(synchronizer.is_waiting(stamp));
+  EXPECT_FALSE(synchronizer.is_waiting(rclcpp::Time(2, 0, RCL_ROS_TIME)));
+
+  synchronizer.add(make_msg<Image>(1));
+  EXPECT_FALSE(synchronizer.is_waiting(stamp));
+}
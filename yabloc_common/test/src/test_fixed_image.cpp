@@ -0,0 +1,56 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/fixed_image.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+namespace common = yabloc::common;
+using FixedImage = yabloc_image_msgs::msg::FixedImage;
+
+TEST(FixedImageTestSuite, roundTrip)
+{
+  cv::Mat image(480, 640, CV_8UC3);
+  cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+  // Non-continuous ROI is copied row by row
+  const cv::Mat roi = image(cv::Rect(10, 20, 600, 400));
+
+  // NOTE: The message is too large to be on the stack
+  auto msg = std::make_unique<FixedImage>();
+  common::fill_fixed_image_msg(*msg, roi, rclcpp::Time(3, 0));
+  EXPECT_EQ(msg->encoding, FixedImage::BGR8);
+  EXPECT_EQ(msg->step, 600u * 3);
+
+  const common::ImageFrame frame = common::to_image_frame(*msg);
+  EXPECT_EQ(rclcpp::Time(frame.header.stamp).seconds(), 3.0);
+  EXPECT_EQ(frame.image.data, msg->data.data());
+  EXPECT_EQ(cv::norm(frame.image, roi, cv::NORM_INF), 0);
+}
+
+TEST(FixedImageTestSuite, rejectLargeImage)
+{
+  // 1920 x 1080 of bgr8 just fits
+  EXPECT_TRUE(common::fits_fixed_image(cv::Mat(1080, 1920, CV_8UC3)));
+  EXPECT_FALSE(common::fits_fixed_image(cv::Mat(1081, 1920, CV_8UC3)));
+
+  auto msg = std::make_unique<FixedImage>();
+  EXPECT_THROW(
+    common::fill_fixed_image_msg(*msg, cv::Mat(1081, 1920, CV_8UC3), rclcpp::Time(0, 0)),
+    std::runtime_error);
+  EXPECT_THROW(
+    common::fill_fixed_image_msg(*msg, cv::Mat(10, 10, CV_32FC1), rclcpp::Time(0, 0)),
+    std::runtime_error);
+}
@@ -0,0 +1,175 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/cv_decompress.hpp"
+#include "yabloc_common/fixed_image.hpp"
+#include "yabloc_common/frame_buffer_pool.hpp"
+
+#include <opencv4/opencv2/imgcodecs.hpp>
+#include <opencv4/opencv2/imgproc.hpp>
+
+#include <gtest/gtest.h>
+
+namespace common = yabloc::common;
+
+// Wrap the default allocator of cv::Mat and count how many times it is called
+class CountingAllocator : public cv::MatAllocator
+{
+public:
+  CountingAllocator() : base_(cv::Mat::getStdAllocator()) {}
+
+  cv::UMatData * allocate(
+    int dims, const int * sizes, int type, void * data, size_t * step, cv::AccessFlag flags,
+    cv::UMatUsageFlags usage_flags) const override
+  {
+    ++count;
+    return base_->allocate(dims, sizes, type, data, step, flags, usage_flags);
+  }
+
+  bool allocate(cv::UMatData * data, cv::AccessFlag flags, cv::UMatUsageFlags usage) const override
+  {
+    return base_->allocate(data, flags, usage);
+  }
+
+  void deallocate(cv::UMatData * data) const override { base_->deallocate(data); }
+
+  mutable int count{0};
+
+private:
+  const cv::MatAllocator * base_;
+};
+
+enum Slot { GRAY = 0, RESIZED, REMAPPED, LINE, MASK, MASKED_LINE, SLOT_COUNT };
+
+// Emulate per-frame processing of lsd, graph_segment, segment_filter and undistort
+void process_frame(
+  common::FrameBufferPool & pool, const cv::Mat & image, const cv::Mat & map_x,
+  const cv::Mat & map_y)
+{
+  cv::Mat & remapped = pool.buffer(REMAPPED, CV_8UC3);
+  cv::remap(image, remapped, map_x, map_y, cv::INTER_LINEAR);
+
+  cv::Mat & gray = pool.buffer(GRAY, CV_8UC1);
+  cv::cvtColor(remapped, gray, cv::COLOR_BGR2GRAY);
+
+  cv::Mat & resized = pool.buffer(RESIZED, CV_8UC3, 0.5);
+  cv::resize(remapped, resized, resized.size());
+
+  cv::Mat & line = pool.buffer(LINE, CV_16UC1);
+  line.setTo(0);
+  cv::line(line, cv::Point2i(10, 10), cv::Point2i(100, 200), cv::Scalar::all(1), 1);
+
+  cv::Mat & mask = pool.buffer(MASK, CV_16UC1);
+  gray.convertTo(mask, CV_16UC1);
+  cv::threshold(mask, mask, 1, std::numeric_limits<ushort>::max(), cv::THRESH_BINARY);
+
+  cv::Mat & masked_line = pool.buffer(MASKED_LINE, CV_16UC1);
+  cv::bitwise_and(mask, line, masked_line);
+}
+
+TEST(FrameBufferPoolTestSuite, reuseBuffer)
+{
+  common::FrameBufferPool pool(SLOT_COUNT);
+  EXPECT_FALSE(pool.is_ready());
+
+  sensor_msgs::msg::CameraInfo info;
+  info.width = 640;
+  info.height = 480;
+  pool.reserve(info);
+  EXPECT_TRUE(pool.is_ready());
+  EXPECT_EQ(pool.frame_size(), cv::Size(640, 480));
+
+  cv::Mat & first = pool.buffer(GRAY, CV_8UC1);
+  const uchar * data = first.data;
+  EXPECT_EQ(pool.buffer(GRAY, CV_8UC1).data, data);
+  EXPECT_EQ(pool.buffer(RESIZED, CV_8UC3, 0.5).size(), cv::Size(320, 240));
+
+  // Resolution change must re-allocate
+  pool.reserve(cv::Size(800, 600));
+  EXPECT_EQ(pool.buffer(GRAY, CV_8UC1).size(), cv::Size(800, 600));
+}
+
+TEST(FrameBufferPoolTestSuite, noAllocationInSteadyState)
+{
+  const cv::Size size(640, 480);
+  cv::Mat image(size, CV_8UC3, cv::Scalar(10, 100, 200));
+  cv::Mat map_x(size, CV_32FC1), map_y(size, CV_32FC1);
+  for (int r = 0; r < size.height; r++) {
+    for (int c = 0; c < size.width; c++) {
+      map_x.at<float>(r, c) = c * 0.9f + 10;
+      map_y.at<float>(r, c) = r * 0.9f + 10;
+    }
+  }
+
+  common::FrameBufferPool pool(SLOT_COUNT);
+  pool.reserve(size);
+
+  CountingAllocator allocator;
+  cv::MatAllocator * default_allocator = cv::Mat::getDefaultAllocator();
+  cv::Mat::setDefaultAllocator(&allocator);
+
+  // Warm up: the first frame allocates all buffers
+  process_frame(pool, image, map_x, map_y);
+  EXPECT_GT(allocator.count, 0);
+
+  allocator.count = 0;
+  for (int i = 0; i < 10; i++) process_frame(pool, image, map_x, map_y);
+  cv::Mat::setDefaultAllocator(default_allocator);
+
+  EXPECT_EQ(allocator.count, 0);
+}
+
+// undistort decodes every incoming frame into a pooled buffer, and the downstream nodes view the
+// received image in place
+TEST(FrameBufferPoolTestSuite, noAllocationInDecompression)
+{
+  const cv::Size size(640, 480);
+  cv::Mat image(size, CV_8UC3);
+  cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+
+  sensor_msgs::msg::CompressedImage compressed_msg;
+  compressed_msg.format = "bgr8; jpeg compressed bgr8";
+  ASSERT_TRUE(cv::imencode(".jpg", image, compressed_msg.data));
+
+  sensor_msgs::msg::Image image_msg;
+  image_msg.height = size.height;
+  image_msg.width = size.width;
+  image_msg.encoding = "bgr8";
+  image_msg.step = size.width * 3;
+  image_msg.data.assign(image.data, image.data + image_msg.step * size.height);
+
+  enum { DECOMPRESSED = 0, DECOMPRESSION_SLOT_COUNT };
+  common::FrameBufferPool pool(DECOMPRESSION_SLOT_COUNT);
+  pool.reserve(size);
+
+  CountingAllocator allocator;
+  cv::MatAllocator * default_allocator = cv::Mat::getDefaultAllocator();
+  cv::Mat::setDefaultAllocator(&allocator);
+
+  cv::Mat viewed;
+  auto process_frame = [&]() -> void {
+    common::decompress_to_cv_mat(compressed_msg, pool.buffer(DECOMPRESSED, CV_8UC3));
+    viewed = common::to_image_frame(image_msg).image;
+  };
+
+  process_frame();
+  allocator.count = 0;
+  for (int i = 0; i < 10; i++) process_frame();
+  cv::Mat::setDefaultAllocator(default_allocator);
+
+  EXPECT_EQ(allocator.count, 0);
+  EXPECT_EQ(pool.buffer(DECOMPRESSED, CV_8UC3).size(), size);
+  EXPECT_EQ(viewed.data, image_msg.data.data());
+  EXPECT_EQ(cv::norm(viewed, image, cv::NORM_INF), 0);
+}
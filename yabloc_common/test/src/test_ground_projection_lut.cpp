@@ -0,0 +1,108 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/ground_projection_lut.hpp"
+
+#include <gtest/gtest.h>
+
+namespace common = yabloc::common;
+
+// A front camera 1.5 m above the ground, looking down slightly
+Eigen::Affine3f make_extrinsic()
+{
+  // optical frame (x:right, y:down, z:forward) in base_link (x:forward, y:left, z:up)
+  Eigen::Matrix3f optical;
+  optical << 0, 0, 1, -1, 0, 0, 0, -1, 0;
+  Eigen::Affine3f extrinsic = Eigen::Affine3f::Identity();
+  extrinsic.linear() =
+    Eigen::AngleAxisf(0.1f, Eigen::Vector3f::UnitY()).toRotationMatrix() * optical;
+  extrinsic.translation() = Eigen::Vector3f(1.0f, 0.0f, 1.5f);
+  return extrinsic;
+}
+
+Eigen::Matrix3f make_intrinsic()
+{
+  Eigen::Matrix3f K;
+  K << 400, 0, 400, 0, 400, 300, 0, 0, 1;
+  return K;
+}
+
+TEST(GroundProjectionLutTestSuite, sameAsExactProjection)
+{
+  const cv::Size size(800, 600);
+  const Eigen::Matrix3f K = make_intrinsic();
+  const Eigen::Affine3f extrinsic = make_extrinsic();
+
+  common::GroundProjectionLut lut;
+  EXPECT_FALSE(lut.is_ready());
+  EXPECT_TRUE(lut.update(size, K, extrinsic));
+  EXPECT_TRUE(lut.is_ready());
+  // Nothing changes
+  EXPECT_FALSE(lut.update(size, K, extrinsic));
+
+  const Eigen::Matrix3f Kinv = K.inverse();
+  int ground_count = 0;
+  for (int v = 0; v < size.height; v += 7) {
+    for (int u = 0; u < size.width; u += 7) {
+      const Eigen::Vector2f query(static_cast<float>(u), static_cast<float>(v));
+      auto expected = common::project_to_ground(Kinv, extrinsic, query);
+      auto actual = lut(cv::Point2i(u, v));
+      ASSERT_EQ(expected.has_value(), actual.has_value());
+      if (!expected.has_value()) continue;
+      EXPECT_TRUE(expected->isApprox(actual.value(), 1e-4f));
+      ground_count++;
+    }
+  }
+  // Both the sky and the ground are in the image
+  EXPECT_GT(ground_count, 0);
+  EXPECT_FALSE(lut(cv::Point2i(400, 0)).has_value());
+
+  // Out of the image is projected exactly
+  auto outside = lut(Eigen::Vector3f(400, 700, 0));
+  ASSERT_TRUE(outside.has_value());
+  EXPECT_TRUE(
+    outside->isApprox(
+      common::project_to_ground(Kinv, extrinsic, Eigen::Vector2f(400.f, 700.f)).value(), 1e-4f));
+}
+
+TEST(GroundProjectionLutTestSuite, subsampledTable)
+{
+  const cv::Size size(800, 600);
+  const Eigen::Matrix3f K = make_intrinsic();
+  const Eigen::Affine3f extrinsic = make_extrinsic();
+  const Eigen::Matrix3f Kinv = K.inverse();
+
+  common::GroundProjectionLut lut(4);
+  lut.update(size, K, extrinsic);
+
+  // Bilinear interpolation is accurate enough within 20 m ahead
+  for (int v = 500; v < size.height; v += 3) {
+    for (int u = 0; u < size.width; u += 3) {
+      const Eigen::Vector3f query(u + 0.5f, v + 0.25f, 0);
+      auto expected = common::project_to_ground(Kinv, extrinsic, query.topRows(2));
+      auto actual = lut(query);
+      ASSERT_TRUE(expected.has_value());
+      ASSERT_TRUE(actual.has_value());
+      EXPECT_LT((expected.value() - actual.value()).norm(), 0.01f);
+    }
+  }
+
+  // Changing the extrinsic rebuilds the table
+  Eigen::Affine3f moved = extrinsic;
+  moved.translation().z() = 2.0f;
+  EXPECT_TRUE(lut.update(size, K, moved));
+  auto expected = common::project_to_ground(Kinv, moved, Eigen::Vector2f(400.f, 552.f));
+  ASSERT_TRUE(expected.has_value());
+  EXPECT_TRUE(expected->isApprox(lut(cv::Point2i(400, 552)).value(), 1e-4f));
+}
@@ -0,0 +1,109 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/line_segments_msg.hpp"
+
+#include <gtest/gtest.h>
+#include <pcl_conversions/pcl_conversions.h>
+
+#include <pcl/common/io.h>
+
+namespace common = yabloc::common;
+
+pcl::PointCloud<pcl::PointXYZLNormal> make_cloud()
+{
+  pcl::PointCloud<pcl::PointXYZLNormal> cloud;
+  for (int i = 0; i < 10; i++) {
+    pcl::PointXYZLNormal pln;
+    pln.getVector3fMap() = Eigen::Vector3f(i, 2 * i, 3 * i);
+    pln.getNormalVector3fMap() = Eigen::Vector3f(-i, i + 0.5f, 1);
+    pln.label = (i % 2 == 0) ? 255 : 0;
+    cloud.push_back(pln);
+  }
+  return cloud;
+}
+
+TEST(LineSegmentsMsgTestSuite, compactLayout)
+{
+  const auto cloud = make_cloud();
+  const sensor_msgs::msg::PointCloud2 msg = common::to_line_segments_msg(cloud, rclcpp::Time(0));
+  EXPECT_EQ(msg.point_step, 28u);
+  EXPECT_EQ(msg.data.size(), 28u * cloud.size());
+
+  const common::LineSegmentsView view(msg);
+  ASSERT_EQ(view.size(), cloud.size());
+  EXPECT_TRUE(view.has_label());
+  for (size_t i = 0; i < cloud.size(); i++) {
+    EXPECT_EQ(view.from(i), cloud.at(i).getVector3fMap());
+    EXPECT_EQ(view.to(i), cloud.at(i).getNormalVector3fMap());
+    EXPECT_EQ(view.label(i), cloud.at(i).label);
+  }
+
+  size_t count = 0;
+  for (const common::LineSegment & segment : view) {
+    EXPECT_EQ(segment.to, cloud.at(count).getNormalVector3fMap());
+    count++;
+  }
+  EXPECT_EQ(count, cloud.size());
+}
+
+TEST(LineSegmentsMsgTestSuite, compactLayoutWithoutLabel)
+{
+  pcl::PointCloud<pcl::PointNormal> cloud;
+  pcl::copyPointCloud(make_cloud(), cloud);
+  const sensor_msgs::msg::PointCloud2 msg = common::to_line_segments_msg(cloud, rclcpp::Time(0));
+  EXPECT_EQ(msg.point_step, 24u);
+
+  const common::LineSegmentsView view(msg);
+  EXPECT_FALSE(view.has_label());
+  for (size_t i = 0; i < cloud.size(); i++) {
+    EXPECT_EQ(view.from(i), cloud.at(i).getVector3fMap());
+    EXPECT_EQ(view.to(i), cloud.at(i).getNormalVector3fMap());
+    EXPECT_EQ(view.label(i), 0u);
+  }
+}
+
+TEST(LineSegmentsMsgTestSuite, legacyLayout)
+{
+  // Messages made by pcl::toROSMsg() are still readable
+  const auto cloud = make_cloud();
+  sensor_msgs::msg::PointCloud2 msg;
+  pcl::toROSMsg(cloud, msg);
+
+  const common::LineSegmentsView view(msg);
+  ASSERT_EQ(view.size(), cloud.size());
+  for (size_t i = 0; i < cloud.size(); i++) {
+    EXPECT_EQ(view.from(i), cloud.at(i).getVector3fMap());
+    EXPECT_EQ(view.to(i), cloud.at(i).getNormalVector3fMap());
+    EXPECT_EQ(view.label(i), cloud.at(i).label);
+  }
+
+  // And compact messages are still readable by pcl::fromROSMsg()
+  pcl::PointCloud<pcl::PointXYZLNormal> restored;
+  pcl::fromROSMsg(common::to_line_segments_msg(cloud, rclcpp::Time(0)), restored);
+  ASSERT_EQ(restored.size(), cloud.size());
+  for (size_t i = 0; i < cloud.size(); i++) {
+    EXPECT_EQ(restored.at(i).getNormalVector3fMap(), cloud.at(i).getNormalVector3fMap());
+    EXPECT_EQ(restored.at(i).label, cloud.at(i).label);
+  }
+}
+
+TEST(LineSegmentsMsgTestSuite, rejectPointCloud)
+{
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  cloud.push_back(pcl::PointXYZ(1, 2, 3));
+  sensor_msgs::msg::PointCloud2 msg;
+  pcl::toROSMsg(cloud, msg);
+  EXPECT_THROW(common::LineSegmentsView{msg}, std::runtime_error);
+}
@@ -0,0 +1,48 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/status_reporter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace common = yabloc::common;
+
+TEST(StatusReporterTestSuite, format)
+{
+  common::StatusFields fields;
+  const size_t velocity = fields.add("vel", 2, "m/s");
+  const size_t bias = fields.add("bias");
+  const size_t rtk = fields.add_label("RTK", {"UNRELIABLE", "FLOAT", "FIX"});
+  EXPECT_EQ(fields.size(), 3u);
+
+  // Fields which are not recorded yet
+  EXPECT_EQ(fields.format("Status"), "--- Status ----\nvel: -\nbias: -\nRTK: -\n");
+
+  fields.set(velocity, 12.345);
+  fields.set(bias, -0.001);
+  fields.set(rtk, 2);
+  EXPECT_EQ(fields.format("Status"), "--- Status ----\nvel: 12.35 m/s\nbias: -0.001\nRTK: FIX\n");
+
+  // The latest value is formatted
+  fields.set(rtk, 1);
+  const common::StatusFields::KeyValues key_values = fields.key_values();
+  ASSERT_EQ(key_values.size(), 3u);
+  EXPECT_EQ(key_values.at(0), std::make_pair(std::string("vel"), std::string("12.35 m/s")));
+  EXPECT_EQ(key_values.at(2), std::make_pair(std::string("RTK"), std::string("FLOAT")));
+
+  fields.set(rtk, 5);
+  EXPECT_EQ(fields.key_values().at(2).second, "UNKNOWN");
+}
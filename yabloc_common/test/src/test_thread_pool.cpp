@@ -0,0 +1,50 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/thread_pool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <numeric>
+#include <vector>
+
+TEST(ThreadPoolTestSuite, everyIndexOnce)
+{
+  yabloc::common::ThreadPool pool(4);
+  EXPECT_EQ(pool.size(), 4u);
+
+  for (size_t count : {0u, 1u, 3u, 1000u}) {
+    std::vector<int> visited(count, 0);
+    pool.parallel_for(count, [&visited](size_t i) { visited[i]++; });
+    EXPECT_EQ(std::accumulate(visited.begin(), visited.end(), 0), static_cast<int>(count));
+    for (int v : visited) EXPECT_EQ(v, 1);
+  }
+}
+
+TEST(ThreadPoolTestSuite, deterministicReduction)
+{
+  yabloc::common::ThreadPool pool;
+  std::vector<double> values(10000);
+  std::atomic<int> calls{0};
+  pool.parallel_for(values.size(), [&](size_t i) {
+    values[i] = 1.0 / static_cast<double>(i + 1);
+    calls++;
+  });
+  EXPECT_EQ(calls.load(), 10000);
+
+  double expected = 0;
+  for (size_t i = 0; i < values.size(); i++) expected += 1.0 / static_cast<double>(i + 1);
+  EXPECT_EQ(std::accumulate(values.begin(), values.end(), 0.0), expected);
+}